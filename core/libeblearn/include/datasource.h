@@ -263,6 +263,12 @@ template<typename T, typename Tdata> class datasource {
   virtual void save_state();
   //! Restore previously saved internal iterators.
   virtual void restore_state();
+  //! Write internal iterators, sample order, sample probabilities and epoch
+  //! counters to file 'fname', so that another process can resume iterating
+  //! from the current sample with read_state().
+  virtual void write_state(const std::string &fname);
+  //! Read internal iterators previously written by write_state() from 'fname'.
+  virtual void read_state(const std::string &fname);
 
   // pretty methods //////////////////////////////////////////////////////////
 
@@ -288,6 +294,14 @@ template<typename T, typename Tdata> class datasource {
   //! Return a vector of sample indices, sorted by their picking counts.
   virtual std::map<uint,intg>& get_pickings();
 
+  // state files /////////////////////////////////////////////////////////////
+
+  //! Append the iterating state to 'm' (used by write_state()).
+  virtual void get_state(svector<idx<double> > &m);
+  //! Set the iterating state from 'm' starting at element 'i', 'i' is
+  //! incremented by the number of elements read (used by read_state()).
+  virtual void set_state(midx<double> &m, uint &i);
+
   // members /////////////////////////////////////////////////////////////////
  public:
   T                   bias;
@@ -721,6 +735,10 @@ class class_datasource : public labeled_datasource<T, Tdata, Tlabel> {
   //! Draw a random number between 0 and 1 and return true if higher
   //! than current sample's probability.
   virtual bool pick_current();
+  //! Append the iterating state to 'm', including balanced iterators.
+  virtual void get_state(svector<idx<double> > &m);
+  //! Set the iterating state from 'm' starting at element 'i'.
+  virtual void set_state(midx<double> &m, uint &i);
 
   // members /////////////////////////////////////////////////////////////////
  protected:
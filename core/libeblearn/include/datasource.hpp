@@ -777,6 +777,69 @@ void datasource<T,Tdata>::restore_state() {
     indices[k] = indices_saved[k];
 }
 
+template <typename T, typename Tdata>
+void datasource<T,Tdata>::write_state(const std::string &fname) {
+  svector<idx<double> > m;
+  get_state(m);
+  if (!save_matrices(m, fname))
+    eblerror("failed to write datasource state to " << fname);
+  std::cout << _name << ": Wrote iterating state to " << fname << std::endl;
+}
+
+template <typename T, typename Tdata>
+void datasource<T,Tdata>::read_state(const std::string &fname) {
+  midx<double> m = load_matrices<double>(fname, false);
+  uint i = 0;
+  set_state(m, i);
+  if (i != (uint) m.dim(0))
+    eblerror("unexpected number of matrices (" << m.dim(0)
+             << ") in datasource state " << fname);
+  std::cout << _name << ": Resuming from iterating state " << fname
+            << " at sample " << it << " (epoch count " << epoch_cnt << ")"
+            << std::endl;
+}
+
+template <typename T, typename Tdata>
+void datasource<T,Tdata>::get_state(svector<idx<double> > &m) {
+  idx<double> iters(5 + epoch_done_counters.size());
+  iters.set((double) it, 0);
+  iters.set((double) it_test, 1);
+  iters.set((double) it_train, 2);
+  iters.set((double) epoch_cnt, 3);
+  iters.set((double) epoch_pick_cnt, 4);
+  for (uint k = 0; k < epoch_done_counters.size(); ++k)
+    iters.set((double) epoch_done_counters[k], 5 + k);
+  m.push_back_new(iters);
+  idx<double> ind(indices.dim(0));
+  idx_copy(indices, ind);
+  m.push_back_new(ind);
+  m.push_back_new(probas);
+}
+
+template <typename T, typename Tdata>
+void datasource<T,Tdata>::set_state(midx<double> &m, uint &i) {
+  if (m.dim(0) < i + 3) eblerror("missing matrices in datasource state");
+  idx<double> iters = m.mget(i++);
+  idx<double> ind = m.mget(i++);
+  idx<double> p = m.mget(i++);
+  if (ind.dim(0) != indices.dim(0))
+    eblerror("datasource state has " << ind.dim(0) << " indices but "
+             << _name << " has " << indices.dim(0) << " samples");
+  if (p.dim(0) != probas.dim(0))
+    eblerror("datasource state has " << p.dim(0) << " probabilities but "
+             << _name << " has " << probas.dim(0) << " samples");
+  it = (intg) iters.get(0);
+  it_test = (intg) iters.get(1);
+  it_train = (intg) iters.get(2);
+  epoch_cnt = (intg) iters.get(3);
+  epoch_pick_cnt = (intg) iters.get(4);
+  epoch_done_counters.clear();
+  for (intg k = 5; k < iters.dim(0); ++k)
+    epoch_done_counters.push_back((intg) iters.get(k));
+  idx_copy(ind, indices);
+  idx_copy(p, probas);
+}
+
 template <typename T, typename Tdata>
 void datasource<T,Tdata>::set_epoch_show(uint modulo) {
   std::cout << _name << ": Print training count every " << modulo
@@ -1193,7 +1256,7 @@ class_datasource<T, Tdata, Tlabel>::
 class_datasource(midx<Tdata> &data_, idx<Tlabel> &labels_,
                  std::vector<std::string*> *lblstr_, const char *name_) {
   defaults();
-  init(data_, labels_, name_, lblstr_);
+  init(data_, labels_, lblstr_, name_);
   this->init_epoch();
   this->pretty(); // print info about dataset
 }
@@ -1203,7 +1266,7 @@ class_datasource<T, Tdata, Tlabel>::
 class_datasource(idx<Tdata> &data_, idx<Tlabel> &labels_,
                  std::vector<std::string*> *lblstr_, const char *name_) {
   defaults();
-  init(data_, labels_, name_, lblstr_);
+  init(data_, labels_, lblstr_, name_);
   this->init_epoch();
   this->pretty(); // print info about dataset
 }
@@ -1980,6 +2043,59 @@ void class_datasource<T,Tdata,Tlabel>::restore_state() {
   }
 }
 
+template <typename T, typename Tdata, typename Tlabel>
+void class_datasource<T,Tdata,Tlabel>::get_state(svector<idx<double> > &m) {
+  datasource<T,Tdata>::get_state(m);
+  idx<double> iters(2 + bal_it.size());
+  iters.set((double) class_it, 0);
+  iters.set((double) class_it_it, 1);
+  for (uint k = 0; k < bal_it.size(); ++k)
+    iters.set((double) bal_it[k], 2 + k);
+  m.push_back_new(iters);
+  idx<double> order(std::max((size_t) 1, class_order.size()));
+  idx_clear(order);
+  for (uint k = 0; k < class_order.size(); ++k)
+    order.set((double) class_order[k], k);
+  m.push_back_new(order);
+  for (uint k = 0; k < bal_indices.size(); ++k) {
+    idx<double> ind(std::max((size_t) 1, bal_indices[k].size()));
+    idx_clear(ind);
+    for (uint l = 0; l < bal_indices[k].size(); ++l)
+      ind.set((double) bal_indices[k][l], l);
+    m.push_back_new(ind);
+  }
+}
+
+template <typename T, typename Tdata, typename Tlabel>
+void class_datasource<T,Tdata,Tlabel>::set_state(midx<double> &m, uint &i) {
+  datasource<T,Tdata>::set_state(m, i);
+  if (m.dim(0) < i + 2 + (intg) bal_indices.size())
+    eblerror("missing balanced matrices in datasource state");
+  idx<double> iters = m.mget(i++);
+  idx<double> order = m.mget(i++);
+  if (iters.dim(0) != (intg) (2 + bal_it.size()))
+    eblerror("datasource state has " << iters.dim(0) - 2 << " classes but "
+             << _name << " has " << bal_it.size());
+  class_it = (uint) iters.get(0);
+  class_it_it = (uint) iters.get(1);
+  for (uint k = 0; k < bal_it.size(); ++k)
+    bal_it[k] = (uint) iters.get(2 + k);
+  if (class_order.size() > 0) {
+    class_order.resize(order.dim(0));
+    for (uint k = 0; k < class_order.size(); ++k)
+      class_order[k] = (uint) order.get(k);
+  }
+  for (uint k = 0; k < bal_indices.size(); ++k) {
+    idx<double> ind = m.mget(i++);
+    if (bal_indices[k].size() > 0 &&
+        ind.dim(0) != (intg) bal_indices[k].size())
+      eblerror("datasource state has " << ind.dim(0) << " samples for class "
+               << k << " but " << _name << " has " << bal_indices[k].size());
+    for (uint l = 0; l < bal_indices[k].size(); ++l)
+      bal_indices[k][l] = (intg) ind.get(l);
+  }
+}
+
 // pretty methods //////////////////////////////////////////////////////////////
 
 template <typename T, typename Tdata, typename Tlabel>
@@ -33,19 +33,19 @@
 #ifndef DETECTOR_H_
 #define DETECTOR_H_
 
+#include <list>
 #include "libidx.h"
 #include "ebl_state.h"
 #include "ebl_arch.h"
 #include "ebl_answer.h"
 #include "ebl_merge.h"
 #include "ebl_preprocessing.h"
+#include "datasource.h"
 #include "bbox.h"
 #include "nms.h"
 
 namespace ebl {
 
-// detector ////////////////////////////////////////////////////////////////////
-
 //! different types of resolutions
 //! MANUAL: resolutions are specified manually by height and width
 //! SCALES: a series of scaling factors, 1 being the network's size
@@ -58,6 +58,66 @@ namespace ebl {
 enum t_scaling { MANUAL = 0, SCALES = 1, NSCALES = 2, SCALES_STEP = 3,
                  ORIGINAL = 4, NETWORK = 5, SCALES_STEP_UP = 6 };
 
+// detector_timing /////////////////////////////////////////////////////////////
+
+//! Durations in seconds of each stage of a detector::fprop() call.
+class EXPORT detector_timing {
+ public:
+  detector_timing();
+  //! Set all durations to zero.
+  void clear();
+  //! Return the duration of stage 'i' (see stage_name()).
+  double get(uint i) const;
+  //! Return the name of stage 'i', 'nstages' being the total.
+  static const char* stage_name(uint i);
+  //! Number of stages, not counting the total.
+  static const uint nstages = 6;
+ public:
+  double prepare;       //!< Input conversion and scales planning.
+  double pyramid;       //!< Resizing and preprocessing of each scale.
+  double fprop;         //!< Network on each scale (including the pyramid
+                        //!< unless stage timing is enabled).
+  double answers;       //!< Outputs thresholding, smoothing and answers.
+  double extraction;    //!< Bounding boxes extraction and sorting.
+  double nms;           //!< Non-maximum suppression.
+  double total;         //!< Entire fprop() call.
+};
+
+//! Return the nearest-rank 'p' percentile (0 < p <= 1) of the values
+//! 'sorted' sorted in increasing order, i.e. the smallest value such that
+//! at least p * n values are lower or equal to it. Returns 0 if empty.
+EXPORT double nearest_rank(const std::vector<double> &sorted, double p);
+//! Print the number of frames, frames per second given the wall-clock
+//! 'seconds' taken to process them, and the 50th, 95th and 99th percentile
+//! latencies of each stage of 'timings' (one per frame) in milliseconds.
+EXPORT void print_timing_percentiles(std::vector<detector_timing> &timings,
+                                     double seconds,
+                                     std::ostream &out = std::cout);
+
+// detector_plan ///////////////////////////////////////////////////////////////
+
+//! Everything a detector derives from an input size: scales, per-scale
+//! buffers and corner geometry. The detector keeps the most recently used
+//! plans so that switching back to a known input size does not recompute
+//! nor reallocate anything (see detector::set_plan_cache()).
+template <typename T> class detector_plan {
+ public:
+  detector_plan() : corners_ready(false) {}
+  idxdim                          indim;    //!< Input size of this plan.
+  midxdim                         scales;
+  midxdim                         actual_scales;
+  std::vector<rect<int> >         original_bboxes;
+  svector<state<T> >              ppinputs;
+  svector<state<T> >              outputs;
+  svector<state<T> >              answers;
+  svector<mfidxdim>               itl, itr, ibl, ibr;
+  svector<mfidxdim>               pptl, pptr, ppbl, ppbr;
+  std::vector<std::vector<uint> > scale_indices;
+  bool                            corners_ready; //!< Corners are inferred.
+};
+
+// detector ////////////////////////////////////////////////////////////////////
+
 template <typename T> class detector {
  public:
   //! Constructor. Default resolutions are 1, 2 and 4 times the network's
@@ -173,6 +233,74 @@ template <typename T> class detector {
                             bool keep_inputs = false);
   //! Set by hand the minimum network input and fix it.
   void set_netdim(idxdim &d);
+  //! Register 'scales' as the precomputed pyramid for inputs of size
+  //! 'dinput'. compute_scales() then reuses them instead of computing them
+  //! whenever the input dimensions match exactly.
+  void set_precomputed_scales(idxdim &dinput, midxdim &scales);
+  //! Keep the plans (scales, buffers and corners) of the 'n' most recently
+  //! used input sizes, so that init() only swaps them back in when an
+  //! input size is seen again. 0 disables the cache (default).
+  void set_plan_cache(uint n);
+  //! Enable cascade (early rejection) detection: the network is split after
+  //! its top-level module named 'module', whose output is scored at each
+  //! location, either by its maximum over features or, if 'weights' is
+  //! given, by a linear classifier (one weight per feature followed by a
+  //! bias). The rest of the network is only computed for the outputs whose
+  //! receptive field contains a score >= 'threshold', all other outputs
+  //! are set to the background target of the answer module. Without
+  //! background class (see set_bgclass()), rejected outputs are instead
+  //! ignored when extracting bounding boxes.
+  //! This can not be combined with set_incremental().
+  void set_cascade(const char *module, T threshold, idx<T> *weights = NULL);
+  //! Set how the rest of the network is evaluated in cascade mode:
+  //! 'band' rows of outputs are computed at a time (also used in
+  //! incremental mode), and if more than 'dense_fraction' of the outputs
+  //! survive, everything is computed densely instead.
+  void set_cascade_evaluation(uint band, float dense_fraction);
+  //! Set the cascade threshold so that a fraction 'recall' of the positive
+  //! (non-background) samples of 'ds' survive the early rejection.
+  //! This returns the new threshold.
+  template <typename Tdata, typename Tlabel>
+  T calibrate_cascade(class_datasource<T,Tdata,Tlabel> &ds, double recall);
+  //! Detect objects in all 'frames' at once, returning the bounding boxes
+  //! of each frame in 'bbs'. Frames must have identical sizes: each scale is
+  //! preprocessed for each frame, then the network runs once on all
+  //! preprocessed frames laid side by side and its outputs are split back
+  //! into each frame's outputs.
+  //! Frames are spaced by less than one network stride of zeros, so that
+  //! each frame's windows are aligned as when alone and only windows lying
+  //! entirely inside a frame are kept. This tiling is an approximation:
+  //! modules padding their inputs (e.g. local normalizations) see the gap
+  //! and the neighboring frame at frame borders instead of their padding,
+  //! and modules normalizing over their whole input normalize over all
+  //! frames at once, so results are close but not identical to fprop().
+  template <class Tin>
+  void fprop_batch(svector<idx<Tin> > &frames, std::vector<bboxes> &bbs,
+                   const char *frame_name = NULL);
+  //! Enable incremental detection for video streams: the preprocessed
+  //! inputs of each scale are compared with the previous frame's by blocks
+  //! of 'block' x 'block' pixels, and the network (after preprocessing) is
+  //! only run on outputs whose receptive field overlaps a block where some
+  //! value changed by more than 'tolerance', other outputs are reused from
+  //! the previous frame. Comparing after preprocessing accounts for changes
+  //! spread by preprocessing. This is an approximation: 'tolerance' bounds
+  //! input changes and not the error on the outputs, and normalizations
+  //! inside the network that are not local are ignored, so even a 0
+  //! tolerance may differ from a full fprop(). Every 'refresh' frames
+  //! (if > 0), the whole frame is recomputed.
+  //! This can not be combined with set_cascade().
+  void set_incremental(uint block, double tolerance, uint refresh);
+  //! Force region 'r' (in input image coordinates) to be recomputed at next
+  //! frame in incremental mode, e.g. the predicted position of a tracked
+  //! object.
+  void add_dirty_region(const rect<float> &r);
+  //! Time the pyramid (resizing and preprocessing) separately from the rest
+  //! of the network in get_timing(), by running them as two halves of the
+  //! network (see split_preprocessing()). When the network can not be
+  //! split, the pyramid is timed as part of fprop.
+  void set_stage_timing(bool set);
+  //! Return the durations of each stage of the last fprop().
+  const detector_timing& get_timing();
   //! Enables dumping of all outputs using the base name 'name', to which
   //! is appending the idx's size and '.mat'. Each resolution
   //! will be dump as a separate matrix file.
@@ -242,6 +370,20 @@ template <typename T> class detector {
   idx<T> get_mask(std::string &classname);
   //! Returns the number of bboxes saved so far.
   uint get_total_saved();
+  //! Returns the network's minimum input dimensions computed by init().
+  const idxdim& get_minimum_input() const;
+  //! Returns the ideal scales computed by the last call to init().
+  const midxdim& get_scales() const;
+  //! Returns the number of init() calls served by the plan cache.
+  uint get_plan_cache_hits() const;
+  //! Returns the number of init() calls that had to compute a new plan.
+  uint get_plan_cache_misses() const;
+  //! Returns the fraction of output locations actually computed by the
+  //! rest of the network since cascade mode was enabled.
+  double get_cascade_evaluated() const;
+  //! Returns the fraction of output locations actually computed by the
+  //! network since incremental mode was enabled.
+  double get_incremental_evaluated() const;
   //! Enable saving of each (preprocessed) window inducing a positive
   //! detection into directory. All detections except for the background
   //! class are dumped into a directory corresponding to the class' name.
@@ -256,6 +398,45 @@ template <typename T> class detector {
  protected:
   // scales methods //////////////////////////////////////////////////////////
 
+  //! Exchange the current plan's members with those of 'p'.
+  void swap_plan(detector_plan<T> &p);
+
+  // cascade methods /////////////////////////////////////////////////////////
+
+  //! Fprop 'in' into 'out' of scale 'scale' with early rejection
+  //! (see set_cascade()).
+  void cascade_fprop(uint scale, state<T> &in, state<T> &out);
+  //! Set the outputs of rejected windows given the number of output
+  //! features 'nout': the background target if available, in which case
+  //! this returns true, or the lowest target otherwise.
+  bool init_cascade_reject(intg nout);
+  //! Compute the rejection score of each location of features 'mid'.
+  void cascade_score(idx<T> &mid, idx<T> &score);
+  //! Split the network into pp_front (up to the resizing module) and pp_back
+  //! (the rest), if not done already. This requires the resizing module to
+  //! be a top-level module followed by at least one module. Otherwise this
+  //! throws an error if 'required', or warns and returns false.
+  bool split_preprocessing(bool required = true);
+  //! Compute the input 'field' and 'stride' (1xHxW) of one output of 'net'.
+  void receptive_field(module_1_1<T> &net, idxdim &field, idxdim &stride);
+  //! Fprop 'in' through 'net' only for the outputs set in 'active' (HxW),
+  //! by bands of rows, copying them into 'out' (FxHxW) and leaving other
+  //! outputs untouched. 'field' and 'stride' are those of 'net'.
+  //! This returns the number of outputs computed.
+  intg sparse_fprop(layers<T> &net, state<T> &in, idx<ubyte> &active,
+                    idxdim &field, idxdim &stride, idx<T> &out);
+
+  // incremental methods /////////////////////////////////////////////////////
+
+  //! Decide if current frame is incremental.
+  void incremental_prepare();
+  //! Mark outputs in 'active' whose receptive field overlaps rectangle
+  //! [y0, y1) x [x0, x1) of preprocessed inputs.
+  void incremental_activate(idx<ubyte> &active, double y0, double x0,
+                            double y1, double x1);
+  //! Fprop 'in' into 'out' at scale 'i', only recomputing dirty regions
+  //! (see set_incremental()).
+  void incremental_fprop(uint i, state<T> &in, state<T> &out);
   //! Compute all scales based on minimum, maximum and input dimensions,
   //! and scaling type.
   //! \param netdim The network's minimal input size.
@@ -336,6 +517,12 @@ template <typename T> class detector {
   void prepare_scale(uint i);
   //! do a fprop on thenet with multiple rescaled inputs
   void multi_res_fprop();
+  //! Extract bounding boxes from the outputs of all scales, then prune,
+  //! save and return them.
+  bboxes& fprop_outputs(const char *frame_name);
+  //! Copy the outputs of frame 'frame' at scale 'scale' from the batched
+  //! outputs into the regular outputs.
+  void batch_output(uint scale, uint frame);
 
   // member variables ////////////////////////////////////////////////////////
  protected:
@@ -374,6 +561,8 @@ template <typename T> class detector {
   midxdim              scales;          //!< Multi-scale (ideal) scales.
   midxdim              actual_scales;   //!< Actually used scales.
   std::vector<midxdim> manual_scales;   //!< Scales set manually.
+  std::vector<idxdim>  precomputed_indims; //!< Inputs of precomputed scales.
+  std::vector<midxdim> precomputed_scales; //!< Scales for each such input.
   std::vector<double>  scale_factors;   //!< A list of scale factors.
   uint                 nscales;         //!< Number of scales if set by hand.
   double               scales_step;
@@ -431,6 +620,66 @@ template <typename T> class detector {
   mfidxdim            bbox_scalings;
   bool                scale_remove_pad; //!< If true, remove padding from target scales.
 
+  // plans cache /////////////////////////////////////////////////////////////
+  std::list<detector_plan<T>*> plans;   //!< Cached plans, most recent first.
+  uint                plan_cache_size;  //!< Maximum number of cached plans.
+  bool                plan_corners_ready; //!< Current plan's corners inferred.
+  uint                plan_hits;        //!< Number of cache hits.
+  uint                plan_misses;      //!< Number of cache misses.
+
+  // cascade /////////////////////////////////////////////////////////////////
+  layers<T>           *cascade_front;   //!< Network up to the cascade module.
+  layers<T>           *cascade_front_nopp; //!< Same without preprocessing.
+  layers<T>           *cascade_back;    //!< Rest of the network.
+  T                   cascade_threshold; //!< Minimum score to survive.
+  idx<T>              cascade_weights;  //!< Optional linear scorer and bias.
+  float               cascade_dense;    //!< Survivors ratio to go dense.
+  state<T>            cascade_mid;      //!< Output of the front network.
+  idxdim              cascade_field;    //!< Back receptive field (1xHxW).
+  idxdim              cascade_stride;   //!< Back stride (1xHxW).
+  intg                cascade_nout;     //!< Back output features.
+  idx<T>              cascade_reject;   //!< Outputs of rejected windows.
+  bool                cascade_reject_bg; //!< cascade_reject is background.
+  //! Surviving outputs of each scale, only kept when rejected outputs can
+  //! not be set to background and must be ignored by extract_bboxes().
+  std::vector<idx<ubyte> > cascade_alive;
+  intg                cascade_total;    //!< Number of outputs seen.
+  intg                cascade_evaluated; //!< Number of outputs computed.
+
+  // sparse and batched evaluation ///////////////////////////////////////////
+  uint                sparse_band;      //!< Output rows computed at once.
+  state<T>            sparse_buf;       //!< Output of a band.
+  layers<T>           *pp_front;        //!< Network up to preprocessing.
+  layers<T>           *pp_back;         //!< Network after preprocessing.
+  idxdim              pp_field;         //!< pp_back receptive field (1xHxW).
+  idxdim              pp_stride;        //!< pp_back stride (1xHxW).
+
+  // incremental /////////////////////////////////////////////////////////////
+  bool                incr_on;          //!< Incremental mode is enabled.
+  uint                incr_block;       //!< Size of compared blocks.
+  double              incr_tolerance;   //!< Maximum mean block difference.
+  uint                incr_refresh;     //!< Full refresh period in frames.
+  uint                incr_frame;       //!< Frames seen in incremental mode.
+  bool                incr_full;        //!< Recompute current frame fully.
+  std::vector<idx<T> > incr_prev;       //!< Previous preprocessed inputs.
+  std::vector<rect<float> > incr_dirty; //!< Regions forced to recompute.
+  svector<state<T> >  incr_outputs;     //!< Raw outputs of all scales.
+  state<T>            incr_pp;          //!< Preprocessed input.
+  intg                incr_total;       //!< Number of outputs seen.
+  intg                incr_evaluated;   //!< Number of outputs computed.
+
+  // batch ///////////////////////////////////////////////////////////////////
+  svector<state<T> >  batch_pp;         //!< Preprocessed frames of a scale.
+  state<T>            batch_in;         //!< Preprocessed frames side by side.
+  svector<state<T> >  batch_maps;       //!< Outputs of all frames per scale.
+  std::vector<intg>   batch_tiles;      //!< Frame spacing per scale (outputs).
+  std::vector<intg>   batch_widths;     //!< Frame width per scale (outputs).
+
+  // timing //////////////////////////////////////////////////////////////////
+  bool                stage_timing;     //!< Time the pyramid separately.
+  detector_timing     timing;           //!< Stages durations of last fprop.
+  state<T>            stage_pp;         //!< Preprocessed input.
+
   // friends /////////////////////////////////////////////////////////////////
   template <typename T2> friend class detector_gui;
   template <typename T2> friend class detection_thread;
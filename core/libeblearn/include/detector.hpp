@@ -50,7 +50,7 @@ detector<T>::detector(module_1_1<T> &thenet_, std::vector<std::string> &labels_,
                       std::ostream &o, std::ostream &e, bool adapt_scales_)
     : thenet(thenet_), thenet_nopp(NULL), resizepp(resize),
       resizepp_delete(false), resizepp_outside(false), input_gain(1),
-      input(NULL), minput(NULL), netdim_fixed(false),
+      input(NULL), tmp(NULL), minput(NULL), netdim_fixed(false),
       bgclass(-1), mask_class(-1), pnms(NULL), scales_step(0), min_scale(1.0),
       max_scale(1.0), restype(ORIGINAL), silent(false), save_mode(false),
       save_dir(""), save_counts(labels_.size(), 0), min_size(0), max_size(0),
@@ -60,7 +60,15 @@ detector<T>::detector(module_1_1<T> &thenet_, std::vector<std::string> &labels_,
       bboxes_off(false), adapt_scales(adapt_scales_), answer(answer_),
       ignore_outsiders(false), corners_inference(0), corners_infered(false),
       pre_threshold(0), outputs_threshold(-1), outputs_threshold_val(-1),
-      bbox_decision(0), scale_remove_pad(false) {
+      bbox_decision(0), scale_remove_pad(false), plan_cache_size(0),
+      plan_corners_ready(false), plan_hits(0), plan_misses(0),
+      cascade_front(NULL), cascade_front_nopp(NULL), cascade_back(NULL),
+      cascade_threshold(0), cascade_dense(.6),
+      cascade_nout(0), cascade_reject_bg(false), cascade_total(0),
+      cascade_evaluated(0), sparse_band(8),
+      pp_front(NULL), pp_back(NULL), incr_on(false), incr_block(16),
+      incr_tolerance(0), incr_refresh(0), incr_frame(0), incr_full(true),
+      incr_total(0), incr_evaluated(0), stage_timing(false) {
   // // make sure the top module is an answer module
   // module_1_1<T> *last = thenet.last_module();
   // if (!dynamic_cast<answer_module<T>*>(last))
@@ -116,6 +124,14 @@ detector<T>::~detector() {
   if (tmp) delete tmp;
   if (minput) delete minput;
   if (pnms) delete pnms;
+  if (cascade_front) delete cascade_front;
+  if (cascade_front_nopp) delete cascade_front_nopp;
+  if (cascade_back) delete cascade_back;
+  if (pp_front) delete pp_front;
+  if (pp_back) delete pp_back;
+  for (typename std::list<detector_plan<T>*>::iterator i = plans.begin();
+       i != plans.end(); ++i)
+    delete *i;
 }
 
 template <typename T>
@@ -354,6 +370,153 @@ void detector<T>::set_netdim(idxdim &d) {
   eblprinto(mout, "Manually setting network's minimum input to " << d << std::endl);
 }
 
+template <typename T>
+void detector<T>::set_precomputed_scales(idxdim &dinput, midxdim &s) {
+  for (uint i = 0; i < precomputed_indims.size(); ++i)
+    if (precomputed_indims[i] == dinput) {
+      precomputed_scales[i].clear();
+      precomputed_scales[i].push_back(s);
+      return ;
+    }
+  precomputed_indims.push_back(dinput);
+  precomputed_scales.push_back(midxdim());
+  precomputed_scales.back().push_back(s);
+}
+
+template <typename T>
+void detector<T>::set_plan_cache(uint n) {
+  plan_cache_size = n;
+  while (plans.size() > plan_cache_size) {
+    delete plans.back();
+    plans.pop_back();
+  }
+  eblprinto(mout, "Caching the plans of up to " << n << " input sizes"
+            << std::endl);
+}
+
+template <typename T>
+void detector<T>::set_cascade(const char *module, T threshold, idx<T> *weights) {
+  if (incr_on)
+    eblerror("cascade mode can not be combined with incremental detection");
+  layers<T> *net = dynamic_cast<layers<T>*>(&thenet);
+  if (!net) eblerror("cascade detection requires a layers network");
+  // find splitting module and preprocessing module
+  int k = -1, pp = -1;
+  for (uint i = 0; i < net->modules.size(); ++i) {
+    if (!strcmp(net->modules[i]->name(), module)) k = (int) i;
+    if (net->modules[i] == resizepp) pp = (int) i;
+  }
+  if (k < 0) eblerror("cascade module \"" << module << "\" not found in "
+                      << "the top-level modules of " << thenet.name());
+  if (k + 1 >= (int) net->modules.size())
+    eblerror("cascade module \"" << module << "\" is the last module");
+  if (pp > k) eblerror("cascade module must come after preprocessing");
+  // split network, modules are shared with the original network
+  if (cascade_front) delete cascade_front;
+  if (cascade_front_nopp) delete cascade_front_nopp;
+  if (cascade_back) delete cascade_back;
+  cascade_front = new layers<T>(false, "cascade_front");
+  cascade_front_nopp = new layers<T>(false, "cascade_front_nopp");
+  cascade_back = new layers<T>(false, "cascade_back");
+  for (int i = 0; i <= k; ++i) {
+    cascade_front->add_module(net->modules[i]);
+    if (i > pp) cascade_front_nopp->add_module(net->modules[i]);
+  }
+  for (uint i = k + 1; i < net->modules.size(); ++i)
+    cascade_back->add_module(net->modules[i]);
+  receptive_field(*cascade_back, cascade_field, cascade_stride);
+  cascade_threshold = threshold;
+  if (weights) cascade_weights = *weights;
+  else cascade_weights = idx<T>();
+  cascade_nout = 0;
+  cascade_total = 0;
+  cascade_evaluated = 0;
+  eblprinto(mout, "Cascade detection after module " << module
+            << " with threshold " << threshold << " ("
+            << (weights ? "linear" : "max") << " score), rejecting windows of "
+            << cascade_field << " with stride " << cascade_stride
+            << std::endl);
+}
+
+template <typename T>
+void detector<T>::set_cascade_evaluation(uint band, float dense_fraction) {
+  sparse_band = std::max((uint) 1, band);
+  cascade_dense = dense_fraction;
+  eblprinto(mout, "Cascade evaluates bands of " << sparse_band
+            << " output rows, densely above " << cascade_dense * 100
+            << "% of survivors" << std::endl);
+}
+
+template <typename T>
+void detector<T>::set_incremental(uint block, double tolerance, uint refresh) {
+  if (cascade_back)
+    eblerror("incremental detection can not be combined with cascade mode");
+  split_preprocessing();
+  incr_block = std::max((uint) 1, block);
+  incr_tolerance = tolerance;
+  incr_refresh = refresh;
+  incr_on = true;
+  incr_frame = 0;
+  incr_prev.clear();
+  incr_outputs.clear();
+  incr_dirty.clear();
+  incr_total = 0;
+  incr_evaluated = 0;
+  eblprinto(mout, "Incremental detection on blocks of " << incr_block << "x"
+            << incr_block << " preprocessed pixels with tolerance "
+            << incr_tolerance
+            << ", refreshing every " << incr_refresh << " frames, windows of "
+            << pp_field << " with stride " << pp_stride << std::endl);
+}
+
+template <typename T>
+void detector<T>::add_dirty_region(const rect<float> &r) {
+  incr_dirty.push_back(r);
+}
+
+template <typename T>
+void detector<T>::set_stage_timing(bool set) {
+  // an outside resizing module is already timed apart from the network,
+  // otherwise fprop times the whole network if it can not be split
+  if (set && !resizepp_outside) split_preprocessing(false);
+  stage_timing = set;
+}
+
+template <typename T>
+const detector_timing& detector<T>::get_timing() {
+  return timing;
+}
+
+template <typename T> template <typename Tdata, typename Tlabel>
+T detector<T>::calibrate_cascade(class_datasource<T,Tdata,Tlabel> &ds,
+                                 double recall) {
+  if (!cascade_front_nopp) eblerror("call set_cascade() before calibration");
+  std::vector<T> scores;
+  state<T> in, mid;
+  idx<T> score;
+  ds.seek_begin();
+  for (uint i = 0; i < ds.size(); ++i, ds.next()) {
+    if (bgclass >= 0 &&
+        ds.get_class_name((int) ds.get_label()) == labels[bgclass])
+      continue ;
+    ds.fprop_data(in);
+    cascade_front_nopp->fprop(in, mid);
+    score = idx<T>(mid.x[0].dim(1), mid.x[0].dim(2));
+    cascade_score(mid.x[0], score);
+    scores.push_back(idx_max(score));
+  }
+  if (scores.empty()) eblerror("no positive samples to calibrate cascade");
+  // keep the 'recall' highest scoring positives
+  std::sort(scores.begin(), scores.end());
+  intg j = (intg) ((1.0 - recall) * scores.size());
+  j = std::max((intg) 0, std::min((intg) scores.size() - 1, j));
+  cascade_threshold = scores[j];
+  eblprinto(mout, "Calibrated cascade threshold to " << cascade_threshold
+            << " for a recall of " << recall << " on " << scores.size()
+            << " positive samples of " << ds.name() << std::endl);
+  return cascade_threshold;
+}
+
 template <typename T>
 void detector<T>::set_mem_optimization(state<T> &in, state<T> &out,
                                               bool keep_inputs_) {
@@ -419,6 +582,36 @@ void detector<T>::set_input_gain(double gain) {
 
 template <typename T>
 void detector<T>::init(idxdim &dsample, const char *frame_name, int frame_id) {
+  if (plan_cache_size > 0) {
+    // move current plan to the front of the cache
+    if (initialized && scales.size() > 0) {
+      detector_plan<T> *p = new detector_plan<T>;
+      p->indim = indim;
+      swap_plan(*p);
+      plans.push_front(p);
+    }
+    // swap back the plan of this input size if known
+    typename std::list<detector_plan<T>*>::iterator i = plans.begin();
+    for ( ; i != plans.end(); ++i)
+      if ((*i)->indim == dsample) break ;
+    if (i != plans.end()) {
+      swap_plan(**i);
+      delete *i;
+      plans.erase(i);
+      plan_hits++;
+    } else
+      plan_misses++;
+    // evict least recently used plans
+    while (plans.size() > plan_cache_size) {
+      delete plans.back();
+      plans.pop_back();
+    }
+    if (scales.size() > 0) { // hit: nothing to recompute nor reallocate
+      initialized = true;
+      indim = dsample;
+      return ;
+    }
+  }
   initialized = true;
   indim = dsample;
   // the network's minimum input dimensions
@@ -472,6 +665,20 @@ void detector<T>::init(idxdim &dsample, const char *frame_name, int frame_id) {
   }
 }
 
+template <typename T>
+void detector<T>::swap_plan(detector_plan<T> &p) {
+  scales.swap(p.scales);
+  actual_scales.swap(p.actual_scales);
+  original_bboxes.swap(p.original_bboxes);
+  ppinputs.swap(p.ppinputs);
+  outputs.swap(p.outputs);
+  answers.swap(p.answers);
+  itl.swap(p.itl); itr.swap(p.itr); ibl.swap(p.ibl); ibr.swap(p.ibr);
+  pptl.swap(p.pptl); pptr.swap(p.pptr); ppbl.swap(p.ppbl); ppbr.swap(p.ppbr);
+  scale_indices.swap(p.scale_indices);
+  std::swap(plan_corners_ready, p.corners_ready);
+}
+
 // scaling methods /////////////////////////////////////////////////////////////
 
 template <typename T>
@@ -485,7 +692,16 @@ compute_scales(midxdim &scales, idxdim &netdim, idxdim &mindim,
     eblprinto(mout, "Scales: input: " << indim << " min: " << netdim
               << " max: " << maxdim << std::endl
               << "Scaling type " << type << ": ");
-  switch (type) {
+  // reuse the scales precomputed for this input size if any
+  bool precomputed = false;
+  for (uint i = 0; i < precomputed_indims.size() && !precomputed; ++i)
+    if (precomputed_indims[i] == indim) {
+      scales.push_back(precomputed_scales[i]);
+      precomputed = true;
+    }
+  if (precomputed) {
+    if (!silent) eblprinto(mout, "precomputed scales." << std::endl);
+  } else switch (type) {
     case ORIGINAL:
       if (!silent) eblprinto(mout, "1 scale only, the image's original scale."
                              << std::endl);
@@ -541,7 +757,7 @@ compute_scales(midxdim &scales, idxdim &netdim, idxdim &mindim,
     default: eblerror("unknown scaling mode");
   }
   // remove pad from target scales
-  if (scale_remove_pad) {
+  if (scale_remove_pad && !precomputed) {
     for (uint i = 0; i < scales.size(); ++i) {
       eblprint( "removing pad from " << scales[i] << ": ");
       scales[i].setdim(1, scales[i].dim(1) - 74);
@@ -1138,9 +1354,20 @@ void detector<T>::extract_bboxes(T threshold, bboxes &bbs) {
       // double offset_w_factor = (in_w - netw) / std::max((double)1, (out_w - 1));
       offset_w = 0;
       state<T> out(outx.get_idxdim());
+      timer tanswer;
+      tanswer.start();
       answer->fprop(output, out);
+      timing.answers += tanswer.elapsed_microseconds() / 1e6;
       answers[scale].x.push_back_new(out.x[0]);
 
+      // outputs rejected by the cascade without background target
+      idx<ubyte> *alive = NULL;
+      if (o == 0 && scale < cascade_alive.size()
+          && cascade_alive[scale].order() == 2
+          && cascade_alive[scale].dim(0) == outx.dim(1)
+          && cascade_alive[scale].dim(1) == outx.dim(2))
+        alive = &cascade_alive[scale];
+
       idx<T> tmp = outx.select(0, 1);
       // eblprint( "out " << o << " threshold " << thresh << " min " << idx_min(tmp)
       //      << " max " << idx_max(tmp) << std::endl);
@@ -1170,6 +1397,8 @@ void detector<T>::extract_bboxes(T threshold, bboxes &bbs) {
 	      break;
 	    default: eblerror("unknown bbox decision type");
           }
+          if (accept && alive && !alive->get(offset_h, offset_w))
+            accept = false;
           if (accept) {
             bbox bb;
             bb.class_id = classid; // Class
@@ -1290,32 +1519,151 @@ bboxes& detector<T>::fprop(idx<Tin> &img, const char *frame_name,
   TIMING1("t1 before prepare");
   TIMING2("t2 before prepare");
   TIMING_RESIZING_RESET();
+  timer ttotal, tstage;
+  ttotal.start();
+  tstage.start();
+  timing.clear();
   // prepare image and resolutions
   prepare(img, frame_name, frame_id);
+  timing.prepare = tstage.elapsed_microseconds() / 1e6;
   // do a fprop for each scaled input, based on the 'image' slot prepared
   // by prepare().
   TIMING2("preparation");
   multi_res_fprop();
   TIMING2("net fprop");
+  bboxes &bbs = fprop_outputs(frame_name);
+  timing.total = ttotal.elapsed_microseconds() / 1e6;
+  return bbs;
+}
+
+template <typename T> template <class Tin>
+void detector<T>::fprop_batch(svector<idx<Tin> > &frames,
+                              std::vector<bboxes> &bbs,
+                              const char *frame_name) {
+  bbs.clear();
+  if (frames.empty()) return ;
+  for (uint f = 1; f < frames.size(); ++f)
+    if (frames[f].get_idxdim() != frames[0].get_idxdim())
+      eblerror("batched frames must have identical sizes but found "
+               << frames[f] << " and " << frames[0]);
+  split_preprocessing();
+  cascade_alive.clear();
+  timer t;
+  t.start();
+  uint n = frames.size();
+  // prepare each frame once, the scales are computed from the first one
+  std::vector<idx<T> > images;
+  for (uint f = 0; f < n; ++f) {
+    prepare(frames[f], frame_name);
+    images.push_back(image);
+  }
+  while (batch_pp.size() < n) batch_pp.push_back(new state<T>());
+  if (batch_maps.size() != scales.size()) {
+    batch_maps.clear();
+    for (uint i = 0; i < scales.size(); ++i)
+      batch_maps.push_back(new state<T>());
+  }
+  batch_tiles.resize(scales.size());
+  batch_widths.resize(scales.size());
+  intg fw = pp_field.dim(2), sw = pp_stride.dim(2);
+  for (uint i = 0; i < scales.size(); ++i) {
+    prepare_scale(i);
+    if (!mem_optimization || keep_inputs)
+      resizepp->set_output_copy(ppinputs[i]);
+    // preprocess each frame at this scale
+    for (uint f = 0; f < n; ++f) {
+      image = images[f];
+      *input = image;
+      pp_front->fprop(*input, batch_pp[f]);
+    }
+    // lay frames side by side, spaced by a multiple of the network stride
+    // so that windows of each frame are the same as when alone
+    idx<T> &p0 = batch_pp[0].x[0];
+    intg w = p0.dim(2), tile = ((w + sw - 1) / sw) * sw;
+    idxdim d(p0.dim(0), p0.dim(1), tile * n);
+    idx<T> &in = batch_in.x[0];
+    if (in.order() != d.order()) in = idx<T>(d);
+    else if (in.get_idxdim() != d) in.resize(d);
+    idx_clear(in);
+    for (uint f = 0; f < n; ++f) {
+      idx<T> dst = in.narrow(2, w, f * tile);
+      idx_copy(batch_pp[f].x[0], dst);
+    }
+    pp_back->fprop(batch_in, batch_maps[i]);
+    batch_tiles[i] = tile / sw;
+    batch_widths[i] = (w - fw) / sw + 1;
+    // the last frame's windows must all be in the outputs
+    intg ow = batch_maps[i].x[0].dim(2);
+    if ((n - 1) * batch_tiles[i] + batch_widths[i] > ow)
+      eblerror("expected at least " << (n - 1) * batch_tiles[i]
+               + batch_widths[i] << " outputs for " << n << " frames of width "
+               << w << " at scale " << i << " but found " << ow);
+    // memorize original input's bbox in resized input
+    rect<int> &bbox = original_bboxes[i];
+    rect<int> bb = resizepp->get_original_bbox();
+    bbox.h0 = bb.h0;
+    bbox.w0 = bb.w0;
+    bbox.height = bb.height;
+    bbox.width = bb.width;
+    // output corners depend on the current scale, infer them from the
+    // first frame's outputs
+    batch_output(i, 0);
+    get_corners(outputs[i], i, !plan_corners_ready);
+  }
+  if (plan_cache_size > 0) plan_corners_ready = true;
+  if (!silent) eblprinto(mout, "net_processing=" << t.elapsed_ms() << " ("
+                         << n << " frames)" << std::endl);
+  // extract each frame's part of the outputs and its bounding boxes
+  bbs.resize(n);
+  for (uint f = 0; f < n; ++f) {
+    image = images[f];
+    if (f > 0)
+      for (uint i = 0; i < scales.size(); ++i) batch_output(i, f);
+    bbs[f].push_back_new(fprop_outputs(frame_name));
+  }
+}
+
+template <typename T>
+void detector<T>::batch_output(uint scale, uint frame) {
+  idx<T> &map = batch_maps[scale].x[0];
+  idx<T> src = map.narrow(2, batch_widths[scale], frame * batch_tiles[scale]);
+  state<T> &out = outputs[scale];
+  out.resize_forward_orders(batch_maps[scale], 1, 1);
+  idx<T> &o = out.x[0];
+  if (o.get_idxdim() != src.get_idxdim()) o.resize(src.get_idxdim());
+  idx_copy(src, o);
+}
+
+template <typename T>
+bboxes& detector<T>::fprop_outputs(const char *frame_name) {
   TIMING1("end of network");
   TIMING_RESIZING("total resizing time");
+  timer tstage;
+  tstage.start();
   // threshold before smoothing
   if (outputs_threshold > -1)
     threshold_outputs(outputs_threshold, outputs_threshold_val);
   // smooth outputs
   smooth_outputs();
+  timing.answers = tstage.elapsed_microseconds() / 1e6;
 
   if (bboxes_off) // do not extract bboxes if off flag is true
     return raw_bboxes;
+  tstage.restart();
   // clear previous bounding boxes
   raw_bboxes.clear();
-  // get new bboxes
+  // get new bboxes (also times the answer module into timing.answers)
+  double answers0 = timing.answers;
   if (answer) extract_bboxes(pre_threshold, raw_bboxes);
   // sort bboxes by confidence (most confident first)
   raw_bboxes.sort_by_confidence();
+  timing.extraction = tstage.elapsed_microseconds() / 1e6
+      - (timing.answers - answers0);
   TIMING1("bbox sorting");
   // non-maximum suppression
+  tstage.restart();
   fprop_nms(raw_bboxes, pruned_bboxes);
+  timing.nms = tstage.elapsed_microseconds() / 1e6;
   TIMING1("bbox nms");
   // print results
   if (!silent) eblprinto(mout, "found " << pruned_bboxes.pretty(&labels));
@@ -1455,6 +1803,38 @@ uint detector<T>::get_total_saved() {
   return total;
 }
 
+template <typename T>
+const idxdim& detector<T>::get_minimum_input() const {
+  return netdim;
+}
+
+template <typename T>
+const midxdim& detector<T>::get_scales() const {
+  return scales;
+}
+
+template <typename T>
+uint detector<T>::get_plan_cache_hits() const {
+  return plan_hits;
+}
+
+template <typename T>
+uint detector<T>::get_plan_cache_misses() const {
+  return plan_misses;
+}
+
+template <typename T>
+double detector<T>::get_cascade_evaluated() const {
+  if (cascade_total == 0) return 1.0;
+  return cascade_evaluated / (double) cascade_total;
+}
+
+template <typename T>
+double detector<T>::get_incremental_evaluated() const {
+  if (incr_total == 0) return 1.0;
+  return incr_evaluated / (double) incr_total;
+}
+
 template <typename T>
 std::string& detector<T>::set_save(const std::string &directory, uint nmax,
                                           bool diverse) {
@@ -1666,12 +2046,295 @@ void detector<T>::prepare_scale(uint i) {
   // 	  << ": actual res " << actual);
 }
 
+template <typename T>
+bool detector<T>::split_preprocessing(bool required) {
+  if (pp_back) return true; // already split
+  std::string err;
+  layers<T> *net = dynamic_cast<layers<T>*>(&thenet);
+  int pp = -1;
+  if (!net) err << "expected a layers network but found " << thenet.name();
+  else {
+    for (uint i = 0; i < net->modules.size(); ++i)
+      if (net->modules[i] == resizepp) pp = (int) i;
+    if (pp < 0) err << "expected the resizing module to be a top-level "
+                    << "module of " << thenet.name();
+    else if (pp + 1 >= (int) net->modules.size())
+      err << "nothing to compute after preprocessing in " << thenet.name();
+  }
+  if (!err.empty()) {
+    if (required) eblerror(err);
+    eblwarn(err << ", the pyramid is timed as part of fprop");
+    return false;
+  }
+  // modules are shared with the original network
+  pp_front = new layers<T>(false, "preprocessing_front");
+  pp_back = new layers<T>(false, "preprocessing_back");
+  for (uint i = 0; i < net->modules.size(); ++i)
+    if ((int) i <= pp) pp_front->add_module(net->modules[i]);
+    else pp_back->add_module(net->modules[i]);
+  receptive_field(*pp_back, pp_field, pp_stride);
+  return true;
+}
+
+template <typename T>
+void detector<T>::receptive_field(module_1_1<T> &net, idxdim &field,
+                                  idxdim &stride) {
+  // input sizes needed for 1x1 and 2x2 outputs
+  mfidxdim o1, o2;
+  o1.push_back_new(fidxdim(1, 1, 1));
+  o2.push_back_new(fidxdim(1, 2, 2));
+  mfidxdim f1 = net.bprop_size(o1);
+  mfidxdim f2 = net.bprop_size(o2);
+  field = idxdim(1, (intg) f1[0].dim(1), (intg) f1[0].dim(2));
+  stride = idxdim(1, std::max((intg) 1, (intg) (f2[0].dim(1) - f1[0].dim(1))),
+                  std::max((intg) 1, (intg) (f2[0].dim(2) - f1[0].dim(2))));
+}
+
+template <typename T>
+intg detector<T>::sparse_fprop(layers<T> &net, state<T> &in,
+                               idx<ubyte> &active, idxdim &field,
+                               idxdim &stride, idx<T> &out) {
+  intg oh = active.dim(0), ow = active.dim(1), n = 0;
+  intg fh = field.dim(1), fw = field.dim(2);
+  intg sh = stride.dim(1), sw = stride.dim(2);
+  // compute active outputs by bands of output rows
+  for (intg y0 = 0; y0 < oh; y0 += sparse_band) {
+    intg y1 = std::min(oh, y0 + (intg) sparse_band), x0 = ow, x1 = -1;
+    for (intg y = y0; y < y1; ++y)
+      for (intg x = 0; x < ow; ++x)
+	if (active.get(y, x)) {
+	  x0 = std::min(x0, x);
+	  x1 = std::max(x1, x);
+	}
+    if (x1 < 0) continue ; // nothing active in this band
+    intg bh = y1 - y0, bw = x1 - x0 + 1;
+    state<T> win = in
+      .narrow_state(1, std::min(in.x[0].dim(1) - y0 * sh, (bh - 1) * sh + fh),
+                    y0 * sh)
+      .narrow_state(2, std::min(in.x[0].dim(2) - x0 * sw, (bw - 1) * sw + fw),
+                    x0 * sw);
+    net.fprop(win, sparse_buf);
+    idx<T> &bout = sparse_buf.x[0];
+    bh = std::min(bh, bout.dim(1));
+    bw = std::min(bw, bout.dim(2));
+    idx<T> src = bout.narrow(1, bh, 0).narrow(2, bw, 0);
+    idx<T> dst = out.narrow(1, bh, y0).narrow(2, bw, x0);
+    idx_copy(src, dst);
+    n += bh * bw;
+  }
+  return n;
+}
+
+template <typename T>
+void detector<T>::cascade_score(idx<T> &mid, idx<T> &score) {
+  if (cascade_weights.order() == 1) { // linear classifier
+    if (cascade_weights.dim(0) != mid.dim(0) + 1)
+      eblerror("expected " << mid.dim(0) + 1 << " cascade weights (features "
+               << "and bias) but found " << cascade_weights);
+    idx_fill(score, cascade_weights.get(mid.dim(0)));
+    for (intg f = 0; f < mid.dim(0); ++f) {
+      idx<T> m = mid.select(0, f);
+      idx_dotcacc(m, cascade_weights.get(f), score);
+    }
+  } else { // maximum over features
+    idx<T> m = mid.select(0, 0);
+    idx_copy(m, score);
+    for (intg f = 1; f < mid.dim(0); ++f) {
+      m = mid.select(0, f);
+      idx_max(m, score);
+    }
+  }
+}
+
+template <typename T>
+void detector<T>::cascade_fprop(uint scale, state<T> &in, state<T> &out) {
+  if (cascade_alive.size() <= scale) cascade_alive.resize(scales.size());
+  cascade_alive[scale] = idx<ubyte>();
+  cascade_front->fprop(in, cascade_mid);
+  idx<T> &mid = cascade_mid.x[0];
+  intg mh = mid.dim(1), mw = mid.dim(2);
+  intg fh = cascade_field.dim(1), fw = cascade_field.dim(2);
+  intg sh = cascade_stride.dim(1), sw = cascade_stride.dim(2);
+  if (mh < fh || mw < fw) { // too small for any window, let the net handle it
+    cascade_back->fprop(cascade_mid, out);
+    return ;
+  }
+  intg oh = (mh - fh) / sh + 1, ow = (mw - fw) / sw + 1;
+  // integral image of locations surviving the rejection
+  idx<T> score(mh, mw);
+  cascade_score(mid, score);
+  idx<intg> sum(mh + 1, mw + 1);
+  idx_clear(sum);
+  for (intg y = 0; y < mh; ++y)
+    for (intg x = 0; x < mw; ++x)
+      sum.set(sum.get(y, x + 1) + sum.get(y + 1, x) - sum.get(y, x)
+              + (score.get(y, x) >= cascade_threshold ? 1 : 0), y + 1, x + 1);
+  // an output survives if its receptive field contains a survivor
+  idx<ubyte> alive(oh, ow);
+  intg nalive = 0;
+  for (intg y = 0; y < oh; ++y)
+    for (intg x = 0; x < ow; ++x) {
+      intg y0 = y * sh, x0 = x * sw, y1 = y0 + fh, x1 = x0 + fw;
+      bool a = sum.get(y1, x1) - sum.get(y0, x1) - sum.get(y1, x0)
+	+ sum.get(y0, x0) > 0;
+      alive.set(a ? 1 : 0, y, x);
+      if (a) nalive++;
+    }
+  cascade_total += oh * ow;
+  // too many survivors, compute everything at once
+  if (nalive > cascade_dense * oh * ow) {
+    cascade_evaluated += oh * ow;
+    cascade_back->fprop(cascade_mid, out);
+    return ;
+  }
+  // number of output features, from a single window the first time
+  if (cascade_nout == 0) {
+    state<T> win = cascade_mid.narrow_state(1, fh, 0).narrow_state(2, fw, 0);
+    cascade_back->fprop(win, sparse_buf);
+    cascade_nout = sparse_buf.x[0].dim(0);
+    cascade_reject_bg = init_cascade_reject(cascade_nout);
+  }
+  intg nout = cascade_nout;
+  idxdim od(nout, oh, ow);
+  out.resize_forward_orders(cascade_mid, 1, 1);
+  idx<T> &o = out.x[0];
+  if (o.get_idxdim() != od) o.resize(od);
+  // rejected outputs are background, or ignored when extracting boxes
+  for (intg k = 0; k < nout; ++k) {
+    idx<T> ok = o.select(0, k);
+    idx_fill(ok, cascade_reject.get(k));
+  }
+  if (!cascade_reject_bg) cascade_alive[scale] = alive;
+  // compute survivors only
+  cascade_evaluated +=
+    sparse_fprop(*cascade_back, cascade_mid, alive, cascade_field,
+                 cascade_stride, o);
+}
+
+template <typename T>
+bool detector<T>::init_cascade_reject(intg nout) {
+  cascade_reject = idx<T>(nout);
+  class_answer<T,T,T> *ca = dynamic_cast<class_answer<T,T,T>*>(answer);
+  if (ca && bgclass >= 0) {
+    idx<T> bg = ca->get_target((T) bgclass);
+    if (bg.order() == 1 && bg.dim(0) == nout) {
+      idx_copy(bg, cascade_reject);
+      return true;
+    }
+  }
+  if (ca) {
+    idx<T> t = ca->get_target((T) 0);
+    idx_fill(cascade_reject, idx_min(t));
+  } else
+    idx_clear(cascade_reject);
+  eblwarn("no background target for rejected cascade outputs, they will be "
+          << "ignored when extracting bounding boxes");
+  return false;
+}
+
+template <typename T>
+void detector<T>::incremental_prepare() {
+  incr_full = true;
+  if (!incr_on) return ;
+  bool refresh = incr_refresh > 0 && incr_frame % incr_refresh == 0;
+  incr_frame++;
+  if (!refresh && incr_outputs.size() == scales.size())
+    incr_full = false;
+  if (incr_outputs.size() != scales.size()) {
+    incr_outputs.clear();
+    for (uint i = 0; i < scales.size(); ++i)
+      incr_outputs.push_back(new state<T>());
+    incr_prev.clear();
+    incr_prev.resize(scales.size());
+  }
+}
+
+template <typename T>
+void detector<T>::incremental_activate(idx<ubyte> &active, double y0,
+                                       double x0, double y1, double x1) {
+  intg oh = active.dim(0), ow = active.dim(1);
+  intg fh = pp_field.dim(1), fw = pp_field.dim(2);
+  intg sh = pp_stride.dim(1), sw = pp_stride.dim(2);
+  // outputs whose field [o * s, o * s + f) overlaps [y0, y1) x [x0, x1)
+  intg oy0 = std::max((intg) 0, (intg) floor((y0 - fh) / sh) + 1);
+  intg oy1 = std::min(oh - 1, (intg) ceil(y1 / sh) - 1);
+  intg ox0 = std::max((intg) 0, (intg) floor((x0 - fw) / sw) + 1);
+  intg ox1 = std::min(ow - 1, (intg) ceil(x1 / sw) - 1);
+  for (intg y = oy0; y <= oy1; ++y)
+    for (intg x = ox0; x <= ox1; ++x)
+      active.set(1, y, x);
+}
+
+template <typename T>
+void detector<T>::incremental_fprop(uint i, state<T> &in, state<T> &out) {
+  pp_front->fprop(in, incr_pp);
+  state<T> &cache = incr_outputs[i];
+  idx<T> &pp = incr_pp.x[0];
+  idx<T> &prev = incr_prev[i];
+  if (incr_full || prev.order() != pp.order()
+      || prev.get_idxdim() != pp.get_idxdim()) {
+    pp_back->fprop(incr_pp, cache);
+    intg n = cache.x[0].dim(1) * cache.x[0].dim(2);
+    incr_total += n;
+    incr_evaluated += n;
+  } else {
+    idx<T> &o = cache.x[0];
+    intg oh = o.dim(1), ow = o.dim(2);
+    idx<ubyte> active(oh, ow);
+    idx_clear(active);
+    // blocks of preprocessed inputs with a change beyond tolerance
+    intg h = pp.dim(1), w = pp.dim(2), b = incr_block;
+    for (intg y0 = 0; y0 < h; y0 += b)
+      for (intg x0 = 0; x0 < w; x0 += b) {
+	intg bh = std::min(b, h - y0), bw = std::min(b, w - x0);
+	idx<T> cur = pp.narrow(1, bh, y0).narrow(2, bw, x0);
+	idx<T> old = prev.narrow(1, bh, y0).narrow(2, bw, x0);
+	bool changed = false;
+	idx_aloop2(c, cur, T, p, old, T) {
+	  if (fabs((double) *c - (double) *p) > incr_tolerance) {
+	    changed = true;
+	    break ;
+	  }
+	}
+	if (changed) incremental_activate(active, y0, x0, y0 + bh, x0 + bw);
+      }
+    // regions forced to recompute, from input to preprocessed coordinates
+    rect<int> ob = resizepp->get_original_bbox();
+    double hr = ob.height / (double) indim.dim(1);
+    double wr = ob.width / (double) indim.dim(2);
+    for (uint j = 0; j < incr_dirty.size(); ++j) {
+      rect<float> &r = incr_dirty[j];
+      incremental_activate(active, ob.h0 + r.h0 * hr, ob.w0 + r.w0 * wr,
+			   ob.h0 + (r.h0 + r.height) * hr,
+			   ob.w0 + (r.w0 + r.width) * wr);
+    }
+    incr_total += oh * ow;
+    incr_evaluated +=
+      sparse_fprop(*pp_back, incr_pp, active, pp_field, pp_stride, o);
+  }
+  // remember preprocessed inputs for next frame
+  if (prev.order() != pp.order()) prev = idx<T>(pp.get_idxdim());
+  else if (prev.get_idxdim() != pp.get_idxdim()) prev.resize(pp.get_idxdim());
+  idx_copy(pp, prev);
+  // outputs may be modified later (smoothing, thresholding), copy them
+  idx<T> &c = cache.x[0];
+  out.resize_forward_orders(cache, 1, 1);
+  idx<T> &o = out.x[0];
+  if (o.get_idxdim() != c.get_idxdim()) o.resize(c.get_idxdim());
+  idx_copy(c, o);
+}
+
 template <typename T>
 void detector<T>::multi_res_fprop() {
   // timing
-  timer t;
+  timer t, tstage;
   t.start();
+  tstage.start();
+  incremental_prepare();
+  timing.prepare += tstage.elapsed_microseconds() / 1e6;
+  cascade_alive.clear();
   for (uint i = 0; i < scales.size(); ++i) {
+    tstage.restart();
     prepare_scale(i);
     *input = image; // put image in input state
     // keep a copy of preprocess' output if displaying
@@ -1680,8 +2343,17 @@ void detector<T>::multi_res_fprop() {
     // fprop
     state<T> &out = outputs[i];
     //      thenet.dump_fprop(*input, out);
-    thenet.fprop(*input, out);
-    get_corners(out, i, true);
+    if (incr_on) incremental_fprop(i, *input, out);
+    else if (cascade_back) cascade_fprop(i, *input, out);
+    else if (stage_timing && pp_back) { // same as thenet, timed in 2 halves
+      pp_front->fprop(*input, stage_pp);
+      timing.pyramid += tstage.elapsed_microseconds() / 1e6;
+      tstage.restart();
+      pp_back->fprop(stage_pp, out);
+    } else thenet.fprop(*input, out);
+    // corners only depend on the input size, infer them once per plan
+    get_corners(out, i, !plan_corners_ready);
+    timing.fprop += tstage.elapsed_microseconds() / 1e6;
     EDEBUG_MAT("detector outputs:", out);
     // outputs dumping
     if (!outputs_dump.empty()) {
@@ -1719,6 +2391,8 @@ void detector<T>::multi_res_fprop() {
       // output = tmp;
     }
   }
+  if (plan_cache_size > 0) plan_corners_ready = true;
+  incr_dirty.clear();
   if (!silent) eblprinto(mout, "net_processing=" << t.elapsed_ms() << std::endl);
 }
 
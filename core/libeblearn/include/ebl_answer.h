@@ -160,6 +160,12 @@ class class_answer : public answer_module<T,Tds1,Tds2> {
   //! Returns the target corresponding to 'label' found in this module.
   virtual idx<T> get_target(const Tds2 &label);
 
+ protected:
+  //! Sets the class and confidence 'oo' of the features 'ii' of 1 pixel,
+  //! given the view 'vt' of the targets (1 target per row).
+  void answer_pixel(idx_view<T,1> &ii, idx_view<T,1> &oo,
+                    const idx_view<T,2> &vt);
+
   // members
  protected:
   idx<T>	 targets;               //!< The targets for training.
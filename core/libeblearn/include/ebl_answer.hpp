@@ -228,64 +228,19 @@ void class_answer<T,Tds1,Tds2>::fprop1(idx<T> &in, idx<T> &out) {
     mtanh.fprop1(in, tmp);
     inx = tmp;
   }
-  // loop on features (dimension 0) to set class and confidence
-  int classid;
-  T conf, max2;
-  idx_1loop2(ii, inx, T, oo, outx, T, {
-      if (binary_target) {
-        T t0 = targets.gget(0);
-        T t1 = targets.gget(1);
-        T a = ii.gget();
-        if (std::fabs((double) a - t0) < std::fabs((double) a - t1)) {
-          oo.set((T) 0, 0); // class 0
-          oo.set((T) (2 - std::fabs((double) a - t0)) / 2, 1); // conf
-        } else {
-          oo.set((T) 1, 0); // class 1
-          oo.set((T) (2 - std::fabs((double) a - t1)) / 2, 1); // conf
-        }
-      } else if (single_output >= 0) {
-        oo.set((T) single_output, 0); // all answers are the same class
-        oo.set((T) ((ii.get(single_output) - target_min) / target_range), 1);
-      } else { // 1-of-n target
-        // set class answer
-        if (force_class >= 0) classid = force_class;
-        else classid = idx_indexmax(ii);
-        oo.set((T) classid, 0);
-        // set confidence
-        intg p;
-        bool ini = false;
-        switch (conf_type) {
-	  case confidence_sqrdist: // squared distance to target
-	    target = targets.select(0, classid);
-	    conf = (T) (1.0 - ((idx_sqrdist(target, ii) - conf_shift)
-			       / conf_ratio));
-	    oo.set(conf, 1);
-	    break ;
-	  case confidence_single: // simply return class' out (normalized)
-	    conf = (T) ((ii.get(classid) - conf_shift) / conf_ratio);
-	    oo.set(conf, 1);
-	    break ;
-	  case confidence_max: // distance with 2nd max answer
-	    conf = std::max(target_min, std::min(target_max, ii.get(classid)));
-	    for (p = 0; p < ii.dim(0); ++p) {
-	      if (p != classid) {
-		if (!ini) {
-		  max2 = ii.get(p);
-		  ini = true;
-		} else {
-		  if (ii.get(p) > max2)
-		    max2 = ii.get(p);
-		}
-	      }
-	    }
-	    max2 = std::max(target_min, std::min(target_max, max2));
-	    oo.set((T) (((conf - max2) - conf_shift) / conf_ratio), 1);
-	    break ;
-	  default:
-	    eblerror("confidence type " << conf_type << " undefined");
-        }
-      }
-    });
+  // loop on pixels with stack-allocated views of their features
+  // (dimension 0), avoiding an idx and its refcounting per pixel
+  if (inx.order() < 1 || inx.order() > 3)
+    eblerror("order " << inx.order() << " not implemented");
+  idx<T> tflat = binary_target ? targets.flat() : targets;
+  idx_view<T,2> vt(tflat);
+  idx_view<T,3> vin = idx_view<T,3>(inx).transpose(0, 2);
+  idx_view<T,3> vout = idx_view<T,3>(outx).transpose(0, 2);
+  idxv_bloop2(iw, vin, T, 3, ow, vout, T, 3) {
+    idxv_bloop2(ii, iw, T, 2, oo, ow, T, 2) {
+      answer_pixel(ii, oo, vt);
+    }
+  }
   // // confidence smoothing
   // idx<T> c = outx.select(0, 1);
   // uint hpad = (uint) (smoothing_kernel.dim(0) / 2);
@@ -311,6 +266,64 @@ void class_answer<T,Tds1,Tds2>::fprop1(idx<T> &in, idx<T> &out) {
 #endif
 }
 
+template <typename T, typename Tds1, typename Tds2>
+void class_answer<T,Tds1,Tds2>::
+answer_pixel(idx_view<T,1> &ii, idx_view<T,1> &oo, const idx_view<T,2> &vt) {
+  intg n = ii.dim(0);
+  if (binary_target) {
+    T t0 = vt(0, 0), t1 = vt(1, 0);
+    T a = ii(0);
+    if (std::fabs((double) a - t0) < std::fabs((double) a - t1)) {
+      oo(0) = (T) 0; // class 0
+      oo(1) = (T) (2 - std::fabs((double) a - t0)) / 2; // conf
+    } else {
+      oo(0) = (T) 1; // class 1
+      oo(1) = (T) (2 - std::fabs((double) a - t1)) / 2; // conf
+    }
+  } else if (single_output >= 0) {
+    oo(0) = (T) single_output; // all answers are the same class
+    oo(1) = (T) ((ii(single_output) - target_min) / target_range);
+  } else { // 1-of-n target
+    // set class answer
+    intg classid = 0;
+    if (force_class >= 0) classid = force_class;
+    else { // index of (first) max
+      for (intg p = 1; p < n; ++p)
+        if (ii(p) > ii(classid)) classid = p;
+    }
+    oo(0) = (T) classid;
+    // set confidence
+    float64 d, dist = 0;
+    T conf, max2 = 0;
+    bool ini = false;
+    switch (conf_type) {
+      case confidence_sqrdist: // squared distance to target
+	for (intg p = 0; p < n; ++p) {
+	  d = (float64) vt(classid, p) - (float64) ii(p);
+	  dist += d * d;
+	}
+	oo(1) = (T) (1.0 - ((dist - conf_shift) / conf_ratio));
+	break ;
+      case confidence_single: // simply return class' out (normalized)
+	oo(1) = (T) ((ii(classid) - conf_shift) / conf_ratio);
+	break ;
+      case confidence_max: // distance with 2nd max answer
+	conf = std::max(target_min, std::min(target_max, ii(classid)));
+	for (intg p = 0; p < n; ++p) {
+	  if (p != classid && (!ini || ii(p) > max2)) {
+	    max2 = ii(p);
+	    ini = true;
+	  }
+	}
+	max2 = std::max(target_min, std::min(target_max, max2));
+	oo(1) = (T) (((conf - max2) - conf_shift) / conf_ratio);
+	break ;
+      default:
+	eblerror("confidence type " << conf_type << " undefined");
+    }
+  }
+}
+
 template <typename T, typename Tds1, typename Tds2>
 void class_answer<T,Tds1,Tds2>::
 fprop_ds2(labeled_datasource<T,Tds1,Tds2> &ds, state<T> &out) {
@@ -37,6 +37,7 @@
 #include "ebl_defines.h"
 #include "ebl_module.h"
 #include "ebl_parameters.h"
+#include "ebl_profiler.h"
 
 #ifndef __NOSTL__
 #include <vector>
@@ -128,6 +129,8 @@ template <typename T> class layers : public module_1_1<T> {
   //! Returns a deep copy of current module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Swap the dual buffers used for memory optimization.
   virtual void swap_buffers();
   //! Return the number of layers contained in this object.
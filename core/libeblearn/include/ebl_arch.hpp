@@ -227,6 +227,12 @@ module_1_1<T>* layers<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) l2;
 }
 
+template <typename T>
+void layers<T>::get_weights(std::vector<state<T>*> &states) {
+  for (uint i = 0; i < modules.size(); ++i)
+    modules[i]->get_weights(states);
+}
+
 template <typename T>
 void layers<T>::swap_buffers() {
   htmp = hi;
@@ -381,11 +387,14 @@ void layers<T>::forward(state<T>& in, state<T>& out, fprop_type fp) {
     // run module
     module_1_1<T> *mod = modules[i];
     EDEBUG_MAT(mod->name() << ": in", *hi);
-    switch (fp) {
-      case T_FPROP1: mod->fprop1(*hi, *ho); break ;
-      case T_FPROP: mod->fprop(*hi, *ho); break ;
-      case T_FPROP_DUMP: mod->fprop_dump(*hi, *ho); break ;
-      default: eblerror("unknown type");
+    { // record this call when profiling
+      profile_scope<T> prof(mod, this, PROF_FPROP, *hi, *ho);
+      switch (fp) {
+        case T_FPROP1: mod->fprop1(*hi, *ho); break ;
+        case T_FPROP: mod->fprop(*hi, *ho); break ;
+        case T_FPROP_DUMP: mod->fprop_dump(*hi, *ho); break ;
+        default: eblerror("unknown type");
+      }
     }
     EDEBUG_MAT(mod->name() << ": out", *ho);
     hi = ho;
@@ -419,10 +428,13 @@ void layers<T>::backward(state<T>& in, state<T>& out, bprop_type bp) {
     // run module
     module_1_1<T> *mod = modules[i];
     EDEBUG_MAT(mod->name() << ": ho.dx ", ho->dx[0]);
-    switch (bp) {
-      case T_BPROP1: mod->bprop1(*hi, *ho); break ;
-      case T_BPROP: mod->bprop(*hi, *ho); break ;
-      default: eblerror("unknown type");
+    { // record this call when profiling
+      profile_scope<T> prof(mod, this, PROF_BPROP, *hi, *ho);
+      switch (bp) {
+        case T_BPROP1: mod->bprop1(*hi, *ho); break ;
+        case T_BPROP: mod->bprop(*hi, *ho); break ;
+        default: eblerror("unknown type");
+      }
     }
     EDEBUG_MAT(mod->name() << ": hi.dx ", hi->dx[0]);
     ho = hi;
@@ -451,10 +463,13 @@ void layers<T>::bbackward(state<T>& in, state<T>& out, bprop_type bp) {
     // run module
     module_1_1<T> *mod = modules[i];
     EDEBUG_MAT(mod->name() << ": ho.ddx ", ho->ddx[0]);
-    switch (bp) {
-      case T_BPROP1: mod->bbprop1(*hi, *ho); break ;
-      case T_BPROP: mod->bbprop(*hi, *ho); break ;
-      default: eblerror("unknown type");
+    { // record this call when profiling
+      profile_scope<T> prof(mod, this, PROF_BBPROP, *hi, *ho);
+      switch (bp) {
+        case T_BPROP1: mod->bbprop1(*hi, *ho); break ;
+        case T_BPROP: mod->bbprop(*hi, *ho); break ;
+        default: eblerror("unknown type");
+      }
     }
     EDEBUG_MAT(mod->name() << ": hi.ddx ", hi->ddx[0]);
     // shift output pointer to input
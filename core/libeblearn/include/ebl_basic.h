@@ -84,11 +84,15 @@ template <typename T> class linear_module: public module_1_1<T> {
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
   //! Copy passed weights into x component of internal weights.
   virtual void load_x(idx<T> &weights);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
   //! Calls fprop and then dumps internal buffers, inputs and outputs
   //! into files. This can be useful for debugging.
   virtual void fprop1_dump(idx<T> &in, idx<T> &out);
+  //! Returns 2 operations per weight for each output vector.
+  virtual double fprop_flops(state<T> &in, state<T> &out);
 
   // members
  public:
@@ -117,6 +121,72 @@ DECLARE_REPLICABLE_MODULE_1_1(linear_module_replicable,
 
 // convolution_module //////////////////////////////////////////////////////////
 
+//! Forward pass of convolution_module split into one piece per output map
+//! for the library-wide thread_pool. Each piece accumulates the connections
+//! of its output in table order, i.e. exactly like the serial version.
+//! 5x5, 7x7 and 9x9 kernels with a 1x1 stride use the fixed-size kernels
+//! of idxconv.h, other shapes the generic idx_m4dotm2acc.
+//! The views of each piece are kept between calls and only rebuilt when
+//! the operands change, i.e. once per input size.
+template <typename T> class convolution_fprop_task : public parallel_task {
+ public:
+  convolution_fprop_task();
+  virtual ~convolution_fprop_task();
+  //! Prepare pieces, rebuilding views only if an operand changed.
+  //! \param uuin Unfolded input (read).
+  //! \param kx Kernel weights (read).
+  //! \param out Output (written).
+  void set(idx<T> &uuin, idx<T> &kx, idx<T> &out, idx<intg> &table);
+  //! Returns the number of pieces.
+  virtual intg size();
+  //! Execute piece 'i'.
+  virtual void run(intg i);
+ protected:
+  svector<idx<T> > suin, sout, lk;
+  std::vector<std::vector<intg> > conns; //!< Connections of each output.
+  std::vector<intg> inputs; //!< Input of each connection.
+  idx<T> cuuin, ckx, cout; //!< Operands the views were built for.
+  idx<intg> ctable; //!< Table the views were built for.
+};
+
+//! Backward pass of convolution_module split into independent pieces for
+//! the library-wide thread_pool. Pieces [0, ninputs) each backpropagate
+//! into one input map, accumulating its connections in table order, and
+//! the remaining pieces each compute the gradient of one kernel. Results
+//! are thus identical to the serial version for any number of threads.
+//! As for the forward pass, common kernel shapes use fixed-size kernels
+//! and views are only rebuilt when the operands change.
+template <typename T> class convolution_bprop_task : public parallel_task {
+ public:
+  //! \param squ If true, use squared operations (bbprop).
+  convolution_bprop_task(bool squ);
+  virtual ~convolution_bprop_task();
+  //! Prepare pieces, rebuilding views only if an operand changed.
+  //! \param uuin Unfolded input gradient (written).
+  //! \param borp Transposed unfolded input (read).
+  //! \param outd Output gradient (read).
+  //! \param kd Kernel gradient (written).
+  //! \param kx Kernel weights, or one reversed kernel for IPP (read).
+  void set(idx<T> &uuin, idx<T> &borp, idx<T> &outd, idx<T> &kd,
+           idx<T> &kx, idx<intg> &table);
+  //! Returns the number of pieces.
+  virtual intg size();
+  //! Execute piece 'i'.
+  virtual void run(intg i);
+ protected:
+  bool squ;
+  intg ninputs;
+  svector<idx<T> > suin, sborp, sout, lk, lkx;
+  std::vector<std::vector<intg> > conns; //!< Connections of each input.
+  std::vector<intg> inputs; //!< Input of each connection.
+  idx<T> cuuin, cborp, coutd, ckd, ckx; //!< Operands the views were built for.
+  idx<intg> ctable; //!< Table the views were built for.
+};
+
+//! Returns true if 'a' and 'b' are views of the same data with the same
+//! layout (storage, offset, dimensions and strides).
+template <typename T> bool same_view(idx<T> &a, idx<T> &b);
+
 /**
  * This module applies 2D convolutions on dimensions 1 and 2
  * (0 contains different layers of information).
@@ -173,11 +243,15 @@ template <typename T> class convolution_module : public module_1_1<T> {
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
   //! Copy passed weights into x component of internal weights.
   virtual void load_x(idx<T> &weights);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
   //! Calls fprop and then dumps internal buffers, inputs and outputs
   //! into files. This can be useful for debugging.
   virtual void fprop1_dump(idx<T> &in, idx<T> &out);
+  //! Returns 2 operations per kernel coefficient for each output location.
+  virtual double fprop_flops(state<T> &in, state<T> &out);
 
   // members /////////////////////////////////////////////////////////////////
  public:
@@ -198,6 +272,9 @@ template <typename T> class convolution_module : public module_1_1<T> {
   idx<T>    outtmp;            //!< a tmp buffer for IPP conv output
   bool      ipp_err_printed;   //!< Print an error msg only once.
   bool      use_ipp;           //!< IPP is useable or not.
+  // parallel jobs, kept to reuse their views ////////////////////////////////
+  convolution_fprop_task<T> fprop_job;
+  convolution_bprop_task<T> bprop_job, bbprop_job;
 };
 
 //! The replicable version of convolution_module.
@@ -245,6 +322,8 @@ class addc_module: public module_1_1<T> {
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
   //! Copy passed weights into x component of internal weights.
   virtual void load_x(idx<T> &weights);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
   //! Calls fprop and then dumps internal buffers, inputs and outputs
@@ -588,6 +667,8 @@ template <typename T> class diag_module : public module_1_1<T> {
   virtual bool resize_output(idx<T> &in, idx<T> &out, idxdim *ignore = NULL);
   //! Copy passed weights into x component of internal weights.
   virtual void load_x(idx<T> &weights);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
   //! Returns a deep copy of this module.
@@ -690,6 +771,8 @@ template <typename T> class dropout_module : module_1_1<T> {
 
  protected:
   idx<ubyte>		keep;						//!< Binary map of kept inputs.
+  idx<float>		draws;					//!< Uniform draws deciding 'keep'.
+  philox_stream gen;						//!< Own stream of random numbers.
   double				drop_proba; 		//!< Probability of dropping input.
   bool          test_time;
 };
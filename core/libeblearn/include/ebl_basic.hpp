@@ -133,6 +133,11 @@ module_1_1<T>* linear_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*)l2;
 }
 
+template <typename T>
+void linear_module<T>::get_weights(std::vector<state<T>*> &states) {
+  states.push_back(&w);
+}
+
 template <typename T>
 void linear_module<T>::load_x(idx<T> &weights) {
   if (!w.same_dim(weights)) {
@@ -172,6 +177,133 @@ void linear_module<T>::fprop1_dump(idx<T> &in, idx<T> &out) {
   DUMP(w.x[0], this->name() << "_linear_module_weights");
 }
 
+template <typename T>
+double linear_module<T>::fprop_flops(state<T> &in, state<T> &out) {
+  return module_1_1<T>::fprop_flops(in, out) * 2 * w.dim(1);
+}
+
+// convolution_fprop_task /////////////////////////////////////////////////////
+
+template <typename T> bool same_view(idx<T> &a, idx<T> &b) {
+  if (a.getstorage() != b.getstorage() || a.offset() != b.offset()
+      || a.order() != b.order())
+    return false;
+  for (int i = 0; i < a.order(); ++i)
+    if (a.dim(i) != b.dim(i) || a.mod(i) != b.mod(i))
+      return false;
+  return true;
+}
+
+template <typename T>
+convolution_fprop_task<T>::convolution_fprop_task() {
+}
+
+template <typename T>
+convolution_fprop_task<T>::~convolution_fprop_task() {
+}
+
+template <typename T>
+void convolution_fprop_task<T>::set(idx<T> &uuin, idx<T> &kx, idx<T> &out,
+                                    idx<intg> &table) {
+  if (same_view(uuin, cuuin) && same_view(kx, ckx) && same_view(out, cout)
+      && same_view(table, ctable))
+    return ;
+  cuuin = uuin; ckx = kx; cout = out; ctable = table;
+  // build all views here, workers only use them
+  suin.clear(); sout.clear(); lk.clear(); inputs.clear();
+  conns.assign(out.dim(0), std::vector<intg>());
+  for (intg i = 0; i < uuin.dim(0); ++i)
+    suin.push_back(new idx<T>(uuin.select(0, i)));
+  for (intg i = 0; i < out.dim(0); ++i)
+    sout.push_back(new idx<T>(out.select(0, i)));
+  { idx_bloop2 (lt, table, intg, lkx, kx, T) {
+      conns[lt.get(1)].push_back((intg) inputs.size());
+      inputs.push_back(lt.get(0));
+      lk.push_back(new idx<T>(lkx));
+    }}
+}
+
+template <typename T>
+intg convolution_fprop_task<T>::size() {
+  return (intg) conns.size();
+}
+
+template <typename T>
+void convolution_fprop_task<T>::run(intg i) {
+  std::vector<intg> &c = conns[i];
+  for (uint j = 0; j < c.size(); ++j) { // 2D convolution
+    idx<T> &in = suin[inputs[c[j]]];
+    // fixed-size kernels for common shapes, generic version otherwise
+    if (!idx_conv_fprop_acc(in, lk[c[j]], sout[i]))
+      idx_m4dotm2acc(in, lk[c[j]], sout[i]);
+  }
+}
+
+// convolution_bprop_task /////////////////////////////////////////////////////
+
+template <typename T>
+convolution_bprop_task<T>::convolution_bprop_task(bool squ_)
+    : squ(squ_), ninputs(0) {
+}
+
+template <typename T>
+convolution_bprop_task<T>::~convolution_bprop_task() {
+}
+
+template <typename T>
+void convolution_bprop_task<T>::set(idx<T> &uuin, idx<T> &borp, idx<T> &outd,
+                                    idx<T> &kd, idx<T> &kx,
+                                    idx<intg> &table) {
+  if (same_view(uuin, cuuin) && same_view(borp, cborp)
+      && same_view(outd, coutd) && same_view(kd, ckd) && same_view(kx, ckx)
+      && same_view(table, ctable))
+    return ;
+  cuuin = uuin; cborp = borp; coutd = outd; ckd = kd; ckx = kx;
+  ctable = table;
+  // build all views here, workers only use them
+  ninputs = uuin.dim(0);
+  suin.clear(); sborp.clear(); sout.clear(); lk.clear(); lkx.clear();
+  inputs.clear();
+  conns.assign(ninputs, std::vector<intg>());
+  for (intg i = 0; i < ninputs; ++i) {
+    suin.push_back(new idx<T>(uuin.select(0, i)));
+    sborp.push_back(new idx<T>(borp.select(0, i)));
+  }
+  { idx_bloop2 (lt, table, intg, lkd, kd, T) {
+      intg e = (intg) inputs.size();
+      inputs.push_back(lt.get(0));
+      conns[lt.get(0)].push_back(e);
+      sout.push_back(new idx<T>(outd.select(0, lt.get(1))));
+      lk.push_back(new idx<T>(lkd));
+      if (kx.order() == 2) // a single (reversed) kernel for all connections
+        lkx.push_back(new idx<T>(kx));
+      else
+        lkx.push_back(new idx<T>(kx.select(0, e)));
+    }}
+}
+
+template <typename T>
+intg convolution_bprop_task<T>::size() {
+  return ninputs + (intg) inputs.size();
+}
+
+template <typename T>
+void convolution_bprop_task<T>::run(intg i) {
+  if (i < ninputs) { // backward convolution into input map i
+    std::vector<intg> &c = conns[i];
+    for (uint j = 0; j < c.size(); ++j) {
+      if (idx_conv_bprop_acc(sout[c[j]], lkx[c[j]], suin[i], squ)) continue;
+      if (squ) idx_m2squextm2acc(sout[c[j]], lkx[c[j]], suin[i]);
+      else idx_m2extm2acc(sout[c[j]], lkx[c[j]], suin[i]);
+    }
+  } else { // gradient of kernel e
+    intg e = i - ninputs;
+    if (idx_conv_kgrad_acc(sborp[inputs[e]], sout[e], lk[e], squ)) return;
+    if (squ) idx_m4squdotm2acc(sborp[inputs[e]], sout[e], lk[e]);
+    else idx_m4dotm2acc(sborp[inputs[e]], sout[e], lk[e]);
+  }
+}
+
 // convolution_module //////////////////////////////////////////////////////////
 
 template <typename T>
@@ -180,7 +312,7 @@ convolution_module(parameter<T> *p, idxdim &ker_, idxdim &stride_,
                    idx<intg> &tbl, const char *name_, bool crop_)
     : module_1_1<T>(name_), ker(ker_), stride(stride_), table(tbl),
       warnings_shown(false), float_precision(false), double_precision(false),
-      crop(crop_), use_ipp(false)  {
+      crop(crop_), use_ipp(false), bprop_job(false), bbprop_job(true) {
   this->default_name("convolution");
   idxdim d(ker);
   d.insert_dim(0, tbl.dim(0));
@@ -266,47 +398,16 @@ void convolution_module<T>::fprop1(idx<T> &in, idx<T> &out) {
 #ifdef __TH__
   // a direct 3D-map optimization
   if((float_precision || double_precision) && in.order()==3) {
-#ifdef __OPENMP__
-    svector< idx<T> > lk_list, suin_list, sout_list;
-    svector<idx<T> > outtmp_list;
-    std::vector< idx<intg> > lt_list;
-    idx_bloop2(lk, kernel, T, lt, table, intg) {
-      lk_list.push_back(new idx<T>(lk));
-      lt_list.push_back(lt);
-      suin_list.push_back(new idx<T>(in.select(0, lt.get(0))));
-      sout_list.push_back(new idx<T>((out).select(0, lt.get(1))));
-      // need own outtmp variable for parallelization
-      outtmp_list.push_back(new idx<T>(outtmp.get_idxdim()));
-    }
-    intg i;
-    intg num_outputs = lk_list.size();
-#pragma omp parallel for private(i)
-    for ( i = 0; i < num_outputs; ++i) {
-      // 2D convolution
-      th_convolution(suin_list[i], lk_list[i], outtmp_list[i],
-                     stride.dim(0), stride.dim(1));
-    } // end of for loop
-#pragma omp parallel for private(i)
-    for ( i = 0; i < out.dim(0); ++i) {
-      for(int j=0; j < lt_list.size(); j++) {
-        if(lt_list[j].get(1) == i)
-          th_add(outtmp_list[i],sout_list[i]);
-      }
-    }
-#else
     th_convolution_3dmap(in, kernel, out, table, stride.dim(0), stride.dim(1));
-#endif // endif __OPENMP__
     return;
   }
   else {
     // unfolding input for a faster convolution operation
     idx<T> uuin(in.unfold(1, kernel.dim(1), stride.dim(0)));
     uuin = uuin.unfold(2, kernel.dim(2), stride.dim(1));
-    idx_bloop2(lk, kernel, T, lt, table, intg) {
-      idx<T> sout((out).select(0, lt.get(1)));
-      idx<T> suin(uuin.select(0, lt.get(0)));
-      idx_m4dotm2acc(suin, lk, sout); // 2D convolution
-    }
+    idx<T> kx = kernel;
+    fprop_job.set(uuin, kx, out, table);
+    parallel_run(fprop_job, fprop_job.size());
     return;
   }
 #endif // endif __TH__
@@ -316,26 +417,26 @@ void convolution_module<T>::fprop1(idx<T> &in, idx<T> &out) {
   idx<T> uuin(in.unfold(1, kernel.dim(1), stride.dim(0)));
   uuin = uuin.unfold(2, kernel.dim(2), stride.dim(1));
   idx_clear(out);
-  // convolve 2D slice for each convolution kernel
-  { idx_bloop2(lk, kernel, T, lt, table, intg) {
-      idx<T> sout((out).select(0, lt.get(1)));
 #ifdef __IPP__
-      if (float_precision && use_ipp) {
+  if (float_precision && use_ipp) {
+    // convolve 2D slice for each convolution kernel
+    { idx_bloop2(lk, kernel, T, lt, table, intg) {
+        idx<T> sout((out).select(0, lt.get(1)));
         rev_idx2_tr(lk, revkernel);
         //		idx_clear(outtmp);
         idx<T> suin(in.select(0, lt.get(0)));
         ipp_convolution(suin, revkernel, outtmp);
         ipp_add(outtmp, sout);
-      } else { // not using IPP
-        idx<T> suin(uuin.select(0, lt.get(0)));
-        idx_m4dotm2acc(suin, lk, sout); // 2D convolution
       }
-#else
-      idx<T> suin(uuin.select(0, lt.get(0)));
-      idx_m4dotm2acc(suin, lk, sout); // 2D convolution
-#endif //endif __IPP__
     }
+    LOCAL_TIMING_REPORT("convcpu total time");
+    return ;
   }
+#endif //endif __IPP__
+  // convolve 2D slices of each output, in parallel
+  idx<T> kx = kernel;
+  fprop_job.set(uuin, kx, out, table);
+  parallel_run(fprop_job, fprop_job.size());
   LOCAL_TIMING_REPORT("convcpu total time");
 }
 
@@ -373,16 +474,9 @@ void convolution_module<T>::bprop1(state<T> &in, state<T> &out) {
     uuinf = uuinf.unfold(2, kernel.dx[0].dim(2), stride.dim(1));
     int transp[5] = { 0, 3, 4, 1, 2 };
     idx<T> borp(uuinf.transpose(transp));
-    { idx_bloop3 (lk, kernel.dx[0], T, lkf, kernel, T,
-                  lt, table, intg) {
-        intg islice = lt.get(0);
-        idx<T> suin(uuin.select(0, islice));
-        idx<T> sborp(borp.select(0, islice));
-        idx<T> sout(out.dx[0].select(0, lt.get(1)));
-        idx_m2extm2acc(sout, lkf, suin); // backward convolution
-        idx_m4dotm2acc(sborp, sout, lk); // compute gradient for kernel
-      }
-    }
+    idx<T> kx = kernel;
+    bprop_job.set(uuin, borp, out.dx[0], kernel.dx[0], kx, table);
+    parallel_run(bprop_job, bprop_job.size());
     return;
   }
 #else
@@ -393,23 +487,14 @@ void convolution_module<T>::bprop1(state<T> &in, state<T> &out) {
   uuinf = uuinf.unfold(2, kernel.dx[0].dim(2), stride.dim(1));
   int transp[5] = { 0, 3, 4, 1, 2 };
   idx<T> borp(uuinf.transpose(transp));
-  { idx_bloop3 (lk, kernel.dx[0], T, lkf, kernel, T,
-                lt, table, intg) {
-      intg islice = lt.get(0);
-      idx<T> suin(uuin.select(0, islice));
-      idx<T> sborp(borp.select(0, islice));
-      idx<T> sout(out.dx[0].select(0, lt.get(1)));
+  idx<T> kx = kernel;
 #ifdef __IPP__
-      if (float_precision && use_ipp)
-        idx_m2extm2acc(sout, revkernel, suin); // backward convolution
-      else
-        idx_m2extm2acc(sout, lkf, suin); // backward convolution
-      idx_m4dotm2acc(sborp, sout, lk); // compute gradient for kernel
-#else
-      idx_m2extm2acc(sout, lkf, suin); // backward convolution
-      idx_m4dotm2acc(sborp, sout, lk); // compute gradient for kernel
-#endif //IPP
-    }}
+  if (float_precision && use_ipp)
+    kx = revkernel;
+#endif
+  // backward convolution and kernel gradients, in parallel
+  bprop_job.set(uuin, borp, out.dx[0], kernel.dx[0], kx, table);
+  parallel_run(bprop_job, bprop_job.size());
 #endif //TH
 }
 
@@ -438,24 +523,14 @@ void convolution_module<T>::bbprop1(state<T> &in, state<T> &out) {
   uuinf = uuinf.unfold(2, kernel.ddx[0].dim(2), stride.dim(1));
   int transp[5] = { 0, 3, 4, 1, 2 };
   idx<T> borp(uuinf.transpose(transp));
-  { idx_bloop3 (lk, kernel.ddx[0], T, lkf, kernel, T,
-                lt, table, intg) {
-      intg islice = lt.get(0);
-      idx<T> suin(uuin.select(0, islice));
-      idx<T> sborp(borp.select(0, islice));
-      idx<T> sout((out.ddx[0]).select(0, lt.get(1)));
-
+  idx<T> kx = kernel;
 #ifdef __IPP__
-      if (float_precision && use_ipp)
-        idx_m2squextm2acc(sout, revkernel, suin); // backward convolution
-      else
-        idx_m2squextm2acc(sout, lkf, suin); // backward convolution
-      idx_m4squdotm2acc(sborp, sout, lk); // compute gradient for kernel
-#else
-      idx_m2squextm2acc(sout, lkf, suin); // backward convolution
-      idx_m4squdotm2acc(sborp, sout, lk); // compute gradient for kernel
+  if (float_precision && use_ipp)
+    kx = revkernel;
 #endif
-    }}
+  // backward convolution and kernel gradients, in parallel
+  bbprop_job.set(uuin, borp, out.ddx[0], kernel.ddx[0], kx, table);
+  parallel_run(bbprop_job, bbprop_job.size());
   EDEBUG_MAT(this->name() << ": kernel.ddx ", kernel.ddx[0]);
 }
 
@@ -592,6 +667,11 @@ module_1_1<T>* convolution_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) l2;
 }
 
+template <typename T>
+void convolution_module<T>::get_weights(std::vector<state<T>*> &states) {
+  states.push_back(&kernel);
+}
+
 template <typename T>
 void convolution_module<T>::load_x(idx<T> &weights) {
   if (!kernel.same_dim(weights)) {
@@ -635,6 +715,13 @@ void convolution_module<T>::fprop1_dump(idx<T> &in, idx<T> &out) {
   DUMP(out, this->name() << "_convolution_module_out");
 }
 
+template <typename T>
+double convolution_module<T>::fprop_flops(state<T> &in, state<T> &out) {
+  if (thickness <= 0) return 0;
+  return module_1_1<T>::fprop_flops(in, out) * 2
+    * kernel.nelements() / thickness;
+}
+
 // addc_module /////////////////////////////////////////////////////////////////
 
 template <typename T>
@@ -700,6 +787,11 @@ module_1_1<T>* addc_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) l2;
 }
 
+template <typename T>
+void addc_module<T>::get_weights(std::vector<state<T>*> &states) {
+  states.push_back(&bias);
+}
+
 template <typename T>
 void addc_module<T>::load_x(idx<T> &weights) {
   if (!bias.same_dim(weights)) {
@@ -1554,6 +1646,11 @@ module_1_1<T>* diag_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) d;
 }
 
+template <typename T>
+void diag_module<T>::get_weights(std::vector<state<T>*> &states) {
+  states.push_back(&coeff);
+}
+
 // copy_module /////////////////////////////////////////////////////////////////
 
 template <typename T>
@@ -1772,16 +1869,22 @@ template <typename T>
 void dropout_module<T>::fprop1(idx<T> &in, idx<T> &out) {
   // resize if necessary
   this->resize_output(in, out); // resize (iff necessary)
-  if (!keep.same_dim(in)) keep = idx<ubyte>(in.get_idxdim());
+  if (!keep.same_dim(in)) {
+    keep = idx<ubyte>(in.get_idxdim());
+    draws = idx<float>(in.get_idxdim());
+  }
 
   // during test time, only scale down outputs because
   // less outputs were passed during training
   if (test_time) {
     idx_dotc(in, 1 - drop_proba, out);
   } else {
-    // decide which inputs to keep
-    idx_aloopf1(k, keep, ubyte, {
-        if (drand() > drop_proba) *k = 1; else *k = 0; });
+    // decide which inputs to keep, drawing all numbers at once from this
+    // module's own stream, whatever the other modules running concurrently
+    idx_fill_uniform(draws, 0.0, 1.0, gen.get());
+    float p = (float) drop_proba;
+    idx_aloopf2(k, keep, ubyte, r, draws, float, {
+        if (*r > p) *k = 1; else *k = 0; });
     // copy and multiply by keep flag to output
     idx_mul(in, keep, out);
   }
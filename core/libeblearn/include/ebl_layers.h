@@ -78,6 +78,8 @@ template <typename T> class full_layer : public module_1_1<T> {
   //! Returns a deep copy of this module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
 
@@ -130,6 +132,8 @@ template <typename T> class convolution_layer : public module_1_1<T> {
   //! Returns a deep copy of this module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
 
   // members ////////////////////////////////////////////////////////
  private:
@@ -188,6 +192,8 @@ template <typename T> class convabsnorm_layer : public module_1_1<T> {
   //! Returns a deep copy of this module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
 
   // members ////////////////////////////////////////////////////////
  private:
@@ -239,6 +245,8 @@ template <typename T> class subsampling_layer : public module_1_1<T> {
   //! Returns a deep copy of this module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
 
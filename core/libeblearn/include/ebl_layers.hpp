@@ -116,6 +116,12 @@ module_1_1<T>* full_layer<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) l2;
 }
 
+template <typename T>
+void full_layer<T>::get_weights(std::vector<state<T>*> &states) {
+  linear.get_weights(states);
+  adder.get_weights(states);
+}
+
 template <typename T>
 std::string full_layer<T>::describe() {
   std::string s;
@@ -210,6 +216,12 @@ module_1_1<T>* convolution_layer<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) l2;
 }
 
+template <typename T>
+void convolution_layer<T>::get_weights(std::vector<state<T>*> &states) {
+  convol.get_weights(states);
+  adder.get_weights(states);
+}
+
 // convabsnorm_layer ///////////////////////////////////////////////////////////
 
 template <typename T>
@@ -302,6 +314,12 @@ module_1_1<T>* convabsnorm_layer<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) l2;
 }
 
+template <typename T>
+void convabsnorm_layer<T>::get_weights(std::vector<state<T>*> &states) {
+  lconv.get_weights(states);
+  norm.get_weights(states);
+}
+
 // subsampling_layer ///////////////////////////////////////////////////////////
 
 template <typename T>
@@ -388,6 +406,12 @@ module_1_1<T>* subsampling_layer<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) l2;
 }
 
+template <typename T>
+void subsampling_layer<T>::get_weights(std::vector<state<T>*> &states) {
+  subsampler.get_weights(states);
+  adder.get_weights(states);
+}
+
 template <typename T>
 std::string subsampling_layer<T>::describe() {
   std::string desc;
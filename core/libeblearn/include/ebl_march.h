@@ -37,6 +37,36 @@
 
 namespace ebl {
 
+// ms_pipe_task ////////////////////////////////////////////////////////////////
+
+//! Propagates each pipe of an ms_module as one piece of a thread_pool job.
+//! Pipes are run in any order, each only writing to its own input and
+//! output states.
+template <typename T> class ms_pipe_task : public parallel_task {
+ public:
+  //! Type of propagation.
+  enum pass { FPROP, FPROP_DUMP, BPROP, BBPROP };
+  //! \param pipes Pipes to propagate, NULL pipes are skipped.
+  //! \param ins Input of each pipe.
+  //! \param outs Output of each pipe.
+  //! \param owner The module owning the pipes, reported by the profiler.
+  ms_pipe_task(std::vector<module_1_1<T>*> &pipes, svector<state<T> > &ins,
+               svector<state<T> > &outs, pass type,
+               const module *owner = NULL);
+  virtual ~ms_pipe_task();
+  //! Propagate pipe 'i'.
+  virtual void run(intg i);
+ protected:
+  std::vector<module_1_1<T>*> &pipes;
+  svector<state<T> > &ins, &outs;
+  pass type;
+  const module *owner;
+};
+
+//! Returns true if the main tensors of 'a' and 'b' use overlapping parts of
+//! the same storage, e.g. a module and its shared copy.
+template <typename T> bool same_weights(state<T> &a, state<T> &b);
+
 // ms_module ///////////////////////////////////////////////////////////////////
 
 //! A container for one or multiple modules with one input and one output
@@ -72,6 +102,11 @@ template <typename T> class ms_module : public module_1_1<T> {
   //! The generic forward method where func is the forward function applied,
   //! i.e. 'fprop' or 'fprop_dump'.
   void forward(state<T>& in, state<T>& out, fprop_type type);
+  //! The generic backward method, propagating the pipes concurrently
+  //! when parallel_bprop() allows it, serially otherwise.
+  //! \param type Either ms_pipe_task<T>::BPROP or BBPROP.
+  void backward(state<T>& in, state<T>& out,
+                typename ms_pipe_task<T>::pass type);
 
   // dumping ///////////////////////////////////////////////////////////////////
 
@@ -114,12 +149,28 @@ template <typename T> class ms_module : public module_1_1<T> {
   virtual std::string pretty(mfidxdim &isize);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
 
   // accessors ///////////////////////////////////////////////////////////////
   //! Only propagate in 1 pipe based on the size of the first input state.
   virtual void set_switch(midxdim &sizes);
   //! Only propagate in pipe with index 'id'.
   virtual void set_switch(intg id);
+  //! Fprop pipes concurrently on the library-wide thread_pool or not.
+  //! Pipes are run serially anyway when the same module is used by
+  //! several pipes. Operations inside pipes then run serially, so this is
+  //! only worth it with several pipes of similar cost.
+  //! bprop and bbprop always run pipes one after the other, since pipes may
+  //! share weights (e.g. netconf '_shared' modules) and accumulate into the
+  //! same weight gradients; operations inside each pipe still use the pool.
+  virtual void set_parallel(bool parallel);
+  //! If true, pipes write their single output directly into consecutive
+  //! slices of dimension 0 of one buffer, so that a following merge_module
+  //! concatenating them along dimension 0 does not need to copy them.
+  //! Output sizes are learnt at the first call for a given input size,
+  //! which therefore uses separate buffers.
+  virtual void set_concat(bool concat);
   //! Returns the number of pipes.
   virtual uint npipes();
   //! Returns pointer to pipe 'i'.
@@ -136,6 +187,17 @@ template <typename T> class ms_module : public module_1_1<T> {
   virtual void init_fprop(state<T> &in, state<T> &out);
   //! Switch used_pipes on input size when switches are defined.
   virtual void switch_pipes(state<T> &in);
+  //! Returns true if used_pipes can be fpropagated concurrently.
+  virtual bool parallel_pipes();
+  //! Returns true if used_pipes can be bpropagated concurrently, i.e. if
+  //! they can be fpropagated concurrently and do not share any weights,
+  //! so that no weight gradient is accumulated by two pipes.
+  virtual bool parallel_bprop();
+  //! Create one output state per used pipe into 'outs', made of
+  //! slices of a single buffer if concatenating and output sizes are known.
+  virtual void init_outputs(state<T> &in, svector<state<T> > &outs);
+  //! Remember output sizes of each pipe for input 'in'.
+  virtual void remember_outputs(state<T> &in, svector<state<T> > &outs);
 
   // variable members ////////////////////////////////////////////////////////
  protected:
@@ -148,6 +210,10 @@ template <typename T> class ms_module : public module_1_1<T> {
   midxdim switches;            //!< Only propagate 1 pipe based on input sizes.
   bool    bindex;              //!< If true, use switch id to switch.
   intg    switch_id;           //!< Index of pipe to switch to.
+  bool    parallel;            //!< Propagate pipes concurrently.
+  bool    concat;              //!< Output pipes into slices of one buffer.
+  midxdim concat_ins;          //!< Input sizes of the last fprop.
+  midxdim concat_outs;         //!< Output sizes of each pipe for concat_ins.
 
   // friends /////////////////////////////////////////////////////////////////
   template <typename T1, class Tc>
@@ -32,6 +32,43 @@
 
 namespace ebl {
 
+// ms_pipe_task //////////////////////////////////////////////////////////////
+
+template <typename T>
+ms_pipe_task<T>::ms_pipe_task(std::vector<module_1_1<T>*> &pipes_,
+                              svector<state<T> > &ins_,
+                              svector<state<T> > &outs_, pass type_,
+                              const module *owner_)
+    : pipes(pipes_), ins(ins_), outs(outs_), type(type_), owner(owner_) {
+}
+
+template <typename T>
+ms_pipe_task<T>::~ms_pipe_task() {
+}
+
+template <typename T>
+void ms_pipe_task<T>::run(intg i) {
+  module_1_1<T> *p = pipes[i];
+  if (!p) return ; // no pipe, data is just passed along
+  // record this call when profiling
+  profile_scope<T> prof(p, owner, type == BPROP ? PROF_BPROP
+                        : (type == BBPROP ? PROF_BBPROP : PROF_FPROP),
+                        ins[i], outs[i]);
+  switch (type) {
+    case FPROP: p->fprop(ins[i], outs[i]); break ;
+    case FPROP_DUMP: p->fprop_dump(ins[i], outs[i]); break ;
+    case BPROP: p->bprop(ins[i], outs[i]); break ;
+    case BBPROP: p->bbprop(ins[i], outs[i]); break ;
+    default: eblerror("unknown type");
+  }
+}
+
+template <typename T> bool same_weights(state<T> &a, state<T> &b) {
+  idx<T> &ta = a, &tb = b;
+  return ta.getstorage() == tb.getstorage()
+      && ta.offset() < tb.footprint() && tb.offset() < ta.footprint();
+}
+
 // ms_module /////////////////////////////////////////////////////////////////
 
 template <typename T>
@@ -81,6 +118,18 @@ void ms_module<T>::forward(state<T> &in, state<T> &out, fprop_type fp) {
   EDEBUG(this->name() << ": in " << in << " ins " << ins
          << " used_pipes " << used_pipes);
   // fprop ins
+  svector<state<T> > outs;
+  init_outputs(in, outs);
+  typename ms_pipe_task<T>::pass type = ms_pipe_task<T>::FPROP;
+  switch (fp) {
+    case T_FPROP: break ;
+    case T_FPROP_DUMP: type = ms_pipe_task<T>::FPROP_DUMP; break ;
+    default: eblerror("unknown type");
+  }
+  ms_pipe_task<T> job(used_pipes, ins, outs, type, this);
+  if (parallel_pipes()) parallel_run(job, used_pipes.size());
+  else for (uint i = 0; i < used_pipes.size(); ++i) job.run(i);
+  // gather outputs
   for (uint i = 0; i < used_pipes.size(); ++i) {
     module_1_1<T> *p = used_pipes[i];
     if (!p) { // no pipe, just pass data along
@@ -89,26 +138,15 @@ void ms_module<T>::forward(state<T> &in, state<T> &out, fprop_type fp) {
       if (i >= pipes_noutputs.size()) pipes_noutputs.push_back(ins[i].x.size());
       else pipes_noutputs[i] = ins[i].x.size();
     } else {
-      state<T> s;
-      EDEBUG("fprop " << p->name() << " with input " << ins[i]);
-      switch (fp) {
-        case T_FPROP: p->fprop(ins[i], s); break ;
-        case T_FPROP_DUMP: p->fprop_dump(ins[i], s); break ;
-        default: eblerror("unknown type");
-      }
+      state<T> &s = outs[i];
       out.add_x_new(s.x);
       if (i >= pipes_noutputs.size()) pipes_noutputs.push_back(s.x.size());
       else pipes_noutputs[i] = s.x.size();
       EDEBUG(p->name() << " in " << ins[i] << " out " << s);
     }
     EDEBUG(this->name() << ": current outputs: " << out.x);
-    // TODO: code below reuses buffers but is a problem when this module
-    // is called multiple times, effectively erasing previous results
-    // -> question: is code above slow? if not, remove this block.
-    // used_pipes[i]->func(ins[i], mbuffers[i]);
-    // out.push_back(mbuffers[i]);
-    // pipes_noutputs[i] = mbuffers[i].x.size();
   }
+  if (concat) remember_outputs(in, outs);
   // remember number of outputs
   this->noutputs = out.x.size();
   EDEBUG(this->name() << ": " << in << " -> " << out);
@@ -117,38 +155,68 @@ void ms_module<T>::forward(state<T> &in, state<T> &out, fprop_type fp) {
 template <typename T>
 void ms_module<T>::bprop(state<T> &in, state<T> &out) {
   DEBUG_CHECK_DX(in); // in debug mode, check backward tensors are allocated
-  uint off = out.x.size();
-  for (int i = (int) used_pipes.size() - 1; i >= 0; --i) {
-    module_1_1<T> *p = used_pipes[i];
-    off -= pipes_noutputs[i];
-    if (!p) { // no pipe, just pass data along
-      EDEBUG("bprop empty pipe doing nothing.");
-    } else {
-      state<T> b = out.narrow_state(pipes_noutputs[i], (uint) off);
-      EDEBUG("bprop " << p->name() << " in " << ins[i] << " out " << b);
-      p->bprop(ins[i], b);
-    }
-  }
-  //used_pipes[i]->bprop(ins[i], out[i]);
-  //      used_pipes[i]->bprop(ins[i], mbuffers[i]);
+  backward(in, out, ms_pipe_task<T>::BPROP);
 }
 
 template <typename T>
 void ms_module<T>::bbprop(state<T> &in, state<T> &out) {
   DEBUG_CHECK_DDX(in); // in debug mode, check backward tensors are allocated
-  int off = out.x.size();
-  for (int i = (int) used_pipes.size() - 1; i >= 0; --i) {
-    module_1_1<T> *p = used_pipes[i];
-    off -= pipes_noutputs[i];
-    if (!p) { // no pipe, just pass data along
-      EDEBUG("bbprop empty pipe doing nothing.");
-    } else {
-      state<T> b = out.narrow_state(pipes_noutputs[i], (uint) off);
-      p->bbprop(ins[i], b);
+  backward(in, out, ms_pipe_task<T>::BBPROP);
+}
+
+template <typename T>
+void ms_module<T>::backward(state<T> &in, state<T> &out,
+                            typename ms_pipe_task<T>::pass type) {
+  svector<state<T> > outs;
+  uint off = out.x.size();
+  for (uint i = 0; i < used_pipes.size(); ++i) off -= pipes_noutputs[i];
+  for (uint i = 0; i < used_pipes.size(); ++i) {
+    if (!used_pipes[i]) outs.push_back_new(state<T>()); // nothing to do
+    else outs.push_back_new(out.narrow_state(pipes_noutputs[i], (uint) off));
+    off += pipes_noutputs[i];
+  }
+  if (!parallel_bprop()) {
+    // serially: pipes sharing weights accumulate into the same gradients
+    ms_pipe_task<T> job(used_pipes, ins, outs, type, this);
+    for (int i = (int) used_pipes.size() - 1; i >= 0; --i) job.run(i);
+    return ;
+  }
+  // replicated inputs share their gradients: all pipes but the 1st
+  // accumulate into zeroed buffers, added to the inputs gradients after
+  bool second = type == ms_pipe_task<T>::BBPROP;
+  svector<state<T> > pins;
+  for (uint i = 0; i < used_pipes.size(); ++i) {
+    if (i == 0 || !replicate_inputs || !used_pipes[i]) {
+      pins.push_back_new(ins[i]);
+      continue ;
+    }
+    svector<idx<T> > &g = second ? ins[i].ddx : ins[i].dx;
+    // the gradient not written by this pass is shared with the input
+    svector<idx<T> > &o = second ? ins[i].dx : ins[i].ddx;
+    state<T> s;
+    s.x.clear();
+    s.add_x_new(ins[i].x);
+    for (uint k = 0; k < g.size(); ++k) {
+      idx<T> b(g[k].get_idxdim());
+      idx_clear(b);
+      if (second) s.ddx.push_back_new(b);
+      else s.dx.push_back_new(b);
+    }
+    for (uint k = 0; k < o.size(); ++k) {
+      if (second) s.dx.push_back_new(o[k]);
+      else s.ddx.push_back_new(o[k]);
     }
+    pins.push_back_new(s);
+  }
+  ms_pipe_task<T> job(used_pipes, pins, outs, type, this);
+  parallel_run(job, used_pipes.size());
+  if (!replicate_inputs) return ;
+  for (uint i = 1; i < used_pipes.size(); ++i) {
+    if (!used_pipes[i]) continue ;
+    svector<idx<T> > &g = second ? ins[i].ddx : ins[i].dx;
+    svector<idx<T> > &b = second ? pins[i].ddx : pins[i].dx;
+    for (uint k = 0; k < g.size(); ++k) idx_add(b[k], g[k]);
   }
-  //used_pipes[i]->bbprop(ins[i], out[i]);
-  //      used_pipes[i]->bbprop(ins[i], mbuffers[i]);
 }
 
 template <typename T>
@@ -307,6 +375,8 @@ std::string ms_module<T>::describe() {
   }
   if (switches.size() > 0)
     desc << ", switching based on input sizes: " << switches;
+  if (parallel) desc << ", parallel pipes";
+  if (concat) desc << ", concatenated outputs";
   desc << ":\n";
   for (uint i = 0; i < pipes.size(); ++i) {
     desc << this->name() << " pipe[" << i << "]: ";
@@ -316,6 +386,12 @@ std::string ms_module<T>::describe() {
   return desc;
 }
 
+template <typename T>
+void ms_module<T>::get_weights(std::vector<state<T>*> &states) {
+  for (uint i = 0; i < pipes.size(); ++i)
+    if (pipes[i]) pipes[i]->get_weights(states);
+}
+
 // accessors /////////////////////////////////////////////////////////////////
 
 template <typename T>
@@ -330,6 +406,18 @@ void ms_module<T>::set_switch(intg id) {
   switch_id = id;
 }
 
+template <typename T>
+void ms_module<T>::set_parallel(bool p) {
+  parallel = p;
+}
+
+template <typename T>
+void ms_module<T>::set_concat(bool c) {
+  concat = c;
+  concat_ins.clear();
+  concat_outs.clear();
+}
+
 template <typename T>
 uint ms_module<T>::npipes() {
   return (uint) pipes.size();
@@ -370,6 +458,8 @@ void ms_module<T>::init() {
   // switching
   bindex = false;
   switch_id = -1;
+  parallel = false;
+  concat = false;
 }
 
 template <typename T>
@@ -430,6 +520,85 @@ void ms_module<T>::switch_pipes(state<T> &in) {
   } else used_pipes = pipes;
 }
 
+template <typename T>
+bool ms_module<T>::parallel_pipes() {
+  if (!parallel || used_pipes.size() < 2) return false;
+  for (uint i = 0; i < used_pipes.size(); ++i) {
+    if (!used_pipes[i]) continue ;
+    for (uint j = i + 1; j < used_pipes.size(); ++j)
+      // the same module cannot run twice at once
+      if (used_pipes[i] == used_pipes[j]) return false;
+  }
+  return true;
+}
+
+template <typename T>
+bool ms_module<T>::parallel_bprop() {
+  if (!parallel_pipes()) return false;
+  std::vector<std::vector<state<T>*> > w(used_pipes.size());
+  for (uint i = 0; i < used_pipes.size(); ++i)
+    if (used_pipes[i]) used_pipes[i]->get_weights(w[i]);
+  for (uint i = 0; i < w.size(); ++i)
+    for (uint j = i + 1; j < w.size(); ++j)
+      for (uint a = 0; a < w[i].size(); ++a)
+        for (uint b = 0; b < w[j].size(); ++b)
+          if (same_weights(*w[i][a], *w[j][b])) return false;
+  return true;
+}
+
+template <typename T>
+void ms_module<T>::init_outputs(state<T> &in, svector<state<T> > &outs) {
+  outs.clear();
+  bool known = concat && concat_outs.size() == used_pipes.size()
+      && concat_ins.size() == in.x.size();
+  for (uint i = 0; known && i < in.x.size(); ++i)
+    if (concat_ins[i] != in.x[i].get_idxdim()) known = false;
+  if (!known) { // separate outputs
+    for (uint i = 0; i < used_pipes.size(); ++i)
+      outs.push_back_new(state<T>());
+    return ;
+  }
+  // allocate one buffer and give a slice of it to each pipe
+  idxdim d(concat_outs[0]);
+  intg n0 = 0;
+  for (uint i = 0; i < concat_outs.size(); ++i) n0 += concat_outs[i].dim(0);
+  d.setdim(0, n0);
+  idx<T> buf(d);
+  intg off = 0;
+  for (uint i = 0; i < concat_outs.size(); ++i) {
+    state<T> s;
+    s.x[0] = buf.narrow(0, concat_outs[i].dim(0), off); // main tensor
+    outs.push_back_new(s);
+    off += concat_outs[i].dim(0);
+  }
+}
+
+template <typename T>
+void ms_module<T>::remember_outputs(state<T> &in, svector<state<T> > &outs) {
+  concat_ins.clear();
+  concat_outs.clear();
+  // outputs can be concatenated only if each pipe outputs 1 tensor and all
+  // outputs only differ in their first dimension
+  for (uint i = 0; i < used_pipes.size(); ++i) {
+    if (!used_pipes[i] || outs[i].x.size() != 1) {
+      concat_outs.clear();
+      return ;
+    }
+    idxdim d = outs[i].x[0].get_idxdim();
+    if (i > 0) {
+      idxdim d0 = concat_outs[0];
+      d0.setdim(0, d.dim(0));
+      if (d0 != d) {
+        concat_outs.clear();
+        return ;
+      }
+    }
+    concat_outs.push_back(d);
+  }
+  for (uint i = 0; i < in.x.size(); ++i)
+    concat_ins.push_back(in.x[i].get_idxdim());
+}
+
 // msc_module //////////////////////////////////////////////////////////////////
 
 template <typename T>
@@ -703,6 +872,8 @@ ms_module<T>* arch_narrow(ms_module<T> *m, Tcast *c,
   bool lfound = false;
   if (!found) found = &lfound;
   ms_module<T> *m2 = new ms_module<T>(m->replicate_inputs, m->name());
+  m2->set_parallel(m->parallel);
+  m2->set_concat(m->concat);
   for (uint i = 0; i < m->pipes.size(); ++i) {
     module_1_1<T> *p2 = NULL;
     if (m->pipes[i]) p2 = arch_narrow(m->pipes[i], c, included, post, found);
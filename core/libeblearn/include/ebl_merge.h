@@ -77,6 +77,8 @@ template <typename T> class flat_merge_module : public module_1_1<T> {
   virtual mfidxdim bprop_size(mfidxdim &osize);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
+  //! Returns 0, merging only moves data.
+  virtual double fprop_flops(state<T> &in, state<T> &out);
   //! Returns the number of expected inputs.
   virtual uint get_ninputs();
   //! Returns the strides for each input.
@@ -151,9 +153,13 @@ template <typename T> class linear_merge_module : public flat_merge_module<T> {
   ///////////////////////////////////////////////////////////////////////////
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
+  //! Returns the operations of the linear combinations and of their sum.
+  virtual double fprop_flops(state<T> &in, state<T> &out);
   //! Returns a deep copy of current module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
 
   // class variables /////////////////////////////////////////////////////////
  private:
@@ -195,6 +201,8 @@ template <typename T> class mstate_merge_module : public module_1_1<T> {
   virtual fidxdim bprop_size(const fidxdim &o_size);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
+  //! Returns 0, merging only moves data.
+  virtual double fprop_flops(state<T> &in, state<T> &out);
 
  private:
   midxdim dins;
@@ -226,6 +234,8 @@ template <typename T> class merge_module : public module_1_1<T> {
   virtual void fprop_dump(state<T> &in, state<T> &out);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
+  //! Returns 0, merging only moves data.
+  virtual double fprop_flops(state<T> &in, state<T> &out);
   //! Returns a deep copy of current module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
@@ -269,6 +279,8 @@ template <typename T> class interlace_module : public module_1_1<T> {
   virtual mfidxdim bprop_size(mfidxdim &osize);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
+  //! Returns 0, merging only moves data.
+  virtual double fprop_flops(state<T> &in, state<T> &out);
   //! Returns a deep copy of current module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
@@ -308,6 +308,11 @@ std::string flat_merge_module<T>::describe() {
   return desc;
 }
 
+template <typename T>
+double flat_merge_module<T>::fprop_flops(state<T> &in, state<T> &out) {
+  return 0;
+}
+
 template <typename T>
 uint flat_merge_module<T>::get_ninputs() {
   return (uint) dins.size();
@@ -477,6 +482,16 @@ std::string linear_merge_module<T>::describe() {
   return desc;
 }
 
+template <typename T>
+double linear_merge_module<T>::fprop_flops(state<T> &in, state<T> &out) {
+  double n = 0;
+  for (uint i = 0; i < convs.size() && i < buffers1.x.size(); ++i)
+    if (convs[i]->thickness > 0)
+      n += 2.0 * buffers1.x[i].nelements() * convs[i]->kernel.nelements()
+        / convs[i]->thickness;
+  return n + (double) buffer2.nelements();
+}
+
 template <typename T>
 module_1_1<T>* linear_merge_module<T>::copy(parameter<T> *p) {
   linear_merge_module<T> *l2 =
@@ -490,6 +505,11 @@ module_1_1<T>* linear_merge_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) l2;
 }
 
+template <typename T>
+void linear_merge_module<T>::get_weights(std::vector<state<T>*> &states) {
+  for (uint i = 0; i < convs.size(); ++i) convs[i]->get_weights(states);
+}
+
 // mstate_merge_module /////////////////////////////////////////////////////////
 
 template <typename T>
@@ -665,6 +685,11 @@ std::string mstate_merge_module<T>::describe() {
   return desc;
 }
 
+template <typename T>
+double mstate_merge_module<T>::fprop_flops(state<T> &in, state<T> &out) {
+  return 0;
+}
+
 // merge ///////////////////////////////////////////////////////////////////////
 
 template <typename T>
@@ -757,6 +782,11 @@ std::string merge_module<T>::describe() {
   return desc;
 }
 
+template <typename T>
+double merge_module<T>::fprop_flops(state<T> &in, state<T> &out) {
+  return 0;
+}
+
 template <typename T>
 module_1_1<T>* merge_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*)
@@ -805,6 +835,23 @@ void merge_module<T>::merge_f(state<T> &in, state<T> &out, uint iout) {
     // increment dimension
     d.setdim(concat_dim, d.dim(concat_dim) + s.dim(concat_dim));
   }
+  // inputs already are consecutive slices of one buffer (e.g. outputs of an
+  // ms_module with concat on): just point to that buffer instead of copying
+  if (concat_dim == 0 && in.x.size() > 1) {
+    bool consecutive = true;
+    for (uint i = 0; i < in.x.size() && consecutive; ++i) {
+      idx<T> &s = in.x[i];
+      if (!s.contiguousp()) consecutive = false;
+      else if (i > 0 && (s.getstorage() != in.x[i - 1].getstorage()
+                         || s.offset() != in.x[i - 1].offset()
+                         + in.x[i - 1].nelements()))
+        consecutive = false;
+    }
+    if (consecutive) {
+      out.x[iout] = idx<T>(in.x[0].getstorage(), in.x[0].offset(), d);
+      return ;
+    }
+  }
   // check that output has the right size, if not, resize
   if (out.get_idxdim() != d) out.resize(d);
   // copy inputs to out
@@ -925,6 +972,11 @@ std::string interlace_module<T>::describe() {
   return desc;
 }
 
+template <typename T>
+double interlace_module<T>::fprop_flops(state<T> &in, state<T> &out) {
+  return 0;
+}
+
 template <typename T>
 module_1_1<T>* interlace_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) new interlace_module<T>(stride, this->name());
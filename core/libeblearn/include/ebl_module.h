@@ -187,6 +187,10 @@ public:
   //! Load internal weights of module with passed weights w.
   //! TODO: there should be not idx specialization at this level.
   virtual void load_x(idx<T> &weights);
+  //! Append to 'states' the weight states of this module and of the modules
+  //! it contains, i.e. the states its bprop and bbprop accumulate into.
+  //! By default, a module has no weights.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns the last module contained in this module, or itself if composed
   //! of only 1 module.
   virtual module_1_1<T>* last_module();
@@ -203,6 +207,13 @@ public:
   //! Update internal "outdims" dimensions of last output.
   virtual void update_outdims(idx<T> &out);
 
+  // profiling ///////////////////////////////////////////////////////////////
+
+  //! Returns an estimate of the number of floating point operations of a
+  //! forward propagation from 'in' to 'out', used by the profiler.
+  //! By default, this is 1 per output element.
+  virtual double fprop_flops(state<T> &in, state<T> &out);
+
   // variable members ////////////////////////////////////////////////////////
 public:
   // these variables describe internal buffers declared to be displayed
@@ -282,6 +282,10 @@ template <typename T>
 void module_1_1<T>::load_x(idx<T> &weights) {
   err_not_implemented(); }
 
+template <typename T>
+void module_1_1<T>::get_weights(std::vector<state<T>*> &states) {
+}
+
 template <typename T>
 module_1_1<T>* module_1_1<T>::last_module() {
   return this;
@@ -317,6 +321,14 @@ void module_1_1<T>::update_outdims(idx<T> &out) {
   outdims = out.get_idxdim();
 }
 
+template <typename T>
+double module_1_1<T>::fprop_flops(state<T> &in, state<T> &out) {
+  double n = 0;
+  for (uint i = 0; i < out.x.size(); ++i)
+    if (out.x.exists(i)) n += out.x[i].nelements();
+  return n;
+}
+
 // module_2_1 //////////////////////////////////////////////////////////////////
 
 template <typename T> module_2_1<T>::module_2_1(const char *name_)
@@ -101,6 +101,8 @@ template <typename T> class tanh_module: public module_1_1<T> {
 	virtual module_1_1<T>* copy(parameter<T> *p = NULL);
 	//! Returns a string describing this module and its parameters.
 	virtual std::string describe();
+	//! Returns the coefficient of the linear term.
+	virtual double get_linear_coeff();
 
  protected:
 	idx<T>				tmp;						//!< Temporary buffer.
@@ -188,6 +190,8 @@ template <typename T> class linear_shrink_module: public module_1_1<T> {
 	//! Returns a deep copy of this module.
 	//! \param p If NULL, the copy points to the same weights as this module.
 	virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+	//! Append the weight states of this module to 'states'.
+	virtual void get_weights(std::vector<state<T>*> &states);
 	//! Returns a string describing this module and its parameters.
 	virtual std::string describe();
 
@@ -222,6 +226,8 @@ template <typename T> class smooth_shrink_module: public module_1_1<T> {
 	//! Returns a deep copy of this module.
 	//! \param p If NULL, the copy points to the same weights as this module.
 	virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+	//! Append the weight states of this module to 'states'.
+	virtual void get_weights(std::vector<state<T>*> &states);
 
  public:
 	state<T> beta, bias;
@@ -261,6 +267,8 @@ template <typename T> class tanh_shrink_module: public module_1_1<T> {
 	//! Returns a deep copy of this module.
 	//! \param p If NULL, the copy points to the same weights as this module.
 	virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+	//! Append the weight states of this module to 'states'.
+	virtual void get_weights(std::vector<state<T>*> &states);
 	//! Returns a string describing this module and its parameters.
 	virtual std::string describe();
  protected:
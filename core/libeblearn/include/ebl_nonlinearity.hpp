@@ -137,6 +137,11 @@ std::string tanh_module<T>::describe() {
   return s;
 }
 
+template <typename T>
+double tanh_module<T>::get_linear_coeff() {
+  return alpha;
+}
+
 // softmax /////////////////////////////////////////////////////////////////////
 
 template <typename T>
@@ -309,6 +314,11 @@ module_1_1<T>* linear_shrink_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) s2;
 }
 
+template <typename T>
+void linear_shrink_module<T>::get_weights(std::vector<state<T>*> &states) {
+  states.push_back(&bias);
+}
+
 template <typename T>
 std::string linear_shrink_module<T>::describe() {
   std::string desc;
@@ -517,6 +527,12 @@ module_1_1<T>* smooth_shrink_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) s2;
 }
 
+template <typename T>
+void smooth_shrink_module<T>::get_weights(std::vector<state<T>*> &states) {
+  states.push_back(&beta);
+  states.push_back(&bias);
+}
+
 // tanh_shrink_module //////////////////////////////////////////////////////////
 
 template <typename T>
@@ -618,6 +634,12 @@ module_1_1<T>* tanh_shrink_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) s2;
 }
 
+template <typename T>
+void tanh_shrink_module<T>::get_weights(std::vector<state<T>*> &states) {
+  if (alpha) alpha->get_weights(states);
+  if (beta) beta->get_weights(states);
+}
+
 template <typename T>
 std::string tanh_shrink_module<T>::describe() {
   std::string desc;
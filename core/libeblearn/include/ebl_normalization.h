@@ -85,6 +85,8 @@ template <typename T> class divisive_norm_module : public module_1_1<T> {
   //! Returns a deep copy of this module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Pre-determine the order of hidden buffers to use only 2 buffers
   //! in order to reduce memory footprint.
   //! This returns true if outputs is actually put in out, false if it's
@@ -188,6 +190,8 @@ template <typename T> class subtractive_norm_module : public module_1_1<T> {
   //! Returns a deep copy of this module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Pre-determine the order of hidden buffers to use only 2 buffers
   //! in order to reduce memory footprint.
   //! This returns true if outputs is actually put in out, false if it's
@@ -281,6 +285,8 @@ class contrast_norm_module : public module_1_1<T> {
   //! Returns a deep copy of this module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Pre-determine the order of hidden buffers to use only 2 buffers
   //! in order to reduce memory footprint.
   //! This returns true if outputs is actually put in out, false if it's
@@ -325,6 +331,8 @@ template <typename T> class laplacian_module : public module_1_1<T> {
   //! Returns a deep copy of this module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
 
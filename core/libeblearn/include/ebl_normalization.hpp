@@ -230,6 +230,11 @@ module_1_1<T>* divisive_norm_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) d;
 }
 
+template <typename T>
+void divisive_norm_module<T>::get_weights(std::vector<state<T>*> &states) {
+  divconv->get_weights(states);
+}
+
 template <typename T>
 bool divisive_norm_module<T>::optimize_fprop(state<T> &in, state<T> &out) {
   // memory optimization
@@ -413,6 +418,11 @@ module_1_1<T>* subtractive_norm_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) d;
 }
 
+template <typename T>
+void subtractive_norm_module<T>::get_weights(std::vector<state<T>*> &states) {
+  meanconv->get_weights(states);
+}
+
 template <typename T>
 bool subtractive_norm_module<T>::optimize_fprop(state<T> &in, state<T> &out) {
   // memory optimization
@@ -530,6 +540,12 @@ module_1_1<T>* contrast_norm_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) d;
 }
 
+template <typename T>
+void contrast_norm_module<T>::get_weights(std::vector<state<T>*> &states) {
+  if (subnorm) subnorm->get_weights(states);
+  if (divnorm) divnorm->get_weights(states);
+}
+
 template <typename T>
 bool contrast_norm_module<T>::optimize_fprop(state<T> &in, state<T> &out) {
   // memory optimization
@@ -604,6 +620,11 @@ module_1_1<T>* laplacian_module<T>::copy(parameter<T> *p) {
       new laplacian_module<T>(nfeatures, mirror, global_norm, this->name());
 }
 
+template <typename T>
+void laplacian_module<T>::get_weights(std::vector<state<T>*> &states) {
+  conv->get_weights(states);
+}
+
 template <typename T>
 std::string laplacian_module<T>::describe() {
   std::string desc;
@@ -96,6 +96,8 @@ template <typename T> class subsampling_module: public module_1_1<T> {
   //! Returns a deep copy of this module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
 
@@ -168,6 +170,8 @@ template <typename T> class lppooling_module: public module_1_1<T> {
   //! Returns a deep copy of this module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
   //! Calls fprop and then dumps internal buffers, inputs and outputs
@@ -227,6 +231,8 @@ class wavg_pooling_module: public module_1_1<T> {
   //! Returns a deep copy of this module.
   //! \param p If NULL, the copy points to the same weights as this module.
   virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
   //! Calls fprop and then dumps internal buffers, inputs and outputs
@@ -328,6 +334,8 @@ template <typename T> class average_pyramid_module : public module_1_1<T> {
 
   //! Returns a string describing this module and its parameters.
   virtual std::string describe();
+  //! Append the weight states of this module to 'states'.
+  virtual void get_weights(std::vector<state<T>*> &states);
   //! Returns input dimensions corresponding to output dimensions 'osize'.
   virtual mfidxdim bprop_size(mfidxdim &osize);
 
@@ -82,15 +82,7 @@ void subsampling_module<T>::fprop1(idx<T> &in, idx<T> &out) {
   if (clear) idx_clear(out);
   // subsample
   { idx_bloop4(lix, inx, T, lsx, sub, T, lcx, coeff, T, ltx, outx, T) {
-      idx<T> uuin(lix.unfold(1, stride.dim(1), stride.dim(1)));
-      uuin = uuin.unfold(0, stride.dim(0), stride.dim(0));
-      // loop on each pixel of subs kernel, assuming that idx_add is faster
-      // than looping on each kernel
-      idx_eloop1(z1, uuin, T) {
-        idx_eloop1(z2, z1, T) {
-          idx_add(z2, lsx); // average
-        }
-      }
+      idx_m2subsample(lix, stride.dim(0), stride.dim(1), lsx); // sum
       idx_dotc(lsx, lcx.get(), ltx); // coeff
     }}
 }
@@ -259,6 +251,11 @@ module_1_1<T>* subsampling_module<T>::copy(parameter<T> *p) {
   return (module_1_1<T>*) l2;
 }
 
+template <typename T>
+void subsampling_module<T>::get_weights(std::vector<state<T>*> &states) {
+  states.push_back(&coeff);
+}
+
 template <typename T>
 std::string subsampling_module<T>::describe() {
   std::string desc;
@@ -412,6 +409,11 @@ module_1_1<T>* lppooling_module<T>::copy(parameter<T> *p) {
       new lppooling_module<T>(thickness, kernel, stride, lp_pow, this->name());
 }
 
+template <typename T>
+void lppooling_module<T>::get_weights(std::vector<state<T>*> &states) {
+  conv->get_weights(states);
+}
+
 template <typename T>
 std::string lppooling_module<T>::describe() {
   std::string desc;
@@ -497,6 +499,11 @@ module_1_1<T>* wavg_pooling_module<T>::copy(parameter<T> *p) {
       new wavg_pooling_module<T>(thickness, kernel, stride, this->name());
 }
 
+template <typename T>
+void wavg_pooling_module<T>::get_weights(std::vector<state<T>*> &states) {
+  conv->get_weights(states);
+}
+
 template <typename T>
 std::string wavg_pooling_module<T>::describe() {
   std::string desc;
@@ -693,6 +700,11 @@ std::string average_pyramid_module<T>::describe() {
   return desc;
 }
 
+template <typename T>
+void average_pyramid_module<T>::get_weights(std::vector<state<T>*> &states) {
+  for (uint i = 0; i < mods.size(); ++i) mods[i]->get_weights(states);
+}
+
 template <typename T>
 mfidxdim average_pyramid_module<T>::bprop_size(mfidxdim &osize) {
   if (osize.size() != strides.size())
@@ -733,8 +745,6 @@ maxss_module<T>::maxss_module(uint thick, idxdim &kernel_, idxdim &stride_,
     if(cont_d) double_precision = true;
   }
   delete temp;
-#else
-  eblerror("Maxss is implemented only using the TH library. ");
 #endif
 }
 
@@ -752,22 +762,14 @@ void maxss_module<T>::fprop1(idx<T> &in, idx<T> &out) {
     return;
   }
 #endif
+  // max of each window, remembering its location for bprop
+  idxdim d(out);
+  d.insert_dim(d.order(), 2);
+  if (switches.get_idxdim() != d)
+    switches = idx<int>(d);
   { idx_bloop3(lix, in, T, sw, switches, int, ltx, out, T) {
-      int i = 0, j = 0;
-      idx<T> uuin(lix.unfold(1, kernel.dim(2), stride.dim(1)));
-      uuin = uuin.unfold(0, kernel.dim(1), stride.dim(0));
-      idx_bloop3(z1, uuin, T, sw1, sw, int, o1, ltx, T) {
-        idx_bloop3(z2, z1, T, sw2, sw1, int, o2, o1, T) {
-          intg indx = idx_indexmax(z2); // find index of max
-          // height in input
-          sw2.set((int) (indx / kernel.dim(2) + stride.dim(0) * i), 0);
-          // width in input
-          sw2.set((int) (indx / kernel.dim(2) + stride.dim(1) * j), 1);
-          o2.set(z2.get(indx)); // copy max to output
-        }
-        j++;
-      }
-      i++;
+      idx_m2maxpool(lix, kernel.dim(0), kernel.dim(1), stride.dim(0),
+                    stride.dim(1), ltx, sw);
     }}
 }
 
@@ -783,13 +785,9 @@ void maxss_module<T>::bprop1(state<T> &in, state<T> &out) {
   }
 #endif
   // copy derivatives in the position given by the switches
-  int i = 0, j = 0;
   idx_bloop3(di1, in.dx[0], T, s1, switches, int, do1, out.dx[0], T) {
-    idx_bloop2(s2, s1, int, do2, do1, T) {
-      idx_bloop2(s3, s2, int, do3, do2, T) {
-        i = s3.get(0); j = s3.get(1);
-        di1.set(di1.get(i, j) + do3.get(), i, j);
-      }}}
+    idx_m2unpoolacc(do1, s1, di1);
+  }
 }
 
 template <typename T>
@@ -804,13 +802,9 @@ void maxss_module<T>::bbprop1(state<T> &in, state<T> &out) {
   }
 #endif
   // copy derivatives in the position given by the switches
-  int i = 0, j = 0;
   idx_bloop3(di1, in.ddx[0], T, s1, switches, int, do1, out.ddx[0], T) {
-    idx_bloop2(s2, s1, int, do2, do1, T) {
-      idx_bloop2(s3, s2, int, do3, do2, T) {
-        i = s3.get(0); j = s3.get(1);
-        di1.set(di1.get(i, j) + do3.get(), i, j);
-      }}}
+    idx_m2unpoolacc(do1, s1, di1);
+  }
 }
 
 template <typename T>
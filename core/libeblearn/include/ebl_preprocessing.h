@@ -1082,6 +1082,9 @@ public:
   //! Adds padding on top, left, bottom and right from pads[0], pads[1],
   //! pads[2], pads[3].
   void set_padding(std::vector<uint> &pads);
+  //! Warp rows in parallel on the library-wide thread_pool or not
+  //! (default: true).
+  void set_parallel(bool parallel);
 
   // multi-state inputs and outputs //////////////////////////////////////////
   virtual void fprop1(idx<T> &in, idx<T> &out);
@@ -1103,6 +1106,13 @@ protected:
   float elcoeff0, elcoeff1; //!< Min/max elastic coefficient.
   zpad_module<T> *zp; //!< Zero-padding.
   state<T> tmp;
+  bool parallel; //!< Warp rows in parallel.
+  philox_stream gen; //!< Own stream of random deformations.
+  // buffers reused across calls
+  idx<T> src; //!< Copy of input when it shares its storage with output.
+  idx<float> flow; //!< Elastic flow.
+  idx<float> noise; //!< Elastic noise.
+  idx<float> smooth; //!< Elastic smoothing buffer.
 };
 
 } // namespace ebl {
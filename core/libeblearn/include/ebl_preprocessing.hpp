@@ -126,9 +126,8 @@ void rgb_to_ynuv_module<T>::fprop1(idx<T> &in, idx<T> &out) {
   } else {
     idx<T> uv, yuv;
     // RGB to YUV
-    idx_eloop2(inx, in, T, outx, out, T) {
-      idx_eloop2(inxx, inx, T, outxx, outx, T) {
-        rgb_to_yuv_1D(inxx, outxx); }}
+    idx<T> inc = in.shift_dim(0, 2), outc = out.shift_dim(0, 2);
+    rgb_to_yuv(inc, outc);
   }
   EDEBUG(this->name() << ": yuv " << out << " min " << idx_min(out)
          << " max " << idx_max(out));
@@ -180,9 +179,8 @@ void rgb_to_ynuvn_module<T>::fprop1(idx<T> &in, idx<T> &out) {
   } else {
     idx<T> uv, yuv;
     // RGB to YUV
-    idx_eloop2(inx, in, T, outx, out, T) {
-      idx_eloop2(inxx, inx, T, outxx, outx, T) {
-        rgb_to_yuv_1D(inxx, outxx); }}
+    idx<T> inc = in.shift_dim(0, 2), outc = out.shift_dim(0, 2);
+    rgb_to_yuv(inc, outc);
   }
   // normalize Y
   this->tmp = out.narrow(0, 1, 0);
@@ -224,9 +222,8 @@ void rgb_to_ynunvn_module<T>::fprop1(idx<T> &in, idx<T> &out) {
   } else {
     idx<T> uv, yuv;
     // RGB to YUV
-    idx_eloop2(inx, in, T, outx, out, T) {
-      idx_eloop2(inxx, inx, T, outxx, outx, T) {
-        rgb_to_yuv_1D(inxx, outxx); }}
+    idx<T> inc = in.shift_dim(0, 2), outc = out.shift_dim(0, 2);
+    rgb_to_yuv(inc, outc);
   }
   // normalize Y
   this->tmp = out.narrow(0, 1, 0);
@@ -267,9 +264,8 @@ void rgb_to_yuv_module<T>::fprop1(idx<T> &in, idx<T> &out) {
     eblerror("expected 3 channels in dim 0 but found: " << in);
   } else {
     // RGB to YUV
-    idx_eloop2(inx, in, T, outx, out, T) {
-      idx_eloop2(inxx, inx, T, outxx, outx, T) {
-        rgb_to_yuv_1D(inxx, outxx); }}
+    idx<T> inc = in.shift_dim(0, 2), outc = out.shift_dim(0, 2);
+    rgb_to_yuv(inc, outc);
     // remove global mean and divide by stddev
     if (this->globnorm) { // normalize Y
       idx<T> y = out.narrow(0, 1, 0);
@@ -313,9 +309,8 @@ void rgb_to_yuvn_module<T>::fprop1(idx<T> &in, idx<T> &out) {
     eblerror("expected 3 channels in dim 0 but found: " << in);
   } else {
     // RGB to YUV
-    idx_eloop2(inx, in, T, outx, out, T) {
-      idx_eloop2(inxx, inx, T, outxx, outx, T) {
-        rgb_to_yuv_1D(inxx, outxx); }}
+    idx<T> inc = in.shift_dim(0, 2), outc = out.shift_dim(0, 2);
+    rgb_to_yuv(inc, outc);
   }
   // first normalize globally Y and UV separately
   idx<T> y = out.narrow(0, 1, 0);
@@ -431,9 +426,8 @@ void rgb_to_y_module<T>::fprop1(idx<T> &in, idx<T> &out) {
     eblerror("expected 3 channels in dim 0 but found: " << in);
   } else {
     // RGB to YUV
-    idx_eloop2(inx, in, T, outx, out, T) {
-      idx_eloop2(inxx, inx, T, outxx, outx, T) {
-        rgb_to_y_1D(inxx, outxx); }}
+    idx<T> inc = in.shift_dim(0, 2), outc = out.shift_dim(0, 2);
+    rgb_to_y(inc, outc);
     // remove global mean and divide by stddev
     if (this->globnorm) image_global_normalization(out);
   }
@@ -470,9 +464,8 @@ void rgb_to_yn_module<T>::fprop1(idx<T> &in, idx<T> &out) {
     this->norm->fprop1(in, out); // local
   } else {
     // RGB to Y
-    idx_eloop2(inx, in, T, tmpx, this->tmp, T) {
-      idx_eloop2(inxx, inx, T, tmpxx, tmpx, T) {
-        rgb_to_y_1D(inxx, tmpxx); }}
+    idx<T> inc = in.shift_dim(0, 2), outc = this->tmp.shift_dim(0, 2);
+    rgb_to_y(inc, outc);
     // convert Y to Yp
     this->norm->fprop1(this->tmp, out); // local
   }
@@ -532,11 +525,8 @@ void bgr_to_ypuv_module<T>::fprop1(idx<T> &in, idx<T> &out) {
   idx<T> uv, yp, yuv;
 
   // BGR to YUV
-  idx_eloop2(inx, in, T, outx, out, T) {
-    idx_eloop2(inxx, inx, T, outxx, outx, T) {
-      bgr_to_yuv_1D(inxx, outxx);
-    }
-  }
+  idx<T> inc = in.shift_dim(0, 2), outc = out.shift_dim(0, 2);
+  bgr_to_yuv(inc, outc);
   // remove global mean and divide by stddev
   uv = out.narrow(0, 2, 1);
   if (this->globnorm) image_global_normalization(uv);
@@ -573,9 +563,8 @@ void bgr_to_yp_module<T>::fprop1(idx<T> &in, idx<T> &out) {
   d.setdim(0, 1);
   this->resize_output(in, out, d); // resize (iff necessary)
   // BGR to YUV
-  idx_eloop2(inx, in, T, tmpx, this->tmp, T) {
-    idx_eloop2(inxx, inx, T, tmpxx, tmpx, T) {
-      bgr_to_y_1D(inxx, tmpxx); }}
+  idx<T> inc = in.shift_dim(0, 2), outc = this->tmp.shift_dim(0, 2);
+  bgr_to_y(inc, outc);
   // convert Y to Yp
   this->norm->fprop1(this->tmp, out); // local
 }
@@ -1933,7 +1922,7 @@ void laplacian_pyramid_module<T>::normalize_globally2(idx<T> &in) {
 
 template <typename T>
 jitter_module<T>::jitter_module(const char *name_)
-  : module_1_1<T>(name_), zp(NULL) {
+  : module_1_1<T>(name_), zp(NULL), parallel(true) {
   // no deformation defaults
   th0 = 0; th1 = 0; tw0 = 0; tw1 = 0; // translation ranges
   deg0 = 0; deg1 = 0; // rotation range
@@ -1984,6 +1973,11 @@ void jitter_module<T>::set_padding(std::vector<uint> &p) {
   zp = new zpad_module<T>(p[0], p[1], p[2], p[3]);
 }
 
+template <typename T>
+void jitter_module<T>::set_parallel(bool p) {
+  parallel = p;
+}
+
 template <typename T>
 void jitter_module<T>::fprop1(idx<T> &in, idx<T> &out) {
   idx<T> *i = &in;
@@ -1993,24 +1987,38 @@ void jitter_module<T>::fprop1(idx<T> &in, idx<T> &out) {
   }
   this->resize_output(*i, out);
   if (this->ignored1(in, out)) return ;
-  // random deformations
-  int th = (int) drand(th0, th1), tw = (int) drand(tw0, tw1); // translation
-  float deg = drand(deg0, deg1); // rotation
-  float sh = drand(sh0, sh1), sw = drand(sw0, sw1); // scale
-  float shh = drand(shh0, shh1), shw = drand(shw0, shw1); // shear
-  uint elsize = (uint) drand(elsz0, elsz1);
+  // random deformations, drawn from this module's own stream so that they
+  // do not depend on other modules running concurrently
+  philox &g = gen.get();
+  double u[8];
+  for (uint k = 0; k < 8; ++k) u[k] = g.uniform();
+  int th = (int) (th0 + u[0] * (th1 - th0)); // translation
+  int tw = (int) (tw0 + u[1] * (tw1 - tw0));
+  float deg = deg0 + u[2] * (deg1 - deg0); // rotation
+  float sh = sh0 + u[3] * (sh1 - sh0), sw = sw0 + u[4] * (sw1 - sw0); // scale
+  float shh = shh0 + u[5] * (shh1 - shh0); // shear
+  float shw = shw0 + u[6] * (shw1 - shw0);
+  uint elsize = (uint) (elsz0 + u[7] * ((double) elsz1 - elsz0));
   float elc = elsize; // elastic
-  // expect channels to be in dim 2,
-  // TODO: allow specifying planar or interleaved in image_deformation
-  // function to avoid this inefficient and dirty code
-  idx<T> i2 = i->shift_dim(0, 2);
-  idx<T> a(i2.get_idxdim()), b(i2.get_idxdim());
-  idx_copy(i2, a);
-  // deform
-  image_deformation(a, b, th, tw, sh, sw, deg, shh, shw, elsize, elc);
-  // TODO: same as above
-  b = b.shift_dim(2, 0);
-  idx_copy(b, out);
+  // the warp cannot read and write the same data
+  if (i->getstorage() == out.getstorage()) {
+    if (src.get_idxdim() != i->get_idxdim()) src = idx<T>(i->get_idxdim());
+    idx_copy(*i, src);
+    i = &src;
+  }
+  // warp planar input directly, a dense flow is only needed for elastic
+  // deformations
+  float m[6];
+  deformation_affine(i->dim(1), i->dim(2), th, tw, sh, sw, deg, shh, shw, m);
+  idx<float> *f = NULL;
+  if (elsize > 0) {
+    idxdim d(2, i->dim(1), i->dim(2));
+    if (flow.get_idxdim() != d) flow = idx<float>(d);
+    idx_clear(flow);
+    elastic_flow(flow, elsize, elc, &noise, &smooth, &g);
+    f = &flow;
+  }
+  image_warp_affine(*i, out, m, f, (T) 0, parallel);
 }
 
 template <typename T>
@@ -2047,6 +2055,7 @@ module_1_1<T>* jitter_module<T>::copy(parameter<T> *p) {
   l2->shh0 = shh0; l2->shh1 = shh1; l2->shw0 = shw0; l2->shw1 = shw1;
   l2->elsz0 = elsz0; l2->elsz1 = elsz1;
   l2->elcoeff0 = elcoeff0; l2->elcoeff1 = elcoeff1;
+  l2->parallel = parallel;
   return l2;
 }
 
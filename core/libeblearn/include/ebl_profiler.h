@@ -0,0 +1,168 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef EBL_PROFILER_H_
+#define EBL_PROFILER_H_
+
+#include "ebl_module.h"
+
+#ifdef __PTHREAD__
+#include <pthread.h>
+#endif
+
+#include <map>
+
+namespace ebl {
+
+//! Types of propagation recorded by the profiler.
+enum profile_type { PROF_FPROP = 0, PROF_BPROP = 1, PROF_BBPROP = 2,
+                    PROF_NTYPES = 3 };
+
+// profile_counters ////////////////////////////////////////////////////////////
+
+//! Cumulative counters of one module instance for one type of propagation.
+//! Flops and bytes are estimates, see module_1_1::fprop_flops().
+class EXPORT profile_counters {
+ public:
+  profile_counters();
+  //! Reset all counters to zero.
+  void clear();
+  //! Add all counters of 'c' to this.
+  void add(const profile_counters &c);
+
+  uint64 calls;           //!< Number of calls.
+  double seconds;         //!< Cumulative wall-clock time.
+  double flops;           //!< Estimated floating point operations.
+  double bytes_moved;     //!< Estimated bytes read and written.
+  double bytes_allocated; //!< Growth of output buffers.
+};
+
+// module_profile //////////////////////////////////////////////////////////////
+
+//! All counters of one module instance.
+class EXPORT module_profile {
+ public:
+  module_profile(const void *mod, const void *parent, const char *name);
+
+  const void *mod;                          //!< The profiled module.
+  const void *parent;                       //!< The module calling it.
+  std::string name;                         //!< Name of the module.
+  profile_counters counters[PROF_NTYPES];   //!< Counters of each type.
+};
+
+// profiler ////////////////////////////////////////////////////////////////////
+
+//! Collects per-module timing and cost estimates of fprop, bprop and bbprop,
+//! as recorded by containers (layers, ms_module) around each module they
+//! call. Modules are identified by their address and attributed to the
+//! container calling them, which gives a tree of modules in the report.
+//! Profiling is off by default, in which case it costs a single test per
+//! module call.
+class EXPORT profiler {
+ public:
+  profiler();
+  virtual ~profiler();
+  //! Returns the library-wide profiler.
+  static profiler& global();
+  //! Returns true if profiling is enabled.
+  static inline bool enabled() { return active; }
+  //! Enable or disable profiling.
+  void enable(bool on = true);
+  //! Add a call of 'type' to module 'mod' called by 'parent'.
+  void record(const void *mod, const void *parent, const char *name,
+              profile_type type, const profile_counters &c);
+  //! Removes all recorded modules.
+  void clear();
+  //! Returns the number of recorded modules.
+  uint size();
+  //! Returns counters of 'type' of module 'mod', including the modules it
+  //! calls. Returns zero counters if 'mod' was never recorded.
+  profile_counters get(const void *mod, profile_type type);
+  //! Prints a table of all recorded modules, indented by caller.
+  void report(std::ostream &out);
+  //! Prints all recorded modules in JSON format.
+  void report_json(std::ostream &out);
+  //! Prints all recorded modules in JSON format into file 'fname'.
+  //! Returns false if file could not be written.
+  bool save_json(const std::string &fname);
+
+ protected:
+  //! Returns counters of 'type' of module 'i' including its children.
+  profile_counters total(uint i, profile_type type);
+  //! Prints module 'i' and its children in 'out', indented by 'indent'.
+  void report_module(std::ostream &out, uint i, uint indent, double tfprop);
+  //! Returns indices of modules called by module 'i'.
+  std::vector<uint> children(uint i);
+  //! Returns indices of modules not called by any other recorded module.
+  std::vector<uint> roots();
+  void lock();
+  void unlock();
+
+ protected:
+  std::vector<module_profile*> profiles;   //!< All recorded modules.
+  std::map<const void*, uint> index;       //!< Index of each module.
+#ifdef __PTHREAD__
+  pthread_mutex_t m;                        //!< Protects all records.
+#endif
+  static bool active;                       //!< Profiling enabled or not.
+};
+
+// profile_scope ///////////////////////////////////////////////////////////////
+
+//! Measures a call to module 'mod' between its construction and destruction
+//! and records it into profiler::global(), if profiling is enabled.
+template <typename T> class profile_scope {
+ public:
+  //! \param parent The module calling 'mod', may be NULL.
+  profile_scope(module_1_1<T> *mod, const module *parent, profile_type type,
+                state<T> &in, state<T> &out);
+  ~profile_scope();
+ protected:
+  module_1_1<T> *mod;
+  const module *parent;
+  profile_type type;
+  state<T> &in, &out;
+  intg footprint;       //!< Output footprint before the call.
+  timer *t;             //!< Only allocated (and started) when active.
+  bool active;
+};
+
+//! Returns the number of elements of all tensors of 'v'.
+template <typename T> intg profile_nelements(svector<idx<T> > &v);
+//! Returns the footprint (in elements) of all tensors of state 's'.
+template <typename T> intg profile_footprint(state<T> &s);
+
+} // namespace ebl
+
+#include "ebl_profiler.hpp"
+
+#endif /* EBL_PROFILER_H_ */
@@ -0,0 +1,97 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef EBL_PROFILER_HPP_
+#define EBL_PROFILER_HPP_
+
+namespace ebl {
+
+// profile_scope ///////////////////////////////////////////////////////////////
+
+template <typename T>
+profile_scope<T>::profile_scope(module_1_1<T> *mod_, const module *parent_,
+                                profile_type type_, state<T> &in_,
+                                state<T> &out_)
+    : mod(mod_), parent(parent_), type(type_), in(in_), out(out_),
+      footprint(0), t(NULL), active(profiler::enabled() && mod_ != NULL) {
+  if (!active) return ;
+  footprint = profile_footprint(out);
+  t = new timer(); // starts the clock
+}
+
+template <typename T>
+profile_scope<T>::~profile_scope() {
+  if (!active) return ;
+  profile_counters c;
+  c.calls = 1;
+  c.seconds = t->elapsed_microseconds() / 1000000.0;
+  delete t;
+  intg nin = profile_nelements(in.x), nout = profile_nelements(out.x);
+  double flops = mod->fprop_flops(in, out);
+  if (type == PROF_FPROP) {
+    c.flops = flops;
+    c.bytes_moved = (double) (nin + nout) * sizeof (T);
+  } else { // gradients w.r.t. inputs and weights cost about twice the fprop
+    c.flops = 2 * flops;
+    c.bytes_moved = (double) (2 * nin + nout) * sizeof (T);
+  }
+  c.bytes_allocated =
+    (double) std::max((intg) 0, profile_footprint(out) - footprint)
+    * sizeof (T);
+  profiler::global().record(mod, parent, mod->name(), type, c);
+}
+
+// helpers /////////////////////////////////////////////////////////////////////
+
+template <typename T>
+intg profile_nelements(svector<idx<T> > &v) {
+  intg n = 0;
+  for (uint i = 0; i < v.size(); ++i)
+    if (v.exists(i)) n += v[i].nelements();
+  return n;
+}
+
+template <typename T>
+intg profile_footprint(state<T> &s) {
+  intg n = 0;
+  for (uint i = 0; i < s.x.size(); ++i)
+    if (s.x.exists(i)) n += s.x[i].footprint();
+  for (uint i = 0; i < s.dx.size(); ++i)
+    if (s.dx.exists(i)) n += s.dx[i].footprint();
+  for (uint i = 0; i < s.ddx.size(); ++i)
+    if (s.ddx.exists(i)) n += s.ddx[i].footprint();
+  return n;
+}
+
+} // namespace ebl
+
+#endif /* EBL_PROFILER_HPP_ */
@@ -0,0 +1,263 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Yann LeCun, Pierre Sermanet and Soumith Chintala*
+ *   yann@cs.nyu.edu, pierre.sermanet@gmail.com, soumith@gmail.com  *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef EBL_QUANTIZE_H_
+#define EBL_QUANTIZE_H_
+
+#include "ebl_defines.h"
+#include "libidx.h"
+#include "ebl_arch.h"
+#include "ebl_basic.h"
+#include "ebl_nonlinearity.h"
+#include "datasource.h"
+
+namespace ebl {
+
+// quantization utilities //////////////////////////////////////////////////////
+
+//! Returns the scale mapping values in [-absmax, absmax] to [-127, 127].
+template <typename T> T quantize_scale(T absmax);
+//! Quantizes 'in' into 'out' as round(in * scale), saturated to [-127, 127].
+//! 'out' is resized to 'in' dimensions iff necessary.
+template <typename T> void idx_quantize(idx<T> &in, T scale, idx<byte> &out);
+
+// quantized_module ////////////////////////////////////////////////////////////
+
+//! Base class of post-training quantized modules. Such a module wraps a
+//! trained float module and, once calibrated, runs its forward pass with
+//! 8-bit weights and inputs and 32-bit integer accumulators.
+//! Inputs and outputs remain of type T so that quantized modules can be
+//! mixed with regular ones in a layers stack.
+//! While in calibration mode, fprop calls the wrapped module and records
+//! the range of its inputs, finalize() then fixes the input scale.
+//! These modules are inference-only, bprop and bbprop raise an error.
+template <typename T> class quantized_module : public module_1_1<T> {
+ public:
+  //! Constructor.
+  //! \param m The trained module to quantize. It is not owned.
+  quantized_module(module_1_1<T> &m, const char *name = "quantized");
+  //! Destructor.
+  virtual ~quantized_module();
+
+  //! Forward propagation from 'in' tensor to 'out' tensor.
+  virtual void fprop1(idx<T> &in, idx<T> &out);
+  //! Errors, quantized modules are inference-only.
+  virtual void bprop1(state<T> &in, state<T> &out);
+  //! Errors, quantized modules are inference-only.
+  virtual void bbprop1(state<T> &in, state<T> &out);
+
+  //! Enable or disable calibration mode. Enabling resets input statistics.
+  virtual void set_calibration(bool enable);
+  //! Compute the input scale from the statistics gathered during calibration.
+  virtual void finalize();
+  //! Returns true if finalize() has been called.
+  virtual bool is_calibrated();
+  //! Returns the input scale.
+  virtual T get_input_scale();
+
+  //! Return dimensions that are compatible with the wrapped module.
+  virtual fidxdim fprop1_size(fidxdim &i_size);
+  //! Return input dimensions given output dimensions of the wrapped module.
+  virtual fidxdim bprop1_size(const fidxdim &o_size);
+  //! Returns a string describing this module and its parameters.
+  virtual std::string describe();
+
+ protected:
+  //! The quantized forward propagation, called once calibrated.
+  virtual void qfprop1(idx<T> &in, idx<T> &out) = 0;
+
+  // members
+ protected:
+  module_1_1<T> &base;        //!< The wrapped float module.
+  bool           calibrating; //!< Calibration mode.
+  bool           calibrated;  //!< finalize() has been called.
+  T              absmax;      //!< Maximum absolute input seen.
+  T              in_scale;    //!< Input quantization scale.
+  idx<byte>      qin;         //!< Quantized input buffer.
+};
+
+// quantized_convolution_module ////////////////////////////////////////////////
+
+//! A convolution with 8-bit kernels (one scale per output map) and 8-bit
+//! inputs, accumulating in 32-bit integers and dequantizing once per
+//! output map. Output maps are computed in parallel on the thread pool.
+template <typename T>
+class quantized_convolution_module : public quantized_module<T> {
+ public:
+  //! Constructor. Kernels are quantized from 'c' at construction time,
+  //! call it again (or finalize()) if 'c' weights change.
+  quantized_convolution_module(convolution_module<T> &c,
+                               const char *name = "quantized_convolution");
+  //! Destructor.
+  virtual ~quantized_convolution_module();
+  //! Re-quantize kernels and compute the input scale.
+  virtual void finalize();
+  //! Returns a string describing this module and its parameters.
+  virtual std::string describe();
+
+ protected:
+  //! The quantized forward propagation.
+  virtual void qfprop1(idx<T> &in, idx<T> &out);
+  //! Quantize the wrapped module's weights.
+  virtual void quantize_weights();
+
+  // members
+ protected:
+  convolution_module<T> &conv;  //!< The wrapped convolution.
+  idx<byte>     qkernel;        //!< Quantized kernels.
+  idx<T>        wscale;         //!< Kernel scale for each output map.
+  idx<int>      acc;            //!< Integer accumulators.
+  std::vector<std::vector<intg> > conns; //!< Connections of each output.
+};
+
+// quantized_convolution_task //////////////////////////////////////////////////
+
+//! Computes one output map of a quantized convolution per piece.
+template <typename T> class quantized_convolution_task : public parallel_task {
+ public:
+  //! Constructor. All buffers must be contiguous.
+  quantized_convolution_task(idx<byte> &qin, idx<byte> &qkernel,
+                             idx<intg> &table,
+                             std::vector<std::vector<intg> > &conns,
+                             idx<int> &acc, idx<T> &out, idx<T> &wscale,
+                             T in_scale, intg si, intg sj);
+  //! Computes output map i.
+  virtual void run(intg i);
+
+ protected:
+  idx<byte> &qin, &qkernel;
+  idx<intg> &table;
+  std::vector<std::vector<intg> > &conns;
+  idx<int> &acc;
+  idx<T> &out, &wscale;
+  T in_scale;
+  intg si, sj;
+};
+
+// quantized_linear_module /////////////////////////////////////////////////////
+
+//! A linear module with 8-bit weights (one scale per output) and 8-bit
+//! inputs, accumulating in 32-bit integers.
+template <typename T> class quantized_linear_module : public quantized_module<T> {
+ public:
+  //! Constructor. Weights are quantized from 'l' at construction time.
+  quantized_linear_module(linear_module<T> &l,
+                          const char *name = "quantized_linear");
+  //! Destructor.
+  virtual ~quantized_linear_module();
+  //! Re-quantize weights and compute the input scale.
+  virtual void finalize();
+  //! Returns a string describing this module and its parameters.
+  virtual std::string describe();
+
+ protected:
+  //! The quantized forward propagation.
+  virtual void qfprop1(idx<T> &in, idx<T> &out);
+  //! Quantize the wrapped module's weights.
+  virtual void quantize_weights();
+
+  // members
+ protected:
+  linear_module<T> &lin;      //!< The wrapped linear module.
+  idx<byte>         qw;       //!< Quantized weights.
+  idx<T>            wscale;   //!< Weight scale for each output.
+  idx<int>          acc;      //!< Integer accumulators.
+};
+
+// tanh_lut_module /////////////////////////////////////////////////////////////
+
+//! The output of tanh_module computed from a lookup table with linear
+//! interpolation. Outside of [-range, range] the table is extrapolated
+//! linearly from its first or last interval.
+template <typename T> class tanh_lut_module : public module_1_1<T> {
+ public:
+  //! Constructor.
+  //! \param linear_coeff Coefficient of the linear term (see tanh_module).
+  //! \param range The table covers [-range, range].
+  //! \param size The number of entries in the table.
+  tanh_lut_module(double linear_coeff = 0, T range = 8, intg size = 4096,
+                  const char *name = "tanh_lut");
+  //! Destructor.
+  virtual ~tanh_lut_module();
+  //! Forward propagation from 'in' tensor to 'out' tensor.
+  virtual void fprop1(idx<T> &in, idx<T> &out);
+  //! Returns a deep copy of this module.
+  virtual module_1_1<T>* copy(parameter<T> *p = NULL);
+  //! Returns a string describing this module and its parameters.
+  virtual std::string describe();
+
+  // members
+ protected:
+  idx<T>  lut;    //!< tanh values at regular intervals in [-range, range].
+  double  alpha;  //!< Coefficient of the linear term.
+  T       range;  //!< Input range covered by the table.
+  T       step;   //!< 1 / table interval.
+};
+
+// quantized_layers ////////////////////////////////////////////////////////////
+
+//! A mirror of a trained layers network where convolution and linear
+//! modules are replaced by their quantized versions and tanh modules by
+//! lookup tables. Other modules (pooling, normalization, ...) are shared
+//! with the original network, which must outlive this object.
+//! Call calibrate() before use.
+template <typename T> class quantized_layers : public layers<T> {
+ public:
+  //! Constructor.
+  //! \param net The trained network to mirror.
+  quantized_layers(layers<T> &net, const char *name = "quantized_layers");
+  //! Destructor.
+  virtual ~quantized_layers();
+
+  //! Runs the float network over the first 'n' samples of 'ds' (or all
+  //! of them if n is 0) to determine quantization ranges.
+  template <typename Tdata>
+    void calibrate(datasource<T,Tdata> &ds, intg n = 0);
+  //! Enable or disable calibration mode in all quantized modules.
+  virtual void set_calibration(bool enable);
+  //! Computes quantization scales of all quantized modules.
+  virtual void finalize();
+  //! Returns the number of modules that were quantized.
+  virtual uint nquantized();
+
+  // members
+ protected:
+  std::vector<quantized_module<T>*> qmodules; //!< Quantized modules.
+  std::vector<quantized_layers<T>*> qlayers;  //!< Quantized sub-networks.
+  std::vector<module_1_1<T>*>       created;  //!< Modules owned by this.
+};
+
+} // namespace ebl {
+
+#include "ebl_quantize.hpp"
+
+#endif /* EBL_QUANTIZE_H_ */
@@ -0,0 +1,464 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Yann LeCun, Pierre Sermanet and Soumith Chintala*
+ *   yann@cs.nyu.edu, pierre.sermanet@gmail.com, soumith@gmail.com  *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+namespace ebl {
+
+// quantization utilities //////////////////////////////////////////////////////
+
+template <typename T> T quantize_scale(T absmax) {
+  if (absmax <= 0) return (T) 1;
+  return (T) 127 / absmax;
+}
+
+template <typename T> void idx_quantize(idx<T> &in, T scale, idx<byte> &out) {
+  idxdim d(in);
+  if (!out.same_dim(d)) out = idx<byte>(d);
+  if (in.contiguousp() && out.contiguousp()) {
+    const T *pi = in.idx_ptr();
+    byte *po = out.idx_ptr();
+    for (intg i = 0, n = in.nelements(); i < n; ++i) {
+      T v = pi[i] * scale;
+      v = v < -127 ? -127 : (v > 127 ? 127 : v);
+      po[i] = (byte) (v < 0 ? v - (T) .5 : v + (T) .5);
+    }
+  } else {
+    idx_aloop2(pi, in, T, po, out, byte) {
+      T v = *pi * scale;
+      v = v < -127 ? -127 : (v > 127 ? 127 : v);
+      *po = (byte) (v < 0 ? v - (T) .5 : v + (T) .5);
+    }
+  }
+}
+
+// quantized_module ////////////////////////////////////////////////////////////
+
+template <typename T>
+quantized_module<T>::quantized_module(module_1_1<T> &m, const char *name_)
+    : module_1_1<T>(name_), base(m), calibrating(false), calibrated(false),
+      absmax(0), in_scale(1) {
+}
+
+template <typename T>
+quantized_module<T>::~quantized_module() {
+}
+
+template <typename T>
+void quantized_module<T>::fprop1(idx<T> &in, idx<T> &out) {
+  if (calibrating) { // record input range and run float module
+    absmax = std::max(absmax, std::max(idx_max(in), (T) -idx_min(in)));
+    base.fprop1(in, out);
+    return ;
+  }
+  if (!calibrated)
+    eblerror(this->name() << ": quantized module used before calibration");
+  qfprop1(in, out);
+}
+
+template <typename T>
+void quantized_module<T>::bprop1(state<T> &in, state<T> &out) {
+  eblerror(this->name() << ": quantized modules are inference-only");
+}
+
+template <typename T>
+void quantized_module<T>::bbprop1(state<T> &in, state<T> &out) {
+  eblerror(this->name() << ": quantized modules are inference-only");
+}
+
+template <typename T>
+void quantized_module<T>::set_calibration(bool enable) {
+  calibrating = enable;
+  if (enable) absmax = 0;
+}
+
+template <typename T>
+void quantized_module<T>::finalize() {
+  calibrating = false;
+  in_scale = quantize_scale(absmax);
+  calibrated = true;
+}
+
+template <typename T>
+bool quantized_module<T>::is_calibrated() {
+  return calibrated;
+}
+
+template <typename T>
+T quantized_module<T>::get_input_scale() {
+  return in_scale;
+}
+
+template <typename T>
+fidxdim quantized_module<T>::fprop1_size(fidxdim &i_size) {
+  return base.fprop1_size(i_size);
+}
+
+template <typename T>
+fidxdim quantized_module<T>::bprop1_size(const fidxdim &o_size) {
+  return base.bprop1_size(o_size);
+}
+
+template <typename T>
+std::string quantized_module<T>::describe() {
+  std::string s;
+  s << "8-bit quantized " << base.describe() << ", input range "
+    << (T) 127 / in_scale;
+  return s;
+}
+
+// quantized_convolution_module ////////////////////////////////////////////////
+
+template <typename T>
+quantized_convolution_module<T>::
+quantized_convolution_module(convolution_module<T> &c, const char *name_)
+    : quantized_module<T>(c, name_), conv(c) {
+  quantize_weights();
+}
+
+template <typename T>
+quantized_convolution_module<T>::~quantized_convolution_module() {
+}
+
+template <typename T>
+void quantized_convolution_module<T>::finalize() {
+  quantized_module<T>::finalize();
+  quantize_weights();
+}
+
+template <typename T>
+void quantized_convolution_module<T>::quantize_weights() {
+  idx<T> k = conv.kernel;
+  idx<intg> &table = conv.table;
+  intg nout = 0;
+  for (intg c = 0; c < table.dim(0); ++c)
+    nout = std::max(nout, table.get(c, 1) + 1);
+  // group connections by output map
+  conns.assign(nout, std::vector<intg>());
+  for (intg c = 0; c < table.dim(0); ++c)
+    conns[table.get(c, 1)].push_back(c);
+  // one scale per output map, so that all its connections can be summed
+  // in the same integer accumulator
+  wscale = idx<T>(nout);
+  qkernel = idx<byte>(k.get_idxdim());
+  for (intg o = 0; o < nout; ++o) {
+    T m = 0;
+    for (uint i = 0; i < conns[o].size(); ++i) {
+      idx<T> kc = k.select(0, conns[o][i]);
+      m = std::max(m, std::max(idx_max(kc), (T) -idx_min(kc)));
+    }
+    wscale.set(quantize_scale(m), o);
+    for (uint i = 0; i < conns[o].size(); ++i) {
+      idx<T> kc = k.select(0, conns[o][i]);
+      idx<byte> qc = qkernel.select(0, conns[o][i]);
+      idx_quantize(kc, wscale.get(o), qc);
+    }
+  }
+}
+
+template <typename T>
+void quantized_convolution_module<T>::qfprop1(idx<T> &in, idx<T> &out) {
+  if (!conv.resize_output(in, out))
+    return ; // do nothing if resizing failed
+  // 'in' may have any strides, it is copied into the contiguous quantized
+  // buffer that the task reads with raw pointer strides.
+  idx_quantize(in, this->in_scale, this->qin);
+  CHECK_CONTIGUOUS2(this->qin, qkernel);
+  idxdim d(out);
+  if (!acc.same_dim(d)) acc = idx<int>(d);
+  quantized_convolution_task<T> job(this->qin, qkernel, conv.table, conns,
+                                    acc, out, wscale, this->in_scale,
+                                    conv.stride.dim(0), conv.stride.dim(1));
+  parallel_run(job, out.dim(0));
+}
+
+template <typename T>
+std::string quantized_convolution_module<T>::describe() {
+  std::string s;
+  s << quantized_module<T>::describe() << ", " << conns.size()
+    << " output maps with 32-bit accumulators";
+  return s;
+}
+
+// quantized_convolution_task //////////////////////////////////////////////////
+
+template <typename T>
+quantized_convolution_task<T>::
+quantized_convolution_task(idx<byte> &qin_, idx<byte> &qkernel_,
+                           idx<intg> &table_,
+                           std::vector<std::vector<intg> > &conns_,
+                           idx<int> &acc_, idx<T> &out_, idx<T> &wscale_,
+                           T in_scale_, intg si_, intg sj_)
+    : qin(qin_), qkernel(qkernel_), table(table_), conns(conns_), acc(acc_),
+      out(out_), wscale(wscale_), in_scale(in_scale_), si(si_), sj(sj_) {
+}
+
+template <typename T>
+void quantized_convolution_task<T>::run(intg o) {
+  intg oi = acc.dim(1), oj = acc.dim(2);
+  intg ki = qkernel.dim(1), kj = qkernel.dim(2);
+  intg inrow = qin.mod(1);
+  int *a = acc.idx_ptr() + o * acc.mod(0);
+  memset(a, 0, oi * oj * sizeof (int));
+  // accumulate all connections to this output in integers
+  std::vector<intg> &oconns = conns[o];
+  for (uint c = 0; c < oconns.size(); ++c) {
+    const byte *src = qin.idx_ptr() + table.get(oconns[c], 0) * qin.mod(0);
+    const byte *k = qkernel.idx_ptr() + oconns[c] * qkernel.mod(0);
+    for (intg r = 0; r < oi; ++r) {
+      int *arow = a + r * oj;
+      for (intg u = 0; u < ki; ++u) {
+        const byte *srow = src + (r * si + u) * inrow;
+        for (intg v = 0; v < kj; ++v) {
+          int kv = k[u * kj + v];
+          if (kv == 0) continue ;
+          const byte *s = srow + v;
+          if (sj == 1)
+            for (intg col = 0; col < oj; ++col) arow[col] += kv * s[col];
+          else
+            for (intg col = 0; col < oj; ++col) arow[col] += kv * s[col * sj];
+        }
+      }
+    }
+  }
+  // dequantize once
+  T f = 1 / (in_scale * wscale.get(o));
+  T *po = out.idx_ptr() + o * out.mod(0);
+  intg m1 = out.mod(1), m2 = out.mod(2);
+  for (intg r = 0; r < oi; ++r)
+    for (intg col = 0; col < oj; ++col)
+      po[r * m1 + col * m2] = (T) a[r * oj + col] * f;
+}
+
+// quantized_linear_module /////////////////////////////////////////////////////
+
+template <typename T>
+quantized_linear_module<T>::
+quantized_linear_module(linear_module<T> &l, const char *name_)
+    : quantized_module<T>(l, name_), lin(l) {
+  quantize_weights();
+}
+
+template <typename T>
+quantized_linear_module<T>::~quantized_linear_module() {
+}
+
+template <typename T>
+void quantized_linear_module<T>::finalize() {
+  quantized_module<T>::finalize();
+  quantize_weights();
+}
+
+template <typename T>
+void quantized_linear_module<T>::quantize_weights() {
+  idx<T> w = lin.w;
+  wscale = idx<T>(w.dim(0));
+  qw = idx<byte>(w.dim(0), w.dim(1));
+  for (intg o = 0; o < w.dim(0); ++o) {
+    idx<T> wo = w.select(0, o);
+    idx<byte> qo = qw.select(0, o);
+    wscale.set(quantize_scale(std::max(idx_max(wo), (T) -idx_min(wo))), o);
+    idx_quantize(wo, wscale.get(o), qo);
+  }
+}
+
+template <typename T>
+void quantized_linear_module<T>::qfprop1(idx<T> &in, idx<T> &out) {
+  if (in.dim(0) != qw.dim(1))
+    eblerror(this->name() << ": expected " << qw.dim(1)
+             << " elements in dimension 0 but got " << in);
+  // flatten dimensions starting from second one, as linear_module does
+  idxdim d(in);
+  d.remove_dim(0);
+  intg ncols = d.nelements();
+  d.insert_dim(0, qw.dim(0));
+  this->resize_output(in, out, &d); // resize (iff necessary)
+  CHECK_CONTIGUOUS1(out);
+  idx_quantize(in, this->in_scale, this->qin);
+  CHECK_CONTIGUOUS1(this->qin);
+  if (!acc.same_dim(idxdim(ncols))) acc = idx<int>(ncols);
+  intg nin = qw.dim(1);
+  const byte *src = this->qin.idx_ptr();
+  int *a = acc.idx_ptr();
+  T *po = out.idx_ptr();
+  for (intg o = 0; o < qw.dim(0); ++o, po += ncols) {
+    const byte *w = qw.idx_ptr() + o * nin;
+    memset(a, 0, ncols * sizeof (int));
+    for (intg k = 0; k < nin; ++k) {
+      int wk = w[k];
+      if (wk == 0) continue ;
+      const byte *s = src + k * ncols;
+      for (intg j = 0; j < ncols; ++j) a[j] += wk * s[j];
+    }
+    T f = 1 / (this->in_scale * wscale.get(o));
+    for (intg j = 0; j < ncols; ++j) po[j] = (T) a[j] * f;
+  }
+}
+
+template <typename T>
+std::string quantized_linear_module<T>::describe() {
+  std::string s;
+  s << quantized_module<T>::describe() << ", " << qw.dim(0)
+    << " outputs with 32-bit accumulators";
+  return s;
+}
+
+// tanh_lut_module /////////////////////////////////////////////////////////////
+
+template <typename T>
+tanh_lut_module<T>::tanh_lut_module(double linear_coeff, T range_, intg size,
+                                    const char *name_)
+    : module_1_1<T>(name_), lut(size), alpha(linear_coeff), range(range_) {
+  if (size < 2) eblerror("expected at least 2 entries in tanh table");
+  step = (T) (size - 1) / (2 * range);
+  // fill the table with tanh_module itself so that both agree on entries
+  idx<T> x(size);
+  for (intg i = 0; i < size; ++i) x.set((T) (-range + i / (double) step), i);
+  tanh_module<T> th(alpha);
+  th.fprop1(x, lut);
+}
+
+template <typename T>
+tanh_lut_module<T>::~tanh_lut_module() {
+}
+
+template <typename T>
+void tanh_lut_module<T>::fprop1(idx<T> &in, idx<T> &out) {
+  this->resize_output(in, out); // resize iff necessary
+  const T *l = lut.idx_ptr();
+  intg last = lut.dim(0) - 1;
+  T r = range, s = step;
+  // linear interpolation inside the table, linear extrapolation outside
+#define TANH_LUT(x, y) {                                        \
+    T p = ((x) + r) * s;                                        \
+    intg j = p <= 0 ? 0 : (p >= last ? last - 1 : (intg) p);    \
+    y = l[j] + (p - j) * (l[j + 1] - l[j]);                     \
+  }
+  if (in.contiguousp() && out.contiguousp()) {
+    const T *pi = in.idx_ptr();
+    T *po = out.idx_ptr();
+    for (intg i = 0, n = in.nelements(); i < n; ++i) TANH_LUT(pi[i], po[i]);
+  } else {
+    idx_aloop2(pi, in, T, po, out, T) { TANH_LUT(*pi, *po); }
+  }
+#undef TANH_LUT
+}
+
+template <typename T>
+module_1_1<T>* tanh_lut_module<T>::copy(parameter<T> *p) {
+  return new tanh_lut_module<T>(alpha, range, lut.dim(0), this->name());
+}
+
+template <typename T>
+std::string tanh_lut_module<T>::describe() {
+  std::string s;
+  s << "tanh lookup table module " << this->name() << " with "
+    << lut.dim(0) << " entries in [" << -range << ", " << range
+    << "] and linear coefficient " << alpha;
+  return s;
+}
+
+// quantized_layers ////////////////////////////////////////////////////////////
+
+template <typename T>
+quantized_layers<T>::quantized_layers(layers<T> &net, const char *name_)
+    : layers<T>(false, name_) {
+  for (uint i = 0; i < net.modules.size(); ++i) {
+    module_1_1<T> *m = net.modules[i], *q = m;
+    layers<T> *l = dynamic_cast<layers<T>*>(m);
+    convolution_module<T> *c = dynamic_cast<convolution_module<T>*>(m);
+    linear_module<T> *lm = dynamic_cast<linear_module<T>*>(m);
+    tanh_module<T> *th = dynamic_cast<tanh_module<T>*>(m);
+    if (l) {
+      quantized_layers<T> *ql = new quantized_layers<T>(*l, m->name());
+      qlayers.push_back(ql);
+      q = ql;
+    } else if (c) {
+      quantized_module<T> *qm =
+          new quantized_convolution_module<T>(*c, m->name());
+      qmodules.push_back(qm);
+      q = qm;
+    } else if (lm) {
+      quantized_module<T> *qm = new quantized_linear_module<T>(*lm, m->name());
+      qmodules.push_back(qm);
+      q = qm;
+    } else if (th)
+      q = new tanh_lut_module<T>(th->get_linear_coeff(), 8, 4096, m->name());
+    if (q != m) created.push_back(q);
+    this->add_module(q);
+  }
+}
+
+template <typename T>
+quantized_layers<T>::~quantized_layers() {
+  for (uint i = 0; i < created.size(); ++i) delete created[i];
+  // hidden buffers are ours even though modules are not all
+  if (!this->memoptimized)
+    for (uint i = 0; i < this->hiddens.size(); ++i)
+      if (this->hiddens[i]) delete this->hiddens[i];
+}
+
+template <typename T> template <typename Tdata>
+void quantized_layers<T>::calibrate(datasource<T,Tdata> &ds, intg n) {
+  if (n <= 0 || n > (intg) ds.size()) n = ds.size();
+  set_calibration(true);
+  state<T> in, out;
+  ds.seek_begin();
+  for (intg i = 0; i < n; ++i) {
+    ds.fprop_data(in);
+    this->fprop(in, out);
+    ds.next();
+  }
+  finalize();
+  ds.seek_begin();
+}
+
+template <typename T>
+void quantized_layers<T>::set_calibration(bool enable) {
+  for (uint i = 0; i < qmodules.size(); ++i)
+    qmodules[i]->set_calibration(enable);
+  for (uint i = 0; i < qlayers.size(); ++i)
+    qlayers[i]->set_calibration(enable);
+}
+
+template <typename T>
+void quantized_layers<T>::finalize() {
+  for (uint i = 0; i < qmodules.size(); ++i) qmodules[i]->finalize();
+  for (uint i = 0; i < qlayers.size(); ++i) qlayers[i]->finalize();
+}
+
+template <typename T>
+uint quantized_layers<T>::nquantized() {
+  uint n = (uint) qmodules.size();
+  for (uint i = 0; i < qlayers.size(); ++i) n += qlayers[i]->nquantized();
+  return n;
+}
+
+} // end namespace ebl
@@ -404,16 +404,16 @@ state<T> state<T>::select_state(int dimension, intg slice_index) {
   // forward
   for (uint i = 0; i < x.size(); i++)
     if (x.exists(i))
-      s.x.push_back_new(s.x[i].select(dimension, slice_index));
+      s.x.push_back_new(x[i].select(dimension, slice_index));
   s.link_f0();
   // backward
   for (uint i = 0; i < dx.size(); i++)
     if (dx.exists(i))
-      s.dx.push_back_new(s.dx[i].select(dimension, slice_index));
+      s.dx.push_back_new(dx[i].select(dimension, slice_index));
   // bbackward
   for (uint i = 0; i < ddx.size(); i++)
     if (ddx.exists(i))
-      s.ddx.push_back_new(s.ddx[i].select(dimension, slice_index));
+      s.ddx.push_back_new(ddx[i].select(dimension, slice_index));
   return s;
 }
 
@@ -425,31 +425,34 @@ state<T> state<T>::narrow_state(int d, intg sz, intg o) {
   // forward
   for (uint i = 0; i < x.size(); i++)
     if (x.exists(i))
-      s.x.push_back_new(s.x[i].narrow(d, sz, o));
+      s.x.push_back_new(x[i].narrow(d, sz, o));
   s.link_f0();
   // backward
   for (uint i = 0; i < dx.size(); i++)
     if (dx.exists(i))
-      s.dx.push_back_new(s.dx[i].narrow(d, sz, o));
+      s.dx.push_back_new(dx[i].narrow(d, sz, o));
   // bbackward
   for (uint i = 0; i < ddx.size(); i++)
     if (ddx.exists(i))
-      s.ddx.push_back_new(s.ddx[i].narrow(d, sz, o));
+      s.ddx.push_back_new(ddx[i].narrow(d, sz, o));
   return s;
 }
 
 template <typename T>
 state<T> state<T>::narrow_state(intg size, intg offset) {
-  if ((uint) (size + offset) > x.size())
+  if (offset < 0 || (uint) (size + offset) > x.size())
     eblerror("cannot narrow this vector of size " << x.size()
              << " to size " << size << " starting at offset " << offset);
   state<T> s;
   s.x.clear();
   s.forward_only = forward_only;
+  // new views of the tensors: sharing the tensors themselves would let s
+  // release them (the first one is replaced by s's main tensor)
   for (uint i = 0; i < size; ++i) {
-    s.add_x(x.at(i + offset));
-    if (i < dx.size()) s.dx.push_back(dx.at(i + offset));
-    if (i < ddx.size()) s.ddx.push_back(ddx.at(i + offset));
+    size_t j = (size_t) (i + offset);
+    s.add_x_new(x[j]);
+    if (j < dx.size()) s.dx.push_back_new(dx[j]);
+    if (j < ddx.size()) s.ddx.push_back_new(ddx[j]);
   }
   return s;
 }
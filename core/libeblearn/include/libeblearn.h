@@ -52,6 +52,7 @@
 #include "ebl_normalization.h"
 #include "ebl_parameters.h"
 #include "ebl_pooling.h"
+#include "ebl_profiler.h"
 #include "ebl_preprocessing.h"
 #include "ebl_state.h"
 #include "ebl_utils.h"
@@ -61,6 +62,7 @@
 #include "ebl_tester.h"
 #include "ebl_trainer.h"
 #include "datasource.h"
+#include "ebl_quantize.h"
 #endif
 
 #ifdef __CUDA__
@@ -30,9 +30,85 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  ***************************************************************************/
 
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
 #include "detector.h"
 
 namespace ebl {
 
+// detector_timing /////////////////////////////////////////////////////////////
+
+detector_timing::detector_timing() {
+  clear();
+}
+
+void detector_timing::clear() {
+  prepare = 0;
+  pyramid = 0;
+  fprop = 0;
+  answers = 0;
+  extraction = 0;
+  nms = 0;
+  total = 0;
+}
+
+double detector_timing::get(uint i) const {
+  switch (i) {
+    case 0: return prepare;
+    case 1: return pyramid;
+    case 2: return fprop;
+    case 3: return answers;
+    case 4: return extraction;
+    case 5: return nms;
+    case 6: return total;
+    default: eblerror("no timing stage " << i);
+  }
+  return 0;
+}
+
+const char* detector_timing::stage_name(uint i) {
+  static const char *names[] = { "prepare", "pyramid", "fprop", "answers",
+                                 "extraction", "nms", "total" };
+  if (i > nstages) eblerror("no timing stage " << i);
+  return names[i];
+}
+
+double nearest_rank(const std::vector<double> &sorted, double p) {
+  intg n = (intg) sorted.size();
+  if (n == 0) return 0;
+  // tolerate rounding of p * n, e.g. .95 * 20 must have rank 19
+  intg r = (intg) std::ceil(p * n - 1e-9);
+  return sorted[std::min(n, std::max((intg) 1, r)) - 1];
+}
+
+void print_timing_percentiles(std::vector<detector_timing> &timings,
+                              double seconds, std::ostream &out) {
+  uint n = (uint) timings.size();
+  out << "frames=" << n << " seconds=" << seconds << " fps="
+      << (seconds > 0 ? n / seconds : 0) << std::endl;
+  if (n == 0) return ;
+  out << std::left << std::setw(12) << "stage (ms)" << std::right
+      << std::setw(10) << "p50" << std::setw(10) << "p95"
+      << std::setw(10) << "p99" << std::setw(10) << "mean" << std::endl;
+  std::vector<double> v(n);
+  for (uint s = 0; s <= detector_timing::nstages; ++s) {
+    double sum = 0;
+    for (uint i = 0; i < n; ++i) {
+      v[i] = timings[i].get(s) * 1000;
+      sum += v[i];
+    }
+    std::sort(v.begin(), v.end());
+    out << std::left << std::setw(12) << detector_timing::stage_name(s)
+        << std::right << std::fixed << std::setprecision(2);
+    double p[3] = { .50, .95, .99 };
+    for (uint k = 0; k < 3; ++k)
+      out << std::setw(10) << nearest_rank(v, p[k]);
+    out << std::setw(10) << sum / n << std::endl;
+    out.unsetf(std::ios::fixed);
+    out << std::setprecision(6);
+  }
+}
+
 } // end namespace ebl
 
@@ -0,0 +1,252 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#include "ebl_profiler.h"
+#include <iomanip>
+#include <fstream>
+
+namespace ebl {
+
+// profile_counters ////////////////////////////////////////////////////////////
+
+profile_counters::profile_counters() {
+  clear();
+}
+
+void profile_counters::clear() {
+  calls = 0;
+  seconds = 0;
+  flops = 0;
+  bytes_moved = 0;
+  bytes_allocated = 0;
+}
+
+void profile_counters::add(const profile_counters &c) {
+  calls += c.calls;
+  seconds += c.seconds;
+  flops += c.flops;
+  bytes_moved += c.bytes_moved;
+  bytes_allocated += c.bytes_allocated;
+}
+
+// module_profile //////////////////////////////////////////////////////////////
+
+module_profile::module_profile(const void *mod_, const void *parent_,
+                               const char *name_)
+    : mod(mod_), parent(parent_), name(name_ ? name_ : "") {
+}
+
+// profiler ////////////////////////////////////////////////////////////////////
+
+bool profiler::active = false;
+
+profiler::profiler() {
+#ifdef __PTHREAD__
+  pthread_mutex_init(&m, NULL);
+#endif
+}
+
+profiler::~profiler() {
+  clear();
+#ifdef __PTHREAD__
+  pthread_mutex_destroy(&m);
+#endif
+}
+
+profiler& profiler::global() {
+  static profiler p;
+  return p;
+}
+
+void profiler::enable(bool on) {
+  active = on;
+}
+
+void profiler::record(const void *mod, const void *parent, const char *name,
+                      profile_type type, const profile_counters &c) {
+  lock();
+  std::map<const void*, uint>::iterator i = index.find(mod);
+  uint k;
+  if (i != index.end()) k = i->second;
+  else {
+    k = profiles.size();
+    profiles.push_back(new module_profile(mod, parent, name));
+    index[mod] = k;
+  }
+  profiles[k]->counters[type].add(c);
+  unlock();
+}
+
+void profiler::clear() {
+  lock();
+  for (uint i = 0; i < profiles.size(); ++i) delete profiles[i];
+  profiles.clear();
+  index.clear();
+  unlock();
+}
+
+uint profiler::size() {
+  return profiles.size();
+}
+
+profile_counters profiler::get(const void *mod, profile_type type) {
+  lock();
+  profile_counters c;
+  std::map<const void*, uint>::iterator i = index.find(mod);
+  if (i != index.end()) c = total(i->second, type);
+  unlock();
+  return c;
+}
+
+void profiler::report(std::ostream &out) {
+  lock();
+  std::vector<uint> r = roots();
+  double tfprop = 0;
+  for (uint i = 0; i < r.size(); ++i)
+    tfprop += total(r[i], PROF_FPROP).seconds;
+  out << "Profile of " << profiles.size() << " modules (times are cumulative, "
+      << "flops and bytes are estimates):" << std::endl;
+  out << std::left << std::setw(32) << "module" << std::right
+      << std::setw(9) << "calls" << std::setw(12) << "fprop ms"
+      << std::setw(10) << "ms/call" << std::setw(7) << "%"
+      << std::setw(10) << "GFLOP/s" << std::setw(11) << "MB moved"
+      << std::setw(10) << "MB alloc" << std::setw(12) << "bprop ms"
+      << std::setw(12) << "bbprop ms" << std::endl;
+  for (uint i = 0; i < r.size(); ++i)
+    report_module(out, r[i], 0, tfprop);
+  unlock();
+}
+
+void profiler::report_json(std::ostream &out) {
+  const char *types[PROF_NTYPES] = { "fprop", "bprop", "bbprop" };
+  lock();
+  out << "{ \"modules\": [" << std::endl;
+  for (uint i = 0; i < profiles.size(); ++i) {
+    module_profile &p = *profiles[i];
+    std::map<const void*, uint>::iterator par = index.find(p.parent);
+    std::string name;
+    for (uint j = 0; j < p.name.size(); ++j) { // escape name
+      if (p.name[j] == '"' || p.name[j] == '\\') name += '\\';
+      name += p.name[j];
+    }
+    out << "  { \"id\": " << i << ", \"name\": \"" << name << "\", \"parent\": "
+        << (par == index.end() ? -1 : (int) par->second);
+    for (uint t = 0; t < PROF_NTYPES; ++t) {
+      profile_counters c = total(i, (profile_type) t);
+      out << ", \"" << types[t] << "\": { \"calls\": " << c.calls
+          << ", \"seconds\": " << c.seconds << ", \"flops\": " << c.flops
+          << ", \"bytes_moved\": " << c.bytes_moved
+          << ", \"bytes_allocated\": " << c.bytes_allocated << " }";
+    }
+    out << " }" << (i + 1 < profiles.size() ? "," : "") << std::endl;
+  }
+  out << "] }" << std::endl;
+  unlock();
+}
+
+bool profiler::save_json(const std::string &fname) {
+  std::ofstream f(fname.c_str());
+  if (!f) return false;
+  report_json(f);
+  return f.good();
+}
+
+// protected methods ///////////////////////////////////////////////////////////
+
+profile_counters profiler::total(uint i, profile_type type) {
+  std::vector<uint> c = children(i);
+  profile_counters t = profiles[i]->counters[type];
+  if (c.empty()) return t;
+  // a container's costs are those of the modules it calls
+  profile_counters sum;
+  for (uint j = 0; j < c.size(); ++j) sum.add(total(c[j], type));
+  t.flops = sum.flops;
+  t.bytes_moved = sum.bytes_moved;
+  t.bytes_allocated = sum.bytes_allocated;
+  return t;
+}
+
+void profiler::report_module(std::ostream &out, uint i, uint indent,
+                             double tfprop) {
+  profile_counters f = total(i, PROF_FPROP);
+  profile_counters b = total(i, PROF_BPROP);
+  profile_counters bb = total(i, PROF_BBPROP);
+  std::string name(indent * 2, ' ');
+  name += profiles[i]->name;
+  if (name.size() > 31) name = name.substr(0, 31);
+  out << std::left << std::setw(32) << name << std::right << std::fixed
+      << std::setw(9) << f.calls
+      << std::setprecision(2) << std::setw(12) << f.seconds * 1000
+      << std::setprecision(3) << std::setw(10)
+      << (f.calls ? f.seconds * 1000 / f.calls : 0.0)
+      << std::setprecision(1) << std::setw(7)
+      << (tfprop > 0 ? 100 * f.seconds / tfprop : 0.0)
+      << std::setprecision(2) << std::setw(10)
+      << (f.seconds > 0 ? f.flops / f.seconds / 1e9 : 0.0)
+      << std::setw(11) << f.bytes_moved / (1024 * 1024)
+      << std::setw(10) << f.bytes_allocated / (1024 * 1024)
+      << std::setw(12) << b.seconds * 1000
+      << std::setw(12) << bb.seconds * 1000 << std::endl;
+  out.unsetf(std::ios_base::floatfield);
+  out << std::setprecision(6);
+  std::vector<uint> c = children(i);
+  for (uint j = 0; j < c.size(); ++j)
+    report_module(out, c[j], indent + 1, tfprop);
+}
+
+std::vector<uint> profiler::children(uint i) {
+  std::vector<uint> c;
+  for (uint j = 0; j < profiles.size(); ++j)
+    if (j != i && profiles[j]->parent == profiles[i]->mod) c.push_back(j);
+  return c;
+}
+
+std::vector<uint> profiler::roots() {
+  std::vector<uint> r;
+  for (uint i = 0; i < profiles.size(); ++i)
+    if (index.find(profiles[i]->parent) == index.end()) r.push_back(i);
+  return r;
+}
+
+void profiler::lock() {
+#ifdef __PTHREAD__
+  pthread_mutex_lock(&m);
+#endif
+}
+
+void profiler::unlock() {
+#ifdef __PTHREAD__
+  pthread_mutex_unlock(&m);
+#endif
+}
+
+} // namespace ebl
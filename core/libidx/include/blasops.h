@@ -88,4 +88,43 @@ namespace ebl {
 
 #endif /* __CBLAS__ */
 
+namespace ebl {
+
+  // The following products are declared regardless of __CBLAS__: they
+  // dispatch to cblas gemm/gemv/ger when available and when strides allow
+  // it, and fall back to cache-blocked, register-tiled loops otherwise.
+
+  // m2dotm2 ///////////////////////////////////////////////////////////////////
+
+  //! Matrix-Matrix multiplication, y <- a . x
+  EXPORT void idx_m2dotm2(idx<double> &a, idx<double> &x, idx<double> &y);
+  //! Matrix-Matrix multiplication, y <- a . x
+  EXPORT void idx_m2dotm2(idx<float> &a, idx<float> &x, idx<float> &y);
+
+  // m4dotm2acc ////////////////////////////////////////////////////////////////
+
+  //! 4-tensor by 2-matrix multiplication with accumulation
+  //! R_ij += sum_kl M1_ijkl * M2_kl
+  EXPORT void idx_m4dotm2acc(idx<double> &i1, idx<double> &i2,
+			     idx<double> &o1);
+  //! 4-tensor by 2-matrix multiplication with accumulation
+  //! R_ij += sum_kl M1_ijkl * M2_kl
+  EXPORT void idx_m4dotm2acc(idx<float> &i1, idx<float> &i2, idx<float> &o1);
+
+  // m2extm2acc ////////////////////////////////////////////////////////////////
+
+  //! outer product between matrices with accumulation.
+  //! Gives a 4-tensor: R_ijkl += M1_ij * M2_kl.
+  //! o1 may be an overlapping view (e.g. an unfolded input in a convolution
+  //! bprop), in which case overlapping elements accumulate all contributions.
+  EXPORT void idx_m2extm2acc(idx<double> &i1, idx<double> &i2,
+			     idx<double> &o1);
+  //! outer product between matrices with accumulation.
+  //! Gives a 4-tensor: R_ijkl += M1_ij * M2_kl.
+  //! o1 may be an overlapping view (e.g. an unfolded input in a convolution
+  //! bprop), in which case overlapping elements accumulate all contributions.
+  EXPORT void idx_m2extm2acc(idx<float> &i1, idx<float> &i2, idx<float> &o1);
+
+} // end namespace ebl
+
 #endif /* BLASOPS_H */
@@ -51,8 +51,13 @@ namespace ebl {
   //! If the input idx has order of 1, it converts only 1 pixel.
   //! If the order is 3, it converts all pixels.
   //! The output y is expected to be allocated with the correct size.
-  template<class T>
-    void rgb_to_yuv(idx<T> &rgb, idx<T> &yuv);
+  //! Channels are expected in the last dimension of both images but
+  //! strides are arbitrary, e.g. an interleaved HxWx3 frame can be converted
+  //! straight into a planar 3xHxW buffer viewed with shift_dim(0, 2).
+  //! Conversion is done row by row with the raw rgb_to_yuv_kernel,
+  //! and whole planes at once when rows are contiguous.
+  template<class T1, class T2>
+    void rgb_to_yuv(idx<T1> &rgb, idx<T2> &yuv);
 
   //! RGB to YUV, on a 1-dimensional idx rgb.
   //! The output y is expected to be allocated with the correct size.
@@ -67,8 +72,9 @@ namespace ebl {
   //! RGB to Y, looping on the 3rd dimension if present, calling rgb_to_y_1D
   //! otherwise.
   //! The output y is expected to be allocated with the correct size.
-  template<class T>
-    void rgb_to_y(idx<T> &rgb, idx<T> &y);
+  //! See rgb_to_yuv for accepted layouts.
+  template<class T1, class T2>
+    void rgb_to_y(idx<T1> &rgb, idx<T2> &y);
 
   //! RGB to Y, on a 1-dimensional idx rgb.
   //! The output y is expected to be allocated with the correct size.
@@ -81,8 +87,13 @@ namespace ebl {
   //! BGR to Y, looping on the 3rd dimension if present, calling bgr_to_y_1D
   //! otherwise.
   //! The output y is expected to be allocated with the correct size.
-  template<class T>
-    void bgr_to_y(idx<T> &bgr, idx<T> &y);
+  //! See rgb_to_yuv for accepted layouts.
+  template<class T1, class T2>
+    void bgr_to_y(idx<T1> &bgr, idx<T2> &y);
+
+  //! Convert all pixels of bgr idx to yuv pixels, see rgb_to_yuv.
+  template<class T1, class T2>
+    void bgr_to_yuv(idx<T1> &bgr, idx<T2> &yuv);
 
   //! BGR to YUV, on a 1-dimensional idx bgr.
   //! The output y is expected to be allocated with the correct size.
@@ -94,6 +105,48 @@ namespace ebl {
   template<class T>
     void bgr_to_y_1D(idx<T> &bgr, idx<T> &y);
 
+  ////////////////////////////////////////////////////////////////
+  // Raw kernels
+
+  //! Converts n pixels whose channels are read at r[i * step], g[i * step]
+  //! and b[i * step] into yuv written at y[i * ostep], u[i * ostep] and
+  //! v[i * ostep]. Unit and interleaved (3) strides get dedicated loops
+  //! that the compiler can vectorize. Computation is done in float (double
+  //! for double outputs) and in 16-bit fixed-point for ubyte inputs.
+  //! Inputs and outputs may be the same buffer.
+  template <typename Tin, typename Tout>
+    void rgb_to_yuv_kernel(const Tin *r, const Tin *g, const Tin *b,
+			   intg step, Tout *y, Tout *u, Tout *v, intg ostep,
+			   intg n);
+
+  //! Same as rgb_to_yuv_kernel but only outputs the Y channel.
+  template <typename Tin, typename Tout>
+    void rgb_to_y_kernel(const Tin *r, const Tin *g, const Tin *b,
+			 intg step, Tout *y, intg ostep, intg n);
+
+  //! Same as rgb_to_yuv_kernel for the HSV color space.
+  template <typename Tin, typename Tout>
+    void rgb_to_hsv_kernel(const Tin *r, const Tin *g, const Tin *b,
+			   intg step, Tout *h, Tout *s, Tout *v, intg ostep,
+			   intg n);
+
+  //! Describes the pixels of an order 1 (1 pixel) or order 3 (HxWxC)
+  //! image as 'rows' rows of 'n' pixels for the raw kernels: channel c of
+  //! pixel i in row j is at row(j) + i * step + c * chan.
+  template <typename T> class color_rows {
+  public:
+    //! Calls eblerror with 'name' if m's order is not 1 or 3.
+    color_rows(idx<T> &m, const char *name);
+    //! Returns a pointer to the first pixel of row j.
+    T* row(intg j);
+    //! Merges all rows of this and 'other' into a single row if both have
+    //! contiguous rows. Errors if both do not have the same number of pixels.
+    template <typename T2> void merge(color_rows<T2> &other, const char *name);
+  public:
+    T *ptr;
+    intg rows, n, rowmod, step, chan;
+  };
+
   ////////////////////////////////////////////////////////////////
   // YUV -> RGB
 
@@ -127,6 +180,7 @@ namespace ebl {
   //! Convert all pixels of rgb idx to hsv pixels.
   //! If the input idx has order of 1, it converts only 1 pixel.
   //! If the order is 3, it converts all pixels.
+  //! See rgb_to_yuv for accepted layouts.
   template<class T>
     void rgb_to_hsv(idx<T> &rgb, idx<T> &hsv);
 
@@ -36,6 +36,152 @@
 
 namespace ebl {
 
+  ////////////////////////////////////////////////////////////////
+  // Raw kernels
+
+  //! Precision used by the raw kernels to compute outputs of type T.
+  template <typename T> struct color_precision { typedef float type; };
+  template <> struct color_precision<double> { typedef double type; };
+
+  template <typename Tin, typename Tout>
+  inline void rgb_to_yuv_pixel(Tin r_, Tin g_, Tin b_,
+			       Tout &y, Tout &u, Tout &v) {
+    typedef typename color_precision<Tout>::type P;
+    P r = (P) r_, g = (P) g_, b = (P) b_;
+    y = (Tout) ((P) 0.299 * r + (P) 0.587 * g + (P) 0.114 * b);
+    u = (Tout) (((P) -0.147 * r - (P) 0.289 * g + (P) 0.437 * b + (P) 111)
+		* (P) 1.14678);
+    v = (Tout) (((P) 0.615 * r - (P) 0.515 * g - (P) 0.100 * b + (P) 157)
+		* (P) 0.81300);
+  }
+
+  // ubyte inputs: coefficients (including the u/v scaling and offsets)
+  // are pre-multiplied by 2^16 so that the whole pixel is integer math.
+  template <typename Tout>
+  inline void rgb_to_yuv_pixel(ubyte r, ubyte g, ubyte b,
+			       Tout &y, Tout &u, Tout &v) {
+    int32 yy = 19595 * r + 38470 * g + 7471 * b;
+    int32 uu = -11048 * r - 21720 * g + 32843 * b + 8342247;
+    int32 vv = 32768 * r - 27440 * g - 5328 * b + 8365081;
+    y = (Tout) ((float) yy * (float) (1.0 / 65536));
+    u = (Tout) ((float) uu * (float) (1.0 / 65536));
+    v = (Tout) ((float) vv * (float) (1.0 / 65536));
+  }
+
+  template <typename Tin, typename Tout>
+  inline void rgb_to_y_pixel(Tin r, Tin g, Tin b, Tout &y) {
+    typedef typename color_precision<Tout>::type P;
+    y = (Tout) ((P) 0.299 * (P) r + (P) 0.587 * (P) g + (P) 0.114 * (P) b);
+  }
+
+  template <typename Tout>
+  inline void rgb_to_y_pixel(ubyte r, ubyte g, ubyte b, Tout &y) {
+    int32 yy = 19595 * r + 38470 * g + 7471 * b;
+    y = (Tout) ((float) yy * (float) (1.0 / 65536));
+  }
+
+  // IS and OS are compile-time input and output strides, 0 meaning the
+  // runtime strides are used instead.
+  template <int IS, int OS, typename Tin, typename Tout>
+  inline void rgb_to_yuv_loop(const Tin *r, const Tin *g, const Tin *b,
+			      intg step, Tout *y, Tout *u, Tout *v, intg ostep,
+			      intg n) {
+    const intg is = IS ? IS : step, os = OS ? OS : ostep;
+    for (intg i = 0; i < n; ++i)
+      rgb_to_yuv_pixel(r[i * is], g[i * is], b[i * is],
+		       y[i * os], u[i * os], v[i * os]);
+  }
+
+  template <int IS, int OS, typename Tin, typename Tout>
+  inline void rgb_to_y_loop(const Tin *r, const Tin *g, const Tin *b,
+			    intg step, Tout *y, intg ostep, intg n) {
+    const intg is = IS ? IS : step, os = OS ? OS : ostep;
+    for (intg i = 0; i < n; ++i)
+      rgb_to_y_pixel(r[i * is], g[i * is], b[i * is], y[i * os]);
+  }
+
+  template <typename Tin, typename Tout>
+  void rgb_to_yuv_kernel(const Tin *r, const Tin *g, const Tin *b,
+			 intg step, Tout *y, Tout *u, Tout *v, intg ostep,
+			 intg n) {
+    if (step == 1 && ostep == 1)
+      rgb_to_yuv_loop<1, 1>(r, g, b, step, y, u, v, ostep, n);
+    else if (step == 3 && ostep == 1)
+      rgb_to_yuv_loop<3, 1>(r, g, b, step, y, u, v, ostep, n);
+    else if (step == 3 && ostep == 3)
+      rgb_to_yuv_loop<3, 3>(r, g, b, step, y, u, v, ostep, n);
+    else if (step == 1 && ostep == 3)
+      rgb_to_yuv_loop<1, 3>(r, g, b, step, y, u, v, ostep, n);
+    else
+      rgb_to_yuv_loop<0, 0>(r, g, b, step, y, u, v, ostep, n);
+  }
+
+  template <typename Tin, typename Tout>
+  void rgb_to_y_kernel(const Tin *r, const Tin *g, const Tin *b,
+		       intg step, Tout *y, intg ostep, intg n) {
+    if (step == 1 && ostep == 1)
+      rgb_to_y_loop<1, 1>(r, g, b, step, y, ostep, n);
+    else if (step == 3 && ostep == 1)
+      rgb_to_y_loop<3, 1>(r, g, b, step, y, ostep, n);
+    else
+      rgb_to_y_loop<0, 0>(r, g, b, step, y, ostep, n);
+  }
+
+  template <typename Tin, typename Tout>
+  void rgb_to_hsv_kernel(const Tin *r, const Tin *g, const Tin *b,
+			 intg step, Tout *h, Tout *s, Tout *v, intg ostep,
+			 intg n) {
+    double hh, ss, vv;
+    for (intg i = 0; i < n; ++i) {
+      PIX_RGB_TO_HSV_COMMON((double) r[i * step], (double) g[i * step],
+			    (double) b[i * step], hh, ss, vv, false);
+      h[i * ostep] = (Tout) hh;
+      s[i * ostep] = (Tout) ss;
+      v[i * ostep] = (Tout) vv;
+    }
+  }
+
+  // color_rows ////////////////////////////////////////////////////////////////
+
+  template <typename T>
+  color_rows<T>::color_rows(idx<T> &m, const char *name)
+    : ptr(m.idx_ptr()), rows(1), n(1), rowmod(0), step(1), chan(0) {
+    switch (m.order()) {
+    case 1: // 1 pixel
+      chan = m.mod(0);
+      break ;
+    case 3: // 2D image
+      rows = m.dim(0);
+      n = m.dim(1);
+      rowmod = m.mod(0);
+      step = m.mod(1);
+      chan = m.mod(2);
+      break ;
+    default:
+      eblerror(name << " dimension not implemented");
+    }
+  }
+
+  template <typename T>
+  T* color_rows<T>::row(intg j) {
+    return ptr + j * rowmod;
+  }
+
+  template <typename T> template <typename T2>
+  void color_rows<T>::merge(color_rows<T2> &other, const char *name) {
+    if (rows != other.rows || n != other.n)
+      eblerror(name << ": expected same number of pixels in input ("
+	       << rows << "x" << n << ") and output (" << other.rows << "x"
+	       << other.n << ")");
+    if (rows > 1 && rowmod == n * step
+	&& other.rowmod == other.n * other.step) {
+      n *= rows;
+      other.n = n;
+      rows = 1;
+      other.rows = 1;
+    }
+  }
+
   ////////////////////////////////////////////////////////////////
   // RGB -> YUV
 
@@ -55,23 +201,16 @@ namespace ebl {
     yuv.set((T) (( 0.615 * r - 0.515 * g - 0.100 * b + 157) * 0.81300), 2);
   }
 
-  template<class T> void rgb_to_yuv(idx<T> &rgb, idx<T> &yuv) {
+  template<class T1, class T2> void rgb_to_yuv(idx<T1> &rgb, idx<T2> &yuv) {
     idx_checknelems2_all(rgb, yuv);
-    switch (rgb.order()) {
-    case 1: // process 1 pixel
-      rgb_to_yuv_1D(rgb, yuv);
-      //      idx_m2dotm1(rgb_yuv, rgb, yuv);
-      return ;
-    case 3: // process 2D image
-      { idx_bloop2(rg, rgb, T, yu, yuv, T) {
-	  { idx_bloop2(r, rg, T, y, yu, T) {
-	      rgb_to_yuv_1D(r, y);
-	      //	      idx_m2dotm1(rgb_yuv, r, y);
-	    }}
-	}}
-      return ;
-    default:
-      eblerror("rgb_to_yuv dimension not implemented");
+    color_rows<T1> in(rgb, "rgb_to_yuv");
+    color_rows<T2> out(yuv, "rgb_to_yuv");
+    in.merge(out, "rgb_to_yuv");
+    for (intg j = 0; j < in.rows; ++j) {
+      T1 *i = in.row(j);
+      T2 *o = out.row(j);
+      rgb_to_yuv_kernel(i, i + in.chan, i + 2 * in.chan, in.step,
+			o, o + out.chan, o + 2 * out.chan, out.step, in.n);
     }
   }
 
@@ -89,22 +228,14 @@ namespace ebl {
     y.set(  (T) 0.299 * (T) r + (T) 0.587 * (T) g + (T) 0.114 * (T) b, 0);
   }
 
-  template<class T> void rgb_to_y(idx<T> &rgb, idx<T> &y) {
-    switch (rgb.order()) {
-    case 1: // process 1 pixel
-      rgb_to_y_1D(rgb, y);
-      //      idx_m2dotm1(rgb_yuv, rgb, yuv);
-      return ;
-    case 3: // process 2D image
-      { idx_bloop2(rg, rgb, T, yy, y, T) {
-	  { idx_bloop2(r, rg, T, yyy, yy, T) {
-	      rgb_to_y_1D(r, yyy);
-	      //	      idx_m2dotm1(rgb_yuv, r, y);
-	    }}
-	}}
-      return ;
-    default:
-      eblerror("rgb_to_y dimension not implemented");
+  template<class T1, class T2> void rgb_to_y(idx<T1> &rgb, idx<T2> &y) {
+    color_rows<T1> in(rgb, "rgb_to_y");
+    color_rows<T2> out(y, "rgb_to_y");
+    in.merge(out, "rgb_to_y");
+    for (intg j = 0; j < in.rows; ++j) {
+      T1 *i = in.row(j);
+      rgb_to_y_kernel(i, i + in.chan, i + 2 * in.chan, in.step,
+		      out.row(j), out.step, in.n);
     }
   }
   
@@ -148,20 +279,27 @@ namespace ebl {
     y.set(  0.299 * r + 0.587 * g + 0.114 * b, 0);
   }
 
-  template<class T> void bgr_to_y(idx<T> &bgr, idx<T> &y) {
-    switch (bgr.order()) {
-    case 1: // process 1 pixel
-      bgr_to_y_1D(bgr, y);
-      return ;
-    case 3: // process 2D image
-      { idx_bloop2(bg, bgr, T, yy, y, T) {
-	  { idx_bloop2(b, bg, T, yyy, yy, T) {
-	      rgb_to_y_1D(b, yyy);
-	    }}
-	}}
-      return ;
-    default:
-      eblerror("bgr_to_y dimension not implemented");
+  template<class T1, class T2> void bgr_to_y(idx<T1> &bgr, idx<T2> &y) {
+    color_rows<T1> in(bgr, "bgr_to_y");
+    color_rows<T2> out(y, "bgr_to_y");
+    in.merge(out, "bgr_to_y");
+    for (intg j = 0; j < in.rows; ++j) {
+      T1 *i = in.row(j);
+      rgb_to_y_kernel(i + 2 * in.chan, i + in.chan, i, in.step,
+		      out.row(j), out.step, in.n);
+    }
+  }
+  
+  template<class T1, class T2> void bgr_to_yuv(idx<T1> &bgr, idx<T2> &yuv) {
+    idx_checknelems2_all(bgr, yuv);
+    color_rows<T1> in(bgr, "bgr_to_yuv");
+    color_rows<T2> out(yuv, "bgr_to_yuv");
+    in.merge(out, "bgr_to_yuv");
+    for (intg j = 0; j < in.rows; ++j) {
+      T1 *i = in.row(j);
+      T2 *o = out.row(j);
+      rgb_to_yuv_kernel(i + 2 * in.chan, i + in.chan, i, in.step,
+			o, o + out.chan, o + 2 * out.chan, out.step, in.n);
     }
   }
   
@@ -255,21 +393,14 @@ namespace ebl {
 
   template<class T> void rgb_to_hsv(idx<T> &rgb, idx<T> &hsv) {
     idx_checknelems2_all(rgb, hsv);
-    switch (rgb.order()) {
-    case 1: // process 1 pixel
-      rgb_to_hsv_1D(rgb, hsv);
-      //      idx_m2dotm1(rgb_hsv, rgb, hsv);
-      return ;
-    case 3: // process 2D image
-      { idx_bloop2(rg, rgb, T, yu, hsv, T) {
-	  { idx_bloop2(r, rg, T, y, yu, T) {
-	      rgb_to_hsv_1D(r, y);
-	      //	      idx_m2dotm1(rgb_hsv, r, y);
-	    }}
-	}}
-      return ;
-    default:
-      eblerror("rgb_to_hsv dimension not implemented");
+    color_rows<T> in(rgb, "rgb_to_hsv");
+    color_rows<T> out(hsv, "rgb_to_hsv");
+    in.merge(out, "rgb_to_hsv");
+    for (intg j = 0; j < in.rows; ++j) {
+      T *i = in.row(j);
+      T *o = out.row(j);
+      rgb_to_hsv_kernel(i, i + in.chan, i + 2 * in.chan, in.step,
+			o, o + out.chan, o + 2 * out.chan, out.step, in.n);
     }
   }
 
@@ -34,6 +34,7 @@
 #define IDXIO_H_
 
 #include "idx.h"
+#include "thread_pool.h"
 
 #ifndef __NOSTL__
 #include <iterator>
@@ -104,6 +105,24 @@ namespace ebl {
 // TODO: implement all types.
 // TODO: is check for endianess required?
 
+//! A parallel_task loading file 'files[i]' into the preallocated slice
+//! 'slices[i]'. Errors are recorded in 'errors[i]' rather than thrown,
+//! as exceptions cannot cross the threads of the pool.
+template <typename T>
+class load_matrix_task : public parallel_task {
+ public:
+  load_matrix_task(const std::vector<std::string> &files,
+                   std::vector<idx<T> > &slices);
+  virtual ~load_matrix_task();
+  virtual void run(intg i);
+  //! Throws the first recorded error, if any.
+  void check_errors();
+ protected:
+  const std::vector<std::string> &files;
+  std::vector<idx<T> > &slices;
+  std::vector<std::string> errors;
+};
+
 // loading /////////////////////////////////////////////////////////////////////
 
 //! Returns matrix from file filename. If original matrix type is different
@@ -118,6 +137,9 @@ template <typename T>
 idx<T> load_matrix(const std::string &filename);
 //! Returns matrix that is the concatenation along dimension 'concat_dim'
 //! of multiple matrices with corresponding filenames.
+//! All headers are read first so that the result is allocated only once,
+//! each file body is then read directly into its slice of the result,
+//! in parallel on the library-wide thread_pool.
 //! If original matrix type is different
 //! than requested type, it is casted (copied) into the new type.
 //! This throws string exceptions upon errors.
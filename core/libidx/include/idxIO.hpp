@@ -138,12 +138,16 @@ void read_cast_matrix(FILE *fp, idx<T2> &out) {
 
 template <typename T>
 void read_matrix_body(FILE *fp, idx<T> &m) {
-  size_t read_count;
-  idx_aloop1(i, m, T) {
-    read_count = fread(&(*i), sizeof (T), 1, fp);
-    if (read_count != 1)
-      eblerror("Read incorrect number of bytes ");
+  // non-contiguous: read contiguously, then copy into m
+  if (!m.contiguousp()) {
+    idx<T> tmp(m.get_idxdim());
+    read_matrix_body(fp, tmp);
+    idx_copy(tmp, m);
+    return ;
   }
+  size_t n = (size_t) m.nelements();
+  if (fread(m.idx_ptr(), sizeof (T), n, fp) != n)
+    eblerror("Read incorrect number of bytes ");
 }
 
 // loading ///////////////////////////////////////////////////////////////////
@@ -173,11 +177,37 @@ idx<T> load_matrix(const std::string &filename) {
 template <typename T>
 idx<T> load_matrix(const std::vector<std::string> &files, intg cdim) {
   if (files.size() == 0) eblerror("expected at least 1 file to load");
-  idx<T> w = load_matrix<T>(files[0]);
-  for (uint i = 1; i < files.size(); ++i) {
-    idx<T> tmp = load_matrix<T>(files[i]);
-    w = idx_concat(w, tmp, cdim);
+  // read all headers to compute the final dimensions
+  std::vector<idxdim> dims;
+  idxdim d;
+  for (uint i = 0; i < files.size(); ++i) {
+    idxdim fd = get_matrix_dims(files[i].c_str());
+    if (cdim < 0 || cdim >= fd.order())
+      eblthrow("cannot concatenate " << files[i] << " " << fd
+               << " along dimension " << cdim);
+    if (i == 0)
+      d = fd;
+    else {
+      idxdim fd2 = fd;
+      fd2.setdim(cdim, d.dim(cdim));
+      if (fd2 != d)
+        eblthrow("cannot concatenate " << files[i] << " " << fd << " with "
+                 << d << " along dimension " << cdim);
+      d.setdim(cdim, d.dim(cdim) + fd.dim(cdim));
+    }
+    dims.push_back(fd);
+  }
+  // allocate once and read each file into its slice
+  idx<T> w(d);
+  std::vector<idx<T> > slices;
+  intg offset = 0;
+  for (uint i = 0; i < dims.size(); ++i) {
+    slices.push_back(w.narrow(cdim, dims[i].dim(cdim), offset));
+    offset += dims[i].dim(cdim);
   }
+  load_matrix_task<T> t(files, slices);
+  parallel_run(t, (intg) files.size());
+  t.check_errors();
   return w;
 }
 
@@ -257,6 +287,50 @@ idx<T> load_matrix(FILE *fp, idx<T> *out_) {
   return *pout;
 }
 
+// load_matrix_task ////////////////////////////////////////////////////////////
+
+template <typename T>
+load_matrix_task<T>::load_matrix_task(const std::vector<std::string> &files_,
+                                      std::vector<idx<T> > &slices_)
+  : files(files_), slices(slices_), errors(files_.size()) {
+}
+
+template <typename T>
+load_matrix_task<T>::~load_matrix_task() {
+}
+
+template <typename T>
+void load_matrix_task<T>::run(intg i) {
+  FILE *fp = fopen(files[i].c_str(), "rb");
+  if (!fp) {
+    errors[i] << "load_matrix failed to open " << files[i];
+    return ;
+  }
+  // validate the header first: read_matrix_header closes fp upon errors
+  try {
+    int magic;
+    read_matrix_header(fp, magic);
+  } catch(eblexception &e) {
+    errors[i] << e << " while loading " << files[i];
+    return ;
+  }
+  rewind(fp);
+  // fp is still open if the body read fails (e.g. truncated file)
+  try {
+    load_matrix<T>(fp, &slices[i]);
+  } catch(eblexception &e) {
+    errors[i] << e << " while loading " << files[i];
+  }
+  fclose(fp);
+}
+
+template <typename T>
+void load_matrix_task<T>::check_errors() {
+  for (uint i = 0; i < errors.size(); ++i)
+    if (!errors[i].empty())
+      eblthrow(errors[i]);
+}
+
 template <typename T>
 midx<T> load_matrices(const std::string &filename, bool ondemand){
   if (!has_multiple_matrices(filename.c_str()))
@@ -0,0 +1,141 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef IDX_VIEW_H_
+#define IDX_VIEW_H_
+
+#include "idx.h"
+
+namespace ebl {
+
+// idx_view ////////////////////////////////////////////////////////////////////
+
+//! A lightweight view of order 'N' on the data of an idx, for the inner
+//! loops of performance-critical code. Unlike idx, a view has no virtual
+//! methods, does not lock its storage and only holds N dimensions and
+//! modulos, so that taking slices of it (select, narrow, transpose or
+//! looping with idxv_bloop macros) costs no heap or refcount traffic.
+//! The viewed idx (or its storage) must outlive the view.
+template <typename T, int N> class idx_view {
+ public:
+  //! Constructs an empty view.
+  idx_view();
+  //! Constructs a view of 'm', whose order must be at most N. Missing
+  //! trailing dimensions have size 1 (and modulo 0).
+  idx_view(idx<T> &m);
+  //! Constructs a view of 'ptr' with dimensions 'dims' and modulos 'mods'.
+  idx_view(T *ptr, const intg *dims, const intg *mods);
+
+  //! Returns the order of this view.
+  inline int order() const { return N; }
+  //! Returns the size of dimension 'd'.
+  inline intg dim(int d) const { return dims[d]; }
+  //! Returns the modulo of dimension 'd'.
+  inline intg mod(int d) const { return mods[d]; }
+  //! Returns the total number of elements.
+  intg nelements() const;
+  //! Returns true if elements are contiguous in memory (row-major).
+  bool contiguousp() const;
+
+  //! Returns a pointer to the first element.
+  inline T *ptr() const { return p; }
+  //! Returns a pointer to element i0 (of dimension 0).
+  inline T *ptr(intg i0) const { return p + i0 * mods[0]; }
+  //! Returns a reference to the (only) element of an order-0 view.
+  inline T &operator*() const { return *p; }
+  //! Returns a reference to element (i0) of an order-1 view.
+  inline T &operator()(intg i0) const { return p[i0 * mods[0]]; }
+  //! Returns a reference to element (i0, i1) of an order-2 view.
+  inline T &operator()(intg i0, intg i1) const {
+    return p[i0 * mods[0] + i1 * mods[1]]; }
+  //! Returns a reference to element (i0, i1, i2) of an order-3 view.
+  inline T &operator()(intg i0, intg i1, intg i2) const {
+    return p[i0 * mods[0] + i1 * mods[1] + i2 * mods[2]]; }
+  //! Returns a reference to element (i0, i1, i2, i3) of an order-4 view.
+  inline T &operator()(intg i0, intg i1, intg i2, intg i3) const {
+    return p[i0 * mods[0] + i1 * mods[1] + i2 * mods[2] + i3 * mods[3]]; }
+
+  //! Returns the slice 'i' of dimension 'd', of order N - 1.
+  idx_view<T,N-1> select(int d, intg i) const;
+  //! Returns a view of 'size' elements of dimension 'd' starting at 'offset'.
+  idx_view<T,N> narrow(int d, intg size, intg offset) const;
+  //! Returns a view with dimensions 'd1' and 'd2' swapped.
+  idx_view<T,N> transpose(int d1, int d2) const;
+
+ protected:
+  T    *p;                       //!< Pointer to the first element.
+  intg  dims[N > 0 ? N : 1];     //!< Dimensions.
+  intg  mods[N > 0 ? N : 1];     //!< Modulos (in elements).
+};
+
+// idx_view_looper /////////////////////////////////////////////////////////////
+
+//! A view of order N - 1 iterating on the slices of dimension 'd' of a view
+//! of order N, as idxlooper does for idx.
+template <typename T, int N>
+class idx_view_looper : public idx_view<T,N-1> {
+ public:
+  //! Iterates on the slices of dimension 'd' of 'v'.
+  idx_view_looper(const idx_view<T,N> &v, int d);
+  //! Moves to the next slice.
+  inline void next() { this->p += step; i++; }
+  //! Returns true while the current slice is valid.
+  inline bool notdone() const { return i < n; }
+  //! Returns the index of the current slice.
+  inline intg index() const { return i; }
+ protected:
+  intg i;     //!< Index of the current slice.
+  intg n;     //!< Number of slices.
+  intg step;  //!< Modulo of the looped dimension.
+};
+
+//! Loops on the slices 'dst0' of dimension 0 of view 'src0' of order
+//! 'order0', as idx_bloop1 does for idx.
+#define idxv_bloop1(dst0, src0, type0, order0)                  \
+  idx_view_looper<type0,order0> dst0(src0, 0);                   \
+  for ( ; dst0.notdone(); dst0.next())
+
+//! Loops simultaneously on the slices of dimension 0 of 2 views,
+//! as idx_bloop2 does for idx.
+#define idxv_bloop2(dst0, src0, type0, order0, dst1, src1, type1, order1) \
+  if ((src0).dim(0) != (src1).dim(0))                                    \
+    eblerror("idxv_bloop2: different dim 0: " << (src0).dim(0)           \
+             << " and " << (src1).dim(0));                               \
+  idx_view_looper<type0,order0> dst0(src0, 0);                           \
+  idx_view_looper<type1,order1> dst1(src1, 0);                           \
+  for ( ; dst0.notdone(); dst0.next(), dst1.next())
+
+} // end namespace ebl
+
+#include "idx_view.hpp"
+
+#endif /* IDX_VIEW_H_ */
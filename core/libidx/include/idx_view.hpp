@@ -0,0 +1,126 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef IDX_VIEW_HPP_
+#define IDX_VIEW_HPP_
+
+namespace ebl {
+
+// idx_view ////////////////////////////////////////////////////////////////////
+
+template <typename T, int N>
+idx_view<T,N>::idx_view() : p(NULL) {
+  for (int d = 0; d < N; ++d) { dims[d] = 0; mods[d] = 0; }
+}
+
+template <typename T, int N>
+idx_view<T,N>::idx_view(idx<T> &m) : p(m.idx_ptr()) {
+  if (m.order() > N)
+    eblerror("cannot view " << m << " with an order " << N << " view");
+  for (int d = 0; d < N; ++d) {
+    if (d < m.order()) {
+      dims[d] = m.dim(d);
+      mods[d] = m.mod(d);
+    } else {
+      dims[d] = 1;
+      mods[d] = 0;
+    }
+  }
+}
+
+template <typename T, int N>
+idx_view<T,N>::idx_view(T *ptr, const intg *dims_, const intg *mods_)
+    : p(ptr) {
+  for (int d = 0; d < N; ++d) { dims[d] = dims_[d]; mods[d] = mods_[d]; }
+}
+
+template <typename T, int N>
+intg idx_view<T,N>::nelements() const {
+  intg n = 1;
+  for (int d = 0; d < N; ++d) n *= dims[d];
+  return n;
+}
+
+template <typename T, int N>
+bool idx_view<T,N>::contiguousp() const {
+  intg size = 1;
+  for (int d = N - 1; d >= 0; --d) {
+    if (dims[d] != 1 && mods[d] != size) return false;
+    size *= dims[d];
+  }
+  return true;
+}
+
+template <typename T, int N>
+idx_view<T,N-1> idx_view<T,N>::select(int d, intg i) const {
+  if (d < 0 || d >= N || i < 0 || i >= dims[d])
+    eblerror("cannot select slice " << i << " of dimension " << d
+             << " of order " << N << " view");
+  intg sdims[N], smods[N];
+  for (int k = 0, j = 0; k < N; ++k)
+    if (k != d) { sdims[j] = dims[k]; smods[j] = mods[k]; j++; }
+  return idx_view<T,N-1>(p + i * mods[d], sdims, smods);
+}
+
+template <typename T, int N>
+idx_view<T,N> idx_view<T,N>::narrow(int d, intg size, intg offset) const {
+  if (d < 0 || d >= N || offset < 0 || size < 1 || offset + size > dims[d])
+    eblerror("cannot narrow dimension " << d << " of size " << dims[d]
+             << " to " << size << " elements starting at " << offset);
+  idx_view<T,N> v(*this);
+  v.p += offset * mods[d];
+  v.dims[d] = size;
+  return v;
+}
+
+template <typename T, int N>
+idx_view<T,N> idx_view<T,N>::transpose(int d1, int d2) const {
+  if (d1 < 0 || d1 >= N || d2 < 0 || d2 >= N)
+    eblerror("cannot transpose dimensions " << d1 << " and " << d2
+             << " of order " << N << " view");
+  idx_view<T,N> v(*this);
+  std::swap(v.dims[d1], v.dims[d2]);
+  std::swap(v.mods[d1], v.mods[d2]);
+  return v;
+}
+
+// idx_view_looper /////////////////////////////////////////////////////////////
+
+template <typename T, int N>
+idx_view_looper<T,N>::idx_view_looper(const idx_view<T,N> &v, int d)
+    : idx_view<T,N-1>(v.dim(d) > 0 ? v.select(d, 0) : idx_view<T,N-1>()),
+      i(0), n(v.dim(d)), step(v.mod(d)) {
+}
+
+} // end namespace ebl
+
+#endif /* IDX_VIEW_HPP_ */
@@ -0,0 +1,101 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef IDXCONV_H_
+#define IDXCONV_H_
+
+#include "idx.h"
+
+namespace ebl {
+
+////////////////////////////////////////////////////////////////////////////////
+// Fixed-size convolution kernels
+//
+// The most common convolutions (5x5, 7x7 and 9x9 kernels with a 1x1 stride)
+// are computed by direct kernels where the kernel size is a compile-time
+// constant. The kernel window is fully unrolled and the inner loops run over
+// contiguous output columns so that the compiler can vectorize them.
+//
+// The idx_conv_*_acc dispatchers take the same arguments as the generic
+// operations they replace and return false without modifying anything when
+// no fixed-size kernel applies, in which case callers should fall back to the
+// generic operation.
+
+//! Returns true if fixed-size kernels exist for KxK kernels.
+inline bool idx_conv_fixed_size(intg k) { return k == 5 || k == 7 || k == 9; }
+
+//! Same as idx_m4dotm2acc(uin, ker, out), i.e. accumulates into 'out' the
+//! correlation of 'ker' with the unfolded input 'uin'.
+//! Returns false if 'uin' is not a stride 1 unfolding of contiguous rows,
+//! or if 'ker' is not 5x5, 7x7 or 9x9.
+template <typename T>
+bool idx_conv_fprop_acc(idx<T> &uin, idx<T> &ker, idx<T> &out);
+//! Same as idx_m2extm2acc(outd, ker, uind), or idx_m2squextm2acc if 'squ'
+//! is true, i.e. backpropagates the output gradient 'outd' to the unfolded
+//! input gradient 'uind'. Returns false under the same conditions as
+//! idx_conv_fprop_acc.
+template <typename T>
+bool idx_conv_bprop_acc(idx<T> &outd, idx<T> &ker, idx<T> &uind,
+                        bool squ = false);
+//! Same as idx_m4dotm2acc(borp, outd, kerd), or idx_m4squdotm2acc if 'squ'
+//! is true, i.e. accumulates into 'kerd' the kernel gradient given the
+//! transposed unfolded input 'borp' (kernel dimensions first) and the output
+//! gradient 'outd'. Returns false under the same conditions as
+//! idx_conv_fprop_acc.
+template <typename T>
+bool idx_conv_kgrad_acc(idx<T> &borp, idx<T> &outd, idx<T> &kerd,
+                        bool squ = false);
+
+//! Accumulates into the 'oh' x 'ow' map 'out' (row modulo 'outm') the
+//! correlation of the KxK kernel 'ker' (row modulo 'kerm') with the map 'in'
+//! (row modulo 'inm'). Columns of all 3 maps must be contiguous.
+template <int K, typename T>
+void idx_conv_fprop_fixed(const T *in, intg inm, const T *ker, intg kerm,
+                          T *out, intg outm, intg oh, intg ow);
+//! Accumulates into the input gradient map 'ind' the backward correlation of
+//! the 'oh' x 'ow' output gradient 'outd' with the KxK kernel 'ker'. If SQU
+//! is true, the squared kernel is used instead (bbprop).
+template <int K, bool SQU, typename T>
+void idx_conv_bprop_fixed(const T *outd, intg outdm, const T *ker, intg kerm,
+                          T *ind, intg indm, intg oh, intg ow);
+//! Accumulates into the KxK kernel gradient 'kerd' the correlation of the
+//! input map 'in' with the 'oh' x 'ow' output gradient 'outd'. If SQU is
+//! true, the squared input is used instead (bbprop).
+template <int K, bool SQU, typename T>
+void idx_conv_kgrad_fixed(const T *in, intg inm, const T *outd, intg outdm,
+                          T *kerd, intg kerdm, intg oh, intg ow);
+
+} // end namespace ebl
+
+#include "idxconv.hpp"
+
+#endif /* IDXCONV_H_ */
@@ -0,0 +1,215 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef IDXCONV_HPP_
+#define IDXCONV_HPP_
+
+namespace ebl {
+
+// unrolling helpers ///////////////////////////////////////////////////////////
+
+//! Fully unrolled dot product of a KxK window of a map (row modulo 'inm')
+//! with a contiguous KxK kernel, starting at element N and accumulating in
+//! row-major order (the same order as idx_m4dotm2acc).
+template <int K, int N, typename T, bool END = (N == K * K)>
+struct idx_conv_unroll {
+  static inline void dot(T &s, const T *in, intg inm, const T *ker) {
+    s += in[(N / K) * inm + N % K] * ker[N];
+    idx_conv_unroll<K, N + 1, T>::dot(s, in, inm, ker);
+  }
+};
+
+template <int K, int N, typename T>
+struct idx_conv_unroll<K, N, T, true> {
+  static inline void dot(T &, const T *, intg, const T *) {}
+};
+
+//! Returns the size K of the KxK window of the unfolded map 'u' of order 4,
+//! where 'w' is the first window dimension and 'p' the first position
+//! dimension, if 'u' is a stride 1 unfolding of a map with contiguous rows
+//! and K has a fixed-size kernel. Returns 0 otherwise.
+template <typename T>
+inline intg idx_conv_unfolded_size(idx<T> &u, int p, int w) {
+  if (u.order() != 4) return 0;
+  intg k = u.dim(w);
+  if (u.dim(w + 1) != k || !idx_conv_fixed_size(k)) return 0;
+  if (u.mod(w + 1) != 1 || u.mod(p + 1) != 1 || u.mod(p) != u.mod(w))
+    return 0;
+  return k;
+}
+
+// fixed-size kernels //////////////////////////////////////////////////////////
+
+template <int K, typename T>
+void idx_conv_fprop_fixed(const T *in, intg inm, const T *ker, intg kerm,
+                          T *out, intg outm, intg oh, intg ow) {
+  T k[K * K]; // contiguous copy of the kernel, kept in registers or cache
+  for (int u = 0; u < K; ++u)
+    for (int v = 0; v < K; ++v)
+      k[u * K + v] = ker[u * kerm + v];
+  for (intg i = 0; i < oh; ++i, in += inm, out += outm)
+    for (intg j = 0; j < ow; ++j) {
+      T s = out[j];
+      idx_conv_unroll<K, 0, T>::dot(s, in + j, inm, k);
+      out[j] = s;
+    }
+}
+
+template <int K, bool SQU, typename T>
+void idx_conv_bprop_fixed(const T *outd, intg outdm, const T *ker, intg kerm,
+                          T *ind, intg indm, intg oh, intg ow) {
+  for (intg i = 0; i < oh; ++i, outd += outdm, ind += indm)
+    for (int u = 0; u < K; ++u) {
+      T *ir = ind + u * indm;
+      // decreasing v so that each input accumulates in the same order as
+      // idx_m2extm2acc (increasing output column)
+      for (int v = K - 1; v >= 0; --v) {
+        T kv = ker[u * kerm + v];
+        T *irv = ir + v;
+        if (SQU)
+          for (intg j = 0; j < ow; ++j) irv[j] += outd[j] * kv * kv;
+        else
+          for (intg j = 0; j < ow; ++j) irv[j] += outd[j] * kv;
+      }
+    }
+}
+
+template <int K, bool SQU, typename T>
+void idx_conv_kgrad_fixed(const T *in, intg inm, const T *outd, intg outdm,
+                          T *kerd, intg kerdm, intg oh, intg ow) {
+  enum { L = 8 }; // independent partial sums, vectorized over columns
+  intg owl = ow - ow % L;
+  for (int u = 0; u < K; ++u)
+    for (int v = 0; v < K; ++v) {
+      T acc[L], rest = 0;
+      for (int l = 0; l < L; ++l) acc[l] = 0;
+      const T *ir = in + u * inm + v, *od = outd;
+      for (intg i = 0; i < oh; ++i, ir += inm, od += outdm) {
+        intg j = 0;
+        for ( ; j < owl; j += L)
+          for (int l = 0; l < L; ++l) {
+            if (SQU) acc[l] += ir[j + l] * ir[j + l] * od[j + l];
+            else acc[l] += ir[j + l] * od[j + l];
+          }
+        for ( ; j < ow; ++j) {
+          if (SQU) rest += ir[j] * ir[j] * od[j];
+          else rest += ir[j] * od[j];
+        }
+      }
+      T s = kerd[u * kerdm + v];
+      for (int l = 0; l < L; ++l) s += acc[l];
+      kerd[u * kerdm + v] = s + rest;
+    }
+}
+
+// dispatchers /////////////////////////////////////////////////////////////////
+
+template <typename T>
+bool idx_conv_fprop_acc(idx<T> &uin, idx<T> &ker, idx<T> &out) {
+  intg k = idx_conv_unfolded_size(uin, 0, 2);
+  if (!k || ker.order() != 2 || ker.dim(0) != k || ker.dim(1) != k
+      || ker.mod(1) != 1 || out.order() != 2 || out.mod(1) != 1
+      || out.dim(0) != uin.dim(0) || out.dim(1) != uin.dim(1))
+    return false;
+  const T *in = uin.idx_ptr(), *kp = ker.idx_ptr();
+  intg inm = uin.mod(0), km = ker.mod(0), om = out.mod(0);
+  intg oh = out.dim(0), ow = out.dim(1);
+  switch (k) {
+  case 5: idx_conv_fprop_fixed<5>(in, inm, kp, km, out.idx_ptr(), om, oh, ow);
+    break ;
+  case 7: idx_conv_fprop_fixed<7>(in, inm, kp, km, out.idx_ptr(), om, oh, ow);
+    break ;
+  case 9: idx_conv_fprop_fixed<9>(in, inm, kp, km, out.idx_ptr(), om, oh, ow);
+    break ;
+  default: return false;
+  }
+  return true;
+}
+
+#define IDX_CONV_BPROP_CASE(k)                                          \
+  case k:                                                               \
+  if (squ) idx_conv_bprop_fixed<k, true>(od, odm, kp, km, id, idm, oh, ow); \
+  else idx_conv_bprop_fixed<k, false>(od, odm, kp, km, id, idm, oh, ow); \
+  break ;
+
+template <typename T>
+bool idx_conv_bprop_acc(idx<T> &outd, idx<T> &ker, idx<T> &uind, bool squ) {
+  intg k = idx_conv_unfolded_size(uind, 0, 2);
+  if (!k || ker.order() != 2 || ker.dim(0) != k || ker.dim(1) != k
+      || ker.mod(1) != 1 || outd.order() != 2 || outd.mod(1) != 1
+      || outd.dim(0) != uind.dim(0) || outd.dim(1) != uind.dim(1))
+    return false;
+  const T *od = outd.idx_ptr(), *kp = ker.idx_ptr();
+  T *id = uind.idx_ptr();
+  intg odm = outd.mod(0), km = ker.mod(0), idm = uind.mod(0);
+  intg oh = outd.dim(0), ow = outd.dim(1);
+  switch (k) {
+    IDX_CONV_BPROP_CASE(5)
+    IDX_CONV_BPROP_CASE(7)
+    IDX_CONV_BPROP_CASE(9)
+  default: return false;
+  }
+  return true;
+}
+
+#define IDX_CONV_KGRAD_CASE(k)                                          \
+  case k:                                                               \
+  if (squ) idx_conv_kgrad_fixed<k, true>(in, inm, od, odm, kd, kdm, oh, ow); \
+  else idx_conv_kgrad_fixed<k, false>(in, inm, od, odm, kd, kdm, oh, ow); \
+  break ;
+
+template <typename T>
+bool idx_conv_kgrad_acc(idx<T> &borp, idx<T> &outd, idx<T> &kerd, bool squ) {
+  intg k = idx_conv_unfolded_size(borp, 2, 0);
+  if (!k || kerd.order() != 2 || kerd.dim(0) != k || kerd.dim(1) != k
+      || kerd.mod(1) != 1 || outd.order() != 2 || outd.mod(1) != 1
+      || outd.dim(0) != borp.dim(2) || outd.dim(1) != borp.dim(3))
+    return false;
+  const T *in = borp.idx_ptr(), *od = outd.idx_ptr();
+  T *kd = kerd.idx_ptr();
+  intg inm = borp.mod(2), odm = outd.mod(0), kdm = kerd.mod(0);
+  intg oh = outd.dim(0), ow = outd.dim(1);
+  switch (k) {
+    IDX_CONV_KGRAD_CASE(5)
+    IDX_CONV_KGRAD_CASE(7)
+    IDX_CONV_KGRAD_CASE(9)
+  default: return false;
+  }
+  return true;
+}
+
+#undef IDX_CONV_BPROP_CASE
+#undef IDX_CONV_KGRAD_CASE
+
+} // end namespace ebl
+
+#endif /* IDXCONV_HPP_ */
@@ -36,6 +36,8 @@
 #include "config.h"
 #include "numerics.h"
 #include "idx.h"
+#include "thread_pool.h"
+#include "random.h"
 
 namespace ebl {
 
@@ -221,6 +223,54 @@ inline void idx_subc_bounded(idx<T> &inp, T2 c, idx<T> &out);
 //! Warning: bounding not working when T=double (TODO)
 template <typename T> void idx_subc_bounded(idx<T> &inp, T c, idx<T> &out);
 
+// parallel elementwise operations ///////////////////////////////////////////
+
+//! A parallel_range_task calling op(x, y) for each element x of 'in' and
+//! the corresponding element y of 'out', over flat element indices if both
+//! are contiguous, otherwise over slices of dimension 0.
+template <typename T, class Top>
+class idx_map_task : public parallel_range_task {
+ public:
+  idx_map_task(idx<T> &in, idx<T> &out, const Top &op);
+  virtual ~idx_map_task();
+  virtual void run_range(intg begin, intg end);
+ protected:
+  idx<T> &in, &out;
+  Top     op;
+  bool    flat;
+};
+
+//! Same as idx_map_task with 2 inputs, calling op(x1, x2, y).
+template <typename T, class Top>
+class idx_map2_task : public parallel_range_task {
+ public:
+  idx_map2_task(idx<T> &in1, idx<T> &in2, idx<T> &out, const Top &op);
+  virtual ~idx_map2_task();
+  virtual void run_range(intg begin, intg end);
+ protected:
+  idx<T> &in1, &in2, &out;
+  Top     op;
+  bool    flat;
+};
+
+//! Calls op(x, y) for each element x of 'in' and the corresponding element
+//! y of 'out' (a reference, 'in' and 'out' may be the same idx), in
+//! parallel on the library-wide thread_pool when there are at least 'grain'
+//! elements per chunk (the pool's default grain if grain <= 0), serially
+//! otherwise. All single-type elementwise operations of this file use it,
+//! except memory-bound ones (idx_copy, idx_clear, idx_fill) and sequential
+//! ones (idx_fill_index, idx_random). Operations mixing element types,
+//! reductions (idx_sum, idx_sumsqr, idx_max, ...), sorts and products
+//! remain serial, so that nothing in libidx starts its own threads.
+template <typename T, class Top>
+void idx_parallel_map(idx<T> &in, idx<T> &out, const Top &op, intg grain = 0);
+
+//! Same as idx_parallel_map() with 2 inputs, calling op(x1, x2, y) ('out'
+//! may be one of the inputs).
+template <typename T, class Top>
+void idx_parallel_map2(idx<T> &in1, idx<T> &in2, idx<T> &out, const Top &op,
+                       intg grain = 0);
+
 // idx_minus /////////////////////////////////////////////////////////////////
 
 //! Negate all elements of 'in' into 'out'.
@@ -439,17 +489,6 @@ template <typename T> T idx_sum(idx<T> &inp, T *out);
 //template <> EXPORT double idx_sum(idx<double> &inp, double *out);
 //template <> EXPORT float idx_sum(idx<float> &inp, float *out);
 
-#if 0 //TODO
-
-/*
-	#if defined(__OPENMP__) and defined(__USE_SSE__)
-	//! returns the sum of all the terms, specialized float32 version
-	template <> float32 idx_sum(idx<float32> &inp, float32 *out);
-	#endif
-*/
-
-#endif
-
 // idx_sumacc ////////////////////////////////////////////////////////////////
 
 //! sum of all the terms, accumulated in idx0 acc
@@ -748,6 +787,27 @@ void idx_m2oversample(idx<T>& small, intg nlin, intg ncol, idx<T>& big);
 template <typename T>
 void idx_m2oversampleacc(idx<T>& small, intg nlin, intg ncol, idx<T>& big);
 
+// idx_m2subsample, idx_m2maxpool ////////////////////////////////////////////
+
+//! Sum each non-overlapping nlin x ncol block of 'big' into the
+//! corresponding element of 'small' (the reverse of idx_m2oversample).
+//! Rows of blocks are first summed vertically in a contiguous buffer, then
+//! 2, 3 and 4 wide blocks are summed with unrolled loops.
+template <typename T>
+void idx_m2subsample(idx<T>& big, intg nlin, intg ncol, idx<T>& small);
+//! Put the max of each ki x kj window of 'in' taken every si x sj into
+//! 'out', and the (row, column) input coordinates of each max into
+//! 'switches' (out.dim(0) x out.dim(1) x 2). Windows crossing the border
+//! of 'in' only use the elements inside. 2x2, 3x3 and 4x4 windows use
+//! unrolled loops. Ties keep the first max in row-major order.
+template <typename T>
+void idx_m2maxpool(idx<T>& in, intg ki, intg kj, intg si, intg sj,
+                   idx<T>& out, idx<int>& switches);
+//! Accumulate each element of 'small' into 'big' at the position given by
+//! 'switches' (as filled by idx_m2maxpool).
+template <typename T>
+void idx_m2unpoolacc(idx<T>& small, idx<int>& switches, idx<T>& big);
+
 // idx_clip //////////////////////////////////////////////////////////////////
 
 //! Copy the max of m and each element of i1 into o1
@@ -779,6 +839,55 @@ template <typename T> void idx_random(idx<T> &m, double v0, double v1);
 //! Set each element of 'm' to a random value in [-v, v].
 template <typename T> void idx_random(idx<T> &m, double v);
 
+//! A parallel_range_task filling 'm' with the numbers of philox stream 'g'
+//! starting at position 'start', mapped to a uniform distribution over
+//! (a, b), or to a normal distribution with mean a and standard deviation b.
+//! Element i of 'm' (in row-major order) only depends on number start + i
+//! (start + 2i and start + 2i + 1 if normal), whatever the chunking, so
+//! results do not depend on the number of threads.
+template <typename T>
+class idx_fill_random_task : public parallel_range_task {
+ public:
+  idx_fill_random_task(idx<T> &m, const philox &g, uint64 start, bool normal,
+                       double a, double b);
+  virtual ~idx_fill_random_task();
+  virtual void run_range(intg begin, intg end);
+  //! Fills 'm' in parallel on the library-wide thread_pool.
+  void run_all();
+ protected:
+  //! Writes the 'n' elements starting at element 'i' into contiguous 'out'.
+  void fill(T *out, intg n, intg i);
+ protected:
+  idx<T>       &m;
+  const philox &g;
+  uint64        start;
+  bool          normal;
+  double        a, b;
+  bool          flat;
+};
+
+//! Set each element of 'm' to a random value uniform over (v0, v1) drawn
+//! from 'g', in parallel and independently of the number of threads.
+//! This moves 'g' m.nelements() numbers ahead.
+template <typename T>
+void idx_fill_uniform(idx<T> &m, double v0, double v1, philox &g);
+//! Same as idx_fill_uniform(m, v0, v1, g) with the library-wide generator
+//! (seeded by init_drand()). Concurrent callers get disjoint ranges of it in
+//! the order they reach it: callers that must be reproducible whatever the
+//! number of threads should pass their own generator (see philox_stream).
+template <typename T>
+void idx_fill_uniform(idx<T> &m, double v0 = 0.0, double v1 = 1.0);
+//! Set each element of 'm' to a random value drawn from 'g' with a normal
+//! distribution of mean 'mean' and standard deviation 'sigma', in parallel
+//! and independently of the number of threads.
+//! This moves 'g' 2 * m.nelements() numbers ahead.
+template <typename T>
+void idx_fill_normal(idx<T> &m, double mean, double sigma, philox &g);
+//! Same as idx_fill_normal(m, mean, sigma, g) with the library-wide
+//! generator (seeded by init_drand()), see idx_fill_uniform().
+template <typename T>
+void idx_fill_normal(idx<T> &m, double mean = 0.0, double sigma = 1.0);
+
 } // end namespace ebl
 
 #include "idxops.hpp"
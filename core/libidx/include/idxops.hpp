@@ -326,94 +326,290 @@ void idx_shuffle_together(idx<T1> &in1_, idx<T2> &in2_, idx<T3> &in3_,
   }
 }
 
+// parallel elementwise operations ///////////////////////////////////////////
+
+template <typename T, class Top>
+idx_map_task<T,Top>::idx_map_task(idx<T> &in_, idx<T> &out_, const Top &op_)
+  : in(in_), out(out_), op(op_),
+    flat(in_.contiguousp() && out_.contiguousp()) {
+}
+
+template <typename T, class Top>
+idx_map_task<T,Top>::~idx_map_task() {
+}
+
+template <typename T, class Top>
+void idx_map_task<T,Top>::run_range(intg begin, intg end) {
+  if (flat) {
+    T *pin = in.idx_ptr(), *pout = out.idx_ptr();
+    for (intg i = begin; i < end; ++i)
+      op(pin[i], pout[i]);
+  } else {
+    idx<T> sin = in.narrow(0, end - begin, begin);
+    idx<T> sout = out.narrow(0, end - begin, begin);
+    idx_aloopf2(pin, sin, T, pout, sout, T, { op(*pin, *pout); });
+  }
+}
+
+template <typename T, class Top>
+idx_map2_task<T,Top>::idx_map2_task(idx<T> &in1_, idx<T> &in2_, idx<T> &out_,
+                                    const Top &op_)
+  : in1(in1_), in2(in2_), out(out_), op(op_),
+    flat(in1_.contiguousp() && in2_.contiguousp() && out_.contiguousp()) {
+}
+
+template <typename T, class Top>
+idx_map2_task<T,Top>::~idx_map2_task() {
+}
+
+template <typename T, class Top>
+void idx_map2_task<T,Top>::run_range(intg begin, intg end) {
+  if (flat) {
+    T *p1 = in1.idx_ptr(), *p2 = in2.idx_ptr(), *pout = out.idx_ptr();
+    for (intg i = begin; i < end; ++i)
+      op(p1[i], p2[i], pout[i]);
+  } else {
+    idx<T> s1 = in1.narrow(0, end - begin, begin);
+    idx<T> s2 = in2.narrow(0, end - begin, begin);
+    idx<T> sout = out.narrow(0, end - begin, begin);
+    idx_aloopf3(p1, s1, T, p2, s2, T, pout, sout, T, { op(*p1, *p2, *pout); });
+  }
+}
+
+template <typename T, class Top>
+void idx_parallel_map(idx<T> &in, idx<T> &out, const Top &op, intg grain) {
+  idx_checknelems2_all(in, out);
+  idx_map_task<T,Top> t(in, out, op);
+  if (grain <= 0) grain = thread_pool::global().get_grain();
+  if (in.contiguousp() && out.contiguousp())
+    parallel_for(t, in.nelements(), grain);
+  else if (in.order() > 0 && in.same_dim(out.get_idxdim()))
+    parallel_for(t, in, 0, grain);
+  else
+    idx_aloopf2(pin, in, T, pout, out, T, { op(*pin, *pout); });
+}
+
+template <typename T, class Top>
+void idx_parallel_map2(idx<T> &in1, idx<T> &in2, idx<T> &out, const Top &op,
+                       intg grain) {
+  idx_checknelems3_all(in1, in2, out);
+  idx_map2_task<T,Top> t(in1, in2, out, op);
+  if (grain <= 0) grain = thread_pool::global().get_grain();
+  if (in1.contiguousp() && in2.contiguousp() && out.contiguousp())
+    parallel_for(t, in1.nelements(), grain);
+  else if (in1.order() > 0 && in1.same_dim(in2.get_idxdim())
+           && in1.same_dim(out.get_idxdim()))
+    parallel_for(t, in1, 0, grain);
+  else
+    idx_aloopf3(p1, in1, T, p2, in2, T, pout, out, T,
+                { op(*p1, *p2, *pout); });
+}
+
+//! Elementwise operators used with idx_parallel_map and idx_parallel_map2.
+template <typename T> struct minus_op {
+  inline void operator()(T x, T &y) const { y = - x; } };
+template <typename T> struct minus_acc_op {
+  inline void operator()(T x, T &y) const { y += - x; } };
+template <typename T> struct inv_op {
+  inline void operator()(T x, T &y) const {
+#ifdef __DEBUG__
+    if (x == 0) eblerror("division by zero");
+#endif
+    y = 1 / x; } };
+template <typename T> struct add_op {
+  inline void operator()(T a, T b, T &y) const { y = a + b; } };
+template <typename T> struct sub_op {
+  inline void operator()(T a, T b, T &y) const { y = a - b; } };
+template <typename T> struct subacc_op {
+  inline void operator()(T a, T b, T &y) const { y += a - b; } };
+template <typename T> struct spherical_sub_op {
+  inline void operator()(T a, T b, T &y) const {
+    T tmp = a - b, tmpabs = std::abs(tmp), tmpabs2 = TWOPI - tmpabs;
+    if (tmpabs > tmpabs2)
+      tmp = (tmp < 0) ? tmpabs2 : -tmpabs2;
+    y = tmp; } };
+template <typename T> struct spherical_add_op {
+  inline void operator()(T a, T b, T &y) const {
+    y = std::min(TWOPI - a, a) + std::min(TWOPI - b, - b); } };
+template <typename T> struct mul_op {
+  inline void operator()(T a, T b, T &y) const { y = a * b; } };
+template <typename T> struct mulacc_op {
+  inline void operator()(T a, T b, T &y) const { y += a * b; } };
+template <typename T> struct div_op {
+  inline void operator()(T a, T b, T &y) const {
+#ifdef __DEBUG__
+    if (b == 0) eblerror("division by zero");
+#endif
+    y = a / b; } };
+template <typename T> struct addc_op {
+  addc_op(T c_) : c(c_) {}
+  inline void operator()(T x, T &y) const { y = x + c; }
+  T c; };
+template <typename T> struct addc_bounded_op {
+  addc_bounded_op(T c_) : c(c_) {}
+  inline void operator()(T x, T &y) const { y = saturate(x + c, T); }
+  T c; };
+template <typename T> struct subc_bounded_op {
+  subc_bounded_op(T c_) : c(c_) {}
+  inline void operator()(T x, T &y) const { y = saturate(x - c, T); }
+  T c; };
+template <typename T> struct addcacc_op {
+  addcacc_op(T c_) : c(c_) {}
+  inline void operator()(T x, T &y) const { y += x + c; }
+  T c; };
+template <typename T, typename T2> struct dotc_op {
+  dotc_op(T2 c_) : c(c_) {}
+  inline void operator()(T x, T &y) const { y = (T) (x * c); }
+  T2 c; };
+template <typename T, typename T2> struct dotc_bounded_op {
+  dotc_bounded_op(T2 c_) : c(c_) {}
+  inline void operator()(T x, T &y) const { y = saturate(x * c, T); }
+  T2 c; };
+template <typename T, typename T2> struct dotcacc_op {
+  dotcacc_op(T2 c_) : c(c_) {}
+  inline void operator()(T x, T &y) const { y += (T) (x * c); }
+  T2 c; };
+template <typename T> struct signdotc_op {
+  signdotc_op(T c_) : c(c_) {}
+  inline void operator()(T x, T &y) const { y = (x < 0) ? -c : c; }
+  T c; };
+template <typename T> struct signdotcacc_op {
+  signdotcacc_op(T c_) : c(c_) {}
+  inline void operator()(T x, T &y) const { y += (x < 0) ? -c : c; }
+  T c; };
+template <typename T> struct subsquare_op {
+  inline void operator()(T a, T b, T &y) const { T d = a - b; y = d * d; } };
+template <typename T> struct subsquareacc_op {
+  inline void operator()(T a, T b, T &y) const { T d = a - b; y += d * d; } };
+template <typename T> struct lincomb_op {
+  lincomb_op(T k1_, T k2_) : k1(k1_), k2(k2_) {}
+  inline void operator()(T a, T b, T &y) const { y = k1 * a + k2 * b; }
+  T k1, k2; };
+template <typename T> struct tanh_op {
+  inline void operator()(T x, T &y) const { y = (T) tanh((double) x); } };
+template <typename T> struct dtanh_op {
+  inline void operator()(T x, T &y) const { y = (T) dtanh((double) x); } };
+template <typename T> struct stdsigmoid_op {
+  inline void operator()(T x, T &y) const {
+    y = (T) stdsigmoid((double) x); } };
+template <typename T> struct dstdsigmoid_op {
+  inline void operator()(T x, T &y) const {
+    y = (T) dstdsigmoid((double) x); } };
+template <typename T> struct thresdotc_acc_op {
+  thresdotc_acc_op(T c_, T th_) : c(c_), th(th_) {}
+  inline void operator()(T x, T &y) const {
+    y += (x < -th) ? -c : (x > th) ? c : 0; }
+  T c, th; };
+template <typename T> struct threshold_op {
+  threshold_op(T th_, T value_) : th(th_), value(value_) {}
+  inline void operator()(T x, T &y) const { y = (x < th) ? value : x; }
+  T th, value; };
+template <typename T> struct threshold2_op {
+  threshold2_op(T th_) : th(th_) {}
+  inline void operator()(T x, T &y) const { y = (x > th) ? th : x; }
+  T th; };
+template <typename T> struct sqrt_op {
+  inline void operator()(T x, T &y) const { y = (T) sqrt((float64) x); } };
+template <typename T> struct power_op {
+  power_op(T p_) : p(p_) {}
+  inline void operator()(T x, T &y) const {
+    y = saturate(pow((double) x, (double) p), T); }
+  T p; };
+template <typename T> struct max_op {
+  inline void operator()(T a, T b, T &y) const { y = std::max(a, b); } };
+template <typename T> struct min_op {
+  inline void operator()(T a, T b, T &y) const { y = std::min(a, b); } };
+template <typename T> struct gaussian_op {
+  gaussian_op(double m_, double sigma_) : m(m_), sigma(sigma_) {}
+  inline void operator()(T x, T &y) const {
+    y = (T) gaussian((double) x, m, sigma); }
+  double m, sigma; };
+template <typename T> struct modulo_op {
+  modulo_op(T mod_) : mod(mod_) {}
+  inline void operator()(T x, T &y) const { y = x % mod; }
+  T mod; };
+template <typename T> struct exp_op {
+  inline void operator()(T x, T &y) const {
+    y = saturate(exp((float32) x), T); } };
+template <typename T> struct log_op {
+  inline void operator()(T x, T &y) const {
+#ifdef __WINDOWS__
+    y = (T) log((double) x);
+#else
+    y = (T) log(x);
+#endif
+  } };
+template <typename T> struct clip_op {
+  clip_op(T m_) : m(m_) {}
+  inline void operator()(T x, T &y) const { y = std::max(m, x); }
+  T m; };
+
 ////////////////////////////////////////////////////////////////////////
 // idx_minus
 
 template <typename T> void idx_minus(idx<T> &inp, idx<T> &out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, { *pout = - *pinp; });
+  idx_parallel_map(inp, out, minus_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_minus_acc
 
 template <typename T> void idx_minus_acc(idx<T> &inp, idx<T> &out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, { *pout += - *pinp; });
+  idx_parallel_map(inp, out, minus_acc_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_inv
 
 template <typename T> void idx_inv(idx<T> &inp, idx<T> &out) {
-#ifdef __DEBUG__
-  idx_aloopf2(pinp, inp, T, pout, out, T, {
-      if (*pinp == 0) eblerror("division by zero");
-      *pout = 1 / *pinp;
-    });
-#else
-  idx_aloopf2(pinp, inp, T, pout, out, T, { *pout = 1 / *pinp; });
-#endif
+  idx_parallel_map(inp, out, inv_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_add
 
 template <typename T> void idx_add(idx<T> &in, idx<T> &out) {
-  idx_aloopf2 (pin, in, T, pout, out, T, { *pout = *pout + *pin; });
+  idx_parallel_map2(out, in, out, add_op<T>());
 }
 
 template<typename T> void idx_add(idx<T> &i1, idx<T> &i2, idx<T> &out) {
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T, { *pout = *pi1 + *pi2; });
+  idx_parallel_map2(i1, i2, out, add_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_sub
 
 template <typename T> void idx_sub(idx<T> &i1, idx<T> &i2) {
-  idx_aloopf2(pi1, i1, T, pi2, i2, T, { *pi1 = *pi1 - *pi2; });
+  idx_parallel_map2(i1, i2, i1, sub_op<T>());
 }
 
 template <typename T> void idx_sub(idx<T> &i1, idx<T> &i2, idx<T> &out) {
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T, {*pout = *pi1 - *pi2; });
+  idx_parallel_map2(i1, i2, out, sub_op<T>());
 }
 
 template <typename T> void idx_subacc(idx<T> &i1, idx<T> &i2, idx<T> &out) {
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T, {*pout += *pi1 - *pi2; });
+  idx_parallel_map2(i1, i2, out, subacc_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_spherical_sub
 
 template <typename T> void idx_spherical_sub(idx<T> &i1, idx<T> &i2, idx<T> &out){
-  T tmp, tmpabs, tmpabs2;
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T, {
-      tmp = *pi1 - *pi2;
-      tmpabs = std::abs(tmp);
-      tmpabs2 = TWOPI - tmpabs;
-      if (tmpabs > tmpabs2) {
-        if (tmp < 0)
-          tmp = tmpabs2;
-        else
-          tmp = -tmpabs2;
-      }
-      *pout = tmp;
-    });
+  idx_parallel_map2(i1, i2, out, spherical_sub_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_spherical_add
 
 template <typename T> void idx_spherical_add(idx<T> &i1, idx<T> &i2, idx<T> &out){
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T, {
-      *pout = std::min(TWOPI - *pi1, *pi1) + std::min(TWOPI - *pi2, - *pi2);
-    });
+  idx_parallel_map2(i1, i2, out, spherical_add_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_mul
 
 template <typename T> void idx_mul(idx<T> &i1, idx<T> &i2, idx<T> &out) {
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T,
-              {*pout = (*pi1) * (*pi2); });
+  idx_parallel_map2(i1, i2, out, mul_op<T>());
 }
 
 template <typename T, typename T2>
@@ -423,25 +619,14 @@ void idx_mul(idx<T> &i1, idx<T2> &i2, idx<T> &out) {
 }
 
 template <typename T> void idx_mulacc(idx<T> &i1, idx<T> &i2, idx<T> &out) {
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T,
-              {*pout += (*pi1) * (*pi2); });
+  idx_parallel_map2(i1, i2, out, mulacc_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_div
 
 template <typename T> void idx_div(idx<T> &i1, idx<T> &i2, idx<T> &out) {
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T, {
-      *pout = (*pi1) / (*pi2);
-    });
-  // since we cannot put a ifdef in a macro, we repeat the code here
-#ifdef __DEBUG__
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T, {
-      if (*pi2 == 0)
-        eblerror("division by zero");
-      *pout = (*pi1) / (*pi2);
-    });
-#endif
+  idx_parallel_map2(i1, i2, out, div_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -452,11 +637,11 @@ template<class T, class T2> void idx_addc(idx<T> & inp, T2 c, idx<T> & out) {
 }
 
 template <typename T> void idx_addc(idx<T> &inp, T c, idx<T> &out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, { *pout = *pinp + c; });
+  idx_parallel_map(inp, out, addc_op<T>(c));
 }
 
 template <typename T> void idx_addc(idx<T> &inp, T c) {
-  idx_aloopf1(pinp, inp, T, { *pinp += c; });
+  idx_parallel_map(inp, inp, addc_op<T>(c));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -469,9 +654,7 @@ void idx_addc_bounded(idx<T> & inp, T2 c, idx<T> & out) {
 
 
 template <typename T> void idx_addc_bounded(idx<T> &inp, T c, idx<T> &out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, {
-      *pout = saturate(*pinp + c, T);
-    });
+  idx_parallel_map(inp, out, addc_bounded_op<T>(c));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -484,9 +667,7 @@ void idx_subc_bounded(idx<T> &inp, T2 c, idx<T> &out) {
 
 
 template <typename T> void idx_subc_bounded(idx<T> &inp, T c, idx<T> &out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, {
-      *pout = saturate(*pinp - c, T);
-    });
+  idx_parallel_map(inp, out, subc_bounded_op<T>(c));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -498,14 +679,14 @@ void idx_addcacc(idx<T> & inp, T2 c, idx<T> & out) {
 }
 
 template <typename T> void idx_addcacc(idx<T> &inp, T c, idx<T> &out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, { *pout += *pinp + c; });
+  idx_parallel_map(inp, out, addcacc_op<T>(c));
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_dotc
 
 template<class T, class T2> void idx_dotc(idx<T> &inp, T2 c, idx<T> &out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, { *pout = (T)(*pinp * c); });
+  idx_parallel_map(inp, out, dotc_op<T,T2>(c));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -513,16 +694,14 @@ template<class T, class T2> void idx_dotc(idx<T> &inp, T2 c, idx<T> &out) {
 
 template<class T, class T2>
 void idx_dotc_bounded(idx<T> &inp, T2 c, idx<T> &out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, {
-      *pout = saturate(*pinp * c, T);
-    });
+  idx_parallel_map(inp, out, dotc_bounded_op<T,T2>(c));
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_dotcacc
 
 template<class T, class T2> void idx_dotcacc(idx<T> &inp, T2 c, idx<T> &out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, { *pout += (T)(*pinp * c); });
+  idx_parallel_map(inp, out, dotcacc_op<T,T2>(c));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -534,9 +713,7 @@ void idx_signdotc(idx<T> &inp, T2 c, idx<T> &out) {
 }
 
 template <typename T> void idx_signdotc(idx<T> &inp, T c, idx<T> &out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, {
-      *pout = (*pinp < 0) ? -c : c;
-    });
+  idx_parallel_map(inp, out, signdotc_op<T>(c));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -548,81 +725,49 @@ void idx_signdotcacc(idx<T> &inp, T2 c, idx<T> &out) {
 }
 
 template <typename T> void idx_signdotcacc(idx<T> &inp, T c, idx<T> &out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, {
-      *pout += (*pinp < 0) ? -c : c;
-    });
+  idx_parallel_map(inp, out, signdotcacc_op<T>(c));
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_subsquare
 
 template <typename T> void idx_subsquare(idx<T> &i1, idx<T> &i2, idx<T> &out) {
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T, {
-      T d = *pi1 - *pi2;
-      *pout = d*d;
-    });
+  idx_parallel_map2(i1, i2, out, subsquare_op<T>());
 }
 
 template <typename T> void idx_subsquareacc(idx<T> &i1, idx<T> &i2, idx<T> &out) {
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T, {
-      T d = *pi1 - *pi2;
-      *pout += d*d;
-    });
+  idx_parallel_map2(i1, i2, out, subsquareacc_op<T>());
 }
 
 // idx_lincom ////////////////////////////////////////////////////////////////
 
-// not very efficient. There must be a more parallel way of doing this
 template <typename T>
 void idx_lincomb(idx<T> &i1, T k1, idx<T> &i2, T k2, idx<T> &out) {
-  idx_aloopf3(pi1, i1, T, pi2, i2, T, pout, out, T, {
-      *pout = k1 * (*pi1) + k2 * (*pi2);
-    });
+  idx_parallel_map2(i1, i2, out, lincomb_op<T>(k1, k2));
 }
 
 // idx_tanh //////////////////////////////////////////////////////////////////
 
 template <typename T> void idx_tanh(idx<T> &inp, idx<T> &out) {
-  idx_checknelems2_all(inp, out);
-#ifdef __OPENMP__
-  T* inptr = inp.idx_ptr();
-  T* outptr = out.idx_ptr();
-#pragma omp parallel for
-  for(int i=0; i< inp.nelements(); ++i) {
-    outptr[i] = (T)(tanh((double)inptr[i]));
-  }
-#else
-  idx_aloopf2(pinp, inp, T, pout, out, T, {
-      *pout = (T)(tanh((double)*pinp));
-    });
-#endif
+  idx_parallel_map(inp, out, tanh_op<T>());
 }
 
 // idx_dtanh /////////////////////////////////////////////////////////////////
 
 template <typename T> void idx_dtanh(idx<T> &inp, idx<T> &out) {
-  idx_checknelems2_all(inp, out);
-  idx_aloopf2(pinp, inp, T, pout, out, T, {
-      *pout = (T) (dtanh((double)*pinp));
-    });
+  idx_parallel_map(inp, out, dtanh_op<T>());
 }
 
 // idx_stdsigmoid ////////////////////////////////////////////////////////////
 
 template <typename T> void idx_stdsigmoid(idx<T> &inp, idx<T> &out) {
-  idx_checknelems2_all(inp, out);
-  idx_aloopf2(pinp, inp, T, pout, out, T, {
-      *pout = (T) (stdsigmoid((double)*pinp));
-    });
+  idx_parallel_map(inp, out, stdsigmoid_op<T>());
 }
 
 // idx_dstdsigmoid ///////////////////////////////////////////////////////////
 
 template <typename T> void idx_dstdsigmoid(idx<T> &inp, idx<T> &out) {
-  idx_checknelems2_all(inp, out);
-  idx_aloopf2(pinp, inp, T, pout, out, T, {
-      *pout = (T) (dstdsigmoid((double)*pinp));
-    });
+  idx_parallel_map(inp, out, dstdsigmoid_op<T>());
 }
 
 // idx_abs ///////////////////////////////////////////////////////////////////
@@ -644,8 +789,12 @@ template<> inline int16 abs2 (int16 a) {
   return (a == -32768) ? 32767 : -a;
 }
 
+//! Elementwise operator of idx_abs.
+template <typename T> struct abs_op {
+  inline void operator()(T x, T &y) const { y = abs2<T>(x); } };
+
 template <typename T> void idx_abs(idx<T>& inp, idx<T>& out) {
-  idx_aloopf2(pinp, inp, T, pout, out, T, { *pout = abs2<T>(*pinp); });
+  idx_parallel_map(inp, out, abs_op<T>());
 }
 
 
@@ -658,9 +807,7 @@ void idx_thresdotc_acc(idx<T>& in, T2 c, T3 th, idx<T>& out) {
 }
 
 template <typename T> void idx_thresdotc_acc(idx<T>& in, T c, T th, idx<T>& out) {
-  idx_aloopf2(pin, in, T, pout, out, T, {
-      *pout += (*pin < -th) ? -c : (*pin > th) ? c : 0;
-    });
+  idx_parallel_map(in, out, thresdotc_acc_op<T>(c, th));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -671,11 +818,11 @@ template<class T, class T2> void idx_threshold(idx<T> & in, T2 th) {
 }
 
 template <typename T> void idx_threshold(idx<T>& in, T th) {
-  idx_aloopf1(pin, in, T, { if (*pin < th) *pin = th; });
+  idx_parallel_map(in, in, threshold_op<T>(th, th));
 }
 
 template <typename T> void idx_threshold2(idx<T>& in, T th) {
-  idx_aloopf1(pin, in, T, { if (*pin > th) *pin = th; });
+  idx_parallel_map(in, in, threshold2_op<T>(th));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -687,13 +834,7 @@ void idx_threshold(idx<T> & in, T2 th, idx<T> & out) {
 }
 
 template <typename T> void idx_threshold(idx<T>& in, T th, idx<T>& out) {
-  idx_checknelems2_all(in, out);
-  idx_aloopf2(pin, in, T, pout, out, T, {
-      if (*pin < th)
-        *pout = th;
-      else
-	*pout = *pin;
-    });
+  idx_parallel_map(in, out, threshold_op<T>(th, th));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -706,7 +847,7 @@ void idx_threshold(idx<T> & in, T2 th, T3 value) {
 }
 
 template <typename T> void idx_threshold(idx<T>& in, T th, T value) {
-  idx_aloopf1(pin, in, T, { if (*pin < th) *pin = value; });
+  idx_parallel_map(in, in, threshold_op<T>(th, value));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -719,12 +860,7 @@ void idx_threshold(idx<T> & in, T2 th, T3 value, idx<T> & out) {
 }
 
 template <typename T> void idx_threshold(idx<T>& in, T th, T value, idx<T>& out) {
-  idx_aloopf2(pin, in, T, pout, out, T, {
-      if (*pin < th)
-        *pout = value;
-      else
-        *pout = *pin;
-    });
+  idx_parallel_map(in, out, threshold_op<T>(th, value));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -742,10 +878,7 @@ void idx_threshold(idx<T>& in, T th, T2 below, T2 above, idx<T2>& out) {
 // idx_sqrt
 
 template <typename T> void idx_sqrt(idx<T>& in, idx<T>& out) {
-  idx_checknelems2_all(in, out);
-  idx_aloopf2(pin, in, T, pout, out, T, {
-      *pout = (T)sqrt((float64)(*pin));
-    });
+  idx_parallel_map(in, out, sqrt_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -757,10 +890,7 @@ template<class T, class T2> void idx_power(idx<T> & in, T2 p, idx<T> & out) {
 }
 
 template <typename T> void idx_power(idx<T>& in, T p, idx<T>& out) {
-  idx_checknelems2_all(in, out);
-  idx_aloopf2(pin, in, T, pout, out, T, {
-      *pout = saturate(pow((double)(*pin), (double)p), T);
-    });
+  idx_parallel_map(in, out, power_op<T>(p));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1485,6 +1615,21 @@ template<typename T>
 void idx_m2oversampleacc(idx<T>& small, intg nlin, intg ncol, idx<T>& big) {
   idx<T> uin  = big.unfold(0, nlin, nlin);
   idx<T> uuin = uin.unfold(1, ncol, ncol);
+  if (small.mod(1) == 1 && big.mod(1) == 1
+      && small.dim(0) == uuin.dim(0) && small.dim(1) == uuin.dim(1)) {
+    // contiguous rows: repeat each element of small ncol times, nlin rows
+    intg ni = small.dim(0), nj = small.dim(1);
+    for (intg i = 0; i < ni; ++i) {
+      T *s = small.idx_ptr() + i * small.mod(0);
+      for (intg l = 0; l < nlin; ++l) {
+        T *b = big.idx_ptr() + (i * nlin + l) * big.mod(0);
+        for (intg j = 0; j < nj; ++j, b += ncol)
+          for (intg c = 0; c < ncol; ++c)
+            b[c] += s[j];
+      }
+    }
+    return ;
+  }
   idx_eloop1(z1, uuin, T) {
     idx_eloop1(z2, z1, T) {
       idx_add(small, z2, z2);
@@ -1492,6 +1637,173 @@ void idx_m2oversampleacc(idx<T>& small, intg nlin, intg ncol, idx<T>& big) {
   }
 }
 
+////////////////////////////////////////////////////////////////////////
+// idx_m2subsample
+
+//! Sum each K consecutive elements of 'row' into 'out', n times.
+template <typename T, int K>
+inline void m2subsample_blocks(const T *row, T *out, intg n) {
+  for (intg j = 0; j < n; ++j, row += K) {
+    T s = row[0];
+    for (int c = 1; c < K; ++c)
+      s += row[c];
+    out[j] = s;
+  }
+}
+
+//! Sum each k consecutive elements of 'row' into 'out', n times.
+template <typename T>
+inline void m2subsample_blocks(const T *row, intg k, T *out, intg n) {
+  for (intg j = 0; j < n; ++j, row += k) {
+    T s = row[0];
+    for (intg c = 1; c < k; ++c)
+      s += row[c];
+    out[j] = s;
+  }
+}
+
+template<typename T>
+void idx_m2subsample(idx<T>& big, intg nlin, intg ncol, idx<T>& small) {
+  idx_checkorder2(big, 2, small, 2);
+  intg ni = small.dim(0), nj = small.dim(1), w = nj * ncol;
+  if (big.dim(0) < ni * nlin || big.dim(1) < w)
+    eblerror("cannot subsample " << big << " by " << nlin << "x" << ncol
+             << " into " << small);
+  if (big.mod(1) != 1) { // non-contiguous rows
+    idx_clear(small);
+    idx<T> b = big.narrow(0, ni * nlin, 0);
+    b = b.narrow(1, w, 0);
+    idx<T> uuin = b.unfold(0, nlin, nlin);
+    uuin = uuin.unfold(1, ncol, ncol);
+    idx_eloop1(z1, uuin, T) {
+      idx_eloop1(z2, z1, T) {
+        idx_add(z2, small);
+      }
+    }
+    return ;
+  }
+  std::vector<T> rowsum(w);
+  T *tmp = &rowsum[0];
+  T *out = small.idx_ptr();
+  idx<T> o;
+  if (small.mod(1) != 1) { // sum into a contiguous buffer
+    o = idx<T>(ni, nj);
+    out = o.idx_ptr();
+  }
+  intg omod = small.mod(1) != 1 ? nj : small.mod(0);
+  for (intg i = 0; i < ni; ++i, out += omod) {
+    // vertical sums of the nlin rows of this block row
+    const T *r = big.idx_ptr() + i * nlin * big.mod(0);
+    for (intg c = 0; c < w; ++c)
+      tmp[c] = r[c];
+    for (intg l = 1; l < nlin; ++l) {
+      r += big.mod(0);
+      for (intg c = 0; c < w; ++c)
+        tmp[c] += r[c];
+    }
+    // horizontal sums
+    switch (ncol) {
+      case 1: for (intg c = 0; c < w; ++c) out[c] = tmp[c]; break ;
+      case 2: m2subsample_blocks<T,2>(tmp, out, nj); break ;
+      case 3: m2subsample_blocks<T,3>(tmp, out, nj); break ;
+      case 4: m2subsample_blocks<T,4>(tmp, out, nj); break ;
+      default: m2subsample_blocks(tmp, ncol, out, nj);
+    }
+  }
+  if (small.mod(1) != 1)
+    idx_copy(o, small);
+}
+
+////////////////////////////////////////////////////////////////////////
+// idx_m2maxpool
+
+//! Max of the KI x KJ window starting at 'in' with row stride 'm0' and
+//! column stride 'm1', returns the window coordinates of the max.
+template <typename T, int KI, int KJ>
+inline T m2maxpool_window(const T *in, intg m0, intg m1, intg &bi, intg &bj) {
+  T best = in[0];
+  bi = 0; bj = 0;
+  for (int r = 0; r < KI; ++r, in += m0)
+    for (int c = 0; c < KJ; ++c)
+      if (in[c * m1] > best) {
+        best = in[c * m1];
+        bi = r; bj = c;
+      }
+  return best;
+}
+
+//! Same as the fixed size version, for a ki x kj window.
+template <typename T>
+inline T m2maxpool_window(const T *in, intg m0, intg m1, intg ki, intg kj,
+                          intg &bi, intg &bj) {
+  T best = in[0];
+  bi = 0; bj = 0;
+  for (intg r = 0; r < ki; ++r, in += m0)
+    for (intg c = 0; c < kj; ++c)
+      if (in[c * m1] > best) {
+        best = in[c * m1];
+        bi = r; bj = c;
+      }
+  return best;
+}
+
+template<typename T>
+void idx_m2maxpool(idx<T>& in, intg ki, intg kj, intg si, intg sj,
+                   idx<T>& out, idx<int>& switches) {
+  idx_checkorder2(in, 2, out, 2);
+  intg ni = out.dim(0), nj = out.dim(1), h = in.dim(0), w = in.dim(1);
+  if (switches.order() != 3 || switches.dim(0) != ni
+      || switches.dim(1) != nj || switches.dim(2) != 2)
+    eblerror("expected " << ni << "x" << nj << "x2 switches but got "
+             << switches);
+  const T *pin = in.idx_ptr();
+  intg m0 = in.mod(0), m1 = in.mod(1);
+  // number of windows fully inside the input
+  intg fi = h < ki ? 0 : std::min(ni, (h - ki) / si + 1);
+  intg fj = w < kj ? 0 : std::min(nj, (w - kj) / sj + 1);
+  intg bi = 0, bj = 0;
+  T best;
+  for (intg i = 0; i < ni; ++i) {
+    T *o = out.idx_ptr() + i * out.mod(0);
+    int *sw = switches.idx_ptr() + i * switches.mod(0);
+    for (intg j = 0; j < nj; ++j, o += out.mod(1), sw += switches.mod(1)) {
+      intg i0 = i * si, j0 = j * sj;
+      if (i0 >= h || j0 >= w) { // window entirely outside of input
+        *o = 0;
+        sw[0] = -1; sw[switches.mod(2)] = -1;
+        continue ;
+      }
+      const T *win = pin + i0 * m0 + j0 * m1;
+      if (i < fi && j < fj && ki == kj && ki >= 2 && ki <= 4) {
+        switch (ki) {
+          case 2: best = m2maxpool_window<T,2,2>(win, m0, m1, bi, bj); break ;
+          case 3: best = m2maxpool_window<T,3,3>(win, m0, m1, bi, bj); break ;
+          default: best = m2maxpool_window<T,4,4>(win, m0, m1, bi, bj);
+        }
+      } else // generic or clipped window
+        best = m2maxpool_window(win, m0, m1, std::min(ki, h - i0),
+                                std::min(kj, w - j0), bi, bj);
+      *o = best;
+      sw[0] = (int) (i0 + bi);
+      sw[switches.mod(2)] = (int) (j0 + bj);
+    }
+  }
+}
+
+template<typename T>
+void idx_m2unpoolacc(idx<T>& small, idx<int>& switches, idx<T>& big) {
+  idx_checkorder2(small, 2, big, 2);
+  intg ni = small.dim(0), nj = small.dim(1);
+  T *b = big.idx_ptr();
+  for (intg i = 0; i < ni; ++i) {
+    for (intg j = 0; j < nj; ++j) {
+      int r = switches.get(i, j, 0), c = switches.get(i, j, 1);
+      if (r >= 0 && c >= 0)
+        b[r * big.mod(0) + c * big.mod(1)] += small.get(i, j);
+    }
+  }
+}
+
 ////////////////////////////////////////////////////////////////////////
 // idx_max
 
@@ -1503,12 +1815,12 @@ template <class T> T idx_max(idx<T> &m) {
 
 // idx_max (between 2 idx's, in-place)
 template <class T> void idx_max(idx<T> &in1, idx<T> &in2) {
-  idx_aloopf2(i1, in1, T, i2, in2, T, { *i2 = std::max(*i1, *i2); });
+  idx_parallel_map2(in1, in2, in2, max_op<T>());
 }
 
 // idx_max (between 2 idx's, not-in-place)
 template <class T> void idx_max(idx<T> &in1, idx<T> &in2, idx<T> &out) {
-  idx_aloopf3(i1, in1, T, i2, in2, T, o, out, T, { *o = std::max(*i1, *i2);});
+  idx_parallel_map2(in1, in2, out, max_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1522,7 +1834,7 @@ template <class T> T idx_min(idx<T> &m) {
 
 // idx_min (between 2 idx's, in-place)
 template <class T> void idx_min(idx<T> &in1, idx<T> &in2) {
-  idx_aloopf2(i1, in1, T, i2, in2, T, { *i2 = std::min(*i1, *i2); });
+  idx_parallel_map2(in1, in2, in2, min_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1828,16 +2140,14 @@ template <typename T> float64 idx_spherical_sqrdist(idx<T> &i1, idx<T> &i2) {
 
 template <typename T>
 void idx_gaussian(idx<T> &in, double m, double sigma, idx<T> &out) {
-  idx_aloopf2(i, in, T, o, out, T, {
-      *o = (T) gaussian((double) (*i), m, sigma);
-    });
+  idx_parallel_map(in, out, gaussian_op<T>(m, sigma));
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_modulo
 
 template <class T> void idx_modulo(idx<T> &m, T mod) {
-  idx_aloopf1(e, m, T, { *e = *e % mod; });
+  idx_parallel_map(m, m, modulo_op<T>(mod));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1848,26 +2158,18 @@ template <class T> void idx_exp(idx<T> &m) {
   // specialized template, therefore, calls to this generic template
   // will be with types of lower precision than float32, no need for
   // float64 precision.
-  idx_aloopf1(i, m, T, { *i = saturate(exp((float32)*i), T); });
+  idx_parallel_map(m, m, exp_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
 // idx_log
 
 template <class T> void idx_log(idx<T> &m) {
-#ifdef __WINDOWS__
-  idx_aloopf1(i, m, T, { *i = (T)log((double)*i); });
-#else
-  idx_aloopf1(i, m, T, { *i = (T)log(*i); });
-#endif
+  idx_parallel_map(m, m, log_op<T>());
 }
 
 template <typename T> EXPORT void idx_log(idx<T>& in, idx<T> &out) {
-#ifdef __WINDOWS__
-	idx_aloopf2(i, in, T, o, out, T, { *o = (T)log((double)*i); });
-#else
-	idx_aloopf2(i, in, T, o, out, T, { *o = (T)log(*i); });
-#endif
+  idx_parallel_map(in, out, log_op<T>());
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -1917,14 +2219,7 @@ template <typename T> void idx_dotacc(idx<T> &i1, idx<T> &i2, idx<T> &o) {
 // idx_clip
 
 template <typename T> void idx_clip(idx<T> &i1, T m, idx<T> &o1) {
-  idx_checknelems2_all(i1, o1);
-#if USING_FAST_ITERS == 0
-  { idx_aloop2(i, i1, T, o, o1, T) {
-      *o = (std::max)(m, *i);
-    }}
-#else
-  idx_aloopf2(i, i1, T, o, o1, T, { *o = std::max(m, *i); });
-#endif
+  idx_parallel_map(i1, o1, clip_op<T>(m));
 }
 
 ////////////////////////////////////////////////////////////////////////
@@ -2056,6 +2351,89 @@ void idx_random(idx<T> &m, double v) {
   idx_aloopf1(mm, m, T, { *mm = (T) drand(v); });
 }
 
+template <typename T>
+idx_fill_random_task<T>::
+idx_fill_random_task(idx<T> &m_, const philox &g_, uint64 start_,
+                     bool normal_, double a_, double b_)
+  : m(m_), g(g_), start(start_), normal(normal_), a(a_), b(b_),
+    flat(m_.contiguousp()) {
+}
+
+template <typename T>
+idx_fill_random_task<T>::~idx_fill_random_task() {
+}
+
+template <typename T>
+void idx_fill_random_task<T>::run_range(intg begin, intg end) {
+  if (flat) {
+    fill(m.idx_ptr() + begin, end - begin, begin);
+    return ;
+  }
+  // slices of dimension 0
+  for (intg j = begin; j < end; ++j) {
+    idx<T> s = m.select(0, j);
+    intg n = s.nelements();
+    if (s.contiguousp())
+      fill(s.idx_ptr(), n, j * n);
+    else {
+      idx<T> tmp(s.get_idxdim());
+      fill(tmp.idx_ptr(), n, j * n);
+      idx_copy(tmp, s);
+    }
+  }
+}
+
+template <typename T>
+void idx_fill_random_task<T>::run_all() {
+  intg grain = thread_pool::global().get_grain();
+  if (flat)
+    parallel_for(*this, m.nelements(), grain);
+  else
+    parallel_for(*this, m, 0, grain);
+}
+
+template <typename T>
+void idx_fill_random_task<T>::fill(T *out, intg n, intg i) {
+  uint32 buf[256];
+  intg per = normal ? 128 : 256;
+  for (intg k = 0; k < n; k += per) {
+    intg nk = std::min(per, n - k);
+    T *o = out + k;
+    if (normal) {
+      g.fill(start + 2 * (i + k), buf, 2 * nk);
+      for (intg e = 0; e < nk; ++e)
+        o[e] = (T) (a + b * philox::to_normal(buf[2 * e], buf[2 * e + 1]));
+    } else {
+      g.fill(start + i + k, buf, nk);
+      for (intg e = 0; e < nk; ++e)
+        o[e] = (T) (a + (b - a) * philox::to_uniform(buf[e]));
+    }
+  }
+}
+
+template <typename T>
+void idx_fill_uniform(idx<T> &m, double v0, double v1, philox &g) {
+  idx_fill_random_task<T> t(m, g, g.reserve(m.nelements()), false, v0, v1);
+  t.run_all();
+}
+
+template <typename T>
+void idx_fill_uniform(idx<T> &m, double v0, double v1) {
+  idx_fill_uniform(m, v0, v1, global_philox());
+}
+
+template <typename T>
+void idx_fill_normal(idx<T> &m, double mean, double sigma, philox &g) {
+  idx_fill_random_task<T> t(m, g, g.reserve(2 * m.nelements()), true,
+                            mean, sigma);
+  t.run_all();
+}
+
+template <typename T>
+void idx_fill_normal(idx<T> &m, double mean, double sigma) {
+  idx_fill_normal(m, mean, sigma, global_philox());
+}
+
 } // end namespace ebl
 
 /*
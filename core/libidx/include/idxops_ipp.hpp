@@ -334,8 +334,6 @@
 ////////////////////////////////////////////////////////////////////////
 // idx_sum
 
-#ifndef __OPENMP__
-
 #define idx_sum_macro(T)				\
   template<> T idx_sum(idx<T> &inp, T* out) {		\
     if (inp.contiguousp()) {				\
@@ -357,8 +355,6 @@
     }							\
   }
 
-#endif
-
 ////////////////////////////////////////////////////////////////////////
 // idx_sumabs
 
@@ -191,6 +191,37 @@ namespace ebl {
     void image_warp_flow(idx<T> &src, idx<T> &dst, idx<float> &flow,
 			 bool bilinear = true, bool use_background = true,
 			 T background = 0);
+
+  //! Warps each channel of planar image 'src' (CxHxW) into 'dst' with
+  //! bilinear interpolation: destination pixel (h, w) is read at source
+  //! coordinates (m[0] * h + m[1] * w + m[2], m[3] * h + m[4] * w + m[5])
+  //! (see deformation_affine()), plus the offsets of 'flow' (2xHxW) if not
+  //! null. Pixels falling outside of 'src' are set to 'background'.
+  //! This gives the same result as image_warp_flow() without building a
+  //! dense flow for the affine part. Coordinates and weights are computed
+  //! once per pixel for all channels, in row buffers the compiler can
+  //! vectorize.
+  //! \param parallel If true, rows are warped in parallel on the
+  //!   library-wide thread_pool.
+  template <typename T>
+    void image_warp_affine(idx<T> &src, idx<T> &dst, const float *m,
+			   idx<float> *flow = NULL, T background = 0,
+			   bool parallel = true);
+
+  //! Warps rows [begin, end) of a planar image, see image_warp_affine().
+  template <typename T>
+    class image_warp_affine_task : public parallel_range_task {
+  public:
+    image_warp_affine_task(idx<T> &src, idx<T> &dst, const float *m,
+			   idx<float> *flow, T background);
+    virtual ~image_warp_affine_task();
+    virtual void run_range(intg begin, intg end);
+  protected:
+    idx<T> &src, &dst;
+    const float *m;
+    idx<float> *flow;
+    T background;
+  };
  
   //////////////////////////////////////////////////////////////////////////////
   // bilinear interpolation
@@ -354,7 +385,9 @@ namespace ebl {
 				      float shh, float shw,
 				      uint elsize, float elcoeff,
 				      T background = 0);
-  //! 
+  //! Applies the deformations of image_deformation_flow() to interleaved
+  //! image 'in' (HxWxC) into 'out'. Only the elastic part uses a dense flow,
+  //! the affine part is directly warped by image_warp_affine().
   template<typename T>
     void image_deformation(idx<T> &in, idx<T> &out, float th, float tw,
 			   float sx, float sy, float deg,
@@ -386,7 +419,21 @@ namespace ebl {
   EXPORT void affine_flow(idx<float> &grid, idx<float> &flow,
 		   float th, float tw, float sh, float sw,
 		   float shh, float shw, float deg);
-  EXPORT void elastic_flow(idx<float> &flow, uint elsize, float elcoeff);
+  //! Accumulates into 'flow' (2xHxW) uniform noise in [-.5, .5] smoothed by
+  //! a gaussian kernel of size 'elsize' and multiplied by 'elcoeff'.
+  //! The gaussian is applied separably on rows then columns.
+  //! \param noise, tmp Optional buffers reused across calls.
+  //! \param g If not NULL, the noise is drawn from 'g' rather than drand().
+  EXPORT void elastic_flow(idx<float> &flow, uint elsize, float elcoeff,
+			   idx<float> *noise = NULL, idx<float> *tmp = NULL,
+			   philox *g = NULL);
+  //! Returns in 'm' the affine transformation computed by
+  //! image_deformation_flow() (without elastic deformation) for an image of
+  //! size 'height'x'width', as the source coordinates of destination pixel
+  //! (h, w): (m[0] * h + m[1] * w + m[2], m[3] * h + m[4] * w + m[5]).
+  EXPORT void deformation_affine(intg height, intg width, float th, float tw,
+				 float sh, float sw, float deg,
+				 float shh, float shw, float *m);
 
   //////////////////////////////////////////////////////////////////////////////
 
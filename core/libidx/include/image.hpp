@@ -35,6 +35,7 @@
 
 #include <math.h>
 #include <stdlib.h>
+#include <vector>
 
 #define BLK_AVRG(nlin, ncol) {						\
     int k,l; int norm = ncol * nlin;					\
@@ -696,6 +697,94 @@ namespace ebl {
     }
   }
 
+  template <typename T>
+  void image_warp_affine(idx<T> &src, idx<T> &dst, const float *m,
+			 idx<float> *flow, T background, bool parallel) {
+    if (src.order() != 3 || !dst.same_dim(src.get_idxdim()))
+      eblerror("expected planar images of same dimensions but got "
+	       << src << " and " << dst);
+    if (flow && (flow->order() != 3 || flow->dim(0) != 2
+		 || flow->dim(1) != src.dim(1) || flow->dim(2) != src.dim(2)))
+      eblerror("expected a 2x" << src.dim(1) << "x" << src.dim(2)
+	       << " flow but got " << *flow);
+    image_warp_affine_task<T> t(src, dst, m, flow, background);
+    if (parallel) parallel_for(t, dst, 1);
+    else t.run_range(0, dst.dim(1));
+  }
+
+  template <typename T>
+  image_warp_affine_task<T>::
+  image_warp_affine_task(idx<T> &src_, idx<T> &dst_, const float *m_,
+			 idx<float> *flow_, T background_)
+    : src(src_), dst(dst_), m(m_), flow(flow_), background(background_) {
+  }
+
+  template <typename T>
+  image_warp_affine_task<T>::~image_warp_affine_task() {
+  }
+
+  template <typename T>
+  void image_warp_affine_task<T>::run_range(intg begin, intg end) {
+    intg nc = src.dim(0), height = src.dim(1), width = src.dim(2);
+    intg sm0 = src.mod(0), sm1 = src.mod(1), sm2 = src.mod(2);
+    intg dm0 = dst.mod(0), dm1 = dst.mod(1), dm2 = dst.mod(2);
+    float fheight = (float) height, fwidth = (float) width;
+    // per-row buffers: source coordinates, then offsets and weights of
+    // the 4 neighbors (offset -1 for background)
+    std::vector<float> py(width), px(width);
+    std::vector<intg> o0(width), o1(width), o2(width), o3(width);
+    std::vector<float> w0(width), w1(width), w2(width), w3(width);
+    T *s = src.idx_ptr(), *d = dst.idx_ptr();
+    for (intg y = begin; y < end; ++y) {
+      // source coordinates
+      float y0 = m[0] * y + m[2], x0 = m[3] * y + m[5];
+      for (intg x = 0; x < width; ++x) {
+	py[x] = y0 + m[1] * x;
+	px[x] = x0 + m[4] * x;
+      }
+      if (flow) {
+	float *fy = flow->idx_ptr() + y * flow->mod(1);
+	float *fx = fy + flow->mod(0);
+	intg fm = flow->mod(2);
+	for (intg x = 0; x < width; ++x) {
+	  py[x] += fy[x * fm];
+	  px[x] += fx[x * fm];
+	}
+      }
+      // neighbors and bilinear weights
+      for (intg x = 0; x < width; ++x) {
+	float iy = py[x], ix = px[x];
+	if (ix < 0 || ix >= fwidth || iy < 0 || iy >= fheight) {
+	  o0[x] = -1;
+	  continue ;
+	}
+	intg ix0 = (intg) ix, iy0 = (intg) iy; // positive: truncation is floor
+	float fx = ix - ix0, fy = iy - iy0;
+	intg ix1 = std::min(ix0 + 1, width - 1);
+	intg iy1 = std::min(iy0 + 1, height - 1);
+	o0[x] = iy0 * sm1 + ix0 * sm2;
+	o1[x] = iy0 * sm1 + ix1 * sm2;
+	o2[x] = iy1 * sm1 + ix0 * sm2;
+	o3[x] = iy1 * sm1 + ix1 * sm2;
+	w0[x] = (1 - fx) * (1 - fy);
+	w1[x] = fx * (1 - fy);
+	w2[x] = (1 - fx) * fy;
+	w3[x] = fx * fy;
+      }
+      // interpolate each channel
+      for (intg c = 0; c < nc; ++c) {
+	T *sc = s + c * sm0, *dc = d + c * dm0 + y * dm1;
+	for (intg x = 0; x < width; ++x, dc += dm2) {
+	  if (o0[x] < 0)
+	    *dc = background;
+	  else
+	    *dc = (T) (sc[o0[x]] * w0[x] + sc[o1[x]] * w1[x]
+		       + sc[o2[x]] * w2[x] + sc[o3[x]] * w3[x]);
+	}
+      }
+    }
+  }
+
   template <typename T>
   void image_interpolate_bilin(T* background, T *pin, int indimi, int indimj,
 			       int inmodi, int inmodj, int ppi, int ppj,
@@ -1167,7 +1256,7 @@ namespace ebl {
 
     if (th != 0 || tw != 0) translation_flow(grid, flow, th, tw);
     if (deg != 0) rotation_flow(grid, flow, deg);
-    if (th != 1 || tw != 1) scale_flow(grid, flow, sh, sw);
+    if (sh != 1 || sw != 1) scale_flow(grid, flow, sh, sw);
     if (shh != 0 || shw != 0) shear_flow(grid, flow, shh, shw);
     if (elsize > 0) elastic_flow(flow, elsize, elcoeff);
 
@@ -1180,11 +1269,17 @@ namespace ebl {
 			 float sh, float sw, float deg,
 			 float shh, float shw, uint elsize, float elcoeff,
 			 T background) {
-    idx<float> flow =
-      image_deformation_flow(in, th, tw, sh, sw, deg, shh, shw, elsize, elcoeff,
-			     background);
-    // apply flow
-    image_warp_flow(in, out, flow);
+    float m[6];
+    deformation_affine(in.dim(0), in.dim(1), th, tw, sh, sw, deg, shh, shw, m);
+    // planar views of interleaved images
+    idx<T> pin = in.shift_dim(2, 0), pout = out.shift_dim(2, 0);
+    if (elsize > 0) {
+      idx<float> flow(2, in.dim(0), in.dim(1));
+      idx_clear(flow);
+      elastic_flow(flow, elsize, elcoeff);
+      image_warp_affine(pin, pout, m, &flow, background);
+    } else
+      image_warp_affine(pin, pout, m, (idx<float>*) NULL, background);
   }
 
 } // end namespace ebl
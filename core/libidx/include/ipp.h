@@ -324,10 +324,8 @@ namespace ebl {
   //! returns the sum of all the terms, specialized int16 version
   template<> int16 idx_sum(idx<int16> &inp, int16 *out);  
 
-#if defined(__OPENMP__) and defined(__USE_SSE__)
   //! returns the sum of all the terms, specialized float32 version
   template<> float32 idx_sum(idx<float32> &inp, float32 *out);
-#endif
 
 #endif
 
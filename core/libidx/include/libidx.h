@@ -40,8 +40,10 @@
 #include "srg.h"
 #include "idx.h"
 #include "idxiter.h"
+#include "idx_view.h"
 #include "idxIO.h"
 #include "idxops.h"
+#include "idxconv.h"
 #include "ippops.h"
 #include "thops.h"
 #include "color_spaces.h"
@@ -56,5 +58,6 @@
 #include "smart.h"
 #include "random.h"
 #include "string_utils.h"
+#include "thread_pool.h"
 
 #endif /* LIBIDX_H_ */
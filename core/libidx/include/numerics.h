@@ -92,7 +92,8 @@ namespace ebl {
   extern IMPORT bool drand_ini;
 #endif
 
-  //! initializes drand by calling dseed, and raises drand_ini
+  //! initializes drand by calling dseed, seeds global_philox() with x,
+  //! and raises drand_ini
   EXPORT void init_drand(int x);
   //! Initializes drand by calling dseed with a random seed taken
   //! from current time and the sum of all arguments characters,
@@ -112,6 +113,9 @@ namespace ebl {
   EXPORT void dseed(int x);
   //! random number generator. Return a random number
   //! drawn from a uniform distribution over [0,1].
+  //! drand, dgauss and dseed share one state and are thread-safe, but
+  //! threads drawing concurrently interleave in no fixed order. Use
+  //! per-thread philox streams for reproducible parallel draws.
   EXPORT double drand(void);
   //! random number generator. Return a random number
   //! drawn from a uniform distribution over [-v,+v].
@@ -86,6 +86,106 @@ private:
   int ma[56];		/* Should not be modified */
 };
 
+// philox //////////////////////////////////////////////////////////////////////
+
+//! A counter-based random number generator (Philox4x32-10, Salmon et al.,
+//! "Parallel random numbers: as easy as 1, 2, 3", 2011). The n-th 32-bit
+//! number of a stream is a pure function of the seed, the stream number and
+//! n: streams are independent, can be seeked in constant time, and ranges
+//! of a stream can be generated by different threads while producing the
+//! same sequence as a single thread.
+class EXPORT philox {
+public:
+  //! Constructs stream 'stream' of the generator with seed 'seed'.
+  philox(uint64 seed = 0, uint64 stream = 0);
+  //! Destructor.
+  virtual ~philox();
+
+  //! Restarts at the beginning of stream 'stream' of seed 'seed'.
+  void seed(uint64 seed, uint64 stream = 0);
+  //! Returns a generator at the beginning of stream 'stream' of the same
+  //! seed, e.g. one stream per thread.
+  philox split(uint64 stream) const;
+  //! Moves to the 'pos'-th 32-bit number of the stream.
+  void seek(uint64 pos);
+  //! Returns the position of the next number of the stream.
+  uint64 tell() const;
+  //! Returns how many times seed() was called on this generator (or on the
+  //! generator it was split from).
+  uint64 seeds() const;
+  //! Returns the position of the next number of the stream and moves 'n'
+  //! numbers ahead. This is atomic with __PTHREAD__, so that threads
+  //! sharing a generator draw disjoint ranges of the stream.
+  uint64 reserve(uint64 n);
+
+  //! Returns the next 32-bit number of the stream.
+  uint32 next();
+  //! Returns the 'pos'-th 32-bit number of the stream, without moving.
+  uint32 at(uint64 pos) const;
+  //! Writes the 'n' numbers of the stream starting at position 'pos'
+  //! into 'out', without moving.
+  void fill(uint64 pos, uint32 *out, intg n) const;
+
+  //! Returns a number drawn from a uniform distribution over (0,1).
+  double uniform();
+  //! Returns a number drawn from a uniform distribution over (v0,v1).
+  double uniform(double v0, double v1);
+  //! Returns a number drawn from a normal distribution with mean 0
+  //! and standard deviation 1.
+  double normal();
+  //! Returns a number drawn from a normal distribution with mean 'm'
+  //! and standard deviation 'sigma'.
+  double normal(double m, double sigma);
+
+  //! Maps a 32-bit number to (0,1).
+  static inline double to_uniform(uint32 x) {
+    return (x + .5) * (1.0 / 4294967296.0); }
+  //! Maps two 32-bit numbers to a normal number (Box-Muller).
+  static double to_normal(uint32 x0, uint32 x1);
+  //! Computes the 4 numbers of counter 'ctr' with key 'key'.
+  static void block(const uint32 key[2], const uint32 ctr[4], uint32 out[4]);
+
+protected:
+  uint32 key[2];          //!< Key derived from the seed.
+  uint64 stream;          //!< Stream number (high half of the counter).
+  uint64 pos;             //!< Position of the next number.
+  uint64 cached;          //!< Block held in 'cache' (+1, 0 if none).
+  uint32 cache[4];        //!< Last block computed by next().
+  uint64 nseeds;          //!< Number of calls to seed().
+};
+
+//! Returns the library-wide generator, seeded by init_drand().
+EXPORT philox &global_philox();
+
+// philox_stream ///////////////////////////////////////////////////////////////
+
+//! A stream of the library-wide generator owned by a single consumer, e.g. a
+//! module drawing random numbers at each fprop. Streams are numbered in the
+//! order they are constructed, and each one restarts whenever
+//! global_philox() is seeded again. The numbers drawn by a consumer thus
+//! only depend on the seed, on the construction order and on how many
+//! numbers it drew before, not on the threads running other consumers.
+class EXPORT philox_stream {
+public:
+  //! Takes the next stream number.
+  philox_stream();
+  //! Takes a new stream number rather than sharing the stream of 's'.
+  philox_stream(const philox_stream &s);
+  //! Destructor.
+  virtual ~philox_stream();
+  //! Keeps this stream's number.
+  philox_stream& operator=(const philox_stream &s);
+
+  //! Returns the generator, positioned after the numbers drawn so far
+  //! since the last seeding of global_philox().
+  philox &get();
+
+protected:
+  uint64 id;    //!< Stream number.
+  philox g;     //!< Generator of stream 'id'.
+  bool   ready; //!< False until 'g' is split from global_philox().
+};
+
 } // end namespace ebl
 
 #endif /* RANDOM_H */
@@ -161,6 +161,8 @@ public:
 
   //! Swap elements 'i' and 'j'.
   virtual void swap(uint i, uint j);
+  //! Exchange all elements with those of 'other', without any copy.
+  virtual void swap(svector<T> &other);
   //! Permute elements according to permutation vector.
   virtual void permute(std::vector<uint> &permutations);
 
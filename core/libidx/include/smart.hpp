@@ -262,6 +262,11 @@ void svector<T>::swap(uint i, uint j) {
   std::vector<T*>::at(i) = tmp;
 }
 
+template <class T>
+void svector<T>::swap(svector<T> &other) {
+  std::vector<T*>::swap(other);
+}
+
 template <class T>
 void svector<T>::permute(std::vector<uint> &permutations) {
   if (permutations.size() > this->size())
@@ -98,6 +98,11 @@ namespace ebl {
     T* get_data();
     //! Sets a pointer to the beginning of the data segment.
     void set_data(T* ptr);
+    //! Use the 's' items at 'ptr' (e.g. a memory-mapped file) as data
+    //! segment without owning them: they are never freed by this srg and
+    //! are first copied into owned memory if the srg is resized. The
+    //! current data segment is freed. 'ptr' must outlive this srg.
+    void set_external_data(T *ptr, intg s);
     //! sets i-th element to val.
     void set(intg i, T val);
     //! fill data with zeros.
@@ -116,6 +121,7 @@ namespace ebl {
   private:
     T *data; //!< pointer to data segment
     intg size_; //!< Number of allocated items.    
+    bool external; //!< 'data' is not owned (see set_external_data()).
 
     //    int refcount; //!< Reference counter: tells us how many idx point here.
 
@@ -51,6 +51,7 @@ namespace ebl {
     //    refcount = 0;
     data = (T *)NULL;
     size_ = 0;
+    external = false;
 #ifdef __DEBUG__
     smart_pointer::debug_name << "srg<" << typeid(T).name() << ">";
 #endif
@@ -61,6 +62,8 @@ namespace ebl {
     intg r;
     //    refcount = 0;
     data = (T *)NULL;
+    size_ = 0;
+    external = false;
     if ( ( r=this->changesize(s) ) > 0 ) this->clear();
     if (r < 0) { eblerror("can't allocate srg"); }
   }
@@ -75,10 +78,10 @@ namespace ebl {
 
     if (data != NULL) {
       DEBUG_LOW("srg: freeing data " << (void*) data);
-      free((void *) data);
+      if (!external) free((void *) data);
       data = NULL;
 #ifdef __DEBUGMEM__
-      this->memsize -= size_ * sizeof (T);
+      if (!external) this->memsize -= size_ * sizeof (T);
 #endif    
       size_ = 0;
     }
@@ -93,6 +96,19 @@ namespace ebl {
   // an srg that has idx pointing to it is very dangerous.
   // In most case, the grow() method should be used.
   template <typename T> intg srg<T>::changesize(intg s) {
+    if (external) { // copy external data into owned memory first
+      T *ext = data;
+      data = (T*) NULL;
+      external = false;
+      if (size_ > 0) {
+	data = (T*) malloc(size_ * sizeof (T));
+	if (data == NULL) { size_ = 0; return -1; }
+	memcpy((void*) data, (void*) ext, size_ * sizeof (T));
+      }
+#ifdef __DEBUGMEM__
+      this->memsize += size_ * sizeof (T);
+#endif
+    }
 #ifdef __DEBUGMEM__
     this->memsize -= size_ * sizeof (T);
 #endif    
@@ -170,6 +186,16 @@ namespace ebl {
   // set data pointer
   template <typename T> void srg<T>::set_data(T* ptr) { data=ptr; }
 
+  template <typename T> void srg<T>::set_external_data(T *ptr, intg s) {
+    if (data != NULL && !external) free((void*) data);
+#ifdef __DEBUGMEM__
+    if (!external) this->memsize -= size_ * sizeof (T);
+#endif
+    data = ptr;
+    size_ = s;
+    external = true;
+  }
+
   // set i-th item
   template <typename T> void srg<T>::set(intg i, T val) { data[i] = val; }
 
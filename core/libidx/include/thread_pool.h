@@ -0,0 +1,195 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include "defines.h"
+
+#ifdef __PTHREAD__
+#include <pthread.h>
+#endif
+
+namespace ebl {
+
+  ////////////////////////////////////////////////////////////////
+  // parallel_task
+
+  //! A job that can be split into independent pieces, executed by a
+  //! thread_pool. Pieces may run concurrently and in any order, so run(i)
+  //! must only write to data owned by piece i.
+  //! Views (select, narrow, unfold, ...) of shared data may be taken inside
+  //! run() when __PTHREAD__ is defined (reference counters are then atomic),
+  //! but building them once before the job starts is cheaper.
+  class EXPORT parallel_task {
+  public:
+    virtual ~parallel_task();
+    //! Execute piece 'i' of the job.
+    virtual void run(intg i) = 0;
+  };
+
+  ////////////////////////////////////////////////////////////////
+  // parallel_range_task
+
+  //! A job over a range [0, n) of items (e.g. the slices of an idx
+  //! dimension), executed in chunks by parallel_for(). Each chunk is
+  //! typically processed by narrowing the data to [begin, end) and looping
+  //! on it with idx_bloop/idx_aloop macros, as in the serial code.
+  class EXPORT parallel_range_task : public parallel_task {
+  public:
+    parallel_range_task();
+    virtual ~parallel_range_task();
+    //! Process items [begin, end).
+    virtual void run_range(intg begin, intg end) = 0;
+    //! Process chunk 'i', called by the thread_pool.
+    virtual void run(intg i);
+
+    // members
+  public:
+    intg n;     //!< Total number of items.
+    intg chunk; //!< Number of items per chunk.
+  };
+
+  ////////////////////////////////////////////////////////////////
+  // thread_pool
+
+  //! A work-stealing pool of worker threads shared by the whole library.
+  //! The pieces of a job are initially split evenly between the calling
+  //! thread and the workers, each thread then steals half of the remaining
+  //! pieces of another thread once it is out of work. run() only returns
+  //! once all pieces are done. Only one job runs on the pool at a time: if
+  //! the pool is busy (e.g. called from several detection threads or from
+  //! inside a job), the job is executed serially by the calling thread
+  //! instead of oversubscribing the cores.
+  class EXPORT thread_pool {
+  public:
+    //! Create a pool using 'nthreads' threads in total (including
+    //! the calling thread), i.e. 'nthreads' - 1 workers.
+    thread_pool(uint nthreads = 1);
+    virtual ~thread_pool();
+
+    //! Change the total number of threads used by this pool.
+    //! This must not be called while a job is running.
+    void set_nthreads(uint nthreads);
+    //! Return the total number of threads used by this pool.
+    uint get_nthreads();
+    //! Set the default minimum number of elements processed by a chunk of
+    //! parallel_for(), smaller jobs run serially.
+    void set_grain(intg grain);
+    //! Return the default minimum number of elements per chunk.
+    intg get_grain();
+
+    //! Call t.run(i) for each i in [0, n) and return when all are done.
+    void run(parallel_task &t, intg n);
+
+    //! Return the library-wide pool.
+    static thread_pool& global();
+
+  protected:
+    //! Start 'n' workers.
+    void start_workers(uint n);
+    //! Stop and join all workers.
+    void stop_workers();
+    //! Execute pieces of the current job as thread 'id' until there are
+    //! none left anywhere. Returns the number of pieces executed.
+    intg work(uint id);
+    //! Take the next piece of job 'gen' for thread 'id', stealing from
+    //! other threads if needed. Returns false if there is none left.
+    bool take(uint id, uint gen, intg &piece);
+    //! Workers main loop.
+    static void* entrypoint(void *worker);
+
+    // internal types
+#ifdef __PTHREAD__
+    //! The range of pieces owned by a thread.
+    struct slot {
+      pthread_mutex_t m;
+      uint            gen;   //!< Job this range belongs to.
+      intg            begin; //!< Next piece to execute.
+      intg            end;   //!< End of the range (exclusive).
+    };
+    //! Arguments of a worker thread.
+    struct worker {
+      thread_pool    *pool;
+      uint            id;
+      pthread_t       thread;
+    };
+#endif
+
+  protected:
+    uint                nthreads;       //!< Total number of threads.
+    intg                grain;          //!< Default elements per chunk.
+#ifdef __PTHREAD__
+    worker             *workers;        //!< Worker threads.
+    slot               *slots;          //!< Pieces owned by each thread.
+    pthread_mutex_t     busy;           //!< Locked while a job is running.
+    pthread_mutex_t     m;              //!< Protects the job state.
+    pthread_cond_t      job_ready;      //!< Signals a new job or stop.
+    pthread_cond_t      job_done;       //!< Signals the end of a job.
+#endif
+    parallel_task      *task;           //!< Current job.
+    intg                njob;           //!< Number of pieces of current job.
+    intg                ndone;          //!< Number of pieces done.
+    uint                generation;     //!< Incremented for each new job.
+    bool                stop;           //!< Tells workers to exit.
+  };
+
+  ////////////////////////////////////////////////////////////////
+  // helpers
+
+  //! Set the library-wide pool to 'ncores' threads (all available cores
+  //! if ncores <= 0) and its default grain to 'grain' elements (unchanged
+  //! if grain <= 0), then print how many threads are used.
+  EXPORT void pool_init(int ncores = 1, intg grain = 0);
+
+  //! Call t.run(i) for each i in [0, n) on the library-wide thread pool.
+  EXPORT void parallel_run(parallel_task &t, intg n);
+
+  //! Call t.run_range() on chunks of [0, n) on the library-wide thread pool.
+  //! Each chunk contains at least 'grain' items, so that a job with less
+  //! than 2 * grain items runs serially in the calling thread.
+  EXPORT void parallel_for(parallel_range_task &t, intg n, intg grain = 1);
+
+  //! Same as parallel_for(t, n, grain) with n = m.dim(d), where 'grain'
+  //! is the minimum number of elements of 'm' per chunk rather than a
+  //! number of slices (the pool's default grain if grain <= 0).
+  template <class Tidx>
+  void parallel_for(parallel_range_task &t, Tidx &m, int d, intg grain = 0) {
+    if (grain <= 0) grain = thread_pool::global().get_grain();
+    intg n = m.dim(d), slice = m.nelements() / (n > 0 ? n : 1);
+    if (slice < 1) slice = 1;
+    parallel_for(t, n, (grain + slice - 1) / slice);
+  }
+
+} // end namespace ebl
+
+#endif /* THREAD_POOL_H_ */
@@ -34,6 +34,7 @@
 #define LIBIDX
 
 #include "config.h"
+#include "idxops.h"
 #include "blasops.h"
 
 #ifdef __CBLAS__
@@ -373,3 +374,344 @@ namespace ebl {
 } // end namespace ebl
 
 #endif /* __CBLAS__ */
+
+namespace ebl {
+
+  // blocked kernels ///////////////////////////////////////////////////////////
+
+  // cache blocking sizes for the non-blas matrix-matrix product, chosen so
+  // that a BLOCK_K x BLOCK_N panel of the right operand stays in L2.
+  static const intg BLOCK_M = 64;
+  static const intg BLOCK_N = 256;
+  static const intg BLOCK_K = 256;
+
+  //! Cache-blocked matrix-matrix product with 4x4 register tiles:
+  //! c <- c + a.b if acc is true, c <- a.b otherwise, where
+  //! a(i,k) = a[i*a0 + k*a1], b(k,j) = b[k*b0 + j*b1], c(i,j) = c[i*c0 + j*c1].
+  template <typename T>
+  void blocked_m2dotm2(intg M, intg N, intg K,
+		       const T *a, intg a0, intg a1,
+		       const T *b, intg b0, intg b1,
+		       T *c, intg c0, intg c1, bool acc) {
+    intg i, j, k;
+    if (!acc)
+      for (i = 0; i < M; ++i)
+	for (j = 0; j < N; ++j)
+	  c[i * c0 + j * c1] = 0;
+    for (intg kk = 0; kk < K; kk += BLOCK_K) {
+      intg kmax = std::min(K, kk + BLOCK_K);
+      for (intg ii = 0; ii < M; ii += BLOCK_M) {
+	intg imax = std::min(M, ii + BLOCK_M);
+	for (intg jj = 0; jj < N; jj += BLOCK_N) {
+	  intg jmax = std::min(N, jj + BLOCK_N);
+	  for (i = ii; i + 4 <= imax; i += 4) {
+	    const T *pa = a + i * a0;
+	    // 4x4 tiles
+	    for (j = jj; j + 4 <= jmax; j += 4) {
+	      T *pc = c + i * c0 + j * c1;
+	      T r00 = pc[0], r01 = pc[c1], r02 = pc[2*c1], r03 = pc[3*c1];
+	      T *pc1 = pc + c0, *pc2 = pc + 2*c0, *pc3 = pc + 3*c0;
+	      T r10 = pc1[0], r11 = pc1[c1], r12 = pc1[2*c1], r13 = pc1[3*c1];
+	      T r20 = pc2[0], r21 = pc2[c1], r22 = pc2[2*c1], r23 = pc2[3*c1];
+	      T r30 = pc3[0], r31 = pc3[c1], r32 = pc3[2*c1], r33 = pc3[3*c1];
+	      const T *pb = b + j * b1;
+	      for (k = kk; k < kmax; ++k) {
+		const T *ak = pa + k * a1, *bk = pb + k * b0;
+		T x0 = ak[0], x1 = ak[a0], x2 = ak[2*a0], x3 = ak[3*a0];
+		T y0 = bk[0], y1 = bk[b1], y2 = bk[2*b1], y3 = bk[3*b1];
+		r00 += x0 * y0; r01 += x0 * y1; r02 += x0 * y2; r03 += x0 * y3;
+		r10 += x1 * y0; r11 += x1 * y1; r12 += x1 * y2; r13 += x1 * y3;
+		r20 += x2 * y0; r21 += x2 * y1; r22 += x2 * y2; r23 += x2 * y3;
+		r30 += x3 * y0; r31 += x3 * y1; r32 += x3 * y2; r33 += x3 * y3;
+	      }
+	      pc[0] = r00; pc[c1] = r01; pc[2*c1] = r02; pc[3*c1] = r03;
+	      pc1[0] = r10; pc1[c1] = r11; pc1[2*c1] = r12; pc1[3*c1] = r13;
+	      pc2[0] = r20; pc2[c1] = r21; pc2[2*c1] = r22; pc2[3*c1] = r23;
+	      pc3[0] = r30; pc3[c1] = r31; pc3[2*c1] = r32; pc3[3*c1] = r33;
+	    }
+	    // remaining columns, 4x1 tiles
+	    for (; j < jmax; ++j) {
+	      T *pc = c + i * c0 + j * c1;
+	      T r0 = pc[0], r1 = pc[c0], r2 = pc[2*c0], r3 = pc[3*c0];
+	      const T *pb = b + j * b1;
+	      for (k = kk; k < kmax; ++k) {
+		const T *ak = pa + k * a1;
+		T y = pb[k * b0];
+		r0 += ak[0] * y; r1 += ak[a0] * y;
+		r2 += ak[2*a0] * y; r3 += ak[3*a0] * y;
+	      }
+	      pc[0] = r0; pc[c0] = r1; pc[2*c0] = r2; pc[3*c0] = r3;
+	    }
+	  }
+	  // remaining rows
+	  for (; i < imax; ++i) {
+	    const T *pa = a + i * a0;
+	    for (j = jj; j < jmax; ++j) {
+	      const T *pb = b + j * b1;
+	      T r = c[i * c0 + j * c1];
+	      for (k = kk; k < kmax; ++k)
+		r += pa[k * a1] * pb[k * b0];
+	      c[i * c0 + j * c1] = r;
+	    }
+	  }
+	}
+      }
+    }
+  }
+
+  //! R_ij += sum_kl M1_ijkl * M2_kl, computing 4 consecutive outputs of
+  //! dimension 1 at a time so that each kernel value is loaded once per tile.
+  template <typename T>
+  void blocked_m4dotm2acc(idx<T> &i1, idx<T> &i2, idx<T> &o1) {
+    intg m0 = i1.mod(0), m1 = i1.mod(1), m2 = i1.mod(2), m3 = i1.mod(3);
+    intg w0 = i2.mod(0), w1 = i2.mod(1);
+    intg o0 = o1.mod(0), om1 = o1.mod(1);
+    intg imax = o1.dim(0), jmax = o1.dim(1);
+    intg kmax = i2.dim(0), lmax = i2.dim(1);
+    bool unit = (m3 == 1 && w1 == 1);
+    T *in = i1.idx_ptr(), *ker = i2.idx_ptr(), *out = o1.idx_ptr();
+    intg i, j, k, l;
+    for (i = 0; i < imax; ++i) {
+      T *pin = in + i * m0, *pout = out + i * o0;
+      for (j = 0; j + 4 <= jmax; j += 4) {
+	T *po = pout + j * om1;
+	T f0 = po[0], f1 = po[om1], f2 = po[2*om1], f3 = po[3*om1];
+	T *p = pin + j * m1;
+	for (k = 0; k < kmax; ++k) {
+	  T *p0 = p + k * m2, *p1 = p0 + m1, *p2 = p1 + m1, *p3 = p2 + m1;
+	  T *pk = ker + k * w0;
+	  if (unit) {
+	    for (l = 0; l < lmax; ++l) {
+	      T w = pk[l];
+	      f0 += p0[l] * w; f1 += p1[l] * w; f2 += p2[l] * w; f3 += p3[l] * w;
+	    }
+	  } else {
+	    for (l = 0; l < lmax; ++l) {
+	      T w = pk[l * w1];
+	      intg o = l * m3;
+	      f0 += p0[o] * w; f1 += p1[o] * w; f2 += p2[o] * w; f3 += p3[o] * w;
+	    }
+	  }
+	}
+	po[0] = f0; po[om1] = f1; po[2*om1] = f2; po[3*om1] = f3;
+      }
+      // remaining outputs
+      for (; j < jmax; ++j) {
+	T f = pout[j * om1];
+	T *p = pin + j * m1;
+	for (k = 0; k < kmax; ++k) {
+	  T *pk = ker + k * w0, *p0 = p + k * m2;
+	  for (l = 0; l < lmax; ++l)
+	    f += p0[l * m3] * pk[l * w1];
+	}
+	pout[j * om1] = f;
+      }
+    }
+  }
+
+  //! R_ijkl += M1_ij * M2_kl. Each output element is updated in place in
+  //! (i,j,k,l) order, which keeps accumulation correct when o1 is an
+  //! overlapping view.
+  template <typename T>
+  void blocked_m2extm2acc(idx<T> &i1, idx<T> &i2, idx<T> &o1) {
+    intg c0 = i1.mod(0), c1 = i1.mod(1), k0 = i2.mod(0), k1 = i2.mod(1);
+    intg d0 = o1.mod(0), d1 = o1.mod(1), d2 = o1.mod(2), d3 = o1.mod(3);
+    intg imax = o1.dim(0), jmax = o1.dim(1);
+    intg kmax = o1.dim(2), lmax = o1.dim(3);
+    bool unit = (d3 == 1 && k1 == 1);
+    T *in = i1.idx_ptr(), *ker = i2.idx_ptr(), *out = o1.idx_ptr();
+    intg i, j, k, l;
+    for (i = 0; i < imax; ++i) {
+      for (j = 0; j < jmax; ++j) {
+	T c = in[i * c0 + j * c1];
+	T *po = out + i * d0 + j * d1;
+	for (k = 0; k < kmax; ++k) {
+	  T *pok = po + k * d2, *pk = ker + k * k0;
+	  if (unit)
+	    for (l = 0; l < lmax; ++l)
+	      pok[l] += c * pk[l];
+	  else
+	    for (l = 0; l < lmax; ++l)
+	      pok[l * d3] += c * pk[l * k1];
+	}
+      }
+    }
+  }
+
+#ifdef __CBLAS__
+
+  //! Returns true if matrix m (of order 2) can be passed to blas,
+  //! and sets its transposition flag and leading dimension.
+  template <typename T>
+  bool blas_layout(idx<T> &m, CBLAS_TRANSPOSE &t, int &ld) {
+    intg rows = m.dim(0), cols = m.dim(1);
+    if ((cols == 1 || m.mod(1) == 1) && (rows == 1 || m.mod(0) >= cols)) {
+      t = CblasNoTrans;
+      ld = (int) (rows == 1 ? std::max(cols, (intg) 1) : m.mod(0));
+      return true;
+    }
+    if ((rows == 1 || m.mod(0) == 1) && (cols == 1 || m.mod(1) >= rows)) {
+      t = CblasTrans;
+      ld = (int) (cols == 1 ? std::max(rows, (intg) 1) : m.mod(1));
+      return true;
+    }
+    return false;
+  }
+
+  inline CBLAS_TRANSPOSE blas_flip(CBLAS_TRANSPOSE t) {
+    return t == CblasNoTrans ? CblasTrans : CblasNoTrans;
+  }
+
+  //! Returns true if the last 2 dimensions of m, starting at dimension d,
+  //! can be read as a single vector of stride 1.
+  template <typename T>
+  bool blas_flat2(idx<T> &m, int d) {
+    return (m.dim(d + 1) == 1 || m.mod(d + 1) == 1)
+      && (m.dim(d) == 1 || m.mod(d) == m.dim(d + 1));
+  }
+
+#define blas_gemm(T, fgemm)						\
+  CBLAS_TRANSPOSE ta, tx, ty; int lda, ldx, ldy;			\
+  if (blas_layout(a, ta, lda) && blas_layout(x, tx, ldx)		\
+      && blas_layout(y, ty, ldy) && a.nelements() > 0			\
+      && y.nelements() > 0) {						\
+    if (ty == CblasNoTrans)						\
+      fgemm(CblasRowMajor, ta, tx, (int) y.dim(0), (int) y.dim(1),	\
+	    (int) a.dim(1), 1.0, a.idx_ptr(), lda, x.idx_ptr(), ldx,	\
+	    0.0, y.idx_ptr(), ldy);					\
+    else /* compute y' = x'.a' */					\
+      fgemm(CblasRowMajor, blas_flip(tx), blas_flip(ta),		\
+	    (int) y.dim(1), (int) y.dim(0), (int) a.dim(1), 1.0,	\
+	    x.idx_ptr(), ldx, a.idx_ptr(), lda, 0.0, y.idx_ptr(), ldy);	\
+    return ;								\
+  }
+
+  // one gemv per output row: rows are indexed by dimension 1 of i1 and
+  // columns by its flattened dimensions 2 and 3.
+#define blas_m4dotm2acc(T, fgemv)					\
+  intg rows = i1.dim(1), cols = i1.dim(2) * i1.dim(3);			\
+  if (blas_flat2(i1, 2) && blas_flat2(i2, 0) && cols > 0		\
+      && (rows == 1 || (i1.mod(1) >= cols && o1.mod(1) > 0))) {		\
+    int lda = (int) (rows == 1 ? cols : i1.mod(1));			\
+    int incy = (int) (rows == 1 ? 1 : o1.mod(1));			\
+    T *pin = i1.idx_ptr(), *pout = o1.idx_ptr();			\
+    for (intg i = 0; i < i1.dim(0); ++i) {				\
+      fgemv(CblasRowMajor, CblasNoTrans, (int) rows, (int) cols, 1.0,	\
+	    pin, lda, i2.idx_ptr(), 1, 1.0, pout, incy);	\
+      pin += i1.mod(0);							\
+      pout += o1.mod(0);						\
+    }									\
+    return ;								\
+  }
+
+  // one ger per row of i1: only used when a given row of o1 does not
+  // overlap with itself, i.e. when blas is free to reorder its updates.
+#define blas_m2extm2acc(T, fger)					\
+  intg rows = o1.dim(1), cols = o1.dim(2) * o1.dim(3);			\
+  if (blas_flat2(o1, 2) && blas_flat2(i2, 0) && cols > 0		\
+      && (rows == 1 || (o1.mod(1) >= cols && i1.mod(1) > 0))) {		\
+    int lda = (int) (rows == 1 ? cols : o1.mod(1));			\
+    int incx = (int) (rows == 1 ? 1 : i1.mod(1));			\
+    T *pin = i1.idx_ptr(), *pout = o1.idx_ptr();			\
+    for (intg i = 0; i < o1.dim(0); ++i) {				\
+      fger(CblasRowMajor, (int) rows, (int) cols, 1.0, pin, incx,	\
+	   i2.idx_ptr(), 1, pout, lda);					\
+      pin += i1.mod(0);							\
+      pout += o1.mod(0);						\
+    }									\
+    return ;								\
+  }
+
+#endif /* __CBLAS__ */
+
+  // size compatibility checking macros ////////////////////////////////////////
+
+#define check_m2dotm2(a, x, y) {					\
+    idx_checkorder3(a, 2, x, 2, y, 2);					\
+    if (a.dim(1) != x.dim(0) || a.dim(0) != y.dim(0)			\
+	|| y.dim(1) != x.dim(1))					\
+      eblerror("incompatible dimensions for matrix-matrix multiplication of " \
+	       << a << " . " << x << " -> " << y);			\
+  }
+
+#define check_m4dotm2(i1, i2, o1) {					\
+    idx_checkorder3(i1, 4, i2, 2, o1, 2);				\
+    if ((i1.dim(0) != o1.dim(0)) || (i1.dim(1) != o1.dim(1))		\
+	|| (i1.dim(2) != i2.dim(0)) || (i1.dim(3) != i2.dim(1)))	\
+      idx_compatibility_error3(i1, i2, o1, "incompatible dimensions");	\
+  }
+
+#define check_m2extm2(i1, i2, o1) {					\
+    idx_checkorder3(i1, 2, i2, 2, o1, 4);				\
+    if ((i1.dim(0) != o1.dim(0)) || (i1.dim(1) != o1.dim(1))		\
+	|| (i2.dim(0) != o1.dim(2)) || (i2.dim(1) != o1.dim(3)))	\
+      idx_compatibility_error3(i1, i2, o1, "incompatible dimensions");	\
+  }
+
+  // idx_m2dotm2 ///////////////////////////////////////////////////////////////
+
+  // matrix-matrix multiplication: y <- a.x
+  void idx_m2dotm2(idx<double> &a, idx<double> &x, idx<double> &y) {
+    check_m2dotm2(a, x, y);
+#ifdef __CBLAS__
+    blas_gemm(double, cblas_dgemm);
+#endif
+    blocked_m2dotm2(y.dim(0), y.dim(1), a.dim(1),
+		    a.idx_ptr(), a.mod(0), a.mod(1),
+		    x.idx_ptr(), x.mod(0), x.mod(1),
+		    y.idx_ptr(), y.mod(0), y.mod(1), false);
+  }
+
+  // matrix-matrix multiplication: y <- a.x
+  void idx_m2dotm2(idx<float> &a, idx<float> &x, idx<float> &y) {
+    check_m2dotm2(a, x, y);
+#ifdef __CBLAS__
+    blas_gemm(float, cblas_sgemm);
+#endif
+    blocked_m2dotm2(y.dim(0), y.dim(1), a.dim(1),
+		    a.idx_ptr(), a.mod(0), a.mod(1),
+		    x.idx_ptr(), x.mod(0), x.mod(1),
+		    y.idx_ptr(), y.mod(0), y.mod(1), false);
+  }
+
+  // idx_m4dotm2acc ////////////////////////////////////////////////////////////
+
+  // R_ij += sum_kl M1_ijkl * M2_kl
+  void idx_m4dotm2acc(idx<double> &i1, idx<double> &i2, idx<double> &o1) {
+    check_m4dotm2(i1, i2, o1);
+#ifdef __CBLAS__
+    blas_m4dotm2acc(double, cblas_dgemv);
+#endif
+    blocked_m4dotm2acc(i1, i2, o1);
+  }
+
+  // R_ij += sum_kl M1_ijkl * M2_kl
+  void idx_m4dotm2acc(idx<float> &i1, idx<float> &i2, idx<float> &o1) {
+    check_m4dotm2(i1, i2, o1);
+#ifdef __CBLAS__
+    blas_m4dotm2acc(float, cblas_sgemv);
+#endif
+    blocked_m4dotm2acc(i1, i2, o1);
+  }
+
+  // idx_m2extm2acc ////////////////////////////////////////////////////////////
+
+  // R_ijkl += M1_ij * M2_kl
+  void idx_m2extm2acc(idx<double> &i1, idx<double> &i2, idx<double> &o1) {
+    check_m2extm2(i1, i2, o1);
+#ifdef __CBLAS__
+    blas_m2extm2acc(double, cblas_dger);
+#endif
+    blocked_m2extm2acc(i1, i2, o1);
+  }
+
+  // R_ijkl += M1_ij * M2_kl
+  void idx_m2extm2acc(idx<float> &i1, idx<float> &i2, idx<float> &o1) {
+    check_m2extm2(i1, i2, o1);
+#ifdef __CBLAS__
+    blas_m2extm2acc(float, cblas_sger);
+#endif
+    blocked_m2extm2acc(i1, i2, o1);
+  }
+
+} // end namespace ebl
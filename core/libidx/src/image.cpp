@@ -442,17 +442,80 @@ namespace ebl {
     idx_subacc(grid, grid0, flow);
   }
 
-  void elastic_flow(idx<float> &flow, uint sz, float coeff) {
-    // make contiguous version of grid
+  void elastic_flow(idx<float> &flow, uint sz, float coeff,
+		    idx<float> *noise, idx<float> *tmp, philox *g) {
+    idx<float> noise0, tmp0;
+    if (!noise) noise = &noise0;
+    if (!tmp) tmp = &tmp0;
+    // random noise, padded for the smoothing
     idxdim d(flow);
     d.setdim(1, d.dim(1) + sz - 1);
     d.setdim(2, d.dim(2) + sz - 1);
-    idx<float> f(d), f2(flow.get_idxdim());
-    idx_random(f, -.5, .5);
-    idx<float> g = create_gaussian_kernel<float>(sz);
-    idx_3dconvol(f, g, f2);
-    // remove grid values
-    idx_dotcacc(f2, coeff, flow);
+    if (noise->get_idxdim() != d) *noise = idx<float>(d);
+    d.setdim(2, flow.dim(2));
+    if (tmp->get_idxdim() != d) *tmp = idx<float>(d);
+    if (g) idx_fill_uniform(*noise, -.5, .5, *g);
+    else idx_random(*noise, -.5, .5);
+    // create_gaussian_kernel(sz) is the outer product of this 1D kernel
+    std::vector<float> k(sz);
+    float vinv = (float) (1 / (2.0 * sz / 4)), total = 0;
+    for (uint i = 0; i < sz; ++i) {
+      int di = (int) i - (int) sz / 2;
+      k[i] = (float) exp((double) -(vinv * di * di));
+      total += k[i];
+    }
+    for (uint i = 0; i < sz; ++i) k[i] /= total;
+    std::vector<float> acc(flow.dim(2));
+    for (intg c = 0; c < flow.dim(0); ++c) {
+      idx<float> n = noise->select(0, c), t = tmp->select(0, c);
+      idx<float> f = flow.select(0, c);
+      // smooth rows
+      for (intg i = 0; i < t.dim(0); ++i) {
+	float *pn = n.idx_ptr() + i * n.mod(0), *pt = t.idx_ptr() + i * t.mod(0);
+	for (intg j = 0; j < t.dim(1); ++j) pt[j] = 0;
+	for (uint b = 0; b < sz; ++b)
+	  for (intg j = 0; j < t.dim(1); ++j)
+	    pt[j] += k[b] * pn[j + b];
+      }
+      // smooth columns and accumulate into flow
+      for (intg i = 0; i < f.dim(0); ++i) {
+	for (intg j = 0; j < f.dim(1); ++j) acc[j] = 0;
+	for (uint a = 0; a < sz; ++a) {
+	  float *pt = t.idx_ptr() + (i + a) * t.mod(0);
+	  for (intg j = 0; j < f.dim(1); ++j)
+	    acc[j] += k[a] * pt[j];
+	}
+	float *pf = f.idx_ptr() + i * f.mod(0);
+	for (intg j = 0; j < f.dim(1); ++j)
+	  pf[j * f.mod(1)] += coeff * acc[j];
+      }
+    }
+  }
+
+  void deformation_affine(intg height, intg width, float th, float tw,
+			  float sh, float sw, float deg,
+			  float shh, float shw, float *m) {
+    // apply the flows of image_deformation_flow() to 3 points of the centered
+    // grid: the origin and unit steps in height and width
+    idx<float> grid(2, 1, 3), flow(2, 1, 3);
+    idx_clear(grid);
+    idx_clear(flow);
+    grid.set(1, 0, 0, 1);
+    grid.set(1, 1, 0, 2);
+    if (th != 0 || tw != 0) translation_flow(grid, flow, th, tw);
+    if (deg != 0) rotation_flow(grid, flow, deg);
+    if (sh != 1 || sw != 1) scale_flow(grid, flow, sh, sw);
+    if (shh != 0 || shw != 0) shear_flow(grid, flow, shh, shw);
+    // grid now contains the transformed points, relative to the center
+    float ch = (float) ((height % 2 == 0 ? height : height - 1) * .5);
+    float cw = (float) ((width % 2 == 0 ? width : width - 1) * .5);
+    float bh = grid.get(0, 0, 0), bw = grid.get(1, 0, 0);
+    m[0] = grid.get(0, 0, 1) - bh;
+    m[1] = grid.get(0, 0, 2) - bh;
+    m[3] = grid.get(1, 0, 1) - bw;
+    m[4] = grid.get(1, 0, 2) - bw;
+    m[2] = ch + bh - m[0] * ch - m[1] * cw;
+    m[5] = cw + bw - m[3] * ch - m[4] * cw;
   }
 
   uint get_resize_type(const char *resize_method) {
@@ -232,71 +232,6 @@ namespace ebl {
   idx_sum_macro(int16)
   idx_sum_macro(float32)
 
-#if 0 // TODO
-#if defined(__USE_SSE__) and defined(__OPENMP__)
-  template<> float idx_sum(idx<float> & inp, float* out) {
-    int n_threads;
-    int ith;
-    const intg n = inp.nelements();
-    float sums[MAX_THREADS];
-    if (inp.contiguousp()) {
-      sse_4float sum;
-      sse_4float *local, *end;
-      const int n_frags = floor((float)n / (float)OPENMP_CHUNK);
-      const size_t size = OPENMP_CHUNK*sizeof(sse_4float);
-      int it;
-      sse_4float* i;
-      #pragma omp parallel private(sum, end, local, it, i, ith)
-      {
-	posix_memalign((void**)&local, 16, size);
-	n_threads = omp_get_num_threads();
-	sum = _mm_setzero_ps();
-	ith = omp_get_thread_num();
-	#pragma omp for
-	for (it = 0; it < n_frags; ++it) {
-	  memcpy(local, inp.idx_ptr() + it * OPENMP_CHUNK, size);
-	  end = local+OPENMP_CHUNK;
-	  for (i = local; i < end; ++i) {
-	    sum = _mm_add_ps(sum, *i);
-	  }
-	}
-	free(local);
-	sums[ith] = 0;
-	for (it = 0; it < 4; ++it)
-	  sums[ith] += ((float*)(&sum))[it]; //TODO : could be faster
-      }
-      float* end2 = inp.idx_ptr() + n; //TODO: sse
-      float* i2;
-      for (i2 = inp.idx_ptr() + n_frags * OPENMP_CHUNK; i2 < end2; ++i2)
-	sums[0] += *i2;
-    } else {
-      float sum;
-      noncontiguous_idxiter<float> it (inp);
-      int i;
-      #pragma omp parallel private(sum, it, ith, i)
-      {
-	sum = 0;
-	ith = omp_get_thread_num();
-	it = noncontiguous_idxiter<float>(inp);
-	it += ith / n_threads;
-	it.n = std::min(it.i + (ith + 1) / n_threads, it.n);
-	#pragma omp for
-	for (i = 0; i < n_threads; ++i) {
-	  for (it = it; it.notdone(); it.next())
-	    sum += *it;
-	  sums[ith] = sum;
-	}
-      }
-    }
-    float sum = 0;
-    for (int i = 0; i < n_threads; ++i)
-      sum += sums[i];
-    return sum;
-  }
-#endif
-#endif
-
-
   /*
   template<> float idx_sum(idx<float> &inp, float *out) {
 #ifdef __IPP__
@@ -35,6 +35,7 @@
 #include "numerics.h"
 #include "defines.h"
 #include "utils.h"
+#include "random.h"
 
 int isinf_local(double x){
 #ifdef __MAC__
@@ -49,6 +50,9 @@ namespace ebl {
 //#ifdef __WINDOWS__
 #include <time.h>
 //#endif
+#ifdef __PTHREAD__
+#include <pthread.h>
+#endif
 
 // tanh ////////////////////////////////////////////////////////////////////////
 
@@ -191,6 +195,17 @@ double dstdsigmoid(double x) {
 static int inext, inextp;
 static int ma[56];		/* Should not be modified */
 
+// the state above is shared by all threads, e.g. datasources, jitter or
+// detection threads, and is only accessed under this lock
+#ifdef __PTHREAD__
+static pthread_mutex_t drand_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define DRAND_LOCK() pthread_mutex_lock(&drand_mutex)
+#define DRAND_UNLOCK() pthread_mutex_unlock(&drand_mutex)
+#else
+#define DRAND_LOCK()
+#define DRAND_UNLOCK()
+#endif
+
 bool drand_ini = false;
 
 void init_drand(int x) {
@@ -198,6 +213,7 @@ void init_drand(int x) {
 	drand_ini = true;
 	dseed(x);
 	srand(x);
+	global_philox().seed((uint64) (uint32) x);
 }
 
 int dynamic_init_drand(int argc, char **argv) {
@@ -229,6 +245,7 @@ void dseed(int x) {
 	int mj, mk;
 	int i, ii;
 
+	DRAND_LOCK();
 	mj = MSEED - (x < 0 ? -x : x);
 	mj &= MMASK;
 	ma[55] = mj;
@@ -246,14 +263,17 @@ void dseed(int x) {
 		}
 	inext = 0;
 	inextp = 31;			/* Special constant */
+	DRAND_UNLOCK();
 }
 
 double drand(void) {
 	register int mj;
+	DRAND_LOCK();
 	if (++inext == 56) inext = 1;
 	if (++inextp == 56) inextp = 1;
 	mj = ((ma[inext] - ma[inextp]) * 84589 + 45989) & MMASK;
 	ma[inext] = mj;
+	DRAND_UNLOCK();
 	return (double)(mj * FAC);
 }
 
@@ -269,6 +289,7 @@ double dgauss(void) {
 	register int mj, sum;
 	mj = 0;
 	sum = 0;
+	DRAND_LOCK();
 	for (i = 12; i; i--) {
 		if (++inext == 56)
 			inext = 1;
@@ -283,6 +304,7 @@ double dgauss(void) {
 		sum += mj;
 	}
 	ma[inext] = (mj * 84589 + 45989) & MMASK;
+	DRAND_UNLOCK();
 	return (double)(sum * FAC2);
 }
 
@@ -299,6 +321,8 @@ double gaussian(double x, double m, double sigma) {
 #undef MSEED
 #undef FAC
 #undef FAC2
+#undef DRAND_LOCK
+#undef DRAND_UNLOCK
 
 ////////////////////////////////////////////////////////////////
 
@@ -146,4 +146,172 @@ void random::dseed(int x) {
 	inextp = 31;			/* Special constant */
 }
 
+// philox //////////////////////////////////////////////////////////////////////
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+
+philox::philox(uint64 seed_, uint64 stream_) : nseeds(0) {
+	seed(seed_, stream_);
+}
+
+philox::~philox() {
+}
+
+void philox::seed(uint64 seed_, uint64 stream_) {
+	key[0] = (uint32) seed_;
+	key[1] = (uint32) (seed_ >> 32);
+	stream = stream_;
+	pos = 0;
+	cached = 0;
+	nseeds++;
+}
+
+philox philox::split(uint64 stream_) const {
+	philox p(*this);
+	p.stream = stream_;
+	p.pos = 0;
+	p.cached = 0;
+	return p;
+}
+
+void philox::seek(uint64 pos_) {
+	pos = pos_;
+}
+
+uint64 philox::tell() const {
+	return pos;
+}
+
+uint64 philox::seeds() const {
+	return nseeds;
+}
+
+uint64 philox::reserve(uint64 n) {
+#if defined(__PTHREAD__) && defined(__GNUC__)
+	return __sync_fetch_and_add(&pos, n);
+#else
+	uint64 p = pos;
+	pos += n;
+	return p;
+#endif
+}
+
+uint32 philox::next() {
+	uint64 b = pos >> 2;
+	if (cached != b + 1) {
+		uint32 ctr[4] = { (uint32) b, (uint32) (b >> 32),
+											(uint32) stream, (uint32) (stream >> 32) };
+		block(key, ctr, cache);
+		cached = b + 1;
+	}
+	return cache[pos++ & 3];
+}
+
+uint32 philox::at(uint64 p) const {
+	uint32 out[4];
+	fill(p, out, 1);
+	return out[0];
+}
+
+void philox::fill(uint64 p, uint32 *out, intg n) const {
+	uint32 ctr[4] = { 0, 0, (uint32) stream, (uint32) (stream >> 32) };
+	uint32 r[4];
+	uint64 b = p >> 2;
+	intg i = 0;
+	for (uint j = (uint) (p & 3); i < n; ++b, j = 0) {
+		ctr[0] = (uint32) b;
+		ctr[1] = (uint32) (b >> 32);
+		block(key, ctr, r);
+		for ( ; j < 4 && i < n; ++j, ++i)
+			out[i] = r[j];
+	}
+}
+
+double philox::uniform() {
+	return to_uniform(next());
+}
+
+double philox::uniform(double v0, double v1) {
+	return (v1 - v0) * uniform() + v0;
+}
+
+double philox::normal() {
+	uint32 x0 = next();
+	return to_normal(x0, next());
+}
+
+double philox::normal(double m, double sigma) {
+	return sigma * normal() + m;
+}
+
+double philox::to_normal(uint32 x0, uint32 x1) {
+	return sqrt(-2.0 * log(to_uniform(x0))) * cos(2 * PI * to_uniform(x1));
+}
+
+void philox::block(const uint32 key_[2], const uint32 ctr[4], uint32 out[4]) {
+	uint32 c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+	uint32 k0 = key_[0], k1 = key_[1];
+	for (int r = 0; r < 10; ++r) {
+		uint64 p0 = (uint64) PHILOX_M0 * c0, p1 = (uint64) PHILOX_M1 * c2;
+		uint32 n0 = (uint32) (p1 >> 32) ^ c1 ^ k0;
+		uint32 n2 = (uint32) (p0 >> 32) ^ c3 ^ k1;
+		c1 = (uint32) p1;
+		c3 = (uint32) p0;
+		c0 = n0;
+		c2 = n2;
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+	out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+philox &global_philox() {
+	static philox g;
+	return g;
+}
+
+// philox_stream ///////////////////////////////////////////////////////////////
+
+//! Last stream number taken, stream 0 is global_philox() itself.
+static uint64 philox_streams = 0;
+
+static uint64 next_philox_stream() {
+#if defined(__PTHREAD__) && defined(__GNUC__)
+	return __sync_add_and_fetch(&philox_streams, 1);
+#else
+	return ++philox_streams;
+#endif
+}
+
+philox_stream::philox_stream() : id(next_philox_stream()), ready(false) {
+}
+
+philox_stream::philox_stream(const philox_stream &s)
+	: id(next_philox_stream()), ready(false) {
+}
+
+philox_stream::~philox_stream() {
+}
+
+philox_stream& philox_stream::operator=(const philox_stream &s) {
+	return *this;
+}
+
+philox &philox_stream::get() {
+	philox &gl = global_philox();
+	if (!ready || g.seeds() != gl.seeds()) { // (re)start after each seeding
+		g = gl.split(id);
+		ready = true;
+	}
+	return g;
+}
+
+#undef PHILOX_M0
+#undef PHILOX_M1
+#undef PHILOX_W0
+#undef PHILOX_W1
+
 } // end namespace ebl
@@ -68,26 +68,34 @@ smart_pointer::~smart_pointer() {
 // reference counting ////////////////////////////////////////////////////////
 
 int smart_pointer::unlock() {
-  refcount--;
+  // the count left after this unlock, read once since other threads may
+  // change the member meanwhile.
+#if defined(__PTHREAD__) && defined(__GNUC__)
+  // atomic so that views of a shared tensor can be taken from
+  // thread_pool workers.
+  int remaining = __sync_sub_and_fetch(&refcount, 1);
+#else
+  int remaining = --refcount;
+#endif
 #ifdef __DEBUGMEM__
   locks--;
 #endif
   // #ifdef __DEBUG__
   //     std::cerr << debug_name << " " << this
-  // 	      << " smart_pointer::unlock: refcount = " << refcount;
-  //     if (refcount == 0) std::cerr << " (deleting)";
+  // 	      << " smart_pointer::unlock: refcount = " << remaining;
+  //     if (remaining == 0) std::cerr << " (deleting)";
   //     std::cerr << std::endl;
   // #endif
-  if (refcount < 0) {
-    eblerror("idx negative reference counter: " << refcount);
-    return refcount;
+  if (remaining < 0) {
+    eblerror("idx negative reference counter: " << remaining);
+    return remaining;
   } else {
-    if (refcount == 0) {
+    if (remaining == 0) {
       DEBUG_LOW("------------ deleting " << this);// << " (" << *this << ")");
       delete this;
       return 0;
     } else {
-      return refcount;
+      return remaining;
     }
   }
 }
@@ -100,7 +108,11 @@ int smart_pointer::lock() {
   //     std::cerr << debug_name << " " << this << " smart_pointer::lock: refcount="
   //    << refcount + 1 << std::endl;
   // #endif
-      return ++refcount;
+#if defined(__PTHREAD__) && defined(__GNUC__)
+  return __sync_add_and_fetch(&refcount, 1);
+#else
+  return ++refcount;
+#endif
 }
 
 int smart_pointer::get_count() {
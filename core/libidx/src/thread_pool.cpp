@@ -0,0 +1,323 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+// tell header that we are in the libidx scope
+#define LIBIDX
+
+#include "thread_pool.h"
+
+#if defined(__LINUX__) || defined(__MAC__)
+#include <unistd.h>
+#endif
+
+namespace ebl {
+
+  ////////////////////////////////////////////////////////////////
+  // parallel_task
+
+  parallel_task::~parallel_task() {
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // parallel_range_task
+
+  parallel_range_task::parallel_range_task() : n(0), chunk(1) {
+  }
+
+  parallel_range_task::~parallel_range_task() {
+  }
+
+  void parallel_range_task::run(intg i) {
+    intg begin = i * chunk, end = begin + chunk;
+    run_range(begin, end < n ? end : n);
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // thread_pool
+
+  thread_pool::thread_pool(uint n)
+    : nthreads(1), grain(16384),
+#ifdef __PTHREAD__
+      workers(NULL), slots(NULL),
+#endif
+      task(NULL), njob(0), ndone(0), generation(0), stop(false) {
+#ifdef __PTHREAD__
+    pthread_mutex_init(&busy, NULL);
+    pthread_mutex_init(&m, NULL);
+    pthread_cond_init(&job_ready, NULL);
+    pthread_cond_init(&job_done, NULL);
+#endif
+    set_nthreads(n);
+  }
+
+  thread_pool::~thread_pool() {
+    stop_workers();
+#ifdef __PTHREAD__
+    pthread_cond_destroy(&job_done);
+    pthread_cond_destroy(&job_ready);
+    pthread_mutex_destroy(&m);
+    pthread_mutex_destroy(&busy);
+#endif
+  }
+
+  void thread_pool::set_nthreads(uint n) {
+    if (n == 0) n = 1;
+    if (n == nthreads) return ;
+    stop_workers();
+#ifdef __PTHREAD__
+    slots = new slot[n];
+    for (uint i = 0; i < n; ++i) {
+      pthread_mutex_init(&slots[i].m, NULL);
+      slots[i].gen = 0;
+      slots[i].begin = 0;
+      slots[i].end = 0;
+    }
+    nthreads = n;
+    start_workers(n - 1);
+#else
+    if (n > 1)
+      eblwarn("pthread missing, thread pool limited to 1 thread");
+#endif
+  }
+
+  uint thread_pool::get_nthreads() {
+    return nthreads;
+  }
+
+  void thread_pool::set_grain(intg g) {
+    grain = g < 1 ? 1 : g;
+  }
+
+  intg thread_pool::get_grain() {
+    return grain;
+  }
+
+  void thread_pool::run(parallel_task &t, intg n) {
+    if (n <= 0) return ;
+#ifdef __PTHREAD__
+    // run serially if there is nothing to share or if pool is already busy
+    if (nthreads <= 1 || n == 1 || pthread_mutex_trylock(&busy) != 0) {
+      for (intg i = 0; i < n; ++i)
+	t.run(i);
+      return ;
+    }
+    // publish job, split evenly between threads
+    pthread_mutex_lock(&m);
+    task = &t;
+    njob = n;
+    ndone = 0;
+    uint gen = ++generation;
+    for (uint i = 0; i < nthreads; ++i) {
+      slot &s = slots[i];
+      pthread_mutex_lock(&s.m);
+      s.gen = gen;
+      s.begin = n * i / nthreads;
+      s.end = n * (i + 1) / nthreads;
+      pthread_mutex_unlock(&s.m);
+    }
+    pthread_cond_broadcast(&job_ready);
+    pthread_mutex_unlock(&m);
+    // participate, then wait for the workers to finish their pieces
+    work(0);
+    pthread_mutex_lock(&m);
+    while (ndone < njob)
+      pthread_cond_wait(&job_done, &m);
+    task = NULL;
+    pthread_mutex_unlock(&m);
+    pthread_mutex_unlock(&busy);
+#else
+    for (intg i = 0; i < n; ++i)
+      t.run(i);
+#endif
+  }
+
+  thread_pool& thread_pool::global() {
+    static thread_pool pool;
+    return pool;
+  }
+
+  void thread_pool::start_workers(uint n) {
+#ifdef __PTHREAD__
+    stop = false;
+    if (n == 0) return ;
+    workers = new worker[n];
+    for (uint i = 0; i < n; ++i) {
+      workers[i].pool = this;
+      workers[i].id = i + 1; // slot 0 is the calling thread's
+      if (pthread_create(&workers[i].thread, NULL, thread_pool::entrypoint,
+			 &workers[i]))
+	eblerror("failed to create thread pool worker " << i);
+    }
+#endif
+  }
+
+  void thread_pool::stop_workers() {
+#ifdef __PTHREAD__
+    if (workers) {
+      pthread_mutex_lock(&m);
+      stop = true;
+      pthread_cond_broadcast(&job_ready);
+      pthread_mutex_unlock(&m);
+      for (uint i = 0; i < nthreads - 1; ++i)
+	pthread_join(workers[i].thread, NULL);
+      delete[] workers;
+      workers = NULL;
+    }
+    if (slots) {
+      for (uint i = 0; i < nthreads; ++i)
+	pthread_mutex_destroy(&slots[i].m);
+      delete[] slots;
+      slots = NULL;
+    }
+    nthreads = 1;
+#endif
+  }
+
+  intg thread_pool::work(uint id) {
+    intg done = 0;
+#ifdef __PTHREAD__
+    pthread_mutex_lock(&m);
+    parallel_task *t = task;
+    uint gen = generation;
+    pthread_mutex_unlock(&m);
+    if (!t) return 0;
+    intg piece;
+    while (take(id, gen, piece)) {
+      t->run(piece);
+      done++;
+    }
+    if (done > 0) {
+      pthread_mutex_lock(&m);
+      ndone += done;
+      if (ndone >= njob)
+	pthread_cond_broadcast(&job_done);
+      pthread_mutex_unlock(&m);
+    }
+#endif
+    return done;
+  }
+
+  bool thread_pool::take(uint id, uint gen, intg &piece) {
+#ifdef __PTHREAD__
+    // own pieces first
+    slot &s = slots[id];
+    pthread_mutex_lock(&s.m);
+    if (s.gen == gen && s.begin < s.end) {
+      piece = s.begin++;
+      pthread_mutex_unlock(&s.m);
+      return true;
+    }
+    pthread_mutex_unlock(&s.m);
+    // steal the last half of another thread's pieces
+    for (uint k = 1; k < nthreads; ++k) {
+      slot &v = slots[(id + k) % nthreads];
+      pthread_mutex_lock(&v.m);
+      if (v.gen == gen && v.begin < v.end) {
+	intg end = v.end;
+	v.end -= (v.end - v.begin + 1) / 2;
+	piece = v.end;
+	pthread_mutex_unlock(&v.m);
+	if (piece + 1 < end) {
+	  pthread_mutex_lock(&s.m);
+	  s.gen = gen;
+	  s.begin = piece + 1;
+	  s.end = end;
+	  pthread_mutex_unlock(&s.m);
+	}
+	return true;
+      }
+      pthread_mutex_unlock(&v.m);
+    }
+#endif
+    return false;
+  }
+
+  void* thread_pool::entrypoint(void *w) {
+#ifdef __PTHREAD__
+    worker *wk = (worker*) w;
+    thread_pool *pool = wk->pool;
+    pthread_mutex_lock(&pool->m);
+    uint seen = pool->generation;
+    while (true) {
+      while (!pool->stop && pool->generation == seen)
+	pthread_cond_wait(&pool->job_ready, &pool->m);
+      if (pool->stop) break ;
+      seen = pool->generation;
+      pthread_mutex_unlock(&pool->m);
+      pool->work(wk->id);
+      pthread_mutex_lock(&pool->m);
+    }
+    pthread_mutex_unlock(&pool->m);
+#endif
+    return NULL;
+  }
+
+  ////////////////////////////////////////////////////////////////
+  // helpers
+
+  void pool_init(int ncores, intg grain) {
+    thread_pool &pool = thread_pool::global();
+#if defined(__LINUX__) || defined(__MAC__)
+    if (ncores <= 0)
+      ncores = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+    if (ncores <= 0) ncores = 1;
+    pool.set_nthreads((uint) ncores);
+    if (grain > 0)
+      pool.set_grain(grain);
+    eblprint("Using thread pool with " << pool.get_nthreads()
+	     << " thread(s), grain " << pool.get_grain() << "." << std::endl);
+  }
+
+  void parallel_run(parallel_task &t, intg n) {
+    thread_pool::global().run(t, n);
+  }
+
+  void parallel_for(parallel_range_task &t, intg n, intg grain) {
+    if (n <= 0) return ;
+    if (grain < 1) grain = 1;
+    thread_pool &pool = thread_pool::global();
+    // a few chunks per thread so that stealing can balance the load
+    intg nchunks = 4 * (intg) pool.get_nthreads();
+    intg chunk = (n + nchunks - 1) / nchunks;
+    if (chunk < grain) chunk = grain;
+    nchunks = (n + chunk - 1) / chunk;
+    if (pool.get_nthreads() <= 1 || nchunks <= 1) {
+      t.run_range(0, n);
+      return ;
+    }
+    t.n = n;
+    t.chunk = chunk;
+    pool.run(t, nchunks);
+  }
+
+} // end namespace ebl
@@ -246,7 +246,7 @@ time_t file_modified(const char *s) {
 }
 
 time_t file_modified(const std::string &s) {
-  return file_size(s.c_str());
+  return file_modified(s.c_str());
 }
 
 int file_modified_elapsed(const char *s) {
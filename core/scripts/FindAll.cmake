@@ -1,12 +1,12 @@
 # determine machine architecture
 ################################################################################
 IF (APPLE) # MAC OS
-  SET (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -D__MAC__ -pthread")
+  SET (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -D__MAC__ -pthread -D__PTHREAD__")
   SET (MAC true)
   SET (OS_NAME "Mac")
 ELSE (APPLE)
   IF("${CMAKE_SYSTEM}" MATCHES "Linux")
-    SET (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -D__LINUX__ -pthread")
+    SET (CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -D__LINUX__ -pthread -D__PTHREAD__")
     SET (LINUX true)
     SET (OS_NAME "Linux")
   ELSE ("${CMAKE_SYSTEM}" MATCHES "Linux")
@@ -0,0 +1,117 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+
+#ifndef BATCH_DETECTOR_H_
+#define BATCH_DETECTOR_H_
+
+#include <list>
+#include <vector>
+
+#include "defines_tools.h"
+#include "detector.h"
+#include "configuration.h"
+#include "bbox.h"
+
+namespace ebl {
+
+// batch_result ////////////////////////////////////////////////////////////////
+
+//! Detections of a single frame processed by a batch_detector.
+class batch_result {
+ public:
+  uint   source;   //!< Source of the frame, e.g. a camera index.
+  uint   frame_id; //!< Id of the frame given when it was pushed.
+  bboxes bbs;      //!< Detections for this frame.
+};
+
+// batch_detector //////////////////////////////////////////////////////////////
+
+//! A front-end to a detector that groups incoming frames of identical sizes,
+//! e.g. coming from several cameras, and detects each group at once
+//! with detector::fprop_batch().
+//! Two knobs control the throughput/latency trade-off: a group is processed
+//! as soon as it holds 'max_batch' frames, or when its oldest frame has
+//! waited more than 'max_latency' milliseconds.
+template <typename T> class batch_detector {
+ public:
+  //! \param max_batch Maximum number of frames processed at once.
+  //! \param max_latency Maximum time in milliseconds a frame waits for
+  //!   other frames before its group is processed, 0 means no waiting.
+  batch_detector(detector<T> &d, uint max_batch, uint max_latency);
+  //! Same as above, reading 'max_batch' and 'max_latency' from
+  //! variables 'batch_size' (default 4) and 'batch_latency' (default 0).
+  batch_detector(detector<T> &d, configuration &conf);
+  virtual ~batch_detector();
+
+  //! Queue 'frame' coming from 'source' with id 'frame_id'. The frame is
+  //! copied, it can be modified right after this call.
+  void push(idx<ubyte> &frame, uint source = 0, uint frame_id = 0);
+  //! Returns true if a group of frames is full or waited long enough.
+  bool ready();
+  //! Detect all groups that are ready (or all groups if 'force' is true)
+  //! and append their detections to 'results', in the order of arrival
+  //! within each group. Returns the number of frames processed.
+  uint process(std::vector<batch_result> &results, bool force = false);
+  //! Detect all queued frames, regardless of the latency.
+  uint flush(std::vector<batch_result> &results);
+  //! Returns the number of frames waiting to be processed.
+  uint pending();
+
+ protected:
+  //! Frames of identical sizes waiting to be processed together.
+  class group {
+   public:
+    svector<idx<ubyte> > frames;
+    std::vector<uint>    sources;
+    std::vector<uint>    ids;
+    timer                age; //!< Started when the first frame arrives.
+  };
+  //! Returns true if 'g' must be processed.
+  bool is_ready(group &g);
+  //! Detect all frames of 'g' and append their results to 'results'.
+  void process(group &g, std::vector<batch_result> &results);
+
+  // members ///////////////////////////////////////////////////////////////////
+ protected:
+  detector<T>          &detect;
+  uint                  max_batch;
+  uint                  max_latency;
+  std::list<group*>     groups; //!< Waiting groups, oldest first.
+  std::vector<bboxes>   bbs;    //!< Temporary detections.
+};
+
+} // end namespace ebl
+
+#include "batch_detector.hpp"
+
+#endif /* BATCH_DETECTOR_H_ */
@@ -0,0 +1,144 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+
+#ifndef BATCH_DETECTOR_HPP_
+#define BATCH_DETECTOR_HPP_
+
+namespace ebl {
+
+template <typename T>
+batch_detector<T>::batch_detector(detector<T> &d, uint max_batch_,
+                                  uint max_latency_)
+  : detect(d), max_batch(max_batch_), max_latency(max_latency_) {
+  if (max_batch == 0) eblerror("batch size must be at least 1");
+}
+
+template <typename T>
+batch_detector<T>::batch_detector(detector<T> &d, configuration &conf)
+  : detect(d), max_batch(conf.try_get_uint("batch_size", 4)),
+    max_latency(conf.try_get_uint("batch_latency", 0)) {
+  if (max_batch == 0) eblerror("batch_size must be at least 1");
+}
+
+template <typename T>
+batch_detector<T>::~batch_detector() {
+  for (typename std::list<group*>::iterator i = groups.begin();
+       i != groups.end(); ++i)
+    delete *i;
+}
+
+template <typename T>
+void batch_detector<T>::push(idx<ubyte> &frame, uint source, uint frame_id) {
+  // find a group with the same dimensions that is not full yet
+  group *g = NULL;
+  for (typename std::list<group*>::iterator i = groups.begin();
+       i != groups.end(); ++i)
+    if ((*i)->frames.size() < max_batch
+        && (*i)->frames[0].get_idxdim() == frame.get_idxdim()) {
+      g = *i;
+      break ;
+    }
+  if (!g) {
+    g = new group;
+    g->age.start();
+    groups.push_back(g);
+  }
+  idx<ubyte> f(frame.get_idxdim());
+  idx_copy(frame, f);
+  g->frames.push_back_new(f);
+  g->sources.push_back(source);
+  g->ids.push_back(frame_id);
+}
+
+template <typename T>
+bool batch_detector<T>::ready() {
+  for (typename std::list<group*>::iterator i = groups.begin();
+       i != groups.end(); ++i)
+    if (is_ready(**i)) return true;
+  return false;
+}
+
+template <typename T>
+uint batch_detector<T>::process(std::vector<batch_result> &results,
+                                bool force) {
+  uint n = 0;
+  typename std::list<group*>::iterator i = groups.begin();
+  while (i != groups.end()) {
+    if (force || is_ready(**i)) {
+      n += (*i)->frames.size();
+      process(**i, results);
+      delete *i;
+      i = groups.erase(i);
+    } else
+      ++i;
+  }
+  return n;
+}
+
+template <typename T>
+uint batch_detector<T>::flush(std::vector<batch_result> &results) {
+  return process(results, true);
+}
+
+template <typename T>
+uint batch_detector<T>::pending() {
+  uint n = 0;
+  for (typename std::list<group*>::iterator i = groups.begin();
+       i != groups.end(); ++i)
+    n += (*i)->frames.size();
+  return n;
+}
+
+// protected methods ///////////////////////////////////////////////////////////
+
+template <typename T>
+bool batch_detector<T>::is_ready(group &g) {
+  return g.frames.size() >= max_batch
+    || g.age.elapsed_milliseconds() >= (long) max_latency;
+}
+
+template <typename T>
+void batch_detector<T>::process(group &g, std::vector<batch_result> &results) {
+  detect.fprop_batch(g.frames, bbs);
+  for (uint i = 0; i < g.frames.size(); ++i) {
+    results.push_back(batch_result());
+    batch_result &r = results.back();
+    r.source = g.sources[i];
+    r.frame_id = g.ids[i];
+    r.bbs.push_back_new(bbs[i]);
+  }
+}
+
+} // end namespace ebl
+
+#endif /* BATCH_DETECTOR_HPP_ */
@@ -0,0 +1,102 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef CAMERA_SYNTHETIC_H_
+#define CAMERA_SYNTHETIC_H_
+
+#include "camera.h"
+
+namespace ebl {
+
+//! The camera_synthetic class generates frames of a given size whose content
+//! only depends on a seed, e.g. to benchmark detection without camera or
+//! image files. 'ndistinct' frames are generated once at construction and
+//! then cycled through, so that grabbing costs no more than a copy.
+template <typename Tdata> class camera_synthetic : public camera<Tdata> {
+ public:
+  // constructors/allocation /////////////////////////////////////////////////
+
+  //! Initialize a synthetic camera.
+  //! \param fheight Height of generated frames.
+  //! \param fwidth Width of generated frames.
+  //! \param nframes Number of frames to grab before empty() (0: infinite).
+  //! \param seed The content of each frame only depends on this seed.
+  //! \param content "shapes" draws random rectangles and ellipses over a
+  //!   noisy gradient, "noise" draws uniform noise.
+  //! \param ndistinct Number of distinct frames.
+  //! \param height Resize input frame to this height if different than -1.
+  //! \param width Resize input frame to this width if different than -1.
+  camera_synthetic(uint fheight, uint fwidth, uint nframes = 0,
+                   uint seed = 0, const char *content = "shapes",
+                   uint ndistinct = 8, int height = -1, int width = -1,
+                   std::ostream &out = std::cout,
+                   std::ostream &err = std::cerr);
+  //! Destructor.
+  virtual ~camera_synthetic();
+
+  // frame grabbing //////////////////////////////////////////////////////////
+
+  //! Return a new frame.
+  virtual idx<Tdata> grab();
+  //! Move to the next frame, without returning the frame.
+  virtual void next();
+  //! Return true when 'nframes' frames have been grabbed.
+  virtual bool empty();
+  //! Skip n frames.
+  virtual void skip(uint n);
+  //! Return the number of frames left to process, -1 if infinite.
+  virtual int remaining();
+  //! Return the total number of frames, -1 if infinite.
+  virtual int size();
+
+ protected:
+  //! Draw the content of frame 'i' into 'f'.
+  void generate(idx<Tdata> &f, uint i);
+
+  // members /////////////////////////////////////////////////////////////////
+ protected:
+  using camera<Tdata>::frame;	        //!< frame buffer
+  using camera<Tdata>::grabbed;	        //!< frame buffer grabbed yet or not
+  using camera<Tdata>::frame_id_;       //!< frame counter
+  using camera<Tdata>::out;             //!< output stream
+  using camera<Tdata>::silent;
+  uint                      nframes;    //!< Number of frames to grab.
+  uint                      seed;       //!< Seed of frames content.
+  std::string               content;    //!< Type of content.
+  std::vector<idx<Tdata> >  frames;     //!< Distinct frames.
+};
+
+} // end namespace ebl
+
+#include "camera_synthetic.hpp"
+
+#endif /* CAMERA_SYNTHETIC_H_ */
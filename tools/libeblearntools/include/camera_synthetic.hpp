@@ -0,0 +1,167 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef CAMERA_SYNTHETIC_HPP_
+#define CAMERA_SYNTHETIC_HPP_
+
+namespace ebl {
+
+// constructors & initializations //////////////////////////////////////////////
+
+template <typename Tdata>
+camera_synthetic<Tdata>::
+camera_synthetic(uint fheight, uint fwidth, uint nframes_, uint seed_,
+                 const char *content_, uint ndistinct, int height_,
+                 int width_, std::ostream &o, std::ostream &e)
+    : camera<Tdata>(height_, width_, o, e), nframes(nframes_), seed(seed_),
+      content(content_) {
+  if (fheight == 0 || fwidth == 0)
+    eblerror("expected non-empty synthetic frames but got "
+             << fheight << "x" << fwidth);
+  if (content != "shapes" && content != "noise")
+    eblerror("unknown synthetic content " << content
+             << ", expected shapes or noise");
+  if (nframes > 0) ndistinct = std::min(ndistinct, nframes);
+  ndistinct = std::max((uint) 1, ndistinct);
+  out << "Initializing synthetic camera with " << ndistinct << " distinct "
+      << fheight << "x" << fwidth << " " << content << " frames (seed "
+      << seed << "), ";
+  if (nframes > 0) out << nframes << " frames." << std::endl;
+  else out << "infinite frames." << std::endl;
+  for (uint i = 0; i < ndistinct; ++i) {
+    idx<Tdata> f(fheight, fwidth, 3);
+    generate(f, i);
+    frames.push_back(f);
+  }
+}
+
+template <typename Tdata>
+camera_synthetic<Tdata>::~camera_synthetic() {
+}
+
+// frame grabbing //////////////////////////////////////////////////////////////
+
+template <typename Tdata>
+idx<Tdata> camera_synthetic<Tdata>::grab() {
+  idx<Tdata> &src = frames[frame_id_ % frames.size()];
+  if (frame.order() != src.order() || frame.get_idxdim() != src.get_idxdim())
+    frame = idx<Tdata>(src.get_idxdim());
+  idx_copy(src, frame);
+  next();
+  grabbed = true;
+  if (!silent)
+    out << frame_id_ << "/" << size() << ": grabbed " << frame << std::endl;
+  return this->postprocess();
+}
+
+template <typename Tdata>
+void camera_synthetic<Tdata>::next() {
+  frame_id_++;
+}
+
+template <typename Tdata>
+bool camera_synthetic<Tdata>::empty() {
+  return nframes > 0 && frame_id_ >= nframes;
+}
+
+template <typename Tdata>
+void camera_synthetic<Tdata>::skip(uint n) {
+  for (uint i = 0; i < n && !empty(); ++i)
+    next();
+}
+
+template <typename Tdata>
+int camera_synthetic<Tdata>::remaining() {
+  if (nframes == 0) return -1;
+  return (int) (nframes - std::min(nframes, frame_id_));
+}
+
+template <typename Tdata>
+int camera_synthetic<Tdata>::size() {
+  if (nframes == 0) return -1;
+  return (int) nframes;
+}
+
+// internal methods ////////////////////////////////////////////////////////////
+
+template <typename Tdata>
+void camera_synthetic<Tdata>::generate(idx<Tdata> &f, uint i) {
+  philox gen(seed, i); // frame i only depends on seed and i
+  intg h = f.dim(0), w = f.dim(1), c = f.dim(2);
+  if (content == "noise") {
+    idx_aloop1(p, f, Tdata) {
+      *p = (Tdata) gen.uniform(0, 255);
+    }
+    return ;
+  }
+  // noisy gradient background
+  double c0[3], c1[3];
+  for (intg k = 0; k < c; ++k) {
+    c0[k] = gen.uniform(0, 255);
+    c1[k] = gen.uniform(0, 255);
+  }
+  double a = gen.uniform();
+  for (intg y = 0; y < h; ++y)
+    for (intg x = 0; x < w; ++x) {
+      double t = a * y / std::max((intg) 1, h - 1)
+          + (1 - a) * x / std::max((intg) 1, w - 1);
+      for (intg k = 0; k < c; ++k) {
+        double v = c0[k] + (c1[k] - c0[k]) * t + gen.normal(0, 8);
+        f.set((Tdata) std::max(0.0, std::min(255.0, v)), y, x, k);
+      }
+    }
+  // random rectangles and ellipses, from 1/16th to 1/3rd of the frame
+  intg m = std::min(h, w);
+  uint nshapes = 20;
+  for (uint s = 0; s < nshapes; ++s) {
+    intg sh = (intg) gen.uniform(m / 16.0, m / 3.0) + 1;
+    intg sw = (intg) gen.uniform(m / 16.0, m / 3.0) + 1;
+    intg y0 = (intg) gen.uniform(-sh / 2.0, h - sh / 2.0);
+    intg x0 = (intg) gen.uniform(-sw / 2.0, w - sw / 2.0);
+    bool ellipse = gen.next() & 1;
+    double color[3];
+    for (intg k = 0; k < c; ++k) color[k] = gen.uniform(0, 255);
+    for (intg y = std::max((intg) 0, y0); y < std::min(h, y0 + sh); ++y)
+      for (intg x = std::max((intg) 0, x0); x < std::min(w, x0 + sw); ++x) {
+        if (ellipse) {
+          double dy = (y - y0 + .5) / sh * 2 - 1;
+          double dx = (x - x0 + .5) / sw * 2 - 1;
+          if (dy * dy + dx * dx > 1) continue ;
+        }
+        for (intg k = 0; k < c; ++k) f.set((Tdata) color[k], y, x, k);
+      }
+  }
+}
+
+} // end namespace ebl
+
+#endif /* CAMERA_SYNTHETIC_HPP_ */
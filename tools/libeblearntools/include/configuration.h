@@ -339,6 +339,8 @@ public:
 
   //! return all possible configurations
   std::vector<configuration>& configurations();
+  //! Return the names of variables taking more than one value.
+  std::list<std::string> varied_variables();
 
   //! print loaded variables
   virtual void pretty();
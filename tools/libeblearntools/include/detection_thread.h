@@ -35,13 +35,17 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <list>
+#include <map>
 
 #include "defines_tools.h"
 #include "thread.h"
 #include "netconf.h"
+#include "netbundle.h"
 #include "configuration.h"
 #include "bbox.h"
 #include "bootstrapping.h"
+#include "batch_detector.h"
 
 namespace ebl {
 
@@ -63,6 +67,10 @@ template <typename T> class detection_thread : public thread {
 
   //! Execute the detection thread.
   virtual void execute();
+  //! Use the already opened bundle 'b' instead of opening the configuration's
+  //! 'netbundle' file, so that all threads share the same mapped weights.
+  //! 'b' is not owned and must outlive this thread. Call before start().
+  virtual void set_netbundle(netbundle<T> *b);
 
   // thread communication ////////////////////////////////////////////////////
 
@@ -81,6 +89,11 @@ template <typename T> class detection_thread : public thread {
   //! We get the frame back even though it was set via set_data,
   //! because we do not know which frame was actually used.
   //! (could use some kind of id, and remember frames to avoid copy).
+  //! In batch mode ('batch_size' > 1), frames are returned one per call
+  //! in the order they were detected, which may differ from the order
+  //! they were sent when their sizes differ. Once stopped, the thread
+  //! waits for its last frames to be read, giving up when none was read
+  //! for 'batch_return_timeout' seconds (default 60).
   //! \param frame_id An optional variable that will be filled with frame's id
   //! \param samples Extracted samples corresponding to bboxes (optional)
   //! \param skipped If frame was ignored, skipped == true.
@@ -90,6 +103,13 @@ template <typename T> class detection_thread : public thread {
                         svector<midx<T> > *samples = NULL,
                         bboxes *bbsamples = NULL,
                         bool *skipped = NULL);
+  //! Thread-safely mark region 'r' of the next frame as changed, so that it
+  //! is recomputed in incremental detection mode (e.g. a tracked object).
+  virtual void add_dirty_region(const rect<float> &r);
+  //! Thread-safely copy the stages durations of each frame processed so far
+  //! into 'timings' (see detector::get_timing()). Durations are only recorded
+  //! when the 'benchmark' variable is set.
+  virtual void get_timings(std::vector<detector_timing> &timings);
   //! Return true if the thread is available to process a new frame, false
   //! otherwise.
   virtual bool available();
@@ -116,6 +136,18 @@ template <typename T> class detection_thread : public thread {
   void set_out_updated();
   //! Set skipped and updated flags to true.
   void skip_frame();
+  //! Detect the groups of 'batch' that are ready (all groups if 'force')
+  //! and queue their results for get_data().
+  void process_batch(batch_detector<T> &batch, bool force = false);
+
+  //! A frame waiting in the batch detector or waiting to be returned.
+  class batched_frame {
+   public:
+    idx<ubyte>  frame;
+    std::string name;
+    uint        id;
+    bboxes      bbs;
+  };
 
   // private members /////////////////////////////////////////////////////////
  private:
@@ -145,6 +177,13 @@ template <typename T> class detection_thread : public thread {
   bootstrapping<T>  boot; //!< Bootstrapping manager.
   bool                 frame_skipped; //!< Processing skipped for this frame.
   bool                 frame_loaded; //!< Frame was loaded or not.
+  std::vector<rect<float> > dirty_regions; //!< Regions changed in next frame.
+  bool                 benchmark; //!< Record stages durations or not.
+  std::vector<detector_timing> timings; //!< Stages durations of each frame.
+  std::map<uint,batched_frame> batch_in; //!< Frames in the batch detector.
+  std::list<batched_frame> batch_out; //!< Detected frames not returned yet.
+  uint                 batch_count; //!< Number of frames batched so far.
+  netbundle<T>        *shared_bundle; //!< A bundle shared by other threads.
 
  public:
   detector<T>       *pdetect;
@@ -64,8 +64,10 @@ detection_thread(configuration &conf_, mutex *om, const char *name_,
       in_updated(false), out_updated(false), bavailable(false), bfed(false),
       frame_name(""), frame_id(0), outdir(""), total_saved(0), color_space(tc),
       silent(false), boot(conf), frame_skipped(false),
-      frame_loaded(false), pdetect(NULL) {
+      frame_loaded(false), benchmark(false), batch_count(0),
+      shared_bundle(NULL), pdetect(NULL) {
   silent = conf.exists_true("silent");
+  benchmark = conf.exists_true("benchmark");
   outdir = get_output_directory(conf);
   mout << "Saving outputs to " << outdir << std::endl;
 }
@@ -74,6 +76,11 @@ template <typename T>
 detection_thread<T>::~detection_thread() {
 }
 
+template <typename T>
+void detection_thread<T>::set_netbundle(netbundle<T> *b) {
+  shared_bundle = b;
+}
+
 template <typename T>
 void detection_thread<T>::execute() {
   try {
@@ -99,12 +106,21 @@ void detection_thread<T>::execute() {
     parameter<T> theparam;
     theparam.set_forward_only();
     idx<ubyte> classes(1,1);
-    //try { // try loading classes names but do not stop upon failure
-    load_matrix<ubyte>(classes, conf.get_cstring("classes"));
-    // } catch(std::string &err) {
-    //   merr << "warning: " << err;
-    //   merr << std::endl;
-    // }
+    // a precompiled bundle already holds classes, weights and scales,
+    // it must be kept until the network is deleted since weights are mapped
+    netbundle<T> *bundle = shared_bundle;
+    if (!bundle && conf.exists("netbundle"))
+      bundle = new netbundle<T>(conf.get_cstring("netbundle"));
+    if (bundle)
+      classes = bundle->get_classes();
+    else {
+      //try { // try loading classes names but do not stop upon failure
+      load_matrix<ubyte>(classes, conf.get_cstring("classes"));
+      // } catch(std::string &err) {
+      //   merr << "warning: " << err;
+      //   merr << std::endl;
+      // }
+    }
     std::vector<std::string> sclasses = ubyteidx_to_stringvector(classes);
     answer_module<T> *ans = create_answer<T,T,T>(conf, classes.dim(0));
     uint noutputs = ans->get_nfeatures();
@@ -112,7 +128,9 @@ void detection_thread<T>::execute() {
     module_1_1<T> *net = create_network<T>(theparam, conf, thick, noutputs,
                                            "arch", this->_id);
     // loading weights
-    if (conf.exists("weights")) { // manual weights
+    if (bundle) // weights mapped from the bundle
+      bundle->load_weights(theparam);
+    else if (conf.exists("weights")) { // manual weights
       // concatenate weights if multiple ones
       std::vector<std::string> w =
           string_to_stringvector(conf.get_string("weights"));
@@ -142,6 +160,7 @@ void detection_thread<T>::execute() {
     // detector
     detector<T> detect(*net, sclasses, ans, NULL, NULL, mout, merr);
     init_detector(detect, conf, outdir, silent);
+    if (bundle) bundle->init_detector(detect);
     // keep pointer to detector
     pdetect = &detect;
     bootstrapping<T> boot(conf);
@@ -160,6 +179,17 @@ void detection_thread<T>::execute() {
     if (conf.exists("mask_class"))
       bmask_class = detect.set_mask_class(conf.get_cstring("mask_class"));
 
+    // detect frames of identical sizes by batches (see batch_detector)
+    batch_detector<T> *batch = NULL;
+    if (conf.try_get_uint("batch_size", 1) > 1) {
+      if (display || precomputed_boxes || conf.exists_true("bootstrapping")
+          || conf.exists_true("incremental")) {
+        eblwarn("ignoring batch_size, batching is not available with display,"
+                << " bbox_file, bootstrapping or incremental detection");
+      } else
+        batch = new batch_detector<T>(detect, conf);
+    }
+
     std::string viddir = outdir;
     viddir += "video/";
     mkdir_full(viddir);
@@ -208,11 +238,16 @@ void detection_thread<T>::execute() {
     bavailable = true;
     while(!this->_stop) {
       // wait until a new image is made available
-      while (!in_updated && !_stop) {
+      while (!in_updated && !_stop && !(batch && batch->ready())) {
         millisleep(1);
       }
       tpass.restart();
       if (_stop) break ;
+      // batched frames waited long enough for other frames
+      if (batch && !in_updated) {
+        process_batch(*batch);
+        continue ;
+      }
       // we got a new frame, reset new frame flag
       in_updated = false; // no need to lock mutex
       // check if this frame should be skipped
@@ -224,6 +259,19 @@ void detection_thread<T>::execute() {
         mout << "loaded image " << frame_fullname << std::endl;
       }
       if (!silent) mout << "processing " << frame_name << std::endl;
+      // batch mode: queue the frame and accept the next one right away,
+      // frames are detected when their batch is full or waited long enough
+      if (batch) {
+        batched_frame &b = batch_in[batch_count];
+        b.frame = idx<ubyte>(uframe.get_idxdim());
+        idx_copy(uframe, b.frame);
+        b.name = frame_name;
+        b.id = frame_id;
+        batch->push(b.frame, batch_count++, frame_id);
+        bavailable = true;
+        if (batch->ready()) process_batch(*batch);
+        continue ;
+      }
       // check frame is correctly allocated, if not, allocate.
       if (frame.order() != uframe.order())
         frame = idx<T>(uframe.get_idxdim());
@@ -260,7 +308,17 @@ void detection_thread<T>::execute() {
         } else {
           try {
             mout << "starting processing of frame " << frame_name << std::endl;
+            mutex_in.lock(); // regions known to change, e.g. from tracking
+            for (uint i = 0; i < dirty_regions.size(); ++i)
+              detect.add_dirty_region(dirty_regions[i]);
+            dirty_regions.clear();
+            mutex_in.unlock();
             bboxes &bb = detect.fprop(frame, frame_name.c_str(), frame_id);
+            if (benchmark) {
+              mutex_out.lock();
+              timings.push_back(detect.get_timing());
+              mutex_out.unlock();
+            }
             copy_bboxes(bb); // make a copy of bounding boxes
           } catch(ebl::eblexception &e) { // detection failed
 #ifdef __NOEXCEPTIONS__
@@ -355,6 +413,19 @@ void detection_thread<T>::execute() {
         mout << bbs.pretty_short(detect.get_labels());
         mout << "processing=" << ms << " ms ("
              << tpass.elapsed() << ")" << std::endl;
+        uint hits = detect.get_plan_cache_hits();
+        uint lookups = hits + detect.get_plan_cache_misses();
+        if (lookups > 0 && conf.exists("plan_cache"))
+          mout << "plan_cache_hits=" << hits << "/" << lookups << " ("
+               << (uint) (hits * 100.0 / lookups + .5) << "%)" << std::endl;
+        if (conf.exists_true("incremental"))
+          mout << "incremental_evaluated="
+               << (uint) (detect.get_incremental_evaluated() * 100 + .5) << "%"
+               << std::endl;
+        if (conf.exists("cascade"))
+          mout << "cascade_evaluated="
+               << (uint) (detect.get_cascade_evaluated() * 100 + .5) << "%"
+               << std::endl;
       }
       DEBUGMEM_PRETTY("after detection");
       // switch 'updated' flag on to warn we just added new data
@@ -368,10 +439,34 @@ void detection_thread<T>::execute() {
           detect.get_total_saved() > conf.get_uint("save_max"))
         break ; // limit number of detection saves
     }
+    if (batch) { // detect remaining frames and wait until they are returned
+      process_batch(*batch, true);
+      // give up if the consumer stops reading frames for too long
+      long timeout = conf.try_get_uint("batch_return_timeout", 60);
+      timer twait;
+      twait.start();
+      mutex_out.lock();
+      size_t left = batch_out.size();
+      mutex_out.unlock();
+      while (out_updated && twait.elapsed_seconds() < timeout) {
+        millisleep(1);
+        mutex_out.lock();
+        if (batch_out.size() < left) { // a frame was read, wait again
+          left = batch_out.size();
+          twait.restart();
+        }
+        mutex_out.unlock();
+      }
+      if (out_updated)
+        eblwarn("dropping " << left << " detected frames that were not "
+                << "returned within " << timeout << " seconds");
+      delete batch;
+    }
     mout << "detection finished. Execution time: " << toverall.elapsed()<<std::endl;
     // free variables
     if (net) delete net;
     if (ans) delete ans;
+    if (bundle && bundle != shared_bundle) delete bundle;
   } eblcatcherror();
 }
 
@@ -490,11 +585,39 @@ void detection_thread<T>::init_detector(detector<T> &detect,
     detect.set_corners_inference(conf.get_uint("corners_inference"));
   if (conf.exists("input_gain"))
     detect.set_input_gain(conf.get_double("input_gain"));
+  if (conf.exists("plan_cache"))
+    detect.set_plan_cache(conf.get_uint("plan_cache"));
+  if (conf.exists_true("incremental")) // only recompute changes in videos
+    detect.set_incremental(conf.try_get_uint("incremental_block", 16),
+                           conf.try_get_double("incremental_tolerance", 0),
+                           conf.try_get_uint("incremental_refresh", 0));
+  if (conf.exists("cascade")) { // early rejection after module "cascade"
+    idx<T> w, *pw = NULL;
+    if (conf.exists("cascade_weights")) {
+      w = load_matrix<T>(conf.get_cstring("cascade_weights"));
+      pw = &w;
+    }
+    detect.set_cascade(conf.get_cstring("cascade"),
+                       (T) conf.try_get_double("cascade_threshold", 0), pw);
+    if (conf.exists("cascade_band") || conf.exists("cascade_dense"))
+      detect.set_cascade_evaluation(conf.try_get_uint("cascade_band", 8),
+                                    conf.try_get_float("cascade_dense", .6));
+    if (conf.exists("cascade_recall")) { // calibrate on validation set
+      class_datasource<T,T,int> val;
+      val.init(conf.get_cstring("val"),
+               conf.try_get_string("val_labels").c_str(), NULL, NULL,
+               conf.try_get_string("val_classes").c_str(), "val",
+               conf.try_get_uint("val_size", 0));
+      detect.calibrate_cascade(val, conf.get_double("cascade_recall"));
+    }
+  }
   if (conf.exists_true("dump_outputs")) {
     std::string fname;
     fname << odir << "/dump/detect_out";
     detect.set_outputs_dumping(fname.c_str());
   }
+  if (conf.exists_true("benchmark")) // time the pyramid apart from the net
+    detect.set_stage_timing(true);
 }
 
 template <typename T>
@@ -514,8 +637,8 @@ bool detection_thread<T>::get_data(bboxes &bboxes2, idx<ubyte> &frame2,
   if (frame_skipped) {
     if (skipped) *skipped = true;
     frame_skipped = false;
-    // reset updated flag
-    out_updated = false;
+    // reset updated flag (unless batched frames are waiting)
+    out_updated = !batch_out.empty();
     // declare thread as available
     bavailable = true;
     // unlock data
@@ -523,6 +646,27 @@ bool detection_thread<T>::get_data(bboxes &bboxes2, idx<ubyte> &frame2,
     return false;
   }
   if (skipped) *skipped = false;
+  // batch mode: return the oldest detected frame, availability is
+  // handled by the detection loop
+  if (!batch_out.empty()) {
+    batched_frame &b = batch_out.front();
+    bboxes2.clear();
+    bboxes2.push_back_new(b.bbs);
+    if (frame2.order() != b.frame.order())
+      frame2 = idx<ubyte>(b.frame.get_idxdim());
+    else if (frame2.get_idxdim() != b.frame.get_idxdim())
+      frame2.resize(b.frame.get_idxdim());
+    idx_copy(b.frame, frame2);
+    total_saved_ = total_saved;
+    frame_name_ = b.name;
+    if (id) *id = b.id;
+    if (samples) samples->clear();
+    if (bbsamples) bbsamples->clear();
+    batch_out.pop_front();
+    out_updated = !batch_out.empty();
+    mutex_out.unlock();
+    return true;
+  }
   // clear bboxes
   bboxes2.clear();
   bboxes2.push_back_new(bbs);
@@ -603,6 +747,20 @@ bool detection_thread<T>::set_data(std::string &fullname,
   return true;
 }
 
+template <typename T>
+void detection_thread<T>::add_dirty_region(const rect<float> &r) {
+  mutex_in.lock();
+  dirty_regions.push_back(r);
+  mutex_in.unlock();
+}
+
+template <typename T>
+void detection_thread<T>::get_timings(std::vector<detector_timing> &t) {
+  mutex_out.lock();
+  t = timings;
+  mutex_out.unlock();
+}
+
 template <typename T>
 bool detection_thread<T>::available() {
   return bavailable;
@@ -688,6 +846,28 @@ void detection_thread<T>::skip_frame() {
   mutex_out.unlock();
 }
 
+template <typename T>
+void detection_thread<T>::process_batch(batch_detector<T> &batch, bool force) {
+  std::vector<batch_result> res;
+  batch.process(res, force);
+  if (res.empty()) return ;
+  if (!silent) mout << "detected a batch of " << res.size() << " frames"
+                    << std::endl;
+  // lock data
+  mutex_out.lock();
+  for (uint i = 0; i < res.size(); ++i) {
+    typename std::map<uint,batched_frame>::iterator b =
+        batch_in.find(res[i].source);
+    batch_out.push_back(b->second);
+    batch_out.back().bbs.push_back_new(res[i].bbs);
+    batch_in.erase(b);
+  }
+  if (pdetect) total_saved = pdetect->get_total_saved();
+  out_updated = true;
+  // unlock data
+  mutex_out.unlock();
+}
+
 } // end namespace ebl
 
 #endif /* DETECTION_THREAD_HPP_ */
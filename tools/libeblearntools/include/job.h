@@ -38,6 +38,7 @@
 #include "utils.h"
 
 #include <sstream>
+#include <set>
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -89,6 +90,8 @@ namespace ebl {
     virtual std::string &name();
     //! Return the short name of this job.
     virtual std::string shortname();
+    //! Return the name identifying this job in its logs (variable "job").
+    virtual std::string get_name();
 
     //! Return root directory of this job.
     virtual std::string get_root();
@@ -107,6 +110,28 @@ namespace ebl {
     //! Returns the progress percentage or -1 if not started.
     //! This value is updated after a check_progress() call only.
     virtual int progress() const;
+    //! Stop this job if we are running it, and declare it stopped
+    //! (a 'stopped' file in the job's directory) so that it is considered
+    //! finished and not started again.
+    virtual void stop();
+    //! Allow a stopped job to be started again, resuming from its latest
+    //! saved parameters.
+    virtual void resume();
+    //! Returns true if this job was stopped before finishing.
+    virtual bool stopped();
+    //! Return the value of variable 'var' in this job's resolved
+    //! configuration, or an empty string if it is not defined.
+    virtual std::string get_variable(const std::string &var);
+    //! Share the first 'iter' iterations of job 'leader': this job is not
+    //! started before 'leader' saved its parameters at iteration 'iter',
+    //! it then continues training from these parameters and from the state
+    //! of the leader's training set.
+    virtual void warm_start(job &leader, uint iter);
+    //! Returns true if this job is waiting for its warm-start parameters.
+    virtual bool waiting();
+    //! Append warm-start parameters to the job's configuration file
+    //! if this job is warm-started and has no parameters of its own.
+    virtual void write_warm_start();
 
     ////////////////////////////////////////////////////////////////
     // file-based resuming capabilities
@@ -133,7 +158,8 @@ namespace ebl {
     //! If 'retrain_iteration' and 'iterations' are defined, return
     //! retrain_iteration / iterations * 100 as percentage.
     virtual int check_progress();
-    //! Returns true if a file named 'finished' exists in the job's directory.
+    //! Returns true if a file named 'finished' or 'stopped' exists in the
+    //! job's directory.
     virtual bool check_finished();
     //! Write the file 'progress' in current directory or in root directory
     //! if specified, and write 'i' and 'total'
@@ -180,7 +206,13 @@ namespace ebl {
     bool                _finished; //!< This is is finished or not.
     int                 _progress; //!< Progress percentage.
     std::string         progress_fname; //!< Filename of progress file.
+    time_t              progress_modified; //!< Time progress was last read.
     std::string         finished_fname; //!< Filename of finished file.
+    std::string         stopped_fname; //!< Filename of stopped file.
+    bool                _stopped; //!< This job was stopped before finishing.
+    job                *warm_leader; //!< Job providing warm-start parameters.
+    uint                warm_iter; //!< Iteration of warm-start parameters.
+    std::string         warm_fname; //!< Warm-start parameters filename.
   };
 
   //! Job comparison definintion based on their progress.
@@ -236,6 +268,20 @@ namespace ebl {
     virtual void jobs_info();
     //! Analyze and send a report.
     virtual void report();
+    //! Read early stopping parameters from the meta configuration.
+    virtual void init_schedule();
+    //! Compare intermediate results of jobs and stop those that do not
+    //! make it into the best 1/eta of jobs at each rung (successive halving),
+    //! resuming paused jobs that became promising.
+    virtual void schedule();
+    //! Promote the best jobs waiting at rung 'k' until the best 1/eta of
+    //! results at this rung are promoted. Promotions are never revoked, so
+    //! that a job never loses the budget it was given.
+    virtual void promote(uint k);
+    //! Group jobs that only differ by the variables listed in
+    //! 'meta_warm_vars': the first job of each group trains from scratch,
+    //! the others start from its parameters at iteration 'meta_warm_iter'.
+    virtual void init_warm_start();
     //! Print stopping message and send last report.
     virtual void last_report();
     //! List all job directories found in conf's root directory and
@@ -269,6 +315,15 @@ namespace ebl {
     varmaplist          besteach; //!< best result of each job
     uint                swait; //!< Waiting time when looping, in seconds.
     timer               time; //!< Total running time.
+    // early stopping ////////////////////////////////////////////////////////
+    std::string         sched_key; //!< Variable minimized by the scheduler.
+    std::vector<uint>   rungs; //!< Iterations where jobs are compared.
+    uint                sched_eta; //!< 1/eta jobs continue past each rung.
+    bool                sched_pause; //!< Pause jobs instead of stopping.
+    //! Results at each rung, for each job index.
+    std::vector<std::map<uint,double> > rung_results;
+    std::vector<int>    job_rungs; //!< Highest rung reached by each job.
+    std::vector<std::set<uint> > promoted_at; //!< Jobs promoted at each rung.
   };
 
 } // end namespace ebl
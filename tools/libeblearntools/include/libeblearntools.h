@@ -33,6 +33,7 @@
 #ifndef LIBEBLEARNTOOLS_H_
 #define LIBEBLEARNTOOLS_H_
 
+#include "batch_detector.h"
 #include "bootstrapping.h"
 #include "camera.h"
 #include "camera_datasource.h"
@@ -42,6 +43,7 @@
 #include "camera_mcams.h"
 #include "camera_opencv.h"
 #include "camera_shmem.h"
+#include "camera_synthetic.h"
 #include "camera_v4l2.h"
 #include "camera_video.h"
 #include "configuration.h"
@@ -53,6 +55,7 @@
 #include "job.h"
 #include "metaparser.h"
 #include "mpijob.h"
+#include "netbundle.h"
 #include "netconf.h"
 #include "nms.h"
 #include "opencv.h"
@@ -183,6 +183,8 @@ public:
 
 	//! Return sub tree.
 	std::map<uint,pairtree>& get_subtree();
+	//! Return leaf variables and their values.
+	std::map<uint,uint>& get_vars();
 
 	// members ////////////////////////////////////////////////////////////////////
 private:
@@ -221,9 +223,23 @@ public:
 	//! Parse all files in root matching the .log extension.
 	//! If 'sticky' is not null, keep those variables between iterations.
 	//! If 'watch' is not null and not empty, only extract those variables.
+	//! Parsing is incremental: each log's byte offset is remembered so that
+	//! subsequent calls only parse lines appended since the last call.
+	//! A log that shrank or whose first or last parsed bytes changed
+	//! (i.e. it was rewritten) or a change of 'sticky' or 'watch' lists
+	//! triggers a full reparse.
 	void parse_logs(const std::string &root, std::list<std::string> *sticky = NULL,
 									std::list<std::string> *watch = NULL);
 
+	//! Same as parse_logs() above, using sticky and watch lists defined in
+	//! 'conf' (see analyze()).
+	void parse_logs(configuration &conf, const std::string &root);
+
+	//! Set 'val' to the value of variable 'key' at iteration 'iter' of job
+	//! 'job', as found by the last parsing. Returns false if not found.
+	bool get_value(const std::string &job, uint iter, const std::string &key,
+								 double &val);
+
 	//! Organize a flat representation 'flat' into a plottable tree
 	//! representation, organized in hierarchy where the 1st depth
 	//! contains curves names composed of each possible configuration of
@@ -241,6 +257,9 @@ public:
 	void write_plots(configuration &conf, const char *dir = NULL,
 									 pairtree *p = NULL, std::string *prefix = NULL);
 
+	//! Forget all parsed logs and their variables.
+	void clear();
+
 	//! Return the n best values (minimized) of key.
 	natural_varmap best(const std::string &key, uint n, bool display = false);
 	//! Return the n best values (minimized) of key.
@@ -292,8 +311,30 @@ public:
 private:
 	//! If 'sticky' is not null, keep those variables between iterations.
 	//! If 'watch' is not null and not empty, only extract those variables.
-	bool parse_log(const std::string &fname, std::list<std::string> *sticky = NULL,
+	//! Parsing state of a log file, so that only new lines are parsed.
+	class log_state {
+	public:
+		log_state();
+		std::streamoff				offset;	//!< Bytes of the log parsed so far.
+		std::string						head;	//!< First parsed bytes, to detect rewrites.
+		std::string						tail;	//!< Last parsed bytes, to detect rewrites.
+		std::map<uint,uint>		stick;	//!< Current sticky variables.
+		varmaplist						records; //!< Parsed variables of each line.
+	};
+
+	//! Parse lines of 'fname' that were appended since last call,
+	//! using and updating its parsing state 'st'. Incomplete lines (not yet
+	//! terminated by a newline) are left for the next call.
+	//! If 'sticky' is not null, keep those variables between iterations.
+	//! If 'watch' is not null and not empty, only extract those variables
+	//! and the hierarchy keys.
+	bool parse_log(const std::string &fname, log_state &st,
+								 std::list<std::string> *sticky = NULL,
 								 std::list<std::string> *watch = NULL);
+	//! Fill 'sticky' and 'watch' lists from 'conf'. 'watch' is left empty
+	//! (i.e. all variables are kept) when 'meta_watch_vars' is not set.
+	void get_sticky_watch(configuration &conf, std::list<std::string> &sticky,
+												std::list<std::string> &watch);
 
 	////////////////////////////////////////////////////////////////
 	// members
@@ -302,6 +343,10 @@ private:
 	char		separator;      //!< token separating var/val
 	std::map<std::string,std::string>	curpath;	//!< Current path to pairtree leaf.
 	std::list<uint>	hierarchy;	//!< List of vars forming the hierarchy.
+	std::map<std::string,log_state> logs; //!< Parsing state of each log.
+	std::list<std::string> logs_sticky;	//!< Sticky list used to parse logs.
+	std::list<std::string> logs_watch;	//!< Watch list used to parse logs.
+	bool		rebuild;				//!< The tree must be rebuilt from all records.
 };
 
 } // end namespace ebl
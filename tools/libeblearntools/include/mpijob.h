@@ -117,6 +117,9 @@ namespace ebl {
     void jinfos(int running[]);
     //! Run a slave manager, which takes orders for the master manager.
     virtual void run_slave();
+    //! Read early stopping parameters, jobs running on slaves cannot be
+    //! paused, they are only prevented from being started again.
+    virtual void init_schedule();
 
     // members /////////////////////////////////////////////////////////////////
   protected:
@@ -0,0 +1,161 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+
+#ifndef NETBUNDLE_H_
+#define NETBUNDLE_H_
+
+#include <vector>
+#include "libeblearn.h"
+#include "configuration.h"
+
+//! Magic number identifying a network bundle file.
+#define MAGIC_NETBUNDLE 0x1e3d4d00
+//! Version of the network bundle layout written by netbundle<T>::save().
+#define NETBUNDLE_VERSION 1
+//! Alignment in bytes of the weights block inside a bundle.
+#define NETBUNDLE_ALIGN 16
+
+namespace ebl {
+
+// mapped_file /////////////////////////////////////////////////////////////////
+
+//! A view of an entire file. The file is memory-mapped copy-on-write when
+//! the platform allows it, otherwise it is read into memory in a single
+//! block. Writes are private to the process and never reach the file.
+class EXPORT mapped_file {
+ public:
+  //! Map file 'filename', throws an eblexception upon failure.
+  mapped_file(const char *filename);
+  //! Unmap the file.
+  virtual ~mapped_file();
+  //! Returns a pointer to the first byte of the file.
+  const char* data() const;
+  //! Returns a writable pointer to the first byte of the file.
+  char* data();
+  //! Returns the size of the file in bytes.
+  size_t size() const;
+ private:
+  mapped_file(const mapped_file&);
+  mapped_file& operator=(const mapped_file&);
+ private:
+  char              *ptr;    //!< Beginning of the file's content.
+  size_t             len;    //!< Size of the file.
+  bool               mapped; //!< True if 'ptr' was mmap'ed.
+  std::vector<char>  buffer; //!< Content when not mapped.
+};
+
+// netbundle header ////////////////////////////////////////////////////////////
+
+//! Returns true if 'filename' starts with the network bundle magic number.
+EXPORT bool is_netbundle(const char *filename);
+
+//! Everything contained in a network bundle except for the weights.
+struct EXPORT netbundle_header {
+  netbundle_header();
+  int                  weights_magic; //!< Type magic of the stored weights.
+  int64                nweights;      //!< Number of stored weights.
+  size_t               offset;        //!< Offset in bytes of the weights.
+  string_map_t         vars;          //!< Resolved configuration variables.
+  std::string          name;          //!< Name of the original configuration.
+  idx<ubyte>           classes;       //!< Class names, one per row.
+  idxdim               netdim;        //!< Network's minimum input.
+  std::vector<idxdim>  indims;        //!< Input sizes with precomputed scales.
+  std::vector<midxdim> scales;        //!< Scales for each of 'indims'.
+};
+
+//! Write all of 'h' but the weights to 'fp' and pad the stream so that the
+//! weights written next are aligned on NETBUNDLE_ALIGN bytes.
+EXPORT void write_netbundle_header(FILE *fp, netbundle_header &h);
+//! Parse the header of bundle 'f' into 'h' and check that 'f' is large
+//! enough to contain the weights announced by the header.
+EXPORT void read_netbundle_header(const mapped_file &f, netbundle_header &h);
+
+// netbundle ///////////////////////////////////////////////////////////////////
+
+//! A single-file, precompiled network: resolved configuration, class names,
+//! trained weights and the detector's scale geometry for known input sizes.
+//! Loading it requires no text parsing, no per-element IO and no
+//! fprop_size/compute_scales pass: the file is mapped once, the network is
+//! rebuilt from the stored resolved variables and its weights point
+//! directly into the mapped file.
+//! The layout (native endianness) is:
+//!   magic, version, weights magic, int64 number of weights,
+//!   name, number of variables, (name, value) of each variable,
+//!   classes dimensions and bytes, network minimum input,
+//!   number of input sizes, (input size, scales) for each,
+//!   padding up to NETBUNDLE_ALIGN bytes, raw weights.
+//! Strings are stored as an int length followed by their characters and
+//! dimensions as an int order followed by int sizes.
+template <typename T> class netbundle {
+ public:
+  //! Map bundle 'filename' and read its header.
+  netbundle(const char *filename);
+  //! Destructor.
+  virtual ~netbundle();
+
+  //! Returns the resolved configuration stored in the bundle.
+  configuration& get_configuration();
+  //! Returns the class names stored in the bundle.
+  idx<ubyte>& get_classes();
+  //! Build the network described by the bundle and load its weights
+  //! into 'theparam' (see load_weights()). Arguments are the same as
+  //! create_network().
+  module_1_1<T>* create_network(parameter<T> &theparam, intg &thick,
+                                int noutputs = -1, int tid = -1);
+  //! Make the weights of 'theparam' point directly into the mapped bundle,
+  //! without copying them. Pages are copy-on-write, so 'theparam' may
+  //! still be modified, and its storage is copied if it is resized.
+  //! This bundle must outlive 'theparam' and all modules using it.
+  void load_weights(parameter<T> &theparam);
+  //! Fix 'd's network minimum input and give it the precomputed scales.
+  void init_detector(detector<T> &d);
+
+  //! Write a bundle to 'filename' with the resolved variables of 'conf',
+  //! class names 'classes', weights of 'theparam' and the scales 'd'
+  //! computes for each size of 'indims'.
+  static void save(const char *filename, configuration &conf,
+                   idx<ubyte> &classes, parameter<T> &theparam,
+                   detector<T> &d, std::vector<idxdim> &indims);
+
+  // members ///////////////////////////////////////////////////////////////
+ protected:
+  mapped_file       file;       //!< The mapped bundle.
+  netbundle_header  header;     //!< Its parsed header.
+  configuration    *conf;       //!< Configuration built from the header.
+};
+
+} // namespace ebl
+
+#include "netbundle.hpp"
+
+#endif /* NETBUNDLE_H_ */
@@ -0,0 +1,158 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+
+#ifndef NETBUNDLE_HPP_
+#define NETBUNDLE_HPP_
+
+#include <string.h>
+#include "netconf.h"
+
+namespace ebl {
+
+template <typename T>
+netbundle<T>::netbundle(const char *filename)
+    : file(filename), conf(NULL) {
+  read_netbundle_header(file, header);
+  if (header.weights_magic != get_magic<T>())
+    eblthrow("bundle " << filename << " holds weights of type "
+             << get_magic_str(header.weights_magic) << " but expected "
+             << get_magic_str(get_magic<T>()));
+  // rebuild configuration from resolved variables, without parsing
+  textlist txt;
+  for (string_map_t::iterator i = header.vars.begin();
+       i != header.vars.end(); ++i) {
+    std::string line;
+    line << i->first << "=" << i->second;
+    txt.push_back(std::pair<std::string,std::string>(line, i->first));
+  }
+  std::string outdir = "";
+  conf = new configuration(header.vars, txt, header.name, outdir);
+}
+
+template <typename T>
+netbundle<T>::~netbundle() {
+  if (conf) delete conf;
+}
+
+template <typename T>
+configuration& netbundle<T>::get_configuration() {
+  return *conf;
+}
+
+template <typename T>
+idx<ubyte>& netbundle<T>::get_classes() {
+  return header.classes;
+}
+
+template <typename T>
+module_1_1<T>* netbundle<T>::create_network(parameter<T> &theparam,
+                                            intg &thick, int noutputs,
+                                            int tid) {
+  module_1_1<T> *net =
+      ebl::create_network<T>(theparam, *conf, thick, noutputs, "arch", tid);
+  if (!net) eblthrow("failed to create network from bundle");
+  load_weights(theparam);
+  return net;
+}
+
+template <typename T>
+void netbundle<T>::load_weights(parameter<T> &theparam) {
+  if (theparam.dim(0) != 1 && theparam.dim(0) != header.nweights)
+    eblerror("Trying to load a network with " << header.nweights
+             << " parameters into a network with " << theparam.dim(0)
+             << " parameters");
+  theparam.resize_parameter((intg) header.nweights);
+  T *w = (T*) (file.data() + header.offset);
+  idx<T> &x = theparam.x[0];
+  if (x.offset() == 0 && x.contiguousp()) { // share the mapped weights
+    x.getstorage()->set_external_data(w, (intg) header.nweights);
+    eblprint("Mapped " << header.nweights << " weights from bundle"
+             << std::endl);
+  } else { // copy them in a single block
+    memcpy(x.idx_ptr(), w, (size_t) header.nweights * sizeof (T));
+    eblprint("Loaded " << header.nweights << " weights from bundle"
+             << std::endl);
+  }
+}
+
+template <typename T>
+void netbundle<T>::init_detector(detector<T> &d) {
+  idxdim nd(header.netdim);
+  if (nd.order() > 1) {
+    nd.remove_dim(0); // set_netdim() adds the feature dimension back
+    d.set_netdim(nd);
+  }
+  for (uint i = 0; i < header.indims.size(); ++i)
+    d.set_precomputed_scales(header.indims[i], header.scales[i]);
+}
+
+template <typename T>
+void netbundle<T>::save(const char *filename, configuration &conf,
+                        idx<ubyte> &classes, parameter<T> &theparam,
+                        detector<T> &d, std::vector<idxdim> &indims) {
+  netbundle_header h;
+  h.weights_magic = get_magic<T>();
+  h.nweights = theparam.dim(0);
+  h.name = conf.get_name();
+  std::vector<std::string> names = conf.get_all_strings("");
+  for (uint i = 0; i < names.size(); ++i)
+    h.vars[names[i]] = conf.get_string(names[i]);
+  h.classes = classes;
+  // compute scales geometry of each input size
+  for (uint i = 0; i < indims.size(); ++i) {
+    d.init(indims[i]);
+    h.indims.push_back(indims[i]);
+    h.scales.push_back(midxdim());
+    h.scales.back().push_back(d.get_scales());
+  }
+  if (indims.size() > 0) h.netdim = d.get_minimum_input();
+  // write header then weights in a single block
+  FILE *fp = fopen(filename, "wb");
+  if (!fp) eblthrow("failed to open " << filename);
+  try {
+    write_netbundle_header(fp, h);
+    idx<T> w = theparam;
+    if (!w.contiguousp()) w = idx_copy(w);
+    if (fwrite(w.idx_ptr(), sizeof (T), w.nelements(), fp)
+        != (size_t) w.nelements())
+      eblthrow("failed to write weights to " << filename);
+  } catch (eblexception &e) {
+    fclose(fp);
+    throw;
+  }
+  fclose(fp);
+}
+
+} // namespace ebl
+
+#endif /* NETBUNDLE_HPP_ */
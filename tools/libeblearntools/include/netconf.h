@@ -239,6 +239,12 @@ bool EXPORT load_table(configuration &conf, const std::string &module_name,
 //! 'conf' into gradient parameters object 'gdp'.
 void EXPORT load_gd_param(configuration &conf, gd_param &gdp);
 
+//! Enable per-module profiling if variable 'profile' is true in 'conf'.
+void EXPORT profile_init(configuration &conf);
+//! If profiling, print the per-module profile and save it in JSON format
+//! into the file named by variable 'profile_json' if defined in 'conf'.
+void EXPORT profile_report(configuration &conf);
+
 } // end namespace ebl
 
 #include "netconf.hpp"
@@ -373,6 +373,10 @@ create_module(const std::string &name, parameter<T> &theparam,
     midxdim switches;
     if (get_param(conf, name, "switch", sswitch, true))
       switches = string_to_idxdimvector(sswitch.c_str());
+    // run pipes concurrently, output them into a single buffer
+    bool parallel = false, concat = false;
+    get_param(conf, name, "parallel", parallel, true);
+    get_param(conf, name, "concat", concat, true);
     // ms
     if (!type.compare("ms")) {
       bool replicate_inputs = false;
@@ -380,6 +384,8 @@ create_module(const std::string &name, parameter<T> &theparam,
       ms_module<T> *ms =
           new ms_module<T>(pipes, replicate_inputs, name.c_str());
       ms->set_switch(switches);
+      ms->set_parallel(parallel);
+      ms->set_concat(concat);
       module = (module_1_1<T>*) ms;
     } else if (!type.compare("msc")) { // msc
       uint nsize = 0, nsize2 = 0, stride = 1;
@@ -389,6 +395,8 @@ create_module(const std::string &name, parameter<T> &theparam,
       msc_module<T> *msc = new msc_module<T>
           (pipes, nsize, stride, nsize2, name.c_str());
       msc->set_switch(switches);
+      msc->set_parallel(parallel);
+      msc->set_concat(concat);
       module = (module_1_1<T>*) msc;
     }
     EDEBUG("type: " << type << " " << module->describe());
@@ -443,6 +451,9 @@ create_module(const std::string &name, parameter<T> &theparam,
       std::vector<uint> sp = string_to_uintvector(spad.c_str());
       j->set_padding(sp);
     }
+    bool parallel = true;
+    get_param(conf, name, "parallel", parallel, true);
+    j->set_parallel(parallel);
   }
   // resizepp /////////////////////////////////////////////////////////
   else if (!type.compare("resizepp")) {
@@ -86,6 +86,10 @@ template <class Tdata> class pascal_dataset : public dataset<Tdata> {
   //! Set the maximum match between a jittered rect and another object
   //! in the same image, beyond which the jitter is ignored.
   virtual void set_max_jitter_match(float match);
+  //! Set the binary file caching the parsed annotations of all xml files,
+  //! by default 'annotations'/.pascal_index. An empty or NULL 'fname'
+  //! disables caching.
+  virtual void set_annotation_cache(const char *fname);
 
  protected:
 
@@ -102,9 +106,9 @@ template <class Tdata> class pascal_dataset : public dataset<Tdata> {
 
   //! count how many samples are present in dataset files to be compiled.
   virtual intg count_samples();
-  //! count sample or not given an xml node. This will update the total_sample
+  //! count sample or not given an object. This will update the total_sample
   //! and total_difficult counters.
-  virtual void count_sample(Node::NodeList &olist);
+  virtual void count_sample(const object &o);
 
   ////////////////////////////////////////////////////////////////
   // internal methods
@@ -142,6 +146,8 @@ template <class Tdata> class pascal_dataset : public dataset<Tdata> {
   //! by more than 'max_match'.
   virtual void remove_jitter_matches(const std::vector<object*> &objs,
                                      uint iobj, float max_match);
+  //! Index all annotations of 'annroot' if not already indexed.
+  virtual void load_index();
   //! Write statistics about frame 'xml' into stream 'fp'.
   virtual void write_statistics(std::string &xml, std::ofstream &fp);
 
@@ -167,6 +173,9 @@ template <class Tdata> class pascal_dataset : public dataset<Tdata> {
   std::string	annroot;	//!< directory of annotation xml files
   std::string	imgroot;	//!< directory of images
   std::string	ignore_root;	//!< directory of ignored annotatiosn
+  // annotations /////////////////////////////////////////////////
+  pascal_index	index;		//!< Parsed annotations of annroot.
+  std::string	index_cache;	//!< Binary cache file of 'index'.
   // base class members to be used ///////////////////////////////
   using dataset<Tdata>::load_img;
   using dataset<Tdata>::usepose;
@@ -73,6 +73,7 @@ pascal_dataset<Tdata>::pascal_dataset(const char *name_, const char *inroot_,
     annroot = annotations;
   else
     eblerror("expected annotations folder, please specify with -annotations");
+  index_cache << annroot << "/.pascal_index";
   if (ignore_path && strcmp(ignore_path, ""))
     ignore_root = ignore_path;
   ignore_difficult = ignore_diff;
@@ -107,16 +108,14 @@ bool pascal_dataset<Tdata>::extract() {
     eblerror("Annotation path " << annroot << " does not exist.");
   xtimer.start();
   processed_cnt = 0;
-  // find all xml files recursively
-  std::list<std::string> *files = find_fullfiles(annroot, XML_PATTERN, NULL,
-                                                 true, true);
-  if (!files || files->size() == 0)
+  // index all xml files recursively (usually already done by count_samples)
+  load_index();
+  if (index.size() == 0)
     eblerror("no xml files found in " << annroot << " using file pattern "
              << XML_PATTERN);
-  std::cout << "Found " << files->size() << " xml files." << std::endl;
-  for (std::list<std::string>::iterator i = files->begin();
-       i != files->end(); ++i) {
-    this->process_xml(*i);
+  std::cout << "Found " << index.size() << " xml files." << std::endl;
+  for (uint i = 0; i < index.size(); ++i) {
+    this->process_xml(index.get(i).xmlfile);
     processed_cnt++;
     if (full())
       break;
@@ -124,7 +123,6 @@ bool pascal_dataset<Tdata>::extract() {
   std::cout << "Extracted " << data_cnt << " elements into dataset." << std::endl;
   std::cout << "Extraction time: " << xtimer.elapsed() << std::endl;
   print_stats();
-  if (files) delete files;
 #endif /* __XML__ */
 #endif /* __BOOST__ */
   return true;
@@ -156,6 +154,15 @@ void pascal_dataset<Tdata>::set_max_jitter_match(float match) {
             << "objects in an image to " << max_jitter_match << std::endl;
 }
 
+template <class Tdata>
+void pascal_dataset<Tdata>::set_annotation_cache(const char *fname) {
+  index_cache = fname ? fname : "";
+  if (index_cache.empty())
+    std::cout << "Disabling annotation cache." << std::endl;
+  else
+    std::cout << "Setting annotation cache to " << index_cache << std::endl;
+}
+
 ////////////////////////////////////////////////////////////////
 // data
 
@@ -179,40 +186,22 @@ intg pascal_dataset<Tdata>::count_samples() {
   total_occluded = 0;
   total_ignored = 0;
   total_samples = 0;
-  std::string xmlpath;
   boost::filesystem::path p(annroot);
   if (!boost::filesystem::exists(p))
     eblthrow("Annotation path " << annroot << " does not exist.");
   std::cout << "Counting number of samples in " << annroot << " ..."
             << std::endl;
-  // find all xml files recursively
-  std::list<std::string> *files = find_fullfiles(annroot, XML_PATTERN, NULL,
-                                                 false, true);
-  if (!files || files->size() == 0)
+  // parse all xml files once, or read them from cache
+  load_index();
+  if (index.size() == 0)
     eblthrow("no xml files found in " << annroot << " using file pattern "
              << XML_PATTERN);
-  std::cout << "Found " << files->size() << " xml files." << std::endl;
-  for (std::list<std::string>::iterator i = files->begin(); i != files->end(); ++i) {
-    xmlpath = *i;
-    // parse xml
-    DomParser parser;
-    parser.parse_file(xmlpath);
-    if (parser) {
-      // initialize root node and list
-      const Node* pNode = parser.get_document()->get_root_node();
-      Node::NodeList list = pNode->get_children();
-      // parse all objects in image
-      for(Node::NodeList::iterator iter = list.begin();
-          iter != list.end(); ++iter) {
-        if (!strcmp((*iter)->get_name().c_str(), "object")) {
-          // check for difficult flag in object node
-          Node::NodeList olist = (*iter)->get_children();
-          count_sample(olist);
-        }
-      }
-    }
+  std::cout << "Found " << index.size() << " xml files." << std::endl;
+  for (uint i = 0; i < index.size(); ++i) {
+    const pascal_annotation &a = index.get(i);
+    for (uint j = 0; j < a.objs.size(); ++j)
+      count_sample(*a.objs[j]);
   }
-  if (files) delete files;
   std::cout << "Found: " << total_samples << " samples, including ";
   std::cout << total_difficult << " difficult, " << total_truncated;
   std::cout << " truncated and " << total_occluded << " occluded." << std::endl;
@@ -227,26 +216,10 @@ intg pascal_dataset<Tdata>::count_samples() {
 }
 
 template <class Tdata>
-void pascal_dataset<Tdata>::count_sample(Node::NodeList &olist) {
-  uint difficult = 0, truncated = 0, occluded = 0;
-  std::string obj_classname, pose;
-  bool pose_found = false;
-  Node::NodeList::iterator oiter;
-
-  for(oiter = olist.begin(); oiter != olist.end(); ++oiter) {
-    if (!strcmp((*oiter)->get_name().c_str(), "difficult"))
-      difficult = xml_get_uint(*oiter);
-    else if (!strcmp((*oiter)->get_name().c_str(), "truncated"))
-      truncated = xml_get_uint(*oiter);
-    else if (!strcmp((*oiter)->get_name().c_str(), "occluded"))
-      occluded = xml_get_uint(*oiter);
-    else if (!strcmp((*oiter)->get_name().c_str(), "name"))
-      xml_get_string(*oiter, obj_classname);
-    else if (!strcmp((*oiter)->get_name().c_str(), "pose")) {
-      xml_get_string(*oiter, pose);
-      pose_found = true;
-    }
-  }
+void pascal_dataset<Tdata>::count_sample(const object &o) {
+  uint difficult = o.difficult, truncated = o.truncated, occluded = o.occluded;
+  std::string obj_classname = o.name, pose = o.pose;
+  bool pose_found = !pose.empty();
 
   ////////////////////////////////////////////////////////////////
   // object
@@ -277,35 +250,27 @@ void pascal_dataset<Tdata>::count_sample(Node::NodeList &olist) {
     std::string part_classname;
 
     // add part's class to dataset
-    for(oiter = olist.begin();oiter != olist.end(); ++oiter) {
-      if (!strcmp((*oiter)->get_name().c_str(), "part")) {
-        // get part's name
-        Node::NodeList plist = (*oiter)->get_children();
-        for(Node::NodeList::iterator piter = plist.begin();
-            piter != plist.end(); ++piter) {
-          if (!strcmp((*piter)->get_name().c_str(), "name")) {
-            xml_get_string(*piter, part_classname);
-            // found a part and its name, add it
-            if (included_pascal(part_classname, difficult, truncated, occluded))
-            {
-              if (usepose && pose_found) { // append pose to class name
-                part_classname += "_";
-                part_classname += pose;
-              }
-              if (dataset<Tdata>::included(part_classname)) {
-                this->add_class(part_classname);
-                // increment samples numbers
-                this->total_samples++;
-                if (difficult) total_difficult++;
-                if (truncated) total_truncated++;
-                if (occluded) total_occluded++;
-                if ((difficult && ignore_difficult)
-                    || (truncated && ignore_truncated)
-                    || (occluded && ignore_occluded))
-                  total_ignored++;
-              }
-            }
-          }
+    for (uint i = 0; i < o.parts.size(); ++i) {
+      // only count parts with a name
+      if (o.parts[i]->name.empty()) continue ;
+      part_classname = o.parts[i]->name;
+      // found a part and its name, add it
+      if (included_pascal(part_classname, difficult, truncated, occluded)) {
+        if (usepose && pose_found) { // append pose to class name
+          part_classname += "_";
+          part_classname += pose;
+        }
+        if (dataset<Tdata>::included(part_classname)) {
+          this->add_class(part_classname);
+          // increment samples numbers
+          this->total_samples++;
+          if (difficult) total_difficult++;
+          if (truncated) total_truncated++;
+          if (occluded) total_occluded++;
+          if ((difficult && ignore_difficult)
+              || (truncated && ignore_truncated)
+              || (occluded && ignore_occluded))
+            total_ignored++;
         }
       }
     }
@@ -321,10 +286,9 @@ bool pascal_dataset<Tdata>::process_xml(const std::string &xmlfile) {
   int height = -1, width = -1, depth = -1;
   rect<int> *cropr = NULL;
 
-  // get image's properties
-  if (!pascal_xml::get_properties(imgroot, xmlfile, image_filename,
-                                  image_fullname, folder, height, width,
-                                  depth, objects, &cropr, false))
+  // get image's properties from the annotation index
+  if (!index.get_properties(imgroot, xmlfile, image_filename, image_fullname,
+                            folder, height, width, depth, objects, &cropr))
     return false;
   // get ignored boxes if present
   if (!ignore_root.empty()) {
@@ -541,13 +505,12 @@ void pascal_dataset<Tdata>::extract_statistics() {
   boost::filesystem::path p(annroot);
   if (!exists(p))
     eblerror("Annotation path " << annroot << " does not exist.");
-  // find all xml files recursively
-  std::list<std::string> *files = find_fullfiles(annroot, XML_PATTERN, NULL,
-                                                 true, true);
-  if (!files || files->size() == 0)
+  // index all xml files recursively
+  load_index();
+  if (index.size() == 0)
     eblerror("no xml files found in " << annroot << " using file pattern "
              << XML_PATTERN);
-  std::cout << "Found " << files->size() << " xml files." << std::endl;
+  std::cout << "Found " << index.size() << " xml files." << std::endl;
   // open an output file
   std::string fname;
   mkdir_full(outdir.c_str());
@@ -559,14 +522,21 @@ void pascal_dataset<Tdata>::extract_statistics() {
   *fp << "filename; height; width; h/w ratio; bbox height; bbox width; bbox h/w ratio; "
       << "max context;" << std::endl;
   // write stats
-  for (std::list<std::string>::iterator i = files->begin();
-       i != files->end(); ++i)
-    this->write_statistics(*i, *fp);
-  if (files) delete files;
+  for (uint i = 0; i < index.size(); ++i) {
+    std::string xml = index.get(i).xmlfile;
+    this->write_statistics(xml, *fp);
+  }
   delete fp;
 #endif
 }
 
+template <class Tdata>
+void pascal_dataset<Tdata>::load_index() {
+  if (index.size() > 0) return ; // already indexed
+  std::cout << "Indexing annotations in " << annroot << " ..." << std::endl;
+  index.load(annroot, index_cache);
+}
+
 template <class Tdata>
 void pascal_dataset<Tdata>::write_statistics(std::string &xml,
                                              std::ofstream &fp) {
@@ -575,9 +545,8 @@ void pascal_dataset<Tdata>::write_statistics(std::string &xml,
   rect<int> *cropr = NULL;
 
   // get image's properties
-  if (!pascal_xml::get_properties(imgroot, xml, image_filename,
-                                  image_fullname, folder, height, width,
-                                  depth, objects, &cropr, false))
+  if (!index.get_properties(imgroot, xml, image_filename, image_fullname,
+                            folder, height, width, depth, objects, &cropr))
     eblerror("error while getting properties of " << xml);
   // loop on objects
   for (uint i = 0; i < objects.size(); ++i) {
@@ -36,6 +36,7 @@
 #include "dataset.h"
 #include "xml_utils.h"
 #include "bbox.h"
+#include <map>
 
 #define XML_PATTERN ".*[.]xml"
 
@@ -83,6 +84,84 @@ namespace ebl {
 #endif /* __XML__ */
   };
 
+  // pascal_annotation /////////////////////////////////////////////////////////
+
+  //! All the properties of 1 annotation xml file, as returned by
+  //! pascal_xml::get_properties(), as stored in a pascal_index.
+  class EXPORT pascal_annotation {
+  public:
+    pascal_annotation();
+    //! Deletes objects and crop rect.
+    virtual ~pascal_annotation();
+    //! Appends new copies of all objects (and their parts) to 'objs',
+    //! to be deleted by the caller.
+    void copy_objects(std::vector<object*> &objs) const;
+
+    std::string		xmlfile;	//!< The annotation file.
+    int64		modified;	//!< Modification time of xmlfile (ns).
+    uint		size;		//!< Size of xmlfile.
+    bool		valid;		//!< False if xmlfile failed to parse.
+    std::string		image_filename;
+    std::string		folder;
+    int			height, width, depth;
+    rect<int>	       *cropr;		//!< Crop rect, NULL if none.
+    std::vector<object*> objs;		//!< All objects (crop-adjusted).
+  };
+
+  // pascal_index //////////////////////////////////////////////////////////////
+
+  //! An index of all annotation xml files of a directory, cached in a
+  //! compact binary file so that the xml files are parsed only once, and
+  //! only again when they change.
+  class EXPORT pascal_index {
+  public:
+    pascal_index();
+    virtual ~pascal_index();
+
+    //! Indexes all xml files found recursively in 'annroot'. Annotations
+    //! are read from binary file 'cache' when it exists and the xml files
+    //! are unchanged since (same modification time and size), other xml
+    //! files are parsed and the cache is rewritten if anything changed.
+    //! An empty 'cache' disables caching. Returns the number of files.
+    uint load(const std::string &annroot, const std::string &cache);
+    //! Returns the number of indexed files.
+    uint size() const;
+    //! Returns the number of xml files parsed by the last load(), the others
+    //! were read from the cache.
+    uint parsed() const;
+    //! Returns the annotation of the i-th indexed file (sorted by name).
+    const pascal_annotation &get(uint i) const;
+    //! Returns the annotation of 'xmlfile', or NULL if not indexed.
+    const pascal_annotation *find(const std::string &xmlfile) const;
+    //! Same as pascal_xml::get_properties(), but reading the properties
+    //! of 'xmlfile' from the index if present, from the xml file otherwise.
+    bool get_properties(const std::string &imgroot,
+			const std::string &xmlfile, std::string &image_filename,
+			std::string &image_fullname, std::string &folder,
+			int &height, int &width, int &depth,
+			std::vector<object*> &objs, rect<int> **cropr) const;
+    //! Removes all annotations.
+    void clear();
+
+  protected:
+    //! Parses 'xmlfile' into a new annotation.
+    pascal_annotation *parse(const std::string &xmlfile) const;
+    //! Reads the properties of xml file 'a.xmlfile' into 'a', returning
+    //! false if it fails to parse.
+    virtual bool read_xml(pascal_annotation &a) const;
+    //! Reads all annotations of 'cache' into 'anns'. Returns false if
+    //! 'cache' is missing or invalid.
+    bool read(const std::string &cache,
+	      std::map<std::string,pascal_annotation*> &anns) const;
+    //! Writes all annotations into 'cache'. Returns false upon failure.
+    bool write(const std::string &cache) const;
+
+  protected:
+    std::vector<pascal_annotation*>	anns;	   //!< Sorted annotations.
+    std::map<std::string,uint>		positions; //!< Index of each file.
+    uint				nparsed;   //!< Files parsed by load().
+  };
+
 } // end namespace ebl
 
 #endif /* PASCAL_XML_H_ */
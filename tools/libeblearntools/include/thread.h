@@ -150,6 +150,9 @@ namespace ebl {
     void ask_stop();
     //! Return true if thread has finished executing.
     bool finished();
+    //! Wait until the started thread has exited, e.g. after stop(), and
+    //! return true on success. A thread can only be joined once.
+    bool join();
     //! Return name of this thread.
     std::string& name();
     //! Return a reference this thread's output stream.
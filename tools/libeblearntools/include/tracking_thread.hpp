@@ -244,6 +244,8 @@ namespace ebl {
 	    b->class_id = -42; // tell that this bbox is result of tracking
 	    b->h0 = minloc.y;
 	    b->w0 = minloc.x;
+	    // let detection recompute the predicted region first
+	    dt.add_dirty_region(*b);
 	    //	    cout << "maxloc h: " << maxloc.y << " w: " << maxloc.x
             // << " minloc h:" << minloc.y << " w: " << minloc.x << endl;
 #endif
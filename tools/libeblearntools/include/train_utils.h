@@ -83,6 +83,17 @@ void test(uint iter, configuration &conf, std::string &conffname,
           infer_param &infp, gd_param &gdp, std::string &shortname,
 	  const std::string &basename);
 
+//! Quantizes network 'net' to 8 bits, calibrates it on 'calib_ds' and
+//! reports its test accuracy on 'test_ds' next to float accuracy
+//! 'float_error' (ignored if negative). Configuration variables:
+//! quantize_calibration_samples (default 100): number of calibration samples.
+//! \param net The trained network, must be a 'layers' object.
+template <typename T, typename Tdata, typename Tlabel>
+void quantized_test(configuration &conf, module_1_1<T> &net, uint noutputs,
+                    labeled_datasource<T,Tdata,Tlabel> &calib_ds,
+                    labeled_datasource<T,Tdata,Tlabel> &test_ds,
+                    infer_param &infp, double float_error = -1);
+
 //! A function that create/loads a validation set given configuration 'conf'.
 //! \param noutputs The number of outputs will be modified according
 //!   to the loaded dataset.
@@ -130,6 +130,13 @@ void test_and_save(uint iter, configuration &conf, std::string &conffname,
   std::ostringstream progress;
   progress << "retrain_iteration = " << iter + 1 << std::endl
            << "retrain_weights = " << wfname.str() << std::endl;
+  // save training iterators so that a warm-started job can resume training
+  // from the same sample order
+  if (conf.exists_true("save_ds_state")) {
+    std::string dsfname; dsfname << wname.str() << "_ds.mat";
+    train_ds.write_state(dsfname);
+    progress << "retrain_ds_state = " << dsfname << std::endl;
+  }
   if (iteration_seconds > 0)
     progress << "meta_timeout = " << iteration_seconds * 1.2 << std::endl;
   // save progress
@@ -284,6 +291,45 @@ void test(uint iter, configuration &conf, std::string &conffname,
 #endif
 }
 
+// quantized testing ///////////////////////////////////////////////////////////
+
+template <typename T, typename Tdata, typename Tlabel>
+void quantized_test(configuration &conf, module_1_1<T> &net, uint noutputs,
+                    labeled_datasource<T,Tdata,Tlabel> &calib_ds,
+                    labeled_datasource<T,Tdata,Tlabel> &test_ds,
+                    infer_param &infp, double float_error) {
+  layers<T> *lnet = dynamic_cast<layers<T>*>(&net);
+  if (!lnet) eblerror("quantization expects a layers network");
+  timer tq;
+  tq.start();
+  quantized_layers<T> qnet(*lnet, "quantized_net");
+  intg ncalib = conf.try_get_intg("quantize_calibration_samples", 100);
+  std::cout << "Calibrating " << qnet.nquantized() << " quantized modules on "
+            << ncalib << " samples of " << calib_ds.name() << std::endl;
+  qnet.calibrate(calib_ds, ncalib);
+  // test quantized network with the same answering module as the float one
+  answer_module<T,Tdata,Tlabel> *answer =
+      create_answer<T,Tdata,Tlabel>(conf, noutputs);
+  if (!answer) eblerror("no answer module found");
+  trainable_module<T,Tdata,Tlabel> *train =
+      create_trainer<T,Tdata,Tlabel>(conf, qnet, *answer);
+  ddparameter<T> qparam;
+  supervised_trainer<T,Tdata,Tlabel> qtrainer(*train, qparam);
+  classifier_meter qmeter;
+  qmeter.init(noutputs);
+  uint maxtest = conf.exists("max_testing") ? conf.get_uint("max_testing") :0;
+  qtrainer.test(test_ds, qmeter, infp, maxtest);
+  double qerror = qmeter.get_normalized_error();
+  std::cout << "quantized_error=" << qerror << std::endl;
+  if (float_error >= 0)
+    std::cout << "quantized_error_increase=" << qerror - float_error
+              << std::endl;
+  std::cout << "quantized_testing_time="; tq.pretty_elapsed();
+  std::cout << std::endl;
+  delete train;
+  delete answer;
+}
+
 template <typename T, typename Tdata, typename Tlabel>
 labeled_datasource<T,Tdata,Tlabel>*
 create_validation_set(configuration &conf, uint &noutputs,
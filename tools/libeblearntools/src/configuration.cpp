@@ -931,6 +931,15 @@ namespace ebl {
     return confs;
   }
 
+  std::list<std::string> meta_configuration::varied_variables() {
+    std::list<std::string> l;
+    string_list_map_t::iterator lmi = lmap.begin();
+    for ( ; lmi != lmap.end(); ++lmi)
+      if (lmi->second.size() > 1)
+        l.push_back(lmi->first);
+    return l;
+  }
+
   void meta_configuration::pretty() {
     eblprint("__________________ Meta configuration ___________________"
              << std::endl);
@@ -39,6 +39,7 @@
 #include <stdlib.h>
 #include <signal.h>
 #include <iomanip>
+#include <algorithm>
 
 #ifndef __WINDOWS__
 #include <unistd.h>
@@ -64,13 +65,17 @@ using namespace std;
 
 namespace ebl {
 
+//! Seconds a stopped job has to exit before it is killed.
+static const long STOP_TIMEOUT = 10;
+
 ////////////////////////////////////////////////////////////////
 // job
 
 job::job(configuration &conf_, const char *oconffname, bool resume)
 	: conf(conf_), rconf(conf_), _locally_started(false), _started(false),
 		_running(false), _alive(false),
-		pid(-1), resumed_(resume), _finished(false), _progress(-1) {
+		pid(-1), resumed_(resume), _finished(false), _progress(-1),
+		progress_modified(0), _stopped(false), warm_leader(NULL), warm_iter(0) {
 	// the resolved conf
 	rconf.resolve();
 	// resolve conf at user's request (default is unresolved)
@@ -107,6 +112,8 @@ job::job(configuration &conf_, const char *oconffname, bool resume)
 	progress_fname << "/progress";
 	finished_fname = get_root();
 	finished_fname << "/finished";
+	stopped_fname = get_root();
+	stopped_fname << "/stopped";
 
 	//     // check if jobs has been finished in the past based on existing files
 	//     check_finished();
@@ -213,6 +220,10 @@ std::string job::shortname() {
 	return conf.get_string("meta_conf_shortname");
 }
 
+std::string job::get_name() {
+	return rconf.get_name();
+}
+
 std::string job::get_root() {
 	std::string root = rconf.get_output_dir();
 	root << "/" << rconf.get_name();
@@ -248,9 +259,84 @@ int job::progress() const {
 	return _progress;
 }
 
+void job::stop() {
+#ifndef __WINDOWS__
+	if (alive()) {
+		cout << "Stopping job " << get_name() << " (pid " << pid << ")" << endl;
+		// the job runs in its own process group, stop the whole group,
+		// killing it if it does not exit in time
+		kill(-(pid_t) pid, SIGTERM);
+		int status = 0;
+		timer wait;
+		wait.start();
+		while (waitpid((pid_t) pid, &status, WNOHANG) == 0) {
+			if (wait.elapsed_seconds() >= STOP_TIMEOUT) {
+				cerr << "warning: job " << get_name() << " did not exit after "
+						 << STOP_TIMEOUT << " seconds, killing it" << endl;
+				kill(-(pid_t) pid, SIGKILL);
+				waitpid((pid_t) pid, &status, 0);
+				break ;
+			}
+			millisleep(10);
+		}
+	}
+#endif
+	_alive = false;
+	_locally_started = false;
+	_stopped = true;
+	_finished = true;
+	ofstream of(stopped_fname.c_str(), ios_base::app);
+	if (!of)
+		cerr << "warning: failed to create file " << stopped_fname << endl;
+}
+
+void job::resume() {
+	if (!rm_file(stopped_fname.c_str()))
+		cerr << "warning: failed to remove " << stopped_fname << endl;
+	_stopped = false;
+	_finished = false;
+	resumed_ = true;
+}
+
+bool job::stopped() {
+	return _stopped;
+}
+
 ////////////////////////////////////////////////////////////////
 // file-based resuming capabilities
 
+std::string job::get_variable(const std::string &var) {
+	if (!rconf.exists(var)) return "";
+	return rconf.get_string(var);
+}
+
+void job::warm_start(job &leader, uint iter) {
+	warm_leader = &leader;
+	warm_iter = iter;
+	std::ostringstream fname;
+	fname << leader.get_root() << "/" << leader.get_name() << "_net"
+				<< std::setfill('0') << std::setw(5) << iter << ".mat";
+	warm_fname = fname.str();
+	// the leader saves its training set state along with its parameters
+	leader.conf.set("save_ds_state", "1");
+}
+
+bool job::waiting() {
+	// jobs started before (e.g. resumed) continue from their own parameters
+	if (!warm_leader || _started) return false;
+	// the leader's progress is updated after its parameters are fully written
+	warm_leader->check_finished();
+	warm_leader->check_progress();
+	if (!warm_leader->finished() && !(warm_leader->conf.exists("i") &&
+			warm_leader->conf.get_uint("i") > warm_iter))
+		return true;
+	if (!file_exists(warm_fname))
+		cerr << "warning: warm-start parameters " << warm_fname
+				 << " not found, training job " << get_name() << " from scratch"
+				 << endl;
+	return false;
+}
+
 bool job::declare_started() {
 	// create file if not created, but do not discard content (append)
 	ofstream of(progress_fname.c_str(), ios_base::app);
@@ -344,10 +430,18 @@ void job::write_finished(const char *root) {
 }
 
 int job::check_progress() {
+	if (!file_exists(progress_fname)) {
+		progress_modified = 0;
+		return _progress = -1;
+	}
+	// only re-read progress file if it was modified since last read. a file
+	// modified within the last second may still change at the same time stamp.
+	time_t modified = file_modified(progress_fname);
+	if (modified == progress_modified && modified < ::time(NULL) - 1)
+		return _progress;
+	progress_modified = modified;
 	_progress = 0;
-	if (!file_exists(progress_fname))
-		_progress = -1;
-	else if (file_size(progress_fname) > 0) {
+	if (file_size(progress_fname) > 0) {
 		// read progress file as a configuration
 		conf.read(progress_fname.c_str(), false, false, true);
 		// check if progress info is present
@@ -366,6 +460,10 @@ bool job::check_finished() {
 	if (res) {
 		_finished = true;
 		_progress = 100;
+	} else if (file_exists(stopped_fname)) {
+		_finished = true;
+		_stopped = true;
+		res = true;
 	}
 	return res;
 }
@@ -433,6 +531,26 @@ void job::figure_resume_from_weights(const char *dir_) {
 	}
 }
 
+void job::write_warm_start() {
+	if (!warm_leader || conf.exists_true("retrain") || !file_exists(warm_fname))
+		return ;
+	std::string dsfname = warm_fname;
+	dsfname = dsfname.substr(0, dsfname.size() - strlen(".mat")) + "_ds.mat";
+	cout << "Warm-starting job " << get_name() << " from iteration "
+			 << warm_iter << " of job " << warm_leader->get_name() << endl;
+	// set retrain params and rewrite job's conf, so that they are replaced
+	// rather than accumulated each time the job runs
+	std::string iter;
+	iter << warm_iter + 1;
+	conf.set("retrain_iteration", iter.c_str());
+	conf.set("retrain_weights", warm_fname.c_str());
+	if (file_exists(dsfname))
+		conf.set("retrain_ds_state", dsfname.c_str());
+	conf.set("retrain", "1");
+	if (!conf.write(confname.c_str()))
+		eblerror("failed to write warm-start params into conf " << confname);
+}
+
 void job::run_child() {
 #ifndef __WINDOWS__
 	// start timer
@@ -465,6 +583,8 @@ void job::run_child() {
 			of.close();
 		}
 	}
+	// warm-start params
+	write_warm_start();
 	// set classe filename if defined
 	if (rconf.exists("train") || rconf.exists("train_classes")) {
 		std::string classesname = rconf.get_output_dir();
@@ -485,6 +605,10 @@ void job::run_child() {
 
 	cout << endl << "Executing job " << filename(confname.c_str())
 			 << " with cmd:" << endl << cmd << endl;
+	// run in a separate process group so that the scheduler can stop the job
+	// with all its children
+	if (rconf.exists("meta_schedule"))
+		setpgid(0, 0);
 	// execl takes over this process (and its pid)
 	execl("/bin/sh", "sh", "-c", cmd.c_str(), (char*)NULL);
 #else
@@ -503,7 +627,8 @@ job_manager::job_manager() : copy_path(""), max_jobs(limits<int32>::max()),
 														 maxiter(-1), mintime(0.0), maxtime(0.0),
 														 nalive(1), nrunning(0), unstarted(0), finished(0),
 														 unfinished(1),
-														 ready_slots(max_jobs), swait(30) {
+														 ready_slots(max_jobs), swait(30), sched_eta(3),
+														 sched_pause(false) {
 }
 
 job_manager::~job_manager() {
@@ -584,6 +709,11 @@ bool job_manager::read_metaconf(const char *fname, const std::string *tstamp,
 	}
 	if (rmconf.exists("meta_watch_interval"))
 		swait = rmconf.get_uint("meta_watch_interval");
+	init_schedule();
+	// job directories do not hold each job's variables, only warm-start jobs
+	// created from the configuration
+	if (!resume_name || !resumedir)
+		init_warm_start();
 	if (rmconf.exists_bool("meta_send_email")) {
 		if (rmconf.exists("meta_email"))
 			cout << "Using email: " << rmconf.get_string("meta_email") << endl;
@@ -697,6 +827,7 @@ void job_manager::run(bool force_start) {
 	while (nalive || unfinished > 0) {
 		jobs_info();
 		release_dead_children();
+		schedule();
 		// sort jobs based on their progress
 		vector<job*> sjobs = jobs;
 		std::sort(sjobs.begin(), sjobs.end(), job_progress_cmp);
@@ -711,7 +842,7 @@ void job_manager::run(bool force_start) {
 				(*i)->check_running();
 				// run if not finished, not alive/running and slots are available
 				if (!(*i)->finished() && !(*i)->running()
-						&& !(*i)->alive() && ready_slots > 0) {
+						&& !(*i)->alive() && !(*i)->waiting() && ready_slots > 0) {
 					(*i)->run();
 					ready_slots--;
 				}
@@ -878,6 +1009,128 @@ void job_manager::report() {
 	}
 }
 
+void job_manager::init_schedule() {
+	rungs.clear();
+	if (!rmconf.exists("meta_schedule")) return ;
+	std::string type = rmconf.get_string("meta_schedule");
+	if (type == "none") return ;
+	if (type != "asha")
+		eblerror("unknown meta_schedule value: " << type);
+	// variable to minimize
+	if (rmconf.exists("meta_schedule_key"))
+		sched_key = rmconf.get_string("meta_schedule_key");
+	else if (rmconf.exists("meta_minimize"))
+		sched_key = string_to_stringlist(rmconf.get_string("meta_minimize")).front();
+	else eblerror("meta_schedule requires meta_schedule_key or meta_minimize");
+	sched_eta = rmconf.try_get_uint("meta_schedule_eta", 3);
+	if (sched_eta < 2) eblerror("meta_schedule_eta must be at least 2");
+	sched_pause = rmconf.exists_true("meta_schedule_pause");
+	// rungs: min_iter * eta^k below the maximum number of iterations
+	uint min_iter = rmconf.try_get_uint("meta_schedule_min_iter", 1);
+	uint max_iter = 0;
+	if (rmconf.exists("meta_schedule_max_iter"))
+		max_iter = rmconf.get_uint("meta_schedule_max_iter");
+	else if (rmconf.exists("iterations"))
+		max_iter = rmconf.get_uint("iterations");
+	else eblerror("meta_schedule requires meta_schedule_max_iter or iterations");
+	for (uint r = std::max((uint) 1, min_iter); r < max_iter; r *= sched_eta)
+		rungs.push_back(r);
+	rung_results.assign(rungs.size(), std::map<uint,double>());
+	promoted_at.assign(rungs.size(), std::set<uint>());
+	job_rungs.assign(jobs.size(), -1);
+	cout << "Successive halving: keeping best 1/" << sched_eta << " of jobs on \""
+			 << sched_key << "\" at iterations " << rungs << ", "
+			 << (sched_pause ? "pausing" : "stopping") << " others." << endl;
+}
+
+void job_manager::schedule() {
+	if (rungs.empty()) return ;
+	parser.parse_logs(rmconf, rmconf.get_output_dir());
+	job_rungs.resize(jobs.size(), -1);
+	// record results of jobs that reached new rungs
+	for (uint j = 0; j < jobs.size(); ++j) {
+		for (uint k = job_rungs[j] + 1; k < rungs.size(); ++k) {
+			double v;
+			if (!parser.get_value(jobs[j]->get_name(), rungs[k], sched_key, v))
+				break ;
+			rung_results[k][j] = v;
+			job_rungs[j] = k;
+		}
+	}
+	for (uint k = 0; k < rungs.size(); ++k)
+		promote(k);
+	// stop jobs that were not promoted at their last rung, resume paused jobs
+	// that are now promoted
+	for (uint j = 0; j < jobs.size(); ++j) {
+		job &jb = *jobs[j];
+		if (job_rungs[j] < 0) continue ;
+		bool promote = promoted_at[job_rungs[j]].count(j) > 0;
+		if (!promote && !jb.finished()) {
+			bool alive = jb.alive();
+			jb.stop();
+			if (alive) ready_slots++;
+		} else if (promote && jb.stopped() && sched_pause && ready_slots > 0) {
+			cout << "Resuming promoted job " << jb.get_name() << endl;
+			jb.resume();
+			jb.run();
+			ready_slots--;
+		}
+	}
+}
+
+void job_manager::promote(uint k) {
+	std::map<uint,double> &res = rung_results[k];
+	std::set<uint> &prom = promoted_at[k];
+	uint n = res.size();
+	// number of jobs allowed past rung k so far, all of them until there are
+	// enough results to compare
+	uint quota = n < sched_eta ? n : (n + sched_eta - 1) / sched_eta;
+	if (prom.size() >= quota) return ;
+	// rank jobs still waiting at rung k, ties broken by job order
+	std::vector<std::pair<double,uint> > waiting;
+	for (std::map<uint,double>::iterator i = res.begin(); i != res.end(); ++i)
+		if (prom.find(i->first) == prom.end()
+				&& (sched_pause || !jobs[i->first]->stopped()))
+			waiting.push_back(std::make_pair(i->second, i->first));
+	std::sort(waiting.begin(), waiting.end());
+	for (uint i = 0; i < waiting.size() && prom.size() < quota; ++i)
+		prom.insert(waiting[i].second);
+}
+
+void job_manager::init_warm_start() {
+	if (!rmconf.exists("meta_warm_vars")) return ;
+	if (!rmconf.exists("meta_warm_iter"))
+		eblerror("meta_warm_vars requires meta_warm_iter");
+	uint iter = rmconf.get_uint("meta_warm_iter");
+	std::list<std::string> warm =
+		string_to_stringlist(rmconf.get_string("meta_warm_vars"));
+	std::list<std::string> vars = mconf.varied_variables();
+	std::list<std::string>::iterator v;
+	for (v = warm.begin(); v != warm.end(); ++v)
+		if (std::find(vars.begin(), vars.end(), *v) == vars.end())
+			cerr << "warning: warm-start variable " << *v
+					 << " does not vary across jobs" << endl;
+	// group jobs by the values of varying variables that are not warm
+	std::map<std::string,uint> leaders;
+	uint nwarm = 0;
+	for (uint j = 0; j < jobs.size(); ++j) {
+		std::string key;
+		for (v = vars.begin(); v != vars.end(); ++v)
+			if (std::find(warm.begin(), warm.end(), *v) == warm.end())
+				key << *v << "=" << jobs[j]->get_variable(*v) << " ";
+		std::map<std::string,uint>::iterator l = leaders.find(key);
+		if (l == leaders.end())
+			leaders[key] = j;
+		else {
+			jobs[j]->warm_start(*jobs[l->second], iter);
+			nwarm++;
+		}
+	}
+	cout << "Warm start: " << nwarm << " jobs start from iteration " << iter
+			 << " of " << leaders.size() << " leading jobs (varying "
+			 << rmconf.get_string("meta_warm_vars") << ")." << endl;
+}
+
 void job_manager::last_report() {
 	cout << "All processes are finished. Exiting." << endl;
 	// email last results before exiting
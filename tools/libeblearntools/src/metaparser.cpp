@@ -553,10 +553,14 @@ map<uint,pairtree>& pairtree::get_subtree() {
 	return subtree;
 }
 
+map<uint,uint>& pairtree::get_vars() {
+	return vars;
+}
+
 ////////////////////////////////////////////////////////////////
 // metaparser
 
-metaparser::metaparser() : separator(VALUE_SEPARATOR) {
+metaparser::metaparser() : separator(VALUE_SEPARATOR), rebuild(false) {
 	hierarchy.push_back(pairtree::get_var_id("job"));
 	hierarchy.push_back(pairtree::get_var_id("i"));
 }
@@ -564,7 +568,32 @@ metaparser::metaparser() : separator(VALUE_SEPARATOR) {
 metaparser::~metaparser() {
 }
 
-bool metaparser::parse_log(const std::string &fname,
+metaparser::log_state::log_state() : offset(0) {
+}
+
+//! Number of bytes at the start and at the end of the parsed part of a log
+//! that are compared to detect a rewritten log.
+static const std::streamoff LOG_MARK_SIZE = 64;
+
+//! Return at most 'n' bytes of 'in' starting at position 'pos'.
+static std::string read_bytes(std::istream &in, std::streamoff pos,
+															std::streamoff n) {
+	std::string s((size_t) n, '\0');
+	in.clear();
+	in.seekg(pos);
+	in.read(&s[0], n);
+	s.resize((size_t) in.gcount());
+	in.clear();
+	return s;
+}
+
+void metaparser::clear() {
+	tree = pairtree();
+	logs.clear();
+	rebuild = false;
+}
+
+bool metaparser::parse_log(const std::string &fname, log_state &st,
 													 std::list<std::string> *sticky,
 													 std::list<std::string> *watch) {
 	ifstream in(fname.c_str());
@@ -572,7 +601,7 @@ bool metaparser::parse_log(const std::string &fname,
 	uint varid, valid;
 	char separator = VALUE_SEPARATOR;
 	std::string::size_type itok, stok;
-	map<uint,uint> vars, stick;
+	map<uint,uint> vars;
 	std::list<uint> usticky;
 	std::list<uint> uwatch;
 	if (sticky) usticky = pairtree::to_varid_list(*sticky);
@@ -582,16 +611,33 @@ bool metaparser::parse_log(const std::string &fname,
 		cerr << "warning: failed to open " << fname << endl;
 		return false;
 	}
-	// parse all lines
-	while (!in.eof()) {
+	// check for new data
+	in.seekg(0, ios::end);
+	std::streamoff size = in.tellg();
+	// the log was truncated or rewritten if it shrank or if the bytes
+	// already parsed changed, start over
+	if (size < st.offset || read_bytes(in, 0, st.head.size()) != st.head
+			|| read_bytes(in, st.offset - st.tail.size(), st.tail.size())
+			!= st.tail) {
+		st = log_state();
+		rebuild = true;
+	}
+	if (size == st.offset)
+		return true; // nothing new
+#ifdef __DEBUG__
+	cout << "Parsing " << fname << endl;
+#endif
+	in.clear();
+	in.seekg(st.offset);
+	// parse all new complete lines
+	while (getline(in, s) && !in.eof()) {
+		st.offset = in.tellg();
 		// extract all variables for this line
-		getline(in, s);
-		istringstream iss(s, istringstream::in);
 		vars.clear(); // clear previous variables
 		// keep sticky variables from previous lines in this new line
 		// hierarchy keys are sticky by default, and additional sticky
 		// variables are defined by 'sticky' list.
-		vars.insert(stick.begin(), stick.end());
+		vars.insert(st.stick.begin(), st.stick.end());
 		// loop over variable/value pairs
 		itok = s.find(separator);
 		while (itok != std::string::npos) { // get remaining values
@@ -604,23 +650,31 @@ bool metaparser::parse_log(const std::string &fname,
 			s = s.substr(stok);
 			itok = s.find(separator);
 			varid = pairtree::get_var_id(var);
-			// if not in watch list, ignore
+			// if not in watch list, ignore (hierarchy keys are always kept)
 			if (watch && watch->size()
-					&& find(uwatch.begin(), uwatch.end(), varid) == uwatch.end())
+					&& find(uwatch.begin(), uwatch.end(), varid) == uwatch.end()
+					&& find(hierarchy.begin(), hierarchy.end(), varid)
+					== hierarchy.end())
 				continue ;
 			// remember var/val
 			valid = pairtree::get_val_id(val);
 			vars[varid] = valid;
 			// if a key, make it sticky
 			if (find(hierarchy.begin(), hierarchy.end(), varid) != hierarchy.end())
-				stick[varid] = valid;
+				st.stick[varid] = valid;
 			// if sticky, remember value
 			if (sticky && find(usticky.begin(), usticky.end(), varid) != usticky.end())
-				stick[varid] = valid;
+				st.stick[varid] = valid;
 		}
-		// add variables to tree, and remember the path to the leaf
+		// add variables to index and tree
+		st.records.push_back(vars);
 		tree.add(hierarchy, vars);
 	}
+	// remember the start and the end of the parsed bytes
+	st.head = read_bytes(in, 0, std::min(st.offset, LOG_MARK_SIZE));
+	st.tail = read_bytes(in, std::max(st.offset - LOG_MARK_SIZE,
+																		(std::streamoff) 0),
+											 std::min(st.offset, LOG_MARK_SIZE));
 	in.close();
 #ifdef __DEBUG__
 	tree.pretty();
@@ -628,6 +682,27 @@ bool metaparser::parse_log(const std::string &fname,
 	return true;
 }
 
+void metaparser::get_sticky_watch(configuration &conf,
+																	std::list<std::string> &sticky,
+																	std::list<std::string> &watch) {
+	// get list of sticky variables
+	if (conf.exists("meta_sticky_vars"))
+		sticky = string_to_stringlist(conf.get_string("meta_sticky_vars"));
+	// get list of variables to watch for
+	if (conf.exists("meta_watch_vars"))
+		watch = string_to_stringlist(conf.get_string("meta_watch_vars"));
+	// default sticky list
+	sticky.push_back("meta_conf_variables");
+	// an empty watch list means all variables are kept, only extend it
+	// with the variables we depend on when it was restricted by the user.
+	if (watch.empty()) return ;
+	for (list<string>::iterator i = sticky.begin(); i != sticky.end(); ++i)
+		watch.push_back(*i);
+	// the scheduler needs its key
+	if (conf.exists("meta_schedule_key"))
+		watch.push_back(conf.get_string("meta_schedule_key"));
+}
+
 int metaparser::get_max_iter() {
 	if (!tree.exists("i"))
 		return -1;
@@ -637,17 +712,7 @@ int metaparser::get_max_iter() {
 int metaparser::get_max_common_iter(configuration &conf,
 																		const std::string &dir) {
 	std::list<std::string> sticky, watch;
-	// get list of sticky variables
-	if (conf.exists("meta_sticky_vars")) {
-		sticky = string_to_stringlist(conf.get_string("meta_sticky_vars"));
-		//cout << "Sticky variables: " << stringlist_to_string(sticky) << endl;
-	}
-	// get list of variables to watch for
-	if (conf.exists("meta_watch_vars")) {
-		watch = string_to_stringlist(conf.get_string("meta_watch_vars"));
-		//cout << "Variables to watch (ignoring others): "
-		//<< stringlist_to_string(watch) << endl;
-	}
+	get_sticky_watch(conf, sticky, watch);
 	parse_logs(dir, &sticky, &watch);
 	return get_max_common_iter();
 }
@@ -924,15 +989,56 @@ void metaparser::write_plots(configuration &conf, const char *dir,
 
 void metaparser::parse_logs(const std::string &root, std::list<std::string> *sticky,
 														std::list<std::string> *watch) {
+	std::list<std::string> lsticky, lwatch;
+	if (sticky) lsticky = *sticky;
+	if (watch) lwatch = *watch;
+	// previous results were extracted differently, start over
+	if (lsticky != logs_sticky || lwatch != logs_watch) {
+		clear();
+		logs_sticky = lsticky;
+		logs_watch = lwatch;
+	}
 	cout << "Parsing all .log files recursively..." << endl;
 	std::list<std::string> *fl = find_fullfiles(root, ".*[.]log");
 	if (fl) {
-		for (std::list<std::string>::iterator i = fl->begin(); i != fl->end(); ++i) {
-			cout << "Parsing " << *i << endl;
-			parse_log(*i, sticky, watch);
-		}
+		for (std::list<std::string>::iterator i = fl->begin(); i != fl->end(); ++i)
+			parse_log(*i, logs[*i], sticky, watch);
 		delete fl;
 	}
+	// some logs were reset, rebuild tree from the records of all logs
+	if (rebuild) {
+		tree = pairtree();
+		for (map<std::string,log_state>::iterator i = logs.begin();
+				 i != logs.end(); ++i)
+			for (varmaplist::iterator j = i->second.records.begin();
+					 j != i->second.records.end(); ++j)
+				tree.add(hierarchy, *j);
+		rebuild = false;
+	}
+}
+
+void metaparser::parse_logs(configuration &conf, const std::string &root) {
+	std::list<std::string> sticky, watch;
+	get_sticky_watch(conf, sticky, watch);
+	parse_logs(root, &sticky, &watch);
+}
+
+bool metaparser::get_value(const std::string &job, uint iter,
+													 const std::string &key, double &val) {
+	// assuming that "job" is first level and "i" second one
+	t_subtree &jobs = tree.get_subtree();
+	t_subtree::iterator j = jobs.find(pairtree::get_val_id(job));
+	if (j == jobs.end()) return false;
+	std::string si;
+	si << iter;
+	t_subtree &iters = j->second.get_subtree();
+	t_subtree::iterator i = iters.find(pairtree::get_val_id(si));
+	if (i == iters.end()) return false;
+	map<uint,uint> &vars = i->second.get_vars();
+	map<uint,uint>::iterator v = vars.find(pairtree::get_var_id(key));
+	if (v == vars.end()) return false;
+	val = string_to_double(pairtree::get_val(v->second));
+	return true;
 }
 
 varmaplist metaparser::analyze(configuration &conf, const std::string &dir,
@@ -942,19 +1048,9 @@ varmaplist metaparser::analyze(configuration &conf, const std::string &dir,
 															 varmaplist *best_common) {
 	std::list<std::string> sticky, watch, keycomb;
 	varmaplist best;
-	// get list of sticky variables
-	if (conf.exists("meta_sticky_vars"))
-		sticky = string_to_stringlist(conf.get_string("meta_sticky_vars"));
-	// get list of variables to watch for
-	if (conf.exists("meta_watch_vars"))
-		watch = string_to_stringlist(conf.get_string("meta_watch_vars"));
-	// default sticky list
-	sticky.push_back("meta_conf_variables");
-	// default watch list
+	get_sticky_watch(conf, sticky, watch);
 	std::string job = "job";
 	if (conf.exists("meta_job_var")) job = conf.get_string("meta_job_var");
-	for (list<string>::iterator i = sticky.begin(); i != sticky.end(); ++i)
-		watch.push_back(*i);
 	cout << "Sticky variables: " << stringlist_to_string(sticky) << endl;
 	cout << "Variables to watch (ignoring others): "
 			 << stringlist_to_string(watch) << endl;
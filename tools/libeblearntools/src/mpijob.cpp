@@ -288,8 +288,9 @@ namespace ebl {
 	jobs[i]->check_finished();
 	jobs[i]->check_started();
 	jobs[i]->check_running();
-	// start job if not finished and not alive
-	if (!jobs[i]->finished() && !jobs[i]->running()) {
+	// start job if not finished, not alive and not waiting for warm-start
+	if (!jobs[i]->finished() && !jobs[i]->running()
+	    && !jobs[i]->waiting()) {
 	  // check if master can run this job
 	  if (use_master && running[0] == -1) {
 	    cout << prefix << "slot 0 is free" << endl;
@@ -318,6 +319,7 @@ namespace ebl {
       }
       jobs_info();
       jinfos(running);
+      schedule();
       secsleep(swait);
       report();
     }
@@ -331,6 +333,15 @@ namespace ebl {
 #endif
   }
 
+  void mpijob_manager::init_schedule() {
+    job_manager::init_schedule();
+    if (sched_pause) {
+      eblwarn("meta_schedule_pause is not supported with MPI, stopping jobs "
+	      << "instead");
+      sched_pause = false;
+    }
+  }
+
   void mpijob_manager::stop_all() {
 #ifdef __MPI__
     cout << "master: ordering all slaves to stop." << endl;
@@ -349,6 +360,8 @@ namespace ebl {
     std::string prefix = "master: ";
     cout << prefix << "assigning job " << jobid << " to slot " << slave_id
 	 << endl;
+    // jobs are rebuilt from their conf file, which must hold warm-start params
+    if (!jobs[jobid]->started()) jobs[jobid]->write_warm_start();
     if (slave_id == 0) { // master
       if (id_running != -1) eblerror("already running job " << id_running);
       id_running = jobid;
@@ -0,0 +1,268 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+
+#include <stdio.h>
+#include <string.h>
+#ifndef __WINDOWS__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#include "netbundle.h"
+
+namespace ebl {
+
+// mapped_file /////////////////////////////////////////////////////////////////
+
+mapped_file::mapped_file(const char *filename)
+    : ptr(NULL), len(0), mapped(false) {
+#ifndef __WINDOWS__
+  int fd = open(filename, O_RDONLY);
+  if (fd < 0) eblthrow("failed to open " << filename);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    eblthrow("failed to stat " << filename);
+  }
+  len = (size_t) st.st_size;
+  if (len > 0) {
+    // copy-on-write: mapped weights may be modified by their users
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      ptr = (char*) p;
+      mapped = true;
+    }
+  }
+  close(fd);
+  if (mapped || len == 0) return ;
+#endif
+  // fall back on reading the whole file at once
+  FILE *fp = fopen(filename, "rb");
+  if (!fp) eblthrow("failed to open " << filename);
+  fseek(fp, 0, SEEK_END);
+  len = (size_t) ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  buffer.resize(len > 0 ? len : 1);
+  if (len > 0 && fread(&buffer[0], 1, len, fp) != len) {
+    fclose(fp);
+    eblthrow("failed to read " << filename);
+  }
+  fclose(fp);
+  ptr = &buffer[0];
+}
+
+mapped_file::~mapped_file() {
+#ifndef __WINDOWS__
+  if (mapped) munmap((void*) ptr, len);
+#endif
+}
+
+const char* mapped_file::data() const {
+  return ptr;
+}
+
+char* mapped_file::data() {
+  return ptr;
+}
+
+size_t mapped_file::size() const {
+  return len;
+}
+
+// netbundle header ////////////////////////////////////////////////////////////
+
+netbundle_header::netbundle_header()
+    : weights_magic(0), nweights(0), offset(0) {
+}
+
+bool is_netbundle(const char *filename) {
+  FILE *fp = fopen(filename, "rb");
+  if (!fp) return false;
+  int magic = 0;
+  bool ret = fread(&magic, sizeof (int), 1, fp) == 1
+      && magic == MAGIC_NETBUNDLE;
+  fclose(fp);
+  return ret;
+}
+
+// writing helpers
+static void bundle_write(FILE *fp, const void *data, size_t n) {
+  if (n > 0 && fwrite(data, 1, n, fp) != n)
+    eblthrow("failed to write network bundle");
+}
+
+static void bundle_write_int(FILE *fp, int v) {
+  bundle_write(fp, &v, sizeof (int));
+}
+
+static void bundle_write_string(FILE *fp, const std::string &s) {
+  bundle_write_int(fp, (int) s.size());
+  bundle_write(fp, s.c_str(), s.size());
+}
+
+static void bundle_write_idxdim(FILE *fp, const idxdim &d) {
+  bundle_write_int(fp, d.order());
+  for (intg i = 0; i < d.order(); ++i)
+    bundle_write_int(fp, (int) d.dim(i));
+}
+
+void write_netbundle_header(FILE *fp, netbundle_header &h) {
+  bundle_write_int(fp, MAGIC_NETBUNDLE);
+  bundle_write_int(fp, NETBUNDLE_VERSION);
+  bundle_write_int(fp, h.weights_magic);
+  bundle_write(fp, &h.nweights, sizeof (int64));
+  bundle_write_string(fp, h.name);
+  // configuration
+  bundle_write_int(fp, (int) h.vars.size());
+  for (string_map_t::iterator i = h.vars.begin(); i != h.vars.end(); ++i) {
+    bundle_write_string(fp, i->first);
+    bundle_write_string(fp, i->second);
+  }
+  // classes
+  if (h.classes.order() == 2) {
+    idx<ubyte> c = h.classes;
+    if (!c.contiguousp()) c = idx_copy(c);
+    bundle_write_idxdim(fp, c.get_idxdim());
+    bundle_write(fp, c.idx_ptr(), c.nelements());
+  } else
+    bundle_write_idxdim(fp, idxdim());
+  // scales geometry
+  bundle_write_idxdim(fp, h.netdim);
+  if (h.indims.size() != h.scales.size())
+    eblerror("expected as many input sizes as scales but got "
+             << h.indims.size() << " and " << h.scales.size());
+  bundle_write_int(fp, (int) h.indims.size());
+  for (uint i = 0; i < h.indims.size(); ++i) {
+    bundle_write_idxdim(fp, h.indims[i]);
+    bundle_write_int(fp, (int) h.scales[i].size());
+    for (uint j = 0; j < h.scales[i].size(); ++j)
+      bundle_write_idxdim(fp, h.scales[i][j]);
+  }
+  // pad so that weights are aligned
+  long pos = ftell(fp);
+  char pad[NETBUNDLE_ALIGN];
+  memset(pad, 0, NETBUNDLE_ALIGN);
+  bundle_write(fp, pad, (NETBUNDLE_ALIGN - pos % NETBUNDLE_ALIGN)
+               % NETBUNDLE_ALIGN);
+  h.offset = (size_t) ftell(fp);
+}
+
+// reading helpers: a bounds-checked cursor over the mapped file
+class bundle_cursor {
+ public:
+  bundle_cursor(const mapped_file &f) : f(f), pos(0) {}
+  const char* read(size_t n) {
+    if (n > f.size() - pos)
+      eblthrow("truncated network bundle (expected " << n
+               << " more bytes at offset " << pos << ")");
+    const char *p = f.data() + pos;
+    pos += n;
+    return p;
+  }
+  int read_int() {
+    int v;
+    memcpy(&v, read(sizeof (int)), sizeof (int));
+    return v;
+  }
+  std::string read_string() {
+    int n = read_int();
+    if (n < 0) eblthrow("corrupted network bundle string length: " << n);
+    return std::string(read(n), n);
+  }
+  idxdim read_idxdim() {
+    idxdim d;
+    int order = read_int();
+    if (order < 0 || order > MAXDIMS)
+      eblthrow("corrupted network bundle dimensions order: " << order);
+    for (int i = 0; i < order; ++i)
+      d.insert_dim(i, read_int());
+    return d;
+  }
+ public:
+  const mapped_file &f;
+  size_t pos;
+};
+
+void read_netbundle_header(const mapped_file &f, netbundle_header &h) {
+  bundle_cursor c(f);
+  if (c.read_int() != MAGIC_NETBUNDLE)
+    eblthrow("not a network bundle (unknown magic number)");
+  int version = c.read_int();
+  if (version != NETBUNDLE_VERSION)
+    eblthrow("unsupported network bundle version " << version
+             << " (expected " << NETBUNDLE_VERSION << ")");
+  h.weights_magic = c.read_int();
+  memcpy(&h.nweights, c.read(sizeof (int64)), sizeof (int64));
+  h.name = c.read_string();
+  // configuration
+  int nvars = c.read_int();
+  h.vars.clear();
+  for (int i = 0; i < nvars; ++i) {
+    std::string name = c.read_string();
+    h.vars[name] = c.read_string();
+  }
+  // classes
+  idxdim dclasses = c.read_idxdim();
+  if (dclasses.order() > 0) {
+    h.classes = idx<ubyte>(dclasses);
+    memcpy(h.classes.idx_ptr(), c.read(dclasses.nelements()),
+           dclasses.nelements());
+  }
+  // scales geometry
+  h.netdim = c.read_idxdim();
+  int nsizes = c.read_int();
+  h.indims.clear();
+  h.scales.clear();
+  for (int i = 0; i < nsizes; ++i) {
+    h.indims.push_back(c.read_idxdim());
+    h.scales.push_back(midxdim());
+    int nscales = c.read_int();
+    for (int j = 0; j < nscales; ++j)
+      h.scales.back().push_back_new(c.read_idxdim());
+  }
+  // weights
+  c.read((NETBUNDLE_ALIGN - c.pos % NETBUNDLE_ALIGN) % NETBUNDLE_ALIGN);
+  h.offset = c.pos;
+  size_t wsize = 0;
+  switch (h.weights_magic) {
+    case MAGIC_FLOAT_MATRIX: wsize = sizeof (float); break ;
+    case MAGIC_DOUBLE_MATRIX: wsize = sizeof (double); break ;
+    default: eblthrow("unsupported network bundle weights type "
+                      << get_magic_str(h.weights_magic));
+  }
+  if (h.nweights < 0) eblthrow("corrupted network bundle weights count");
+  c.read((size_t) h.nweights * wsize);
+}
+
+} // namespace ebl
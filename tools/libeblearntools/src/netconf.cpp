@@ -101,4 +101,23 @@ namespace ebl {
     eblprint(gdp << std::endl);
   }
 
+  void profile_init(configuration &conf) {
+    if (!conf.exists_true("profile")) return ;
+    profiler::global().clear();
+    profiler::global().enable();
+    eblprint("Profiling fprop/bprop/bbprop of each module" << std::endl);
+  }
+
+  void profile_report(configuration &conf) {
+    if (!profiler::enabled()) return ;
+    profiler::global().report(std::cout);
+    if (conf.exists("profile_json")) {
+      std::string fname = conf.get_string("profile_json");
+      if (profiler::global().save_json(fname))
+	eblprint("Saved profile to " << fname << std::endl);
+      else
+	eblwarn("failed to save profile to " << fname);
+    }
+  }
+
 } /* namespace ebl */
@@ -33,6 +33,10 @@
 #include "pascal_xml.h"
 #include "tools_utils.h"
 
+#ifndef __WINDOWS__
+#include <sys/stat.h>
+#endif
+
 #ifdef __BOOST__
 #define BOOST_FILESYSTEM_VERSION 3
 #include "boost/filesystem.hpp"
@@ -378,4 +382,381 @@ namespace ebl {
 
 #endif /* __XML__ */
 
+  // pascal_annotation /////////////////////////////////////////////////////////
+
+  pascal_annotation::pascal_annotation()
+    : modified(0), size(0), valid(false), height(-1), width(-1), depth(-1),
+      cropr(NULL) {
+  }
+
+  //! Deletes object 'o' and its parts.
+  static void delete_object(object *o) {
+    for (uint i = 0; i < o->parts.size(); ++i) delete_object(o->parts[i]);
+    delete o;
+  }
+
+  pascal_annotation::~pascal_annotation() {
+    for (uint i = 0; i < objs.size(); ++i) delete_object(objs[i]);
+    if (cropr) delete cropr;
+  }
+
+  //! Returns a new copy of object 'o' and of its parts.
+  static object *copy_object(const object &o) {
+    object *c = new object(o.id);
+    static_cast<rect<int>&>(*c) = o;
+    if (o.visible) c->visible = new rect<int>(*o.visible);
+    if (o.centroid) c->centroid = new std::pair<int,int>(*o.centroid);
+    c->name = o.name;
+    c->difficult = o.difficult;
+    c->truncated = o.truncated;
+    c->occluded = o.occluded;
+    c->pose = o.pose;
+    c->ignored = o.ignored;
+    for (uint i = 0; i < o.parts.size(); ++i)
+      c->parts.push_back(copy_object(*o.parts[i]));
+    return c;
+  }
+
+  void pascal_annotation::copy_objects(vector<object*> &v) const {
+    for (uint i = 0; i < objs.size(); ++i)
+      v.push_back(copy_object(*objs[i]));
+  }
+
+  // pascal_index binary format ////////////////////////////////////////////////
+
+#define PASCAL_INDEX_MAGIC "EBLPASCALIDX"
+#define PASCAL_INDEX_VERSION 2
+
+  // object flags
+#define PASCAL_IDX_DIFFICULT 1
+#define PASCAL_IDX_TRUNCATED 2
+#define PASCAL_IDX_OCCLUDED 4
+#define PASCAL_IDX_VISIBLE 8
+#define PASCAL_IDX_CENTROID 16
+
+  static void write_int(FILE *fp, int v) {
+    fwrite(&v, sizeof (int), 1, fp);
+  }
+
+  static void write_string(FILE *fp, const std::string &s) {
+    write_int(fp, (int) s.size());
+    if (s.size() > 0) fwrite(s.c_str(), 1, s.size(), fp);
+  }
+
+  static void write_rect(FILE *fp, const rect<int> &r) {
+    int v[4] = { r.h0, r.w0, (int) r.height, (int) r.width };
+    fwrite(v, sizeof (int), 4, fp);
+  }
+
+  static void write_object(FILE *fp, const object &o) {
+    int flags = (o.difficult ? PASCAL_IDX_DIFFICULT : 0)
+      | (o.truncated ? PASCAL_IDX_TRUNCATED : 0)
+      | (o.occluded ? PASCAL_IDX_OCCLUDED : 0)
+      | (o.visible ? PASCAL_IDX_VISIBLE : 0)
+      | (o.centroid ? PASCAL_IDX_CENTROID : 0);
+    write_int(fp, (int) o.id);
+    write_int(fp, flags);
+    write_rect(fp, o);
+    if (o.visible) write_rect(fp, *o.visible);
+    if (o.centroid) {
+      write_int(fp, o.centroid->first);
+      write_int(fp, o.centroid->second);
+    }
+    write_string(fp, o.name);
+    write_string(fp, o.pose);
+    write_int(fp, (int) o.parts.size());
+    for (uint i = 0; i < o.parts.size(); ++i)
+      write_object(fp, *o.parts[i]);
+  }
+
+  static bool read_int(FILE *fp, int &v) {
+    return fread(&v, sizeof (int), 1, fp) == 1;
+  }
+
+  static bool read_string(FILE *fp, std::string &s) {
+    int n;
+    if (!read_int(fp, n) || n < 0) return false;
+    s.resize(n);
+    return n == 0 || fread(&s[0], 1, n, fp) == (size_t) n;
+  }
+
+  static bool read_rect(FILE *fp, rect<int> &r) {
+    int v[4];
+    if (fread(v, sizeof (int), 4, fp) != 4) return false;
+    r = rect<int>(v[0], v[1], v[2], v[3]);
+    return true;
+  }
+
+  //! Returns a new object read from 'fp', or NULL upon failure.
+  static object *read_object(FILE *fp) {
+    int id, flags, n;
+    if (!read_int(fp, id) || !read_int(fp, flags)) return NULL;
+    object *o = new object(id);
+    o->ignored = false;
+    bool ok = read_rect(fp, *o);
+    o->difficult = (flags & PASCAL_IDX_DIFFICULT) ? 1 : 0;
+    o->truncated = (flags & PASCAL_IDX_TRUNCATED) ? 1 : 0;
+    o->occluded = (flags & PASCAL_IDX_OCCLUDED) ? 1 : 0;
+    if (ok && (flags & PASCAL_IDX_VISIBLE)) {
+      o->visible = new rect<int>();
+      ok = read_rect(fp, *o->visible);
+    }
+    if (ok && (flags & PASCAL_IDX_CENTROID)) {
+      int h, w;
+      ok = read_int(fp, h) && read_int(fp, w);
+      if (ok) o->centroid = new std::pair<int,int>(h, w);
+    }
+    ok = ok && read_string(fp, o->name) && read_string(fp, o->pose)
+      && read_int(fp, n) && n >= 0;
+    for (int i = 0; ok && i < n; ++i) {
+      object *p = read_object(fp);
+      if (p) o->parts.push_back(p);
+      else ok = false;
+    }
+    if (!ok) {
+      delete_object(o);
+      return NULL;
+    }
+    return o;
+  }
+
+  // pascal_index //////////////////////////////////////////////////////////////
+
+  //! Returns the modification time of 'fname' in nanoseconds, so that edits
+  //! within the same second are detected where the system records them.
+  static int64 modified_ns(const std::string &fname) {
+#ifndef __WINDOWS__
+    struct stat buf;
+    if (stat(fname.c_str(), &buf) == -1)
+      return 0; // file not found
+#ifdef __MAC__
+    return (int64) buf.st_mtimespec.tv_sec * 1000000000
+      + buf.st_mtimespec.tv_nsec;
+#else
+    return (int64) buf.st_mtim.tv_sec * 1000000000 + buf.st_mtim.tv_nsec;
+#endif
+#else /* WINDOWS */
+    return (int64) file_modified(fname) * 1000000000;
+#endif
+  }
+
+  pascal_index::pascal_index() : nparsed(0) {
+  }
+
+  pascal_index::~pascal_index() {
+    clear();
+  }
+
+  uint pascal_index::load(const std::string &annroot,
+			  const std::string &cache) {
+    clear();
+    nparsed = 0;
+    // find all xml files recursively
+    std::list<std::string> *files =
+      find_fullfiles(annroot, XML_PATTERN, NULL, true, true);
+    if (!files || files->size() == 0) {
+      if (files) delete files;
+      return 0;
+    }
+    // read previously cached annotations
+    std::map<std::string,pascal_annotation*> cached;
+    if (!cache.empty() && file_exists(cache))
+      if (!read(cache, cached))
+	cerr << "warning: ignoring invalid annotation cache " << cache << endl;
+    for (std::list<std::string>::iterator i = files->begin();
+	 i != files->end(); ++i) {
+      pascal_annotation *a = NULL;
+      std::map<std::string,pascal_annotation*>::iterator c = cached.find(*i);
+      if (c != cached.end()) {
+	// use cached annotation only if file is unchanged
+	if (c->second->modified == modified_ns(*i)
+	    && c->second->size == file_size(*i))
+	  a = c->second;
+	else
+	  delete c->second;
+	cached.erase(c);
+      }
+      if (!a) {
+	a = parse(*i);
+	nparsed++;
+      }
+      positions[*i] = anns.size();
+      anns.push_back(a);
+    }
+    delete files;
+    // delete annotations of files that disappeared
+    bool removed = !cached.empty();
+    for (std::map<std::string,pascal_annotation*>::iterator c = cached.begin();
+	 c != cached.end(); ++c)
+      delete c->second;
+    cout << "Indexed " << anns.size() << " xml files (" << nparsed
+	 << " parsed, " << anns.size() - nparsed << " from cache)." << endl;
+    // update cache
+    if (!cache.empty() && (nparsed > 0 || removed)) {
+      if (write(cache))
+	cout << "Saved annotation cache to " << cache << endl;
+      else
+	cerr << "warning: failed to save annotation cache to " << cache << endl;
+    }
+    return anns.size();
+  }
+
+  uint pascal_index::size() const {
+    return anns.size();
+  }
+
+  uint pascal_index::parsed() const {
+    return nparsed;
+  }
+
+  const pascal_annotation &pascal_index::get(uint i) const {
+    if (i >= anns.size())
+      eblerror("trying to access annotation " << i << " out of "
+	       << anns.size());
+    return *anns[i];
+  }
+
+  const pascal_annotation *pascal_index::find(const std::string &xmlfile)
+    const {
+    std::map<std::string,uint>::const_iterator i = positions.find(xmlfile);
+    if (i == positions.end()) return NULL;
+    return anns[i->second];
+  }
+
+  bool pascal_index::get_properties(const std::string &imgroot,
+				    const std::string &xmlfile,
+				    std::string &image_filename,
+				    std::string &image_fullname,
+				    std::string &folder,
+				    int &height, int &width, int &depth,
+				    vector<object*> &objs,
+				    rect<int> **cropr) const {
+    const pascal_annotation *a = find(xmlfile);
+    if (!a) // not indexed, parse xml file directly
+      return pascal_xml::get_properties(imgroot, xmlfile, image_filename,
+					image_fullname, folder, height, width,
+					depth, objs, cropr, false);
+    if (!a->valid) return false;
+    image_filename = a->image_filename;
+    folder = a->folder;
+    image_fullname = imgroot;
+    if (!folder.empty())
+      image_fullname << "/" << folder << "/";
+    image_fullname << image_filename;
+    if (a->height >= 0) height = a->height;
+    if (a->width >= 0) width = a->width;
+    if (a->depth >= 0) depth = a->depth;
+    if (cropr && a->cropr) *cropr = new rect<int>(*a->cropr);
+    a->copy_objects(objs);
+    return true;
+  }
+
+  void pascal_index::clear() {
+    for (uint i = 0; i < anns.size(); ++i) delete anns[i];
+    anns.clear();
+    positions.clear();
+  }
+
+  pascal_annotation *pascal_index::parse(const std::string &xmlfile) const {
+    pascal_annotation *a = new pascal_annotation;
+    a->xmlfile = xmlfile;
+    a->modified = modified_ns(xmlfile);
+    a->size = file_size(xmlfile);
+    a->valid = read_xml(*a);
+    return a;
+  }
+
+  bool pascal_index::read_xml(pascal_annotation &a) const {
+    std::string fullname;
+    return pascal_xml::get_properties("", a.xmlfile, a.image_filename,
+				      fullname, a.folder, a.height, a.width,
+				      a.depth, a.objs, &a.cropr, false);
+  }
+
+  bool pascal_index::read(const std::string &cache,
+			  std::map<std::string,pascal_annotation*> &cached)
+    const {
+    FILE *fp = fopen(cache.c_str(), "rb");
+    if (!fp) return false;
+    char magic[sizeof (PASCAL_INDEX_MAGIC)];
+    int version, n;
+    bool ok = fread(magic, 1, sizeof (magic), fp) == sizeof (magic)
+      && !memcmp(magic, PASCAL_INDEX_MAGIC, sizeof (magic))
+      && read_int(fp, version) && version == PASCAL_INDEX_VERSION
+      && read_int(fp, n) && n >= 0;
+    for (int i = 0; ok && i < n; ++i) {
+      pascal_annotation *a = new pascal_annotation;
+      int64 modified;
+      int size, valid, hascrop, nobjs;
+      ok = read_string(fp, a->xmlfile)
+	&& fread(&modified, sizeof (int64), 1, fp) == 1
+	&& read_int(fp, size) && read_int(fp, valid)
+	&& read_string(fp, a->image_filename) && read_string(fp, a->folder)
+	&& read_int(fp, a->height) && read_int(fp, a->width)
+	&& read_int(fp, a->depth) && read_int(fp, hascrop);
+      if (ok && hascrop) {
+	a->cropr = new rect<int>();
+	ok = read_rect(fp, *a->cropr);
+      }
+      ok = ok && read_int(fp, nobjs) && nobjs >= 0;
+      for (int j = 0; ok && j < nobjs; ++j) {
+	object *o = read_object(fp);
+	if (o) a->objs.push_back(o);
+	else ok = false;
+      }
+      a->modified = modified;
+      a->size = (uint) size;
+      a->valid = valid != 0;
+      if (ok) {
+	std::map<std::string,pascal_annotation*>::iterator c =
+	  cached.find(a->xmlfile);
+	if (c != cached.end()) delete c->second;
+	cached[a->xmlfile] = a;
+      } else
+	delete a;
+    }
+    fclose(fp);
+    if (!ok) { // discard everything upon corruption
+      for (std::map<std::string,pascal_annotation*>::iterator c =
+	     cached.begin(); c != cached.end(); ++c)
+	delete c->second;
+      cached.clear();
+    }
+    return ok;
+  }
+
+  bool pascal_index::write(const std::string &cache) const {
+    // write to a temporary file first, then rename it, so that an interrupted
+    // write never leaves a corrupted cache behind.
+    std::string tmp;
+    tmp << cache << ".tmp";
+    FILE *fp = fopen(tmp.c_str(), "wb");
+    if (!fp) return false;
+    fwrite(PASCAL_INDEX_MAGIC, 1, sizeof (PASCAL_INDEX_MAGIC), fp);
+    write_int(fp, PASCAL_INDEX_VERSION);
+    write_int(fp, (int) anns.size());
+    for (uint i = 0; i < anns.size(); ++i) {
+      const pascal_annotation &a = *anns[i];
+      write_string(fp, a.xmlfile);
+      fwrite(&a.modified, sizeof (int64), 1, fp);
+      write_int(fp, (int) a.size);
+      write_int(fp, a.valid ? 1 : 0);
+      write_string(fp, a.image_filename);
+      write_string(fp, a.folder);
+      write_int(fp, a.height);
+      write_int(fp, a.width);
+      write_int(fp, a.depth);
+      write_int(fp, a.cropr ? 1 : 0);
+      if (a.cropr) write_rect(fp, *a.cropr);
+      write_int(fp, (int) a.objs.size());
+      for (uint j = 0; j < a.objs.size(); ++j)
+	write_object(fp, *a.objs[j]);
+    }
+    bool ok = !ferror(fp);
+    if (fclose(fp) != 0) ok = false;
+    if (ok) ok = rename(tmp.c_str(), cache.c_str()) == 0;
+    if (!ok) rm_file(tmp.c_str());
+    return ok;
+  }
+
 } // end namespace ebl
@@ -219,6 +219,21 @@ namespace ebl {
     return _finished;
   }
 
+  bool thread::join() {
+#ifndef __PTHREAD__
+    eblerror("pthread missing, install it and recompile.");
+    return false;
+#else
+    int ret = pthread_join(threadptr, NULL);
+    if (ret) {
+      merr << "Warning: failed to join thread, with error code " << ret
+	   << std::endl;
+      return false;
+    }
+    return true;
+#endif
+  }
+
   /*static */
   void* thread::entrypoint(void * pthis) {
     thread *pt = (thread*) pthis;
@@ -0,0 +1,170 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Cyril Poulet   *
+ *   cyril.poulet@centraliens.net   *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef SPBLAS_H_
+#define SPBLAS_H_
+
+#include "spIdx.h"
+
+namespace ebl {
+
+// Operations on sparse idx. Unless stated otherwise, arguments must have
+// the same dimensions and outputs may be the same objects as inputs.
+// Outputs never store BACKGROUND values.
+
+// copies //////////////////////////////////////////////////////////////////////
+
+//! Copies 'in' into 'out', casting values. 'out' takes the dimensions of 'in'.
+template <typename T1, typename T2>
+void idx_copy(const spIdx<T1> &in, spIdx<T2> &out);
+//! Copies sparse 'in' into dense 'out', which must have the same dimensions.
+template <typename T1, typename T2>
+void idx_copy(const spIdx<T1> &in, idx<T2> &out);
+//! Copies non-BACKGROUND elements of dense 'in' into 'out', casting values.
+//! 'out' takes the dimensions of 'in'.
+template <typename T1, typename T2>
+void idx_copy(idx<T1> &in, spIdx<T2> &out);
+//! Removes all elements of 'inp'.
+template <typename T> void idx_clear(spIdx<T> &inp);
+
+// element-wise operations /////////////////////////////////////////////////////
+
+//! out = -in
+template <typename T> void idx_minus(spIdx<T> &in, spIdx<T> &out);
+//! out = 1 / in, on elements of 'in' only.
+template <typename T> void idx_inv(spIdx<T> &in, spIdx<T> &out);
+//! out = |in|
+template <typename T> void idx_abs(spIdx<T> &in, spIdx<T> &out);
+//! out = in + c, on elements of 'in' only.
+template <typename T> void idx_addc(spIdx<T> &in, T c, spIdx<T> &out);
+//! out += in + c, with in + c on elements of 'in' only.
+template <typename T> void idx_addcacc(spIdx<T> &in, T c, spIdx<T> &out);
+//! out = c * in
+template <typename T> void idx_dotc(spIdx<T> &in, T c, spIdx<T> &out);
+//! out += c * in
+template <typename T> void idx_dotcacc(spIdx<T> &in, T c, spIdx<T> &out);
+//! out = i1 + i2
+template <typename T> void idx_add(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &out);
+//! out = i1 - i2
+template <typename T> void idx_sub(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &out);
+//! out = i1 * i2
+template <typename T> void idx_mul(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &out);
+//! out = (i1 - i2)^2
+template <typename T>
+void idx_subsquare(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &out);
+//! out = k1 * i1 + k2 * i2
+template <typename T>
+void idx_lincomb(spIdx<T> &i1, T k1, spIdx<T> &i2, T k2, spIdx<T> &out);
+
+// reductions //////////////////////////////////////////////////////////////////
+
+//! Returns the position in the list of stored elements of the largest
+//! stored value, or -1 if 'm' is empty.
+template <typename T> intg idx_indexmax(spIdx<T> &m);
+//! Returns the sum of squared differences between i1 and i2.
+template <typename T> float64 idx_sqrdist(spIdx<T> &i1, spIdx<T> &i2);
+//! Puts the sum of squared differences between i1 and i2 in idx0 'out'.
+template <typename T>
+void idx_sqrdist(spIdx<T> &i1, spIdx<T> &i2, idx<T> &out);
+
+// products ////////////////////////////////////////////////////////////////////
+
+//! y = A x, with sparse matrix A and dense vectors.
+template <typename T> void idx_m2dotm1(spIdx<T> &a, idx<T> &x, idx<T> &y);
+//! y += A x, with sparse matrix A and dense vectors.
+template <typename T> void idx_m2dotm1acc(spIdx<T> &a, idx<T> &x, idx<T> &y);
+//! y = A x, all sparse.
+template <typename T>
+void idx_m2dotm1(spIdx<T> &a, spIdx<T> &x, spIdx<T> &y);
+//! y += A x, all sparse.
+template <typename T>
+void idx_m2dotm1acc(spIdx<T> &a, spIdx<T> &x, spIdx<T> &y);
+//! y_i = sum_j A_ij^2 x_j, with sparse matrix A and dense vectors.
+template <typename T> void idx_m2squdotm1(spIdx<T> &a, idx<T> &x, idx<T> &y);
+//! y_i += sum_j A_ij^2 x_j, with sparse matrix A and dense vectors.
+template <typename T>
+void idx_m2squdotm1acc(spIdx<T> &a, idx<T> &x, idx<T> &y);
+//! y_i = sum_j A_ij^2 x_j, all sparse.
+template <typename T>
+void idx_m2squdotm1(spIdx<T> &a, spIdx<T> &x, spIdx<T> &y);
+//! y_i += sum_j A_ij^2 x_j, all sparse.
+template <typename T>
+void idx_m2squdotm1acc(spIdx<T> &a, spIdx<T> &x, spIdx<T> &y);
+//! Y = A X, with sparse matrix A (m x n) and dense X (n x k), Y (m x k).
+template <typename T> void idx_m2dotm2(spIdx<T> &a, idx<T> &x, idx<T> &y);
+//! Y += A X, with sparse matrix A (m x n) and dense X (n x k), Y (m x k).
+template <typename T> void idx_m2dotm2acc(spIdx<T> &a, idx<T> &x, idx<T> &y);
+//! Outer product of matrices: o_ijkl = i1_ij * i2_kl
+template <typename T>
+void idx_m2extm2(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &o);
+//! Outer product of matrices: o_ijkl += i1_ij * i2_kl
+template <typename T>
+void idx_m2extm2acc(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &o);
+//! Square outer product of matrices: o_ijkl += i1_ij * i2_kl^2
+template <typename T>
+void idx_m2squextm2acc(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &o);
+//! Puts sum(i1_ij^2 * i2_ij) in idx0 'o'.
+template <typename T>
+void idx_m2squdotm2(spIdx<T> &i1, spIdx<T> &i2, idx<T> &o);
+//! Accumulates sum(i1_ij^2 * i2_ij) in idx0 'o'.
+template <typename T>
+void idx_m2squdotm2acc(spIdx<T> &i1, spIdx<T> &i2, idx<T> &o);
+//! Vector outer product o_ij = x_i * y_j. Note that the output comes first.
+template <typename T>
+void idx_m1extm1(spIdx<T> &o, spIdx<T> &x, spIdx<T> &y);
+//! Vector outer product o_ij += x_i * y_j. Note that the output comes first.
+template <typename T>
+void idx_m1extm1acc(spIdx<T> &o, spIdx<T> &x, spIdx<T> &y);
+//! o_ij = x_i * y_j^2. Note that the output comes first.
+template <typename T>
+void idx_m1squextm1(spIdx<T> &o, spIdx<T> &x, spIdx<T> &y);
+//! o_ij += x_i * y_j^2. Note that the output comes first.
+template <typename T>
+void idx_m1squextm1acc(spIdx<T> &o, spIdx<T> &x, spIdx<T> &y);
+//! Normalizes each column of matrix 'm' to unit L2 norm.
+template <typename T> void norm_columns(spIdx<T> &m);
+
+// convolution /////////////////////////////////////////////////////////////////
+
+//! 2D valid correlation of sparse 'in' with dense 'kernel', as the dense
+//! idx_2dconvol(): out_ij = sum_kl in_(i+k)(j+l) * kernel_kl. The cost is
+//! proportional to the number of input elements times the kernel size, plus
+//! the output size.
+//! \param clear If false, results are accumulated into 'out'.
+template <typename T>
+void idx_2dconvol(spIdx<T> &in, idx<T> &kernel, spIdx<T> &out,
+                  bool clear = true);
+
+} // end namespace ebl
+
+#include "spBlas.hpp"
+
+#endif /* SPBLAS_H_ */
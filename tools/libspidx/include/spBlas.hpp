@@ -0,0 +1,505 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Cyril Poulet   *
+ *   cyril.poulet@centraliens.net   *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef SPBLAS_HPP_
+#define SPBLAS_HPP_
+
+#include <cmath>
+
+namespace ebl {
+
+// internal helpers ////////////////////////////////////////////////////////////
+
+//! Lexicographic comparison of coordinates 'a' and 'b' of order 'o'.
+//! Returns -1, 0 or 1.
+inline int spidx_compare(const intg *a, const intg *b, intg o) {
+  for (intg i = 0; i < o; ++i)
+    if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+  return 0;
+}
+
+//! Checks that 'a' and 'b' have the same dimensions.
+template <typename T1, typename T2>
+void spidx_checkdims(const spIdx<T1> &a, const spIdx<T2> &b) {
+  if (!a.same_dim(b.get_idxdim()))
+    eblerror("expected same dimensions but got " << a.get_idxdim()
+             << " and " << b.get_idxdim());
+}
+
+//! Sets 'out' to f(in) on the support of 'in'.
+template <typename T, class F>
+void spidx_map(const spIdx<T> &in, spIdx<T> &out, const F &f) {
+  spIdx<T> r(in.nelements(), in.get_idxdim());
+  for (intg e = 0; e < in.nelements(); ++e)
+    r.append(f(*in.values_ptr(e)), in.index_ptr(e));
+  out = r;
+}
+
+//! Sets 'out' to f(a, b) on the union of the supports of 'a' and 'b', or
+//! their intersection if 'intersect' is true. Missing values are BACKGROUND.
+template <typename T, class F>
+void spidx_merge(const spIdx<T> &a, const spIdx<T> &b, spIdx<T> &out,
+                 const F &f, bool intersect = false) {
+  spidx_checkdims(a, b);
+  spIdx<T> r(std::max(a.nelements(), b.nelements()), a.get_idxdim());
+  intg ea = 0, eb = 0, na = a.nelements(), nb = b.nelements(), o = a.order();
+  T bg = (T) BACKGROUND;
+  while (ea < na || eb < nb) {
+    int c = ea >= na ? 1 : (eb >= nb ? -1 :
+                            spidx_compare(a.index_ptr(ea), b.index_ptr(eb), o));
+    if (c == 0) {
+      r.append(f(*a.values_ptr(ea), *b.values_ptr(eb)), a.index_ptr(ea));
+      ea++; eb++;
+    } else if (c < 0) {
+      if (!intersect) r.append(f(*a.values_ptr(ea), bg), a.index_ptr(ea));
+      ea++;
+    } else {
+      if (!intersect) r.append(f(bg, *b.values_ptr(eb)), b.index_ptr(eb));
+      eb++;
+    }
+  }
+  out = r;
+}
+
+template <typename T> struct spidx_minus_op {
+  T operator()(T a) const { return -a; } };
+template <typename T> struct spidx_inv_op {
+  T operator()(T a) const { return (T) 1 / a; } };
+template <typename T> struct spidx_abs_op {
+  T operator()(T a) const { return a < 0 ? -a : a; } };
+template <typename T> struct spidx_addc_op {
+  spidx_addc_op(T c_) : c(c_) {}
+  T operator()(T a) const { return a + c; }
+  T c; };
+template <typename T> struct spidx_dotc_op {
+  spidx_dotc_op(T c_) : c(c_) {}
+  T operator()(T a) const { return a * c; }
+  T c; };
+template <typename T> struct spidx_add_op {
+  T operator()(T a, T b) const { return a + b; } };
+template <typename T> struct spidx_sub_op {
+  T operator()(T a, T b) const { return a - b; } };
+template <typename T> struct spidx_mul_op {
+  T operator()(T a, T b) const { return a * b; } };
+template <typename T> struct spidx_subsquare_op {
+  T operator()(T a, T b) const { return (a - b) * (a - b); } };
+template <typename T> struct spidx_lincomb_op {
+  spidx_lincomb_op(T k1_, T k2_) : k1(k1_), k2(k2_) {}
+  T operator()(T a, T b) const { return k1 * a + k2 * b; }
+  T k1, k2; };
+
+// copies //////////////////////////////////////////////////////////////////////
+
+template <typename T1, typename T2>
+void idx_copy(const spIdx<T1> &in, spIdx<T2> &out) {
+  spIdx<T2> r(in.nelements(), in.get_idxdim());
+  for (intg e = 0; e < in.nelements(); ++e)
+    r.append((T2) *in.values_ptr(e), in.index_ptr(e));
+  out = r;
+}
+
+template <typename T1, typename T2>
+void idx_copy(const spIdx<T1> &in, idx<T2> &out) {
+  if (!in.same_dim(out.get_idxdim()))
+    eblerror("expected same dimensions but got " << in.get_idxdim()
+             << " and " << out);
+  idx_fill(out, (T2) BACKGROUND);
+  T2 *po = out.idx_ptr();
+  intg o = in.order();
+  for (intg e = 0; e < in.nelements(); ++e) {
+    const intg *p = in.index_ptr(e);
+    intg off = 0;
+    for (intg i = 0; i < o; ++i) off += p[i] * out.mod(i);
+    po[off] = (T2) *in.values_ptr(e);
+  }
+}
+
+template <typename T1, typename T2>
+void idx_copy(idx<T1> &in, spIdx<T2> &out) {
+  spIdx<T2> r(0, in.get_idxdim());
+  intg pos[MAXDIMS];
+  memset(pos, 0, MAXDIMS * sizeof (intg));
+  intg o = in.order();
+  // walk 'in' in row-major order so that elements are appended in order
+  { idx_aloop1(i, in, T1) {
+      T2 v = (T2) *i;
+      if (v != (T2) BACKGROUND) r.append(v, pos);
+      for (intg d = o - 1; d >= 0; --d) {
+        if (++pos[d] < in.dim(d)) break ;
+        pos[d] = 0;
+      }
+    }}
+  out = r;
+}
+
+template <typename T> void idx_clear(spIdx<T> &inp) {
+  inp.clear();
+}
+
+// element-wise operations /////////////////////////////////////////////////////
+
+template <typename T> void idx_minus(spIdx<T> &in, spIdx<T> &out) {
+  spidx_map(in, out, spidx_minus_op<T>());
+}
+
+template <typename T> void idx_inv(spIdx<T> &in, spIdx<T> &out) {
+  spidx_map(in, out, spidx_inv_op<T>());
+}
+
+template <typename T> void idx_abs(spIdx<T> &in, spIdx<T> &out) {
+  spidx_map(in, out, spidx_abs_op<T>());
+}
+
+template <typename T> void idx_addc(spIdx<T> &in, T c, spIdx<T> &out) {
+  spidx_map(in, out, spidx_addc_op<T>(c));
+}
+
+template <typename T> void idx_addcacc(spIdx<T> &in, T c, spIdx<T> &out) {
+  spIdx<T> tmp(0, in.get_idxdim());
+  spidx_map(in, tmp, spidx_addc_op<T>(c));
+  spidx_merge(tmp, out, out, spidx_add_op<T>());
+}
+
+template <typename T> void idx_dotc(spIdx<T> &in, T c, spIdx<T> &out) {
+  spidx_map(in, out, spidx_dotc_op<T>(c));
+}
+
+template <typename T> void idx_dotcacc(spIdx<T> &in, T c, spIdx<T> &out) {
+  spIdx<T> tmp(0, in.get_idxdim());
+  spidx_map(in, tmp, spidx_dotc_op<T>(c));
+  spidx_merge(tmp, out, out, spidx_add_op<T>());
+}
+
+template <typename T> void idx_add(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &out) {
+  spidx_merge(i1, i2, out, spidx_add_op<T>());
+}
+
+template <typename T> void idx_sub(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &out) {
+  spidx_merge(i1, i2, out, spidx_sub_op<T>());
+}
+
+template <typename T> void idx_mul(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &out) {
+  spidx_merge(i1, i2, out, spidx_mul_op<T>(), true);
+}
+
+template <typename T>
+void idx_subsquare(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &out) {
+  spidx_merge(i1, i2, out, spidx_subsquare_op<T>());
+}
+
+template <typename T>
+void idx_lincomb(spIdx<T> &i1, T k1, spIdx<T> &i2, T k2, spIdx<T> &out) {
+  spidx_merge(i1, i2, out, spidx_lincomb_op<T>(k1, k2));
+}
+
+// reductions //////////////////////////////////////////////////////////////////
+
+template <typename T> intg idx_indexmax(spIdx<T> &m) {
+  intg imax = -1;
+  for (intg e = 0; e < m.nelements(); ++e)
+    if (imax < 0 || *m.values_ptr(e) > *m.values_ptr(imax)) imax = e;
+  return imax;
+}
+
+template <typename T> float64 idx_sqrdist(spIdx<T> &i1, spIdx<T> &i2) {
+  spidx_checkdims(i1, i2);
+  float64 sum = 0;
+  intg e1 = 0, e2 = 0, n1 = i1.nelements(), n2 = i2.nelements();
+  intg o = i1.order();
+  while (e1 < n1 || e2 < n2) {
+    int c = e1 >= n1 ? 1 : (e2 >= n2 ? -1 :
+                            spidx_compare(i1.index_ptr(e1), i2.index_ptr(e2), o));
+    float64 d;
+    if (c == 0) d = (float64) *i1.values_ptr(e1++) - *i2.values_ptr(e2++);
+    else if (c < 0) d = (float64) *i1.values_ptr(e1++);
+    else d = (float64) *i2.values_ptr(e2++);
+    sum += d * d;
+  }
+  return sum;
+}
+
+template <typename T>
+void idx_sqrdist(spIdx<T> &i1, spIdx<T> &i2, idx<T> &out) {
+  idx_checkorder1(out, 0);
+  out.set((T) idx_sqrdist(i1, i2));
+}
+
+// products ////////////////////////////////////////////////////////////////////
+
+template <typename T> void idx_m2dotm1(spIdx<T> &a, idx<T> &x, idx<T> &y) {
+  idx_clear(y);
+  idx_m2dotm1acc(a, x, y);
+}
+
+template <typename T> void idx_m2dotm1acc(spIdx<T> &a, idx<T> &x, idx<T> &y) {
+  if (a.order() != 2) eblerror("expected a sparse matrix");
+  idx_checkorder2(x, 1, y, 1);
+  if (a.dim(0) != y.dim(0) || a.dim(1) != x.dim(0))
+    eblerror("incompatible dimensions " << a.get_idxdim() << ", " << x
+             << " and " << y);
+  T *px = x.idx_ptr(), *py = y.idx_ptr();
+  intg mx = x.mod(0), my = y.mod(0);
+  for (intg e = 0; e < a.nelements(); ++e) {
+    const intg *p = a.index_ptr(e);
+    py[p[0] * my] += *a.values_ptr(e) * px[p[1] * mx];
+  }
+}
+
+//! Sets 'y' to sum_j f(A_ij) x_j where A, x and y are sparse. Each row of
+//! A is merged with x since both are sorted by column.
+template <typename T>
+void spidx_m2dotm1(spIdx<T> &a, spIdx<T> &x, spIdx<T> &y, bool square) {
+  if (a.order() != 2 || x.order() != 1)
+    eblerror("expected a sparse matrix and a sparse vector");
+  if (a.dim(1) != x.dim(0))
+    eblerror("incompatible dimensions " << a.get_idxdim() << " and "
+             << x.get_idxdim());
+  spIdx<T> r(0, a.dim(0));
+  intg e = 0, na = a.nelements(), nx = x.nelements();
+  while (e < na) {
+    intg row = a.index_ptr(e)[0], ex = 0;
+    T sum = 0;
+    for (; e < na && a.index_ptr(e)[0] == row; ++e) {
+      intg col = a.index_ptr(e)[1];
+      while (ex < nx && x.index_ptr(ex)[0] < col) ex++;
+      if (ex < nx && x.index_ptr(ex)[0] == col) {
+        T v = *a.values_ptr(e);
+        sum += (square ? v * v : v) * *x.values_ptr(ex);
+      }
+    }
+    r.append(sum, &row);
+  }
+  y = r;
+}
+
+template <typename T>
+void idx_m2dotm1(spIdx<T> &a, spIdx<T> &x, spIdx<T> &y) {
+  spidx_m2dotm1(a, x, y, false);
+}
+
+template <typename T>
+void idx_m2dotm1acc(spIdx<T> &a, spIdx<T> &x, spIdx<T> &y) {
+  spIdx<T> tmp(0, a.dim(0));
+  spidx_m2dotm1(a, x, tmp, false);
+  idx_add(tmp, y, y);
+}
+
+template <typename T> void idx_m2squdotm1(spIdx<T> &a, idx<T> &x, idx<T> &y) {
+  idx_clear(y);
+  idx_m2squdotm1acc(a, x, y);
+}
+
+template <typename T>
+void idx_m2squdotm1acc(spIdx<T> &a, idx<T> &x, idx<T> &y) {
+  if (a.order() != 2) eblerror("expected a sparse matrix");
+  idx_checkorder2(x, 1, y, 1);
+  if (a.dim(0) != y.dim(0) || a.dim(1) != x.dim(0))
+    eblerror("incompatible dimensions " << a.get_idxdim() << ", " << x
+             << " and " << y);
+  T *px = x.idx_ptr(), *py = y.idx_ptr();
+  intg mx = x.mod(0), my = y.mod(0);
+  for (intg e = 0; e < a.nelements(); ++e) {
+    const intg *p = a.index_ptr(e);
+    T v = *a.values_ptr(e);
+    py[p[0] * my] += v * v * px[p[1] * mx];
+  }
+}
+
+template <typename T>
+void idx_m2squdotm1(spIdx<T> &a, spIdx<T> &x, spIdx<T> &y) {
+  spidx_m2dotm1(a, x, y, true);
+}
+
+template <typename T>
+void idx_m2squdotm1acc(spIdx<T> &a, spIdx<T> &x, spIdx<T> &y) {
+  spIdx<T> tmp(0, a.dim(0));
+  spidx_m2dotm1(a, x, tmp, true);
+  idx_add(tmp, y, y);
+}
+
+template <typename T> void idx_m2dotm2(spIdx<T> &a, idx<T> &x, idx<T> &y) {
+  idx_clear(y);
+  idx_m2dotm2acc(a, x, y);
+}
+
+template <typename T> void idx_m2dotm2acc(spIdx<T> &a, idx<T> &x, idx<T> &y) {
+  if (a.order() != 2) eblerror("expected a sparse matrix");
+  idx_checkorder2(x, 2, y, 2);
+  if (a.dim(0) != y.dim(0) || a.dim(1) != x.dim(0) || x.dim(1) != y.dim(1))
+    eblerror("incompatible dimensions " << a.get_idxdim() << ", " << x
+             << " and " << y);
+  // each stored element adds a scaled row of x to a row of y
+  T *px = x.idx_ptr(), *py = y.idx_ptr();
+  intg mx0 = x.mod(0), mx1 = x.mod(1), my0 = y.mod(0), my1 = y.mod(1);
+  intg k, kmax = x.dim(1);
+  for (intg e = 0; e < a.nelements(); ++e) {
+    const intg *p = a.index_ptr(e);
+    T v = *a.values_ptr(e);
+    T *xr = px + p[1] * mx0, *yr = py + p[0] * my0;
+    if (mx1 == 1 && my1 == 1)
+      for (k = 0; k < kmax; ++k) yr[k] += v * xr[k];
+    else
+      for (k = 0; k < kmax; ++k) yr[k * my1] += v * xr[k * mx1];
+  }
+}
+
+//! Sets 'o' to the outer product f(i1) x g(i2) of sparse tensors, where
+//! 'squ' squares elements of i2.
+template <typename T>
+void spidx_ext(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &o, bool squ) {
+  intg o1 = i1.order(), o2 = i2.order();
+  idxdim d(i1.get_idxdim());
+  for (intg i = 0; i < o2; ++i) d.insert_dim(o1 + i, i2.dim(i));
+  if (!o.same_dim(d))
+    eblerror("expected output of dimensions " << d << " but got "
+             << o.get_idxdim());
+  spIdx<T> r(i1.nelements() * i2.nelements(), d);
+  intg pos[MAXDIMS];
+  // concatenated coordinates of sorted inputs are sorted
+  for (intg e1 = 0; e1 < i1.nelements(); ++e1) {
+    memcpy(pos, i1.index_ptr(e1), o1 * sizeof (intg));
+    T v1 = *i1.values_ptr(e1);
+    for (intg e2 = 0; e2 < i2.nelements(); ++e2) {
+      memcpy(pos + o1, i2.index_ptr(e2), o2 * sizeof (intg));
+      T v2 = *i2.values_ptr(e2);
+      r.append(v1 * (squ ? v2 * v2 : v2), pos);
+    }
+  }
+  o = r;
+}
+
+template <typename T>
+void idx_m2extm2(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &o) {
+  spidx_ext(i1, i2, o, false);
+}
+
+template <typename T>
+void idx_m2extm2acc(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &o) {
+  spIdx<T> tmp(0, o.get_idxdim());
+  spidx_ext(i1, i2, tmp, false);
+  idx_add(tmp, o, o);
+}
+
+template <typename T>
+void idx_m2squextm2acc(spIdx<T> &i1, spIdx<T> &i2, spIdx<T> &o) {
+  spIdx<T> tmp(0, o.get_idxdim());
+  spidx_ext(i1, i2, tmp, true);
+  idx_add(tmp, o, o);
+}
+
+template <typename T>
+void idx_m2squdotm2(spIdx<T> &i1, spIdx<T> &i2, idx<T> &o) {
+  idx_checkorder1(o, 0);
+  o.set(0);
+  idx_m2squdotm2acc(i1, i2, o);
+}
+
+template <typename T>
+void idx_m2squdotm2acc(spIdx<T> &i1, spIdx<T> &i2, idx<T> &o) {
+  idx_checkorder1(o, 0);
+  spIdx<T> tmp(0, i1.get_idxdim());
+  idx_mul(i1, i1, tmp);
+  idx_mul(tmp, i2, tmp);
+  T sum = o.get();
+  for (intg e = 0; e < tmp.nelements(); ++e) sum += *tmp.values_ptr(e);
+  o.set(sum);
+}
+
+template <typename T>
+void idx_m1extm1(spIdx<T> &o, spIdx<T> &x, spIdx<T> &y) {
+  spidx_ext(x, y, o, false);
+}
+
+template <typename T>
+void idx_m1extm1acc(spIdx<T> &o, spIdx<T> &x, spIdx<T> &y) {
+  spIdx<T> tmp(0, o.get_idxdim());
+  spidx_ext(x, y, tmp, false);
+  idx_add(tmp, o, o);
+}
+
+template <typename T>
+void idx_m1squextm1(spIdx<T> &o, spIdx<T> &x, spIdx<T> &y) {
+  spidx_ext(x, y, o, true);
+}
+
+template <typename T>
+void idx_m1squextm1acc(spIdx<T> &o, spIdx<T> &x, spIdx<T> &y) {
+  spIdx<T> tmp(0, o.get_idxdim());
+  spidx_ext(x, y, tmp, true);
+  idx_add(tmp, o, o);
+}
+
+template <typename T> void norm_columns(spIdx<T> &m) {
+  if (m.order() != 2) eblerror("expected a sparse matrix");
+  std::vector<float64> norms(m.dim(1), 0.0);
+  for (intg e = 0; e < m.nelements(); ++e) {
+    float64 v = *m.values_ptr(e);
+    norms[m.index_ptr(e)[1]] += v * v;
+  }
+  for (intg e = 0; e < m.nelements(); ++e) {
+    float64 n = norms[m.index_ptr(e)[1]];
+    *m.values_ptr(e) = (T) (*m.values_ptr(e) / std::sqrt(n));
+  }
+}
+
+// convolution /////////////////////////////////////////////////////////////////
+
+template <typename T>
+void idx_2dconvol(spIdx<T> &in, idx<T> &kernel, spIdx<T> &out, bool clear) {
+  if (in.order() != 2) eblerror("expected a sparse matrix");
+  idx_checkorder1(kernel, 2);
+  intg ki = kernel.dim(0), kj = kernel.dim(1);
+  intg oi = in.dim(0) - ki + 1, oj = in.dim(1) - kj + 1;
+  if (out.order() != 2 || out.dim(0) != oi || out.dim(1) != oj)
+    eblerror("expected output of dimensions " << oi << "x" << oj
+             << " but got " << out.get_idxdim());
+  // scatter each input element onto the outputs it contributes to
+  idx<T> acc(oi, oj);
+  if (clear) idx_clear(acc);
+  else idx_copy(out, acc);
+  T *pa = acc.idx_ptr();
+  for (intg e = 0; e < in.nelements(); ++e) {
+    const intg *p = in.index_ptr(e);
+    T v = *in.values_ptr(e);
+    intg kimin = std::max((intg) 0, p[0] - oi + 1);
+    intg kimax = std::min(ki - 1, p[0]);
+    intg kjmin = std::max((intg) 0, p[1] - oj + 1);
+    intg kjmax = std::min(kj - 1, p[1]);
+    for (intg k = kimin; k <= kimax; ++k)
+      for (intg l = kjmin; l <= kjmax; ++l)
+        pa[(p[0] - k) * oj + p[1] - l] += v * kernel.get(k, l);
+  }
+  idx_copy(acc, out);
+}
+
+} // end namespace ebl
+
+#endif /* SPBLAS_HPP_ */
@@ -0,0 +1,176 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Cyril Poulet   *
+ *   cyril.poulet@centraliens.net   *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef SPIDX_H_
+#define SPIDX_H_
+
+#include "libidx.h"
+
+namespace ebl {
+
+//! The value of all elements that are not stored in a sparse idx.
+#define BACKGROUND 0
+
+// spIdx ///////////////////////////////////////////////////////////////////////
+
+//! A sparse tensor of up to 8 dimensions. Only elements different from
+//! BACKGROUND are stored, in coordinate (COO) format: an index matrix
+//! of size nelements x order and a vector of values.
+//! Elements are always kept sorted in lexicographic (row-major) order of
+//! their coordinates, so that lookups are logarithmic and elements of
+//! the same row are contiguous (see row_offsets() for a CSR view).
+//! Unlike idx, narrow(), select() and transpose() return copies.
+template <typename T> class spIdx {
+ public:
+  // constructors //////////////////////////////////////////////////////////////
+
+  //! Constructs a sparse idx of order 'order' and dimensions 'dims'.
+  //! \param nelemmax The number of elements to reserve space for. Storage
+  //!   grows automatically beyond that.
+  spIdx(intg nelemmax, intg order, intg *dims);
+  //! Constructs a sparse idx with dimensions s0 x s1 x ... (up to 8).
+  //! \param nelemmax The number of elements to reserve space for.
+  spIdx(intg nelemmax, intg s0, intg s1 = -1, intg s2 = -1, intg s3 = -1,
+        intg s4 = -1, intg s5 = -1, intg s6 = -1, intg s7 = -1);
+  //! Constructs a sparse idx with dimensions 'd'.
+  spIdx(intg nelemmax, const idxdim &d);
+  //! Deep copy constructor.
+  spIdx(const spIdx<T> &other);
+  //! Destructor.
+  virtual ~spIdx();
+  //! Deep copy.
+  spIdx<T>& operator=(const spIdx<T> &other);
+
+  // dimensions ////////////////////////////////////////////////////////////////
+
+  //! Returns the order.
+  int order() const;
+  //! Returns the size of dimension 'd'.
+  intg dim(int d) const;
+  //! Returns the dimensions.
+  const idxdim& get_idxdim() const;
+  //! Returns the number of stored (non-BACKGROUND) elements.
+  intg nelements() const;
+  //! Returns true if no element is stored.
+  bool isempty() const;
+  //! Returns true if dimensions are the same as 'd'.
+  bool same_dim(const idxdim &d) const;
+
+  // element access ////////////////////////////////////////////////////////////
+
+  //! Returns the element at given coordinates, BACKGROUND if not stored.
+  T get(intg i0, intg i1 = -1, intg i2 = -1, intg i3 = -1, intg i4 = -1,
+        intg i5 = -1, intg i6 = -1, intg i7 = -1) const;
+  //! Returns the element at coordinates 'pos' (of size order()).
+  T get_pos(const intg *pos) const;
+  //! Sets element at given coordinates to 'v'. Setting an element to
+  //! BACKGROUND removes it.
+  void set(T v, intg i0, intg i1 = -1, intg i2 = -1, intg i3 = -1,
+           intg i4 = -1, intg i5 = -1, intg i6 = -1, intg i7 = -1);
+  //! Sets element at coordinates 'pos' (of size order()) to 'v'.
+  void set_pos(T v, const intg *pos);
+  //! Appends element 'v' at coordinates 'pos' in constant time.
+  //! 'pos' must come after all stored coordinates, BACKGROUND values are
+  //! ignored.
+  void append(T v, const intg *pos);
+  //! Removes all elements.
+  void clear();
+  //! Returns the coordinates buffer, of size capacity x order.
+  //! Only its first nelements() rows are valid.
+  idx<intg>* index();
+  //! Returns the values buffer. Only its first nelements() are valid.
+  idx<T>* values();
+  //! Returns a pointer to the coordinates of element 'e'.
+  const intg* index_ptr(intg e = 0) const;
+  //! Returns a pointer to the value of element 'e'.
+  T* values_ptr(intg e = 0);
+  //! Returns a pointer to the value of element 'e'.
+  const T* values_ptr(intg e = 0) const;
+
+  // copies ////////////////////////////////////////////////////////////////////
+
+  //! Returns a copy of the 'size' slices starting at 'offset' of dim 'd'.
+  spIdx<T> narrow(int d, intg size, intg offset) const;
+  //! Returns a copy of slice 'i' of dimension 'd', of order order() - 1.
+  spIdx<T> select(int d, intg i) const;
+  //! Returns a copy with dimensions 'd1' and 'd2' swapped.
+  spIdx<T> transpose(int d1, int d2) const;
+  //! Returns a copy where dimension i is dimension p[i] of this one.
+  spIdx<T> transpose(int *p) const;
+
+  // resizing and sorting //////////////////////////////////////////////////////
+
+  //! Changes dimensions, the order cannot change. Elements out of
+  //! the new bounds are removed.
+  void resize(intg s0, intg s1 = -1, intg s2 = -1, intg s3 = -1, intg s4 = -1,
+              intg s5 = -1, intg s6 = -1, intg s7 = -1);
+  //! Changes dimensions, the order cannot change.
+  void resize(const idxdim &d);
+  //! Sorts elements in lexicographic order of their coordinates. This is
+  //! only needed after writing directly into index() or values().
+  void sort();
+  //! Returns the CSR row offsets of this matrix: elements of row i
+  //! (first coordinate) are in [r(i), r(i + 1)).
+  idx<intg> row_offsets() const;
+
+  // printing //////////////////////////////////////////////////////////////////
+
+  //! Prints order, dimensions and number of elements.
+  void pretty(std::ostream &out = std::cout) const;
+  //! Prints all stored elements with their coordinates.
+  void printElems(std::ostream &out = std::cout) const;
+
+  // internal methods //////////////////////////////////////////////////////////
+ protected:
+  //! Allocate storage for 'nelemmax' elements of dims 'd'.
+  void init(intg nelemmax, const idxdim &d);
+  //! Makes sure storage can hold at least 'n' elements.
+  void reserve(intg n);
+  //! Returns the position of 'pos' in the sorted elements or where it would
+  //! be inserted, 'found' is set if it exists.
+  intg find(const intg *pos, bool &found) const;
+  //! Fills 'pos' with i0...i7 and checks it fits with dimensions.
+  void check_pos(intg *pos, intg i0, intg i1, intg i2, intg i3, intg i4,
+                 intg i5, intg i6, intg i7) const;
+
+  // members ///////////////////////////////////////////////////////////////////
+ protected:
+  idxdim    dims;   //!< Dimensions.
+  intg      nelem;  //!< Number of stored elements.
+  idx<intg> ind;    //!< Coordinates buffer, capacity x order.
+  idx<T>    val;    //!< Values buffer.
+};
+
+} // end namespace ebl
+
+#include "spIdx.hpp"
+
+#endif /* SPIDX_H_ */
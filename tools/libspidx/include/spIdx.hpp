@@ -0,0 +1,434 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Cyril Poulet   *
+ *   cyril.poulet@centraliens.net   *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef SPIDX_HPP_
+#define SPIDX_HPP_
+
+#include <algorithm>
+
+namespace ebl {
+
+// spIdx constructors //////////////////////////////////////////////////////////
+
+template <typename T>
+spIdx<T>::spIdx(intg nelemmax, intg order, intg *d) {
+  if (order < 1 || order > MAXDIMS)
+    eblerror("spIdx order must be in [1, " << MAXDIMS << "], got " << order);
+  idxdim dd(d[0]);
+  for (intg i = 1; i < order; ++i) dd.insert_dim(i, d[i]);
+  init(nelemmax, dd);
+}
+
+template <typename T>
+spIdx<T>::spIdx(intg nelemmax, intg s0, intg s1, intg s2, intg s3, intg s4,
+                intg s5, intg s6, intg s7) {
+  init(nelemmax, idxdim(s0, s1, s2, s3, s4, s5, s6, s7));
+}
+
+template <typename T>
+spIdx<T>::spIdx(intg nelemmax, const idxdim &d) {
+  init(nelemmax, d);
+}
+
+template <typename T>
+spIdx<T>::spIdx(const spIdx<T> &other) {
+  init(other.nelem, other.dims);
+  *this = other;
+}
+
+template <typename T>
+spIdx<T>::~spIdx() {
+}
+
+template <typename T>
+spIdx<T>& spIdx<T>::operator=(const spIdx<T> &other) {
+  if (this == &other) return *this;
+  if (order() != other.order()) init(other.nelem, other.dims);
+  else reserve(other.nelem);
+  dims = other.dims;
+  nelem = other.nelem;
+  memcpy(ind.idx_ptr(), other.index_ptr(), nelem * order() * sizeof (intg));
+  memcpy(val.idx_ptr(), other.values_ptr(), nelem * sizeof (T));
+  return *this;
+}
+
+// dimensions //////////////////////////////////////////////////////////////////
+
+template <typename T>
+int spIdx<T>::order() const {
+  return (int) dims.order();
+}
+
+template <typename T>
+intg spIdx<T>::dim(int d) const {
+  return dims.dim(d);
+}
+
+template <typename T>
+const idxdim& spIdx<T>::get_idxdim() const {
+  return dims;
+}
+
+template <typename T>
+intg spIdx<T>::nelements() const {
+  return nelem;
+}
+
+template <typename T>
+bool spIdx<T>::isempty() const {
+  return nelem == 0;
+}
+
+template <typename T>
+bool spIdx<T>::same_dim(const idxdim &d) const {
+  if (d.order() != dims.order()) return false;
+  for (intg i = 0; i < d.order(); ++i)
+    if (d.dim(i) != dims.dim(i)) return false;
+  return true;
+}
+
+// element access //////////////////////////////////////////////////////////////
+
+template <typename T>
+T spIdx<T>::get(intg i0, intg i1, intg i2, intg i3, intg i4, intg i5, intg i6,
+                intg i7) const {
+  intg pos[MAXDIMS];
+  check_pos(pos, i0, i1, i2, i3, i4, i5, i6, i7);
+  return get_pos(pos);
+}
+
+template <typename T>
+T spIdx<T>::get_pos(const intg *pos) const {
+  bool found;
+  intg e = find(pos, found);
+  return found ? val.get(e) : (T) BACKGROUND;
+}
+
+template <typename T>
+void spIdx<T>::set(T v, intg i0, intg i1, intg i2, intg i3, intg i4, intg i5,
+                   intg i6, intg i7) {
+  intg pos[MAXDIMS];
+  check_pos(pos, i0, i1, i2, i3, i4, i5, i6, i7);
+  set_pos(v, pos);
+}
+
+template <typename T>
+void spIdx<T>::set_pos(T v, const intg *pos) {
+  bool found;
+  intg e = find(pos, found);
+  intg o = order();
+  if (found) {
+    if (v != (T) BACKGROUND) val.set(v, e);
+    else { // remove element e
+      intg *p = ind.idx_ptr();
+      T *pv = val.idx_ptr();
+      memmove(p + e * o, p + (e + 1) * o, (nelem - e - 1) * o * sizeof (intg));
+      memmove(pv + e, pv + e + 1, (nelem - e - 1) * sizeof (T));
+      nelem--;
+    }
+  } else if (v != (T) BACKGROUND) { // insert new element at e
+    reserve(nelem + 1);
+    intg *p = ind.idx_ptr();
+    T *pv = val.idx_ptr();
+    memmove(p + (e + 1) * o, p + e * o, (nelem - e) * o * sizeof (intg));
+    memmove(pv + e + 1, pv + e, (nelem - e) * sizeof (T));
+    memcpy(p + e * o, pos, o * sizeof (intg));
+    pv[e] = v;
+    nelem++;
+  }
+}
+
+template <typename T>
+void spIdx<T>::append(T v, const intg *pos) {
+  if (v == (T) BACKGROUND) return ;
+  reserve(nelem + 1);
+  intg o = order();
+  memcpy(ind.idx_ptr() + nelem * o, pos, o * sizeof (intg));
+  val.set(v, nelem);
+  nelem++;
+}
+
+template <typename T>
+void spIdx<T>::clear() {
+  nelem = 0;
+}
+
+template <typename T>
+idx<intg>* spIdx<T>::index() {
+  return &ind;
+}
+
+template <typename T>
+idx<T>* spIdx<T>::values() {
+  return &val;
+}
+
+template <typename T>
+const intg* spIdx<T>::index_ptr(intg e) const {
+  return ind.idx_ptr() + e * order();
+}
+
+template <typename T>
+T* spIdx<T>::values_ptr(intg e) {
+  return val.idx_ptr() + e;
+}
+
+template <typename T>
+const T* spIdx<T>::values_ptr(intg e) const {
+  return val.idx_ptr() + e;
+}
+
+// copies //////////////////////////////////////////////////////////////////////
+
+template <typename T>
+spIdx<T> spIdx<T>::narrow(int d, intg size, intg offset) const {
+  if (d < 0 || d >= order())
+    eblerror("narrow: illegal dimension " << d << " in " << dims);
+  if (offset < 0 || size < 1 || offset + size > dim(d))
+    eblerror("trying to narrow dimension " << d << " to size " << size
+             << " starting at offset " << offset << " in " << dims);
+  idxdim nd(dims);
+  nd.setdim(d, size);
+  spIdx<T> r(0, nd);
+  intg pos[MAXDIMS], o = order();
+  for (intg e = 0; e < nelem; ++e) {
+    const intg *p = index_ptr(e);
+    if (p[d] < offset || p[d] >= offset + size) continue ;
+    memcpy(pos, p, o * sizeof (intg));
+    pos[d] -= offset;
+    r.append(val.get(e), pos); // order is preserved
+  }
+  return r;
+}
+
+template <typename T>
+spIdx<T> spIdx<T>::select(int d, intg i) const {
+  if (order() < 2) eblerror("cannot select in a 1D sparse idx");
+  if (d < 0 || d >= order() || i < 0 || i >= dim(d))
+    eblerror("trying to select slice " << i << " of dimension " << d
+             << " in " << dims);
+  idxdim nd(dims);
+  nd.remove_dim(d);
+  spIdx<T> r(0, nd);
+  intg pos[MAXDIMS], o = order();
+  for (intg e = 0; e < nelem; ++e) {
+    const intg *p = index_ptr(e);
+    if (p[d] != i) continue ;
+    for (intg j = 0, k = 0; j < o; ++j)
+      if (j != d) pos[k++] = p[j];
+    r.append(val.get(e), pos); // order is preserved
+  }
+  return r;
+}
+
+template <typename T>
+spIdx<T> spIdx<T>::transpose(int d1, int d2) const {
+  int p[MAXDIMS];
+  for (int i = 0; i < order(); ++i) p[i] = i;
+  p[d1] = d2;
+  p[d2] = d1;
+  return transpose(p);
+}
+
+template <typename T>
+spIdx<T> spIdx<T>::transpose(int *p) const {
+  intg o = order();
+  idxdim nd(dims);
+  for (intg i = 0; i < o; ++i) {
+    if (p[i] < 0 || p[i] >= o)
+      eblerror("illegal transpose permutation " << p[i] << " in " << dims);
+    nd.setdim(i, dim(p[i]));
+  }
+  spIdx<T> r(nelem, nd);
+  intg *rp = r.ind.idx_ptr();
+  for (intg e = 0; e < nelem; ++e) {
+    const intg *pe = index_ptr(e);
+    for (intg i = 0; i < o; ++i) rp[e * o + i] = pe[p[i]];
+  }
+  memcpy(r.val.idx_ptr(), val.idx_ptr(), nelem * sizeof (T));
+  r.nelem = nelem;
+  r.sort();
+  return r;
+}
+
+// resizing and sorting ////////////////////////////////////////////////////////
+
+template <typename T>
+void spIdx<T>::resize(intg s0, intg s1, intg s2, intg s3, intg s4, intg s5,
+                      intg s6, intg s7) {
+  resize(idxdim(s0, s1, s2, s3, s4, s5, s6, s7));
+}
+
+template <typename T>
+void spIdx<T>::resize(const idxdim &d) {
+  if (d.order() != dims.order())
+    eblerror("cannot change order when resizing " << dims << " to " << d);
+  // remove elements out of new bounds, keeping order
+  intg o = order(), n = 0;
+  intg *p = ind.idx_ptr();
+  T *pv = val.idx_ptr();
+  for (intg e = 0; e < nelem; ++e) {
+    bool in = true;
+    for (intg i = 0; i < o && in; ++i) in = p[e * o + i] < d.dim(i);
+    if (!in) continue ;
+    if (n != e) {
+      memcpy(p + n * o, p + e * o, o * sizeof (intg));
+      pv[n] = pv[e];
+    }
+    n++;
+  }
+  nelem = n;
+  dims = d;
+}
+
+//! Lexicographic comparison of element coordinates, used by spIdx::sort().
+class spidx_index_less {
+ public:
+  spidx_index_less(const intg *p_, intg o_) : p(p_), o(o_) {}
+  bool operator()(intg a, intg b) const {
+    const intg *pa = p + a * o, *pb = p + b * o;
+    for (intg i = 0; i < o; ++i)
+      if (pa[i] != pb[i]) return pa[i] < pb[i];
+    return false;
+  }
+ private:
+  const intg *p;
+  intg o;
+};
+
+template <typename T>
+void spIdx<T>::sort() {
+  intg o = order();
+  std::vector<intg> perm(nelem);
+  for (intg e = 0; e < nelem; ++e) perm[e] = e;
+  std::stable_sort(perm.begin(), perm.end(),
+                   spidx_index_less(ind.idx_ptr(), o));
+  idx<intg> sind(std::max(nelem, (intg) 1), o);
+  idx<T> sval(std::max(nelem, (intg) 1));
+  for (intg e = 0; e < nelem; ++e) {
+    memcpy(sind.idx_ptr() + e * o, ind.idx_ptr() + perm[e] * o,
+           o * sizeof (intg));
+    sval.set(val.get(perm[e]), e);
+  }
+  ind = sind;
+  val = sval;
+}
+
+template <typename T>
+idx<intg> spIdx<T>::row_offsets() const {
+  idx<intg> r(dim(0) + 1);
+  idx_clear(r);
+  intg *pr = r.idx_ptr(), o = order();
+  for (intg e = 0; e < nelem; ++e) pr[ind.idx_ptr()[e * o] + 1]++;
+  for (intg i = 0; i < dim(0); ++i) pr[i + 1] += pr[i];
+  return r;
+}
+
+// printing ////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void spIdx<T>::pretty(std::ostream &out) const {
+  out << "sparse idx of order " << order() << " and dimensions " << dims
+      << " with " << nelem << " elements" << std::endl;
+}
+
+template <typename T>
+void spIdx<T>::printElems(std::ostream &out) const {
+  intg o = order();
+  for (intg e = 0; e < nelem; ++e) {
+    const intg *p = index_ptr(e);
+    out << "(";
+    for (intg i = 0; i < o; ++i) out << (i ? ", " : "") << p[i];
+    out << ") = " << val.get(e) << std::endl;
+  }
+}
+
+// internal methods ////////////////////////////////////////////////////////////
+
+template <typename T>
+void spIdx<T>::init(intg nelemmax, const idxdim &d) {
+  if (d.order() < 1) eblerror("expected a sparse idx of order at least 1");
+  dims = d;
+  nelem = 0;
+  nelemmax = std::max(nelemmax, (intg) 1);
+  ind = idx<intg>(nelemmax, d.order());
+  val = idx<T>(nelemmax);
+}
+
+template <typename T>
+void spIdx<T>::reserve(intg n) {
+  if (n <= val.dim(0)) return ;
+  intg cap = std::max(n, 2 * val.dim(0));
+  idx<intg> nind(cap, order());
+  idx<T> nval(cap);
+  memcpy(nind.idx_ptr(), ind.idx_ptr(), nelem * order() * sizeof (intg));
+  memcpy(nval.idx_ptr(), val.idx_ptr(), nelem * sizeof (T));
+  ind = nind;
+  val = nval;
+}
+
+template <typename T>
+intg spIdx<T>::find(const intg *pos, bool &found) const {
+  intg lo = 0, hi = nelem, o = order();
+  const intg *p = ind.idx_ptr();
+  found = false;
+  while (lo < hi) { // lower bound
+    intg mid = (lo + hi) / 2, c = 0;
+    const intg *pm = p + mid * o;
+    for (intg i = 0; i < o && c == 0; ++i)
+      c = pm[i] < pos[i] ? -1 : (pm[i] > pos[i] ? 1 : 0);
+    if (c < 0) lo = mid + 1;
+    else {
+      if (c == 0) found = true;
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+template <typename T>
+void spIdx<T>::check_pos(intg *pos, intg i0, intg i1, intg i2, intg i3,
+                         intg i4, intg i5, intg i6, intg i7) const {
+  pos[0] = i0; pos[1] = i1; pos[2] = i2; pos[3] = i3;
+  pos[4] = i4; pos[5] = i5; pos[6] = i6; pos[7] = i7;
+  intg o = order();
+  for (intg i = 0; i < MAXDIMS; ++i) {
+    if (i < o && (pos[i] < 0 || pos[i] >= dims.dim(i)))
+      eblerror("coordinate " << pos[i] << " out of bounds in dimension " << i
+               << " of " << dims);
+    if (i >= o && pos[i] != -1)
+      eblerror("too many coordinates for " << dims);
+  }
+}
+
+} // end namespace ebl
+
+#endif /* SPIDX_HPP_ */
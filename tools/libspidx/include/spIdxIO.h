@@ -0,0 +1,83 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Cyril Poulet   *
+ *   cyril.poulet@centraliens.net   *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef SPIDXIO_H_
+#define SPIDXIO_H_
+
+#include "spIdx.h"
+
+//! Magic number of sparse matrix files. Following the magic number are the
+//! order, the dimensions (at least 3 as in dense files) and the number of
+//! stored elements, all as ints. If there are elements, they follow as
+//! a dense long matrix of coordinates (elements x order) and a dense
+//! matrix of values.
+#define MAGIC_SPARSE_MATRIX	0x1e3d4c5c
+
+namespace ebl {
+
+// loading /////////////////////////////////////////////////////////////////////
+
+//! Loads sparse matrix 'm' from file 'filename'. 'm' takes the dimensions
+//! found in the file and values are cast into T if stored with another type.
+//! This throws string exceptions upon errors.
+template <typename T>
+void load_matrix(spIdx<T> &m, const char *filename);
+//! Loads sparse matrix 'm' from file 'filename'.
+//! This throws string exceptions upon errors.
+template <typename T>
+void load_matrix(spIdx<T> &m, const std::string &filename);
+
+// saving //////////////////////////////////////////////////////////////////////
+
+//! Saves sparse matrix 'm' in file 'filename'.
+//! Returns true if successful, false otherwise.
+template <typename T>
+bool save_matrix(spIdx<T> &m, const char *filename);
+//! Saves sparse matrix 'm' in file 'filename'.
+//! Returns true if successful, false otherwise.
+template <typename T>
+bool save_matrix(spIdx<T> &m, const std::string &filename);
+
+// headers /////////////////////////////////////////////////////////////////////
+
+//! Writes the header of a sparse matrix of dimensions 'd' with 'nelem'
+//! elements into 'fp'. Returns false upon error.
+EXPORT bool write_sparse_header(FILE *fp, const idxdim &d, intg nelem);
+//! Reads the header of a sparse matrix from 'fp', returns its dimensions
+//! and sets 'nelem' to its number of elements. This throws string
+//! exceptions upon errors.
+EXPORT idxdim read_sparse_header(FILE *fp, intg &nelem);
+
+} // end namespace ebl
+
+#include "spIdxIO.hpp"
+
+#endif /* SPIDXIO_H_ */
@@ -0,0 +1,97 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Cyril Poulet   *
+ *   cyril.poulet@centraliens.net   *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef SPIDXIO_HPP_
+#define SPIDXIO_HPP_
+
+namespace ebl {
+
+// loading /////////////////////////////////////////////////////////////////////
+
+template <typename T>
+void load_matrix(spIdx<T> &m, const char *filename) {
+  FILE *fp = fopen(filename, "rb");
+  if (!fp) eblthrow("load_matrix failed to open " << filename);
+  intg nelem = 0;
+  idxdim d = read_sparse_header(fp, nelem);
+  spIdx<T> r(nelem, d);
+  if (nelem > 0) {
+    idx<intg> ind = load_matrix<intg>(fp, NULL);
+    idx<T> val = load_matrix<T>(fp, NULL);
+    if (ind.order() != 2 || ind.dim(0) != nelem || ind.dim(1) != d.order()
+        || val.order() != 1 || val.dim(0) != nelem) {
+      fclose(fp);
+      eblthrow("inconsistent sparse matrix in " << filename << ": " << ind
+               << " coordinates and " << val << " values for " << nelem
+               << " elements of " << d);
+    }
+    // elements are saved in order, so appending keeps them sorted
+    for (intg e = 0; e < nelem; ++e)
+      r.append(val.get(e), ind.idx_ptr() + e * d.order());
+  }
+  fclose(fp);
+  m = r;
+}
+
+template <typename T>
+void load_matrix(spIdx<T> &m, const std::string &filename) {
+  load_matrix(m, filename.c_str());
+}
+
+// saving //////////////////////////////////////////////////////////////////////
+
+template <typename T>
+bool save_matrix(spIdx<T> &m, const char *filename) {
+  FILE *fp = fopen(filename, "wb");
+  if (!fp) {
+    eblwarn("save_matrix failed (" << filename << "): ");
+    perror("");
+    return false;
+  }
+  bool ret = write_sparse_header(fp, m.get_idxdim(), m.nelements());
+  if (ret && m.nelements() > 0) {
+    idx<intg> ind = m.index()->narrow(0, m.nelements(), 0);
+    idx<T> val = m.values()->narrow(0, m.nelements(), 0);
+    ret = save_matrix(ind, fp) && save_matrix(val, fp);
+  }
+  fclose(fp);
+  if (!ret) eblwarn("save_matrix failed (" << filename << ")");
+  return ret;
+}
+
+template <typename T>
+bool save_matrix(spIdx<T> &m, const std::string &filename) {
+  return save_matrix(m, filename.c_str());
+}
+
+} // end namespace ebl
+
+#endif /* SPIDXIO_HPP_ */
@@ -0,0 +1,153 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Cyril Poulet   *
+ *   cyril.poulet@centraliens.net   *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef SPMODULES_H_
+#define SPMODULES_H_
+
+#include "libspidx.h"
+#include "ebl_basic.h"
+
+namespace ebl {
+
+// Sparse versions of trained modules, for pruned networks where most
+// weights are zero. The cost of fprop, bprop and bbprop is proportional to
+// the number of remaining weights instead of the dense weight count.
+// These modules share the weights of the dense module they wrap: pruned
+// weights are set to zero in the dense module and remaining ones are read
+// from it again at the first fprop following a backward pass, so that
+// training the sparse module trains the dense one (pruned weights stay pruned
+// since they receive no gradient). Call refresh() after modifying the dense
+// weights any other way.
+// Unlike libspidx itself, this header requires libeblearn.
+
+// sparse_linear_module ////////////////////////////////////////////////////////
+
+//! A linear module whose weight matrix is pruned and stored as a sparse
+//! matrix, computing \f$\vec{out} = W \vec{in}\f$ with sparse W.
+template <typename T> class sparse_linear_module : public module_1_1<T> {
+ public:
+  //! Constructor.
+  //! \param l The trained dense module, it is not owned.
+  //! \param threshold Weights with an absolute value not greater than
+  //!   'threshold' are pruned.
+  sparse_linear_module(linear_module<T> &l, T threshold = 0,
+                       const char *name = "sparse_linear");
+  //! Destructor.
+  virtual ~sparse_linear_module();
+  //! Forward propagation from 'in' tensor to 'out' tensor.
+  virtual void fprop1(idx<T> &in, idx<T> &out);
+  //! Backward propagation from out to in, only remaining weights get
+  //! gradients.
+  virtual void bprop1(state<T> &in, state<T> &out);
+  //! Second-derivative backward propagation from out to in.
+  virtual void bbprop1(state<T> &in, state<T> &out);
+  //! Prunes weights with an absolute value not greater than 'threshold'.
+  virtual void prune(T threshold);
+  //! Reads remaining weights again from the dense module.
+  virtual void refresh();
+  //! Returns the fraction of remaining weights.
+  virtual double density();
+  //! Append the weights of the dense module to 'states', since gradients
+  //! are accumulated into them.
+  virtual void get_weights(std::vector<state<T>*> &states);
+  //! Return dimensions that are compatible with this module.
+  virtual fidxdim fprop1_size(fidxdim &i_size);
+  //! Return dimensions compatible with this module given output dimensions.
+  virtual fidxdim bprop1_size(const fidxdim &o_size);
+  //! Returns a string describing this module and its parameters.
+  virtual std::string describe();
+  // members ///////////////////////////////////////////////////////////////////
+ public:
+  linear_module<T> &lin; //!< The dense module.
+  spIdx<T> w; //!< Remaining weights.
+ protected:
+  bool stale; //!< Dense weights may have changed since last read.
+};
+
+// sparse_convolution_module ///////////////////////////////////////////////////
+
+//! A convolution module whose kernels are pruned and stored as a sparse
+//! tensor of dimensions connections x kernel height x kernel width. Each
+//! remaining tap adds a strided, scaled input map to an output map.
+template <typename T> class sparse_convolution_module : public module_1_1<T> {
+ public:
+  //! Constructor.
+  //! \param c The trained dense module, it is not owned.
+  //! \param threshold Kernel weights with an absolute value not greater than
+  //!   'threshold' are pruned.
+  sparse_convolution_module(convolution_module<T> &c, T threshold = 0,
+                            const char *name = "sparse_convolution");
+  //! Destructor.
+  virtual ~sparse_convolution_module();
+  //! Forward propagation from 'in' tensor to 'out' tensor.
+  virtual void fprop1(idx<T> &in, idx<T> &out);
+  //! Backward propagation from out to in, only remaining weights get
+  //! gradients.
+  virtual void bprop1(state<T> &in, state<T> &out);
+  //! Second-derivative backward propagation from out to in.
+  virtual void bbprop1(state<T> &in, state<T> &out);
+  //! Order of operation.
+  virtual int replicable_order() { return 3; }
+  //! Prunes weights with an absolute value not greater than 'threshold'.
+  virtual void prune(T threshold);
+  //! Reads remaining weights again from the dense module.
+  virtual void refresh();
+  //! Returns the fraction of remaining weights.
+  virtual double density();
+  //! Append the weights of the dense module to 'states', since gradients
+  //! are accumulated into them.
+  virtual void get_weights(std::vector<state<T>*> &states);
+  //! Return dimensions that are compatible with this module.
+  virtual fidxdim fprop1_size(fidxdim &i_size);
+  //! Return dimensions compatible with this module given output dimensions.
+  virtual fidxdim bprop1_size(const fidxdim &o_size);
+  //! Returns a string describing this module and its parameters.
+  virtual std::string describe();
+ protected:
+  //! Returns 'in' cropped as convolution_module does.
+  idx<T> crop_input(idx<T> &in);
+  //! Propagates 'outd' to 'ind' and accumulates kernel gradients in 'kd'.
+  //! \param squ If true, use squared weights and inputs (bbprop).
+  void backward(idx<T> &inx, idx<T> &ind, idx<T> &outd, idx<T> &kd, bool squ);
+  // members ///////////////////////////////////////////////////////////////////
+ public:
+  convolution_module<T> &conv; //!< The dense module.
+  spIdx<T> taps; //!< Remaining kernel weights.
+ protected:
+  bool stale; //!< Dense weights may have changed since last read.
+  idx<intg> offsets; //!< Range of taps of each connection.
+};
+
+} // end namespace ebl
+
+#include "spModules.hpp"
+
+#endif /* SPMODULES_H_ */
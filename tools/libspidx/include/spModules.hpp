@@ -0,0 +1,321 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Cyril Poulet   *
+ *   cyril.poulet@centraliens.net   *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#ifndef SPMODULES_HPP_
+#define SPMODULES_HPP_
+
+namespace ebl {
+
+//! Returns a matrix view of contiguous 'm', of dimensions
+//! dim(0) x (all other dimensions flattened).
+template <typename T> idx<T> spidx_flat2(idx<T> &m) {
+  CHECK_CONTIGUOUS1(m);
+  return idx<T>(m.getstorage(), m.offset(), m.dim(0),
+                m.nelements() / m.dim(0));
+}
+
+//! Zeroes elements of 'm' with an absolute value not greater than 'thr'.
+template <typename T> void spidx_prune(idx<T> &m, T thr) {
+  idx_aloop1(v, m, T) {
+    if (*v <= thr && *v >= -thr) *v = 0;
+  }
+}
+
+// sparse_linear_module ////////////////////////////////////////////////////////
+
+template <typename T>
+sparse_linear_module<T>::sparse_linear_module(linear_module<T> &l,
+                                              T threshold, const char *name_)
+    : module_1_1<T>(name_), lin(l), w(0, l.w.dim(0), l.w.dim(1)) {
+  prune(threshold);
+}
+
+template <typename T>
+sparse_linear_module<T>::~sparse_linear_module() {
+}
+
+template <typename T>
+void sparse_linear_module<T>::fprop1(idx<T> &in, idx<T> &out) {
+  if (in.dim(0) != w.dim(1))
+    eblerror(this->name() << ": expected " << w.dim(1)
+             << " elements in dimension 0 but got " << in);
+  // flatten dimensions starting from second one, as linear_module does
+  idxdim d(in);
+  d.remove_dim(0);
+  d.insert_dim(0, w.dim(0));
+  this->resize_output(in, out, &d); // resize (iff necessary)
+  idx<T> inx = spidx_flat2(in), outx = spidx_flat2(out);
+  if (stale) refresh(); // the dense module may have trained
+  idx_m2dotm2(w, inx, outx);
+}
+
+template <typename T>
+void sparse_linear_module<T>::bprop1(state<T> &in, state<T> &out) {
+  DEBUG_CHECK_DX(in); // in debug mode, check backward tensors are allocated
+  stale = true; // weights may be updated from these gradients
+  idx<T> inx = spidx_flat2(in), indx = spidx_flat2(in.dx[0]);
+  idx<T> outdx = spidx_flat2(out.dx[0]), wdx = lin.w.dx[0];
+  intg c, ncols = inx.dim(1);
+  for (intg e = 0; e < w.nelements(); ++e) {
+    const intg *p = w.index_ptr(e);
+    T v = *w.values_ptr(e), g = 0;
+    T *pin = inx.idx_ptr() + p[1] * ncols, *pind = indx.idx_ptr() + p[1] * ncols;
+    T *pout = outdx.idx_ptr() + p[0] * ncols;
+    for (c = 0; c < ncols; ++c) {
+      pind[c] += v * pout[c]; // backprop to input
+      g += pout[c] * pin[c];
+    }
+    wdx.set(wdx.get(p[0], p[1]) + g, p[0], p[1]); // backprop to weights
+  }
+}
+
+template <typename T>
+void sparse_linear_module<T>::bbprop1(state<T> &in, state<T> &out) {
+  DEBUG_CHECK_DDX(in); // in debug mode, check backward tensors are allocated
+  stale = true; // weights may be updated from these gradients
+  idx<T> inx = spidx_flat2(in), inddx = spidx_flat2(in.ddx[0]);
+  idx<T> outddx = spidx_flat2(out.ddx[0]), wddx = lin.w.ddx[0];
+  intg c, ncols = inx.dim(1);
+  for (intg e = 0; e < w.nelements(); ++e) {
+    const intg *p = w.index_ptr(e);
+    T v = *w.values_ptr(e), g = 0;
+    T *pin = inx.idx_ptr() + p[1] * ncols;
+    T *pind = inddx.idx_ptr() + p[1] * ncols;
+    T *pout = outddx.idx_ptr() + p[0] * ncols;
+    for (c = 0; c < ncols; ++c) {
+      pind[c] += v * v * pout[c]; // backprop to input
+      g += pout[c] * pin[c] * pin[c];
+    }
+    wddx.set(wddx.get(p[0], p[1]) + g, p[0], p[1]); // backprop to weights
+  }
+}
+
+template <typename T>
+void sparse_linear_module<T>::prune(T threshold) {
+  idx<T> wx = lin.w;
+  spidx_prune(wx, threshold);
+  idx_copy(wx, w);
+  stale = false;
+}
+
+template <typename T>
+void sparse_linear_module<T>::refresh() {
+  T *pw = lin.w.idx_ptr();
+  intg m0 = lin.w.mod(0), m1 = lin.w.mod(1);
+  for (intg e = 0; e < w.nelements(); ++e) {
+    const intg *p = w.index_ptr(e);
+    *w.values_ptr(e) = pw[p[0] * m0 + p[1] * m1];
+  }
+  stale = false;
+}
+
+template <typename T>
+double sparse_linear_module<T>::density() {
+  return w.nelements() / (double) (w.dim(0) * w.dim(1));
+}
+
+template <typename T>
+void sparse_linear_module<T>::get_weights(std::vector<state<T>*> &states) {
+  lin.get_weights(states);
+}
+
+template <typename T>
+fidxdim sparse_linear_module<T>::fprop1_size(fidxdim &isize) {
+  return lin.fprop1_size(isize);
+}
+
+template <typename T>
+fidxdim sparse_linear_module<T>::bprop1_size(const fidxdim &osize) {
+  return lin.bprop1_size(osize);
+}
+
+template <typename T>
+std::string sparse_linear_module<T>::describe() {
+  std::string s;
+  s << "sparse " << lin.describe() << ", " << w.nelements()
+    << " remaining weights (density " << density() << ")";
+  return s;
+}
+
+// sparse_convolution_module ///////////////////////////////////////////////////
+
+template <typename T>
+sparse_convolution_module<T>::
+sparse_convolution_module(convolution_module<T> &c, T threshold,
+                          const char *name_)
+    : module_1_1<T>(name_), conv(c),
+      taps(0, c.kernel.dim(0), c.kernel.dim(1), c.kernel.dim(2)) {
+  prune(threshold);
+}
+
+template <typename T>
+sparse_convolution_module<T>::~sparse_convolution_module() {
+}
+
+template <typename T>
+void sparse_convolution_module<T>::fprop1(idx<T> &in, idx<T> &out) {
+  if (!conv.resize_output(in, out))
+    return ; // do nothing if resizing failed
+  idx<T> inx = crop_input(in);
+  idx_clear(out);
+  if (stale) refresh(); // the dense module may have trained
+  intg si = conv.stride.dim(0), sj = conv.stride.dim(1);
+  intg oh = out.dim(1), ow = out.dim(2), i, j;
+  for (intg c = 0; c < taps.dim(0); ++c) {
+    idx<T> sin = inx.select(0, conv.table.get(c, 0));
+    idx<T> sout = out.select(0, conv.table.get(c, 1));
+    intg im0 = sin.mod(0) * si, im1 = sin.mod(1) * sj;
+    intg om0 = sout.mod(0), om1 = sout.mod(1);
+    for (intg e = offsets.get(c); e < offsets.get(c + 1); ++e) {
+      const intg *p = taps.index_ptr(e);
+      T v = *taps.values_ptr(e);
+      // add the strided input window of this tap, scaled by v
+      T *pi = sin.idx_ptr() + p[1] * sin.mod(0) + p[2] * sin.mod(1);
+      T *po = sout.idx_ptr();
+      for (i = 0; i < oh; ++i)
+        for (j = 0; j < ow; ++j)
+          po[i * om0 + j * om1] += v * pi[i * im0 + j * im1];
+    }
+  }
+}
+
+template <typename T>
+void sparse_convolution_module<T>::bprop1(state<T> &in, state<T> &out) {
+  DEBUG_CHECK_DX(in); // in debug mode, check backward tensors are allocated
+  stale = true; // weights may be updated from these gradients
+  idx<T> inx = crop_input(in), indx = crop_input(in.dx[0]);
+  backward(inx, indx, out.dx[0], conv.kernel.dx[0], false);
+}
+
+template <typename T>
+void sparse_convolution_module<T>::bbprop1(state<T> &in, state<T> &out) {
+  DEBUG_CHECK_DDX(in); // in debug mode, check backward tensors are allocated
+  stale = true; // weights may be updated from these gradients
+  idx<T> inx = crop_input(in), inddx = crop_input(in.ddx[0]);
+  backward(inx, inddx, out.ddx[0], conv.kernel.ddx[0], true);
+}
+
+template <typename T>
+void sparse_convolution_module<T>::prune(T threshold) {
+  idx<T> kx = conv.kernel;
+  spidx_prune(kx, threshold);
+  idx_copy(kx, taps);
+  offsets = taps.row_offsets();
+  stale = false;
+}
+
+template <typename T>
+void sparse_convolution_module<T>::refresh() {
+  T *pk = conv.kernel.idx_ptr();
+  intg m0 = conv.kernel.mod(0), m1 = conv.kernel.mod(1);
+  intg m2 = conv.kernel.mod(2);
+  for (intg e = 0; e < taps.nelements(); ++e) {
+    const intg *p = taps.index_ptr(e);
+    *taps.values_ptr(e) = pk[p[0] * m0 + p[1] * m1 + p[2] * m2];
+  }
+  stale = false;
+}
+
+template <typename T>
+double sparse_convolution_module<T>::density() {
+  return taps.nelements() / (double) conv.kernel.nelements();
+}
+
+template <typename T>
+void sparse_convolution_module<T>::get_weights(std::vector<state<T>*> &states) {
+  conv.get_weights(states);
+}
+
+template <typename T>
+fidxdim sparse_convolution_module<T>::fprop1_size(fidxdim &isize) {
+  return conv.fprop1_size(isize);
+}
+
+template <typename T>
+fidxdim sparse_convolution_module<T>::bprop1_size(const fidxdim &osize) {
+  return conv.bprop1_size(osize);
+}
+
+template <typename T>
+std::string sparse_convolution_module<T>::describe() {
+  std::string s;
+  s << "sparse " << conv.describe() << ", " << taps.nelements()
+    << " remaining weights (density " << density() << ")";
+  return s;
+}
+
+// protected methods ///////////////////////////////////////////////////////////
+
+template <typename T>
+idx<T> sparse_convolution_module<T>::crop_input(idx<T> &in) {
+  idx<T> inx = in;
+  intg ki = conv.kernel.dim(1), kj = conv.kernel.dim(2);
+  intg si = conv.stride.dim(0), sj = conv.stride.dim(1);
+  intg oi = in.dim(1) - (ki - si), oj = in.dim(2) - (kj - sj);
+  if (oi % si != 0) inx = inx.narrow(1, in.dim(1) - oi % si, 0);
+  if (oj % sj != 0) inx = inx.narrow(2, in.dim(2) - oj % sj, 0);
+  return inx;
+}
+
+template <typename T>
+void sparse_convolution_module<T>::backward(idx<T> &inx, idx<T> &ind,
+                                            idx<T> &outd, idx<T> &kd,
+                                            bool squ) {
+  intg si = conv.stride.dim(0), sj = conv.stride.dim(1);
+  intg oh = outd.dim(1), ow = outd.dim(2), i, j;
+  for (intg c = 0; c < taps.dim(0); ++c) {
+    intg ti = conv.table.get(c, 0);
+    idx<T> sin = inx.select(0, ti), sind = ind.select(0, ti);
+    idx<T> sout = outd.select(0, conv.table.get(c, 1));
+    intg im0 = sin.mod(0) * si, im1 = sin.mod(1) * sj;
+    intg dm0 = sind.mod(0) * si, dm1 = sind.mod(1) * sj;
+    intg om0 = sout.mod(0), om1 = sout.mod(1);
+    for (intg e = offsets.get(c); e < offsets.get(c + 1); ++e) {
+      const intg *p = taps.index_ptr(e);
+      T v = *taps.values_ptr(e), g = 0;
+      if (squ) v = v * v;
+      T *pi = sin.idx_ptr() + p[1] * sin.mod(0) + p[2] * sin.mod(1);
+      T *pd = sind.idx_ptr() + p[1] * sind.mod(0) + p[2] * sind.mod(1);
+      T *po = sout.idx_ptr();
+      for (i = 0; i < oh; ++i)
+        for (j = 0; j < ow; ++j) {
+          T o = po[i * om0 + j * om1], x = pi[i * im0 + j * im1];
+          pd[i * dm0 + j * dm1] += v * o; // backprop to input
+          g += o * (squ ? x * x : x);
+        }
+      kd.set(kd.get(p[0], p[1], p[2]) + g, p[0], p[1], p[2]);
+    }
+  }
+}
+
+} // end namespace ebl
+
+#endif /* SPMODULES_HPP_ */
@@ -0,0 +1,92 @@
+/***************************************************************************
+ *   Copyright (C) 2008 by Cyril Poulet   *
+ *   cyril.poulet@centraliens.net   *
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#include <stdio.h>
+#include "spIdxIO.h"
+
+namespace ebl {
+
+bool write_sparse_header(FILE *fp, const idxdim &d, intg nelem) {
+  int v = MAGIC_SPARSE_MATRIX;
+  if (fwrite(&v, sizeof (int), 1, fp) != 1) return false;
+  v = (int) d.order();
+  if (fwrite(&v, sizeof (int), 1, fp) != 1) return false;
+  for (intg i = 0; (i < d.order()) || (i < 3); ++i) {
+    v = i < d.order() ? (int) d.dim(i) : 1;
+    if (fwrite(&v, sizeof (int), 1, fp) != 1) return false;
+  }
+  v = (int) nelem;
+  if (fwrite(&v, sizeof (int), 1, fp) != 1) return false;
+  return true;
+}
+
+idxdim read_sparse_header(FILE *fp, intg &nelem) {
+  int magic, ndim, v;
+  if (fread(&magic, sizeof (int), 1, fp) != 1) {
+    fclose(fp);
+    eblthrow("cannot read magic number");
+  }
+  if (magic != MAGIC_SPARSE_MATRIX) {
+    fclose(fp);
+    eblthrow("not a sparse matrix, magic number is " << magic);
+  }
+  if (fread(&ndim, sizeof (int), 1, fp) != 1) {
+    fclose(fp);
+    eblthrow("cannot read number of dimensions");
+  }
+  if (ndim < 1 || ndim > MAXDIMS) {
+    fclose(fp);
+    eblthrow("invalid number of dimensions: " << ndim << " (MAXDIMS = "
+             << MAXDIMS << ").");
+  }
+  idxdim dims;
+  for (int i = 0; (i < ndim) || (i < 3); ++i) {
+    if (fread(&v, sizeof (int), 1, fp) != 1) {
+      fclose(fp);
+      eblthrow("failed to read matrix dimensions");
+    }
+    if (i < ndim) {
+      if (v <= 0) {
+        fclose(fp);
+        eblthrow("dimension is negative or zero");
+      }
+      dims.insert_dim(i, v);
+    }
+  }
+  if (fread(&v, sizeof (int), 1, fp) != 1 || v < 0) {
+    fclose(fp);
+    eblthrow("failed to read number of elements");
+  }
+  nelem = v;
+  return dims;
+}
+
+} // end namespace ebl
@@ -17,7 +17,9 @@ LOCAL_SRC_FILES  := \
 		    $(SRC)/ebl_logger.cpp \
 		    $(SRC)/ebl_module.cpp \
 		    $(SRC)/ebl_utils.cpp \
-		    $(SRC)/ebl_parameters.cpp
+		    $(SRC)/ebl_parameters.cpp \
+		    $(SRC)/ebl_profiler.cpp \
+		    $(SRC)/detector.cpp
 		    #entries.cpp
 
 	       	    #$(SRC)/ebl_arch.cpp \
@@ -29,7 +31,6 @@ LOCAL_SRC_FILES  := \
 		    #$(SRC)/ebl_basic.cpp \
 		    #$(SRC)/ebl_cost.cpp \
 		    #$(SRC)/ebl_layers.cpp \
-	       	    #$(SRC)/detector.cpp \
 	       	    # $(SRC)/ebl_codec.cpp \
 		    # $(SRC)/datasource.cpp \
 		    # $(SRC)/ebl_trainer.cpp \
@@ -8,6 +8,7 @@
 class datasource_test : public CppUnit::TestFixture  {
   CPPUNIT_TEST_SUITE(datasource_test);
   //  CPPUNIT_TEST(test_mnist_LabeledDataSource); // TODO: fix test
+  CPPUNIT_TEST(test_state);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -21,6 +22,9 @@ public:
 
   // Test functions
   void test_mnist_LabeledDataSource();
+  //! Checks that resuming from write_state()/read_state() continues the
+  //! same training sequence.
+  void test_state();
 };
 
 #endif /* DATASOURCE_TEST_H_ */
@@ -8,6 +8,15 @@
 class detector_test : public CppUnit::TestFixture  {
   CPPUNIT_TEST_SUITE(detector_test);
   CPPUNIT_TEST(test_face);
+  CPPUNIT_TEST(test_netbundle);
+  CPPUNIT_TEST(test_plan_cache);
+  CPPUNIT_TEST(test_cascade);
+  CPPUNIT_TEST(test_incremental);
+  CPPUNIT_TEST(test_batch);
+  CPPUNIT_TEST(test_batch_thread);
+  CPPUNIT_TEST(test_timing_percentiles);
+  CPPUNIT_TEST(test_camera_synthetic);
+  CPPUNIT_TEST(test_stage_timing_fallback);
   /* CPPUNIT_TEST(test_norb); */
   //CPPUNIT_TEST(test_norb_binoc);
   CPPUNIT_TEST_SUITE_END();
@@ -23,6 +32,29 @@ public:
 
   // Test functions
   void test_face();
+  //! Check a network bundle reproduces the weights and detections of the
+  //! configuration it was compiled from.
+  void test_netbundle();
+  //! Check that alternating input sizes with plans caching enabled yields
+  //! the same detections as without caching.
+  void test_plan_cache();
+  //! Test that cascade detection matches regular detection when nothing is
+  //! rejected, and skips the rest of the network when everything is.
+  void test_cascade();
+  //! Test that incremental detection only recomputes changed regions and
+  //! matches regular detection on them.
+  void test_incremental();
+  //! Test batched detection of several frames.
+  void test_batch();
+  //! Test that a detection thread batching frames matches one that does not.
+  void test_batch_thread();
+  //! Test nearest-rank percentiles of per-stage detection latencies.
+  void test_timing_percentiles();
+  //! Test that synthetic camera frames only depend on their seed and index.
+  void test_camera_synthetic();
+  //! Test that stage timing falls back to timing the pyramid in fprop when
+  //! the resizing module is nested or last in the network.
+  void test_stage_timing_fallback();
   //  void test_norb();
   void test_norb_binoc();
 };
@@ -6,6 +6,9 @@
 #include "ebl_layers.h"
 #include "ebl_tester.h"
 #include "ebl_pooling.h"
+#include "ebl_quantize.h"
+#include "ebl_march.h"
+#include "ebl_merge.h"
 
 //! Test class for Ebm class
 class ebl_basic_test : public CppUnit::TestFixture  {
@@ -49,6 +52,7 @@ class ebl_basic_test : public CppUnit::TestFixture  {
 
   //CPPUNIT_TEST(test_wavg_pooling_module_double); //segfaults
   CPPUNIT_TEST(test_l2pooling_module_double); //inconsistent tensor size?
+  CPPUNIT_TEST(test_maxss_module_double);
   CPPUNIT_TEST(test_sqrt_power_module_double);
   CPPUNIT_TEST(test_power2_module_double);
   CPPUNIT_TEST(test_power_inv_module_double);
@@ -66,6 +70,14 @@ class ebl_basic_test : public CppUnit::TestFixture  {
   CPPUNIT_TEST(test_state_copy);
   
   CPPUNIT_TEST(test_convolution_timing); 
+  CPPUNIT_TEST(test_convolution_bprop_parallel);
+  CPPUNIT_TEST(test_convolution_sizes);
+  CPPUNIT_TEST(test_convolution_fixed_kernels);
+  CPPUNIT_TEST(test_ms_module_parallel);
+  CPPUNIT_TEST(test_ms_module_shared_weights);
+  CPPUNIT_TEST(test_ms_module_dropout_threads);
+  CPPUNIT_TEST(test_profiler);
+  CPPUNIT_TEST(test_quantized_layers);
   
   CPPUNIT_TEST_SUITE_END();
 
@@ -88,6 +100,20 @@ public:
   void test_softmax();
   void test_state_copy();
   void test_convolution_timing();
+  void test_convolution_bprop_parallel();
+  //! Test a convolution reused on inputs of different sizes.
+  void test_convolution_sizes();
+  //! Test fixed-size convolution kernels against the generic operations.
+  void test_convolution_fixed_kernels();
+  //! Test concurrent pipes of ms_module and their concatenation.
+  void test_ms_module_parallel();
+  //! Test parallel ms_module pipes sharing the same weights.
+  void test_ms_module_shared_weights();
+  //! Test that concurrent dropout pipes do not depend on the thread count.
+  void test_ms_module_dropout_threads();
+  //! Test per-module profiling through layers and ms_module.
+  void test_profiler();
+  void test_quantized_layers();
   void test_convolution_module_float();
   void test_convolution_module_cuda();
   void test_convolution_module_double();
@@ -97,6 +123,7 @@ public:
   void test_wavg_pooling_module_double();
   void test_l2pooling_module_float();
   void test_l2pooling_module_double();
+  void test_maxss_module_double();
   void test_sqrt_power_module_float();
   void test_sqrt_power_module_double();
   void test_power2_module_float();
@@ -10,6 +10,7 @@
 class ebl_preprocessing_test : public CppUnit::TestFixture  {
   CPPUNIT_TEST_SUITE(ebl_preprocessing_test);
   CPPUNIT_TEST(test_preprocessing_modules);
+  CPPUNIT_TEST(test_jitter_random);
   //  CPPUNIT_TEST(test_resizing);
   CPPUNIT_TEST_SUITE_END();
 
@@ -25,6 +26,8 @@ public:
   // Test functions
   void test_resizing();
   void test_preprocessing_modules();
+  //! Test that jitter deformations only depend on the philox stream.
+  void test_jitter_random();
 };
 
 #endif /* EBL_PREPROCESSING_TEST_H_ */
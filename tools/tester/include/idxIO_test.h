@@ -14,6 +14,7 @@ class idxIO_test : public CppUnit::TestFixture  {
   CPPUNIT_TEST(test_save_load_matrix_long);
   CPPUNIT_TEST(test_save_load_matrix_matrix);
   CPPUNIT_TEST(test_save_load_matrices);
+  CPPUNIT_TEST(test_load_matrix_concat);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -33,6 +34,7 @@ public:
   void test_save_load_matrix_long();
   void test_save_load_matrix_matrix();
   void test_save_load_matrices();
+  void test_load_matrix_concat();
 };
 
 #endif /* IDXIOTEST_H_ */
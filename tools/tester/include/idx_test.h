@@ -16,6 +16,7 @@ class idx_test : public CppUnit::TestFixture  {
   CPPUNIT_TEST(test_IdxIter2);
   CPPUNIT_TEST(test_Idx_macros);
   CPPUNIT_TEST(test_view_as_order);
+  CPPUNIT_TEST(test_idx_view);
   CPPUNIT_TEST_SUITE_END();
 
 private:
@@ -37,5 +38,6 @@ public:
   void test_IdxIter2();
   void test_Idx_macros();
   void test_view_as_order();
+  void test_idx_view();
 };
 #endif /*IDXTEST_*/
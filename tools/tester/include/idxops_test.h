@@ -16,9 +16,15 @@ class idxops_test : public CppUnit::TestFixture  {
   CPPUNIT_TEST(test_idx_m2squdotm1);
   CPPUNIT_TEST(test_idx_m2extm2acc);
   CPPUNIT_TEST(test_idx_m2dotm1);
+  CPPUNIT_TEST(test_idx_m2dotm2);
+  CPPUNIT_TEST(test_idx_m4dotm2acc);
+  CPPUNIT_TEST(test_parallel_for);
+  CPPUNIT_TEST(test_idx_m2pooling);
   CPPUNIT_TEST(test_idx_copy);
   CPPUNIT_TEST(test_idx_copy2);
   CPPUNIT_TEST(test_idx_abs);
+  CPPUNIT_TEST(test_philox);
+  CPPUNIT_TEST(test_drand_threads);
   CPPUNIT_TEST(test_huge_vec);
   CPPUNIT_TEST_SUITE_END();
 
@@ -41,9 +47,16 @@ public:
   void test_idx_m2squdotm1();
   void test_idx_m2extm2acc();
   void test_idx_m2dotm1();
+  void test_idx_m2dotm2();
+  void test_idx_m4dotm2acc();
+  void test_parallel_for();
+  void test_idx_m2pooling();
   void test_idx_copy();
   void test_idx_copy2();
   void test_idx_abs();
+  void test_philox();
+  //! Test that concurrent drand() calls share the state without races.
+  void test_drand_threads();
   void test_huge_vec();
 };
 
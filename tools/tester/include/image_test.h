@@ -8,6 +8,8 @@
 class image_test : public CppUnit::TestFixture  {
   CPPUNIT_TEST_SUITE(image_test);
   CPPUNIT_TEST(test_deformations);
+  CPPUNIT_TEST(test_deformation_affine);
+  CPPUNIT_TEST(test_colorspace_kernels);
   CPPUNIT_TEST(test_resize);
   CPPUNIT_TEST(test_pnm_P3);
   CPPUNIT_TEST(test_pnm_P6);
@@ -30,6 +32,8 @@ public:
   void test_pnm_P6();
   void test_gaussian_pyramid();
   void test_deformations();
+  void test_deformation_affine();
+  void test_colorspace_kernels();
   void test_colorspaces();
 };
 #endif /*IMAGE_TEST_H_*/
@@ -0,0 +1,35 @@
+#ifndef METAPARSER_TEST_H_
+#define METAPARSER_TEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "metaparser.h"
+
+//! Test class for metaparser class
+class metaparser_test : public CppUnit::TestFixture  {
+  CPPUNIT_TEST_SUITE(metaparser_test);
+  CPPUNIT_TEST(test_max_common_iter);
+  CPPUNIT_TEST(test_promotion);
+  CPPUNIT_TEST(test_rewritten_log);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  // member variables
+  std::string dir; //!< Temporary directory containing the job logs.
+
+public:
+  //! This function is called before each test function is called.
+  void setUp();
+  //! This function is called after each test function is called.
+  void tearDown();
+
+  // Test functions
+  void test_max_common_iter();
+  //! Test that successive halving promotes the best 1/eta of the jobs at a
+  //! rung and never demotes a promoted job.
+  void test_promotion();
+  //! Test that a log rewritten without shrinking is parsed again from its
+  //! start, while appended lines are parsed incrementally.
+  void test_rewritten_log();
+};
+
+#endif /* METAPARSER_TEST_H_ */
@@ -0,0 +1,32 @@
+#ifndef PASCAL_XML_TEST_H_
+#define PASCAL_XML_TEST_H_
+
+#include <cppunit/extensions/HelperMacros.h>
+#include "pascal_xml.h"
+
+//! Test class for the pascal_index annotation cache
+class pascal_xml_test : public CppUnit::TestFixture  {
+  CPPUNIT_TEST_SUITE(pascal_xml_test);
+  CPPUNIT_TEST(test_cache_roundtrip);
+  CPPUNIT_TEST(test_cache_invalidation);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  // member variables
+  std::string dir; //!< Temporary directory containing the xml files.
+  std::string cache; //!< Annotation cache of 'dir'.
+
+public:
+  //! This function is called before each test function is called.
+  void setUp();
+  //! This function is called after each test function is called.
+  void tearDown();
+
+  // Test functions
+  //! Test that annotations read from the cache match parsed annotations.
+  void test_cache_roundtrip();
+  //! Test that changed xml files and invalid caches are parsed again.
+  void test_cache_invalidation();
+};
+
+#endif /* PASCAL_XML_TEST_H_ */
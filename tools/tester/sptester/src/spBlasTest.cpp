@@ -46,7 +46,7 @@ void spBlasTest::test_copy2(){
 	sptest.set(3, 2, 3, 0);
 	sptest.set(4, 3, 0, 1);
 
-	Idx<int> test(4,4, 4);
+	idx<int> test(4,4, 4);
 	idx_copy(sptest, test);
 	for(int i = 0; i<4; i++){
 		for(int j = 0; j<4; j++){
@@ -59,7 +59,7 @@ void spBlasTest::test_copy2(){
 }
 
 void spBlasTest::test_copy3(){
-	Idx<double> test(2,2);
+	idx<double> test(2,2);
 	test.set(1.5, 0, 0);
 	test.set(2.25, 0, 1);
 	test.set(-1.5, 1, 0);
@@ -73,7 +73,7 @@ void spBlasTest::test_copy3(){
 		};
 	};
 
-	Idx<double> test2(2,2);
+	idx<double> test2(2,2);
 	test2.set(1.5, 0, 0);
 	test2.set(-2.5, 1, 0);
 
@@ -386,7 +386,7 @@ void spBlasTest::test_sqrdist(){
 
 	CPPUNIT_ASSERT_EQUAL((double)35, idx_sqrdist(sptest, sptest2));
 
-	Idx<double> res;
+	idx<double> res;
 	idx_sqrdist(sptest, sptest2, res);
 	CPPUNIT_ASSERT_EQUAL(res.get(), idx_sqrdist(sptest, sptest2));
 }
@@ -399,7 +399,7 @@ void spBlasTest::test_m2dotm1(){
 	sptest.set(3, 2, 3);
 	sptest.set(4, 3, 0);
 
-	Idx<float> x(4), y(4);
+	idx<float> x(4), y(4);
 	x.set(0, 0);
 	x.set(1,1);
 	x.set(2,2);
@@ -441,7 +441,7 @@ void spBlasTest::test_m2dotm1acc(){
 	sptest.set(3, 2, 3);
 	sptest.set(4, 3, 0);
 
-	Idx<float> x(4), y(4);
+	idx<float> x(4), y(4);
 	x.set(0, 0);
 	x.set(1,1);
 	x.set(2,2);
@@ -451,7 +451,7 @@ void spBlasTest::test_m2dotm1acc(){
 	y.set(2,2);
 	y.set(3,3);
 
-	Idx<float> y2(4);
+	idx<float> y2(4);
 	idx_copy(y, y2);
 
 	idx_m2dotm1acc(sptest, x, y);
@@ -548,7 +548,7 @@ void spBlasTest::test_m2squdotm2(){
 	sptest.set(3, 2, 3);
 	sptest.set(4, 3, 0);
 
-	Idx<double> res;
+	idx<double> res;
 	idx_m2squdotm2(sptest, sptest, res);
 
 	res.printElems();
@@ -563,7 +563,7 @@ void spBlasTest::test_m2squdotm2acc(){
 	sptest.set(3, 2, 3);
 	sptest.set(4, 3, 0);
 
-	Idx<double> res;
+	idx<double> res;
 	res.set(15);
 	idx_m2squdotm2acc(sptest, sptest, res);
 
@@ -616,7 +616,7 @@ void spBlasTest::test_m2squdotm1(){
 	sptest.set(3, 2, 3);
 	sptest.set(4, 3, 0);
 
-	Idx<double> x(4), y(4);
+	idx<double> x(4), y(4);
 	x.set(0, 0);
 	x.set(1,1);
 	x.set(2,2);
@@ -652,7 +652,7 @@ void spBlasTest::test_m2squdotm1acc(){
 	sptest.set(3, 2, 3);
 	sptest.set(4, 3, 0);
 
-	Idx<float> x(4), y(4);
+	idx<float> x(4), y(4);
 	x.set(0, 0);
 	x.set(1,1);
 	x.set(2,2);
@@ -744,7 +744,7 @@ void spBlasTest::test_normcolumn(){
 }
 
 void spBlasTest::test_2dconvol(){
-	Idx<double> test(10,10);
+	idx<double> test(10,10);
 	test.set(1, 0, 0);
 	test.set(3, 0, 5);
 	test.set(5, 3, 3);
@@ -755,14 +755,14 @@ void spBlasTest::test_2dconvol(){
 	test.set(-4, 7, 7);
 	test.set(6, 9, 4);
 
-	Idx<double> kernel(3,3);
+	idx<double> kernel(3,3);
 	kernel.set(-1, 0, 1);
 	kernel.set(-1, 1, 0);
 	kernel.set(-1, 1, 2);
 	kernel.set(-1, 2, 1);
 	kernel.set(4, 1, 1);
 
-	Idx<double> res1(8, 8);
+	idx<double> res1(8, 8);
 
 	idx_2dconvol(test, kernel, res1);
 	res1.printElems();
@@ -0,0 +1,115 @@
+/*
+ * spModulesTest.cpp
+ */
+
+#include "spModulesTest.h"
+
+//! Returns the max absolute difference between 'a' and 'b' where 'mask'
+//! is not zero.
+static double masked_maxdist(idx<double> &a, idx<double> &b,
+                             idx<double> &mask) {
+  double m = 0;
+  idx_aloop3(pa, a, double, pb, b, double, pm, mask, double) {
+    if (*pm != 0) m = std::max(m, fabs(*pa - *pb));
+  }
+  return m;
+}
+
+void spModulesTest::test_sparse_linear(){
+  ddparameter<double> prm(1000);
+  linear_module<double> lin(&prm, 6, 4);
+  dseed(1);
+  idx_random(lin.w, -1, 1);
+  // the dense module keeps the pruned weights and is the reference
+  sparse_linear_module<double> sp(lin, .5);
+  CPPUNIT_ASSERT(sp.density() < 1 && sp.density() > 0);
+  idx<double> x(6), xd(6), xdd(6), y1, y2;
+  idx<double> yd(4), ydd(4);
+  idx_random(x, -1, 1);
+  idx_random(yd, -1, 1);
+  idx_random(ydd, 0, 1);
+  state<double> in(x, xd, xdd);
+  state<double> out(idx<double>(4), yd, ydd);
+  lin.fprop1(x, y1);
+  sp.fprop1(x, y2);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_sqrdist(y1, y2), 1e-20);
+  // backward passes agree on inputs and on remaining weights
+  idx<double> w = lin.w, wd = lin.w.dx[0], wdd = lin.w.ddx[0];
+  idx<double> rxd(6), rxdd(6), rwd(4, 6), rwdd(4, 6);
+  in.zero_dx(); in.zero_ddx(); idx_clear(wd); idx_clear(wdd);
+  lin.bprop1(in, out);
+  lin.bbprop1(in, out);
+  idx_copy(xd, rxd); idx_copy(xdd, rxdd); idx_copy(wd, rwd); idx_copy(wdd, rwdd);
+  in.zero_dx(); in.zero_ddx(); idx_clear(wd); idx_clear(wdd);
+  sp.bprop1(in, out);
+  sp.bbprop1(in, out);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_sqrdist(xd, rxd), 1e-20);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_sqrdist(xdd, rxdd), 1e-20);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, masked_maxdist(wd, rwd, w), 1e-10);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, masked_maxdist(wdd, rwdd, w), 1e-10);
+  // pruned weights receive no gradient
+  idx_aloop2(pw, w, double, pd, wd, double) {
+    if (*pw == 0) CPPUNIT_ASSERT_EQUAL(0.0, *pd);
+  }
+  // weights updated after a backward pass are read again at next fprop
+  idx_dotc(w, 2.0, w);
+  lin.fprop1(x, y1);
+  sp.fprop1(x, y2);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_sqrdist(y1, y2), 1e-20);
+  // otherwise only when refreshed
+  idx_dotc(w, 2.0, w);
+  lin.fprop1(x, y1);
+  sp.fprop1(x, y2);
+  CPPUNIT_ASSERT(idx_sqrdist(y1, y2) > 0);
+  sp.refresh();
+  sp.fprop1(x, y2);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_sqrdist(y1, y2), 1e-20);
+}
+
+void spModulesTest::test_sparse_convolution(){
+  ddparameter<double> prm(10000);
+  idxdim ker(3, 3), stride(2, 1);
+  idx<intg> table = full_table(2, 3);
+  convolution_module<double> conv(&prm, ker, stride, table);
+  dseed(2);
+  idx_random(conv.kernel, -1, 1);
+  sparse_convolution_module<double> sp(conv, .6);
+  CPPUNIT_ASSERT(sp.density() < 1 && sp.density() > 0);
+  // even height so that the input gets cropped
+  idx<double> xc(2, 10, 9), y1, y2;
+  idx_random(xc, -1, 1);
+  conv.fprop1(xc, y1);
+  sp.fprop1(xc, y2);
+  CPPUNIT_ASSERT(y1.same_dim(y2.get_idxdim()));
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_sqrdist(y1, y2), 1e-20);
+  idx<double> x(2, 11, 9), xd(2, 11, 9), xdd(2, 11, 9);
+  idx_random(x, -1, 1);
+  conv.fprop1(x, y1);
+  sp.fprop1(x, y2);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_sqrdist(y1, y2), 1e-20);
+  idx<double> yd(y1.get_idxdim()), ydd(y1.get_idxdim());
+  idx_random(yd, -1, 1);
+  idx_random(ydd, 0, 1);
+  state<double> in(x, xd, xdd);
+  state<double> out(y1, yd, ydd);
+  idx<double> k = conv.kernel, kd = conv.kernel.dx[0];
+  idx<double> kdd = conv.kernel.ddx[0];
+  idx<double> rxd(xd.get_idxdim()), rxdd(xd.get_idxdim());
+  idx<double> rkd(k.get_idxdim()), rkdd(k.get_idxdim());
+  in.zero_dx(); in.zero_ddx(); idx_clear(kd); idx_clear(kdd);
+  conv.bprop1(in, out);
+  conv.bbprop1(in, out);
+  idx_copy(xd, rxd); idx_copy(xdd, rxdd); idx_copy(kd, rkd); idx_copy(kdd, rkdd);
+  in.zero_dx(); in.zero_ddx(); idx_clear(kd); idx_clear(kdd);
+  sp.bprop1(in, out);
+  sp.bbprop1(in, out);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_sqrdist(xd, rxd), 1e-20);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_sqrdist(xdd, rxdd), 1e-20);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, masked_maxdist(kd, rkd, k), 1e-10);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, masked_maxdist(kdd, rkdd, k), 1e-10);
+  // kernels updated after a backward pass are read again at next fprop
+  idx_dotc(k, 2.0, k);
+  conv.fprop1(x, y1);
+  sp.fprop1(x, y2);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_sqrdist(y1, y2), 1e-20);
+}
@@ -13,6 +13,7 @@
 #include "spIdxTest.h"
 #include "spBlasTest.h"
 #include "spIdxIOTest.h"
+#include "spModulesTest.h"
 
 using namespace std;
 
@@ -21,6 +22,7 @@ int main(){
 	runner.addTest(spIdxTest::suite());
 	runner.addTest(spBlasTest::suite());
 	runner.addTest(spIdxIOTest::suite());
+	runner.addTest(spModulesTest::suite());
 
 	CppUnit::BriefTestProgressListener listener;
 	runner.eventManager().addListener(&listener);
@@ -15,6 +15,8 @@ extern string *gl_data_dir;
 extern string *gl_mnist_errmsg;
 extern string *gl_data_errmsg;
 
+#define STATE_FILE "./eblearn_tester_ds_state.mat"
+
 void datasource_test::setUp() {
 }
 
@@ -53,3 +55,50 @@ void datasource_test::test_mnist_LabeledDataSource() {
     CPPUNIT_ASSERT(false); // error
   }
 }
+
+void datasource_test::test_state() {
+  // 30 samples of 3 classes, each filled with its index
+  idx<float> data(30, 1, 2, 2);
+  idx<int> labels(30);
+  for (intg i = 0; i < data.dim(0); ++i) {
+    idx<float> s = data.select(0, i);
+    idx_fill(s, (float) i);
+    labels.set(i % 3, i);
+  }
+  class_datasource<float,float,int> ds1(data, labels,
+                                        (vector<string*>*) NULL, "ds1");
+  class_datasource<float,float,int> ds2(data, labels,
+                                        (vector<string*>*) NULL, "ds2");
+  ds1.set_balanced(true);
+  ds1.set_shuffle_passes(true);
+  ds1.set_random_class_order(true);
+  ds2.set_balanced(true);
+  ds2.set_shuffle_passes(true);
+  ds2.set_random_class_order(true);
+  // move ds1 across a pass and save its state
+  dseed(1);
+  srand(1);
+  for (uint i = 0; i < 47; ++i)
+    ds1.next_train();
+  ds1.write_state(STATE_FILE);
+  ds2.read_state(STATE_FILE);
+  remove(STATE_FILE);
+  // both continue with the same samples, across more passes
+  // (passes and class order are shuffled with std::rand)
+  state<float> s1(1, 2, 2), s2(1, 2, 2);
+  idx<float> seq(100);
+  dseed(2);
+  srand(2);
+  for (uint i = 0; i < seq.dim(0); ++i) {
+    ds1.fprop_data(s1);
+    seq.set(s1.get(0, 0, 0), i);
+    ds1.next_train();
+  }
+  dseed(2);
+  srand(2);
+  for (uint i = 0; i < seq.dim(0); ++i) {
+    ds2.fprop_data(s2);
+    CPPUNIT_ASSERT_EQUAL(seq.get(i), s2.get(0, 0, 0));
+    ds2.next_train();
+  }
+}
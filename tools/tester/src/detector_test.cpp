@@ -72,6 +72,578 @@ void detector_test::test_face() {
 // #endif
 }
 
+void detector_test::test_netbundle() {
+  try {
+    typedef float t_net;
+    CPPUNIT_ASSERT_MESSAGE(*gl_data_errmsg, gl_data_dir != NULL);
+
+    string name = "nens.gif";
+    string confname, imagename, root, ebl, bname;
+    root << *gl_data_dir << "/face/";
+    ebl << *gl_data_dir << "/../../";
+    confname << root << "best.conf";
+    imagename << root << name;
+    bname << "detector_test.bundle";
+    idx<ubyte> im = load_image<ubyte>(imagename);
+    configuration conf;
+    conf.read(confname.c_str(), false, false, true);
+    conf.set("root2", root.c_str());
+    conf.set("current_dir", root.c_str());
+    conf.set("ebl", ebl.c_str());
+    conf.resolve(true);
+    string odir = "";
+
+    // reference detector built from configuration
+    idx<ubyte> classes(1,1);
+    load_matrix<ubyte>(classes, conf.get_cstring("classes"));
+    vector<string> sclasses = ubyteidx_to_stringvector(classes);
+    answer_module<t_net> *ans1 =
+      create_answer<t_net,t_net,t_net>(conf, classes.dim(0));
+    parameter<t_net> p1;
+    p1.set_forward_only();
+    intg thick = -1;
+    module_1_1<t_net> *net1 =
+      create_network<t_net>(p1, conf, thick, ans1->get_nfeatures());
+    vector<string> w = string_to_stringvector(conf.get_string("weights"));
+    p1.load_x(w);
+    detector<t_net> d1(*net1, sclasses, ans1);
+    detection_thread<t_net>::init_detector(d1, conf, odir, true);
+    vector<idxdim> indims;
+    idxdim d = im.get_idxdim();
+    d.shift_dim(2, 0);
+    indims.push_back(d);
+    netbundle<t_net>::save(bname.c_str(), conf, classes, p1, d1, indims);
+    bboxes bb1 = d1.fprop(im);
+
+    // detector built from bundle
+    netbundle<t_net> bundle(bname.c_str());
+    configuration &bconf = bundle.get_configuration();
+    vector<string> bclasses = ubyteidx_to_stringvector(bundle.get_classes());
+    CPPUNIT_ASSERT(bclasses == sclasses);
+    answer_module<t_net> *ans2 =
+      create_answer<t_net,t_net,t_net>(bconf, bundle.get_classes().dim(0));
+    parameter<t_net> p2;
+    p2.set_forward_only();
+    thick = -1;
+    module_1_1<t_net> *net2 =
+      bundle.create_network(p2, thick, ans2->get_nfeatures());
+    CPPUNIT_ASSERT_EQUAL(p1.dim(0), p2.dim(0));
+    CPPUNIT_ASSERT_EQUAL((float64) 0, idx_sqrdist((idx<t_net>&) p1,
+                                                  (idx<t_net>&) p2));
+    detector<t_net> d2(*net2, bclasses, ans2);
+    detection_thread<t_net>::init_detector(d2, bconf, odir, true);
+    bundle.init_detector(d2);
+    bboxes bb2 = d2.fprop(im);
+
+    // tests
+    CPPUNIT_ASSERT_EQUAL(bb1.size(), bb2.size());
+    for (uint i = 0; i < bb1.size(); ++i) {
+      CPPUNIT_ASSERT_EQUAL(bb1[i].class_id, bb2[i].class_id);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[i].confidence, bb2[i].confidence,
+                                   1e-6);
+    }
+    // mapped weights are copy-on-write and copied when resized
+    idx<t_net> w1 = idx_copy((idx<t_net>&) p1);
+    idx_addc(w1, (t_net) 1);
+    idx_addc(p2.x[0], (t_net) 1);
+    p2.resize_parameter(p1.dim(0) + 10);
+    idx<t_net> w2 = p2.x[0].narrow(0, p1.dim(0), 0);
+    CPPUNIT_ASSERT_EQUAL((float64) 0, idx_sqrdist(w1, w2));
+    // and the bundle file is left intact
+    netbundle<t_net> bundle3(bname.c_str());
+    parameter<t_net> p3;
+    p3.set_forward_only();
+    p3.resize_parameter(p1.dim(0));
+    bundle3.load_weights(p3);
+    CPPUNIT_ASSERT_EQUAL((float64) 0, idx_sqrdist((idx<t_net>&) p1,
+                                                  (idx<t_net>&) p3));
+    remove(bname.c_str());
+  }
+  catch(string &err) { cerr << err << endl; }
+}
+
+void detector_test::test_plan_cache() {
+  try {
+    typedef float t_net;
+    CPPUNIT_ASSERT_MESSAGE(*gl_data_errmsg, gl_data_dir != NULL);
+
+    string confname, imagename, root, ebl;
+    root << *gl_data_dir << "/face/";
+    ebl << *gl_data_dir << "/../../";
+    confname << root << "best.conf";
+    imagename << root << "nens.gif";
+    configuration conf;
+    conf.read(confname.c_str(), false, false, true);
+    conf.set("root2", root.c_str());
+    conf.set("current_dir", root.c_str());
+    conf.set("ebl", ebl.c_str());
+    conf.resolve(true);
+    string odir = "";
+
+    idx<ubyte> classes(1,1);
+    load_matrix<ubyte>(classes, conf.get_cstring("classes"));
+    vector<string> sclasses = ubyteidx_to_stringvector(classes);
+    answer_module<t_net> *ans =
+      create_answer<t_net,t_net,t_net>(conf, classes.dim(0));
+    parameter<t_net> theparam;
+    theparam.set_forward_only();
+    intg thick = -1;
+    module_1_1<t_net> *net =
+      create_network<t_net>(theparam, conf, thick, ans->get_nfeatures());
+    vector<string> w = string_to_stringvector(conf.get_string("weights"));
+    theparam.load_x(w);
+    detector<t_net> ref(*net, sclasses, ans);
+    detection_thread<t_net>::init_detector(ref, conf, odir, true);
+    detector<t_net> cached(*net, sclasses, ans);
+    detection_thread<t_net>::init_detector(cached, conf, odir, true);
+    cached.set_plan_cache(1);
+
+    // alternate between 3 input sizes, 1 plan is kept besides the current one
+    idx<ubyte> im = load_image<ubyte>(imagename);
+    idx<ubyte> ims[3] = { im, idx_copy(im.narrow(0, im.dim(0) * 3 / 4, 0)),
+                          idx_copy(im.narrow(1, im.dim(1) * 3 / 4, 0)) };
+    // 0 and 1 are hit once, 2 evicts the least recently used plan of 0,
+    // then 0 evicts the plan of 1 and 2 is hit once.
+    uint seq[7] = { 0, 1, 0, 1, 2, 0, 2 };
+    bool hit[7] = { false, false, true, true, false, false, true };
+    uint hits = 0, misses = 0;
+    for (uint i = 0; i < 7; ++i) {
+      idx<ubyte> &im = ims[seq[i]];
+      bboxes bb1 = ref.fprop(im);
+      bboxes bb2 = cached.fprop(im);
+      if (hit[i]) hits++; else misses++;
+      CPPUNIT_ASSERT_EQUAL(hits, cached.get_plan_cache_hits());
+      CPPUNIT_ASSERT_EQUAL(misses, cached.get_plan_cache_misses());
+      CPPUNIT_ASSERT_EQUAL(bb1.size(), bb2.size());
+      for (uint j = 0; j < bb1.size(); ++j) {
+        CPPUNIT_ASSERT_EQUAL(bb1[j].class_id, bb2[j].class_id);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[j].confidence, bb2[j].confidence,
+                                     1e-6);
+        CPPUNIT_ASSERT_EQUAL(bb1[j].h0, bb2[j].h0);
+        CPPUNIT_ASSERT_EQUAL(bb1[j].w0, bb2[j].w0);
+      }
+    }
+    CPPUNIT_ASSERT_EQUAL((uint) 3, cached.get_plan_cache_hits());
+    CPPUNIT_ASSERT_EQUAL((uint) 4, cached.get_plan_cache_misses());
+  }
+  catch(string &err) { cerr << err << endl; }
+}
+
+// a detector giving access to its raw outputs.
+template <typename T> class outputs_detector : public detector<T> {
+ public:
+  outputs_detector(module_1_1<T> &net, vector<string> &labels,
+                   answer_module<T> *ans) : detector<T>(net, labels, ans) {}
+  svector<state<T> >& get_outputs() { return this->outputs; }
+};
+
+void detector_test::test_cascade() {
+  try {
+    typedef float t_net;
+    CPPUNIT_ASSERT_MESSAGE(*gl_data_errmsg, gl_data_dir != NULL);
+
+    string confname, imagename, root, ebl;
+    root << *gl_data_dir << "/face/";
+    ebl << *gl_data_dir << "/../../";
+    confname << root << "best.conf";
+    imagename << root << "nens.gif";
+    configuration conf;
+    conf.read(confname.c_str(), false, false, true);
+    conf.set("root2", root.c_str());
+    conf.set("current_dir", root.c_str());
+    conf.set("ebl", ebl.c_str());
+    conf.resolve(true);
+    string odir = "";
+
+    idx<ubyte> classes(1,1);
+    load_matrix<ubyte>(classes, conf.get_cstring("classes"));
+    vector<string> sclasses = ubyteidx_to_stringvector(classes);
+    answer_module<t_net> *ans =
+      create_answer<t_net,t_net,t_net>(conf, classes.dim(0));
+    parameter<t_net> theparam;
+    theparam.set_forward_only();
+    intg thick = -1;
+    module_1_1<t_net> *net =
+      create_network<t_net>(theparam, conf, thick, ans->get_nfeatures());
+    vector<string> w = string_to_stringvector(conf.get_string("weights"));
+    theparam.load_x(w);
+    detector<t_net> ref(*net, sclasses, ans);
+    detection_thread<t_net>::init_detector(ref, conf, odir, true);
+    detector<t_net> cascade(*net, sclasses, ans);
+    detection_thread<t_net>::init_detector(cascade, conf, odir, true);
+    // never fall back to dense evaluation, always compute by bands
+    cascade.set_cascade_evaluation(3, 1.0);
+
+    // nothing rejected: same detections as the regular detector
+    idx<ubyte> im = load_image<ubyte>(imagename);
+    cascade.set_cascade("wstd2", -1e9);
+    bboxes bb1 = ref.fprop(im);
+    bboxes bb2 = cascade.fprop(im);
+    CPPUNIT_ASSERT(bb1.size() > 0);
+    CPPUNIT_ASSERT_EQUAL(bb1.size(), bb2.size());
+    for (uint j = 0; j < bb1.size(); ++j) {
+      CPPUNIT_ASSERT_EQUAL(bb1[j].class_id, bb2[j].class_id);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[j].confidence, bb2[j].confidence, 1e-3);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[j].h0, bb2[j].h0, 1e-2);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[j].w0, bb2[j].w0, 1e-2);
+    }
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(1.0, cascade.get_cascade_evaluated(), 1e-9);
+    // everything rejected: nothing computed and nothing detected
+    cascade.set_cascade("wstd2", 1e9);
+    bboxes bb3 = cascade.fprop(im);
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, bb3.size());
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(0.0, cascade.get_cascade_evaluated(), 1e-9);
+    // rejected outputs hold the background target of the answer module,
+    // here scaled by a target factor
+    conf.set("class_answer_factor", ".5");
+    answer_module<t_net> *ans2 =
+      create_answer<t_net,t_net,t_net>(conf, classes.dim(0));
+    outputs_detector<t_net> scaled(*net, sclasses, ans2);
+    detection_thread<t_net>::init_detector(scaled, conf, odir, true);
+    scaled.set_cascade_evaluation(3, 1.0);
+    scaled.set_cascade("wstd2", 1e9);
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, scaled.fprop(im).size());
+    idx<t_net> bg = ((class_answer<t_net>*) ans2)->get_target((t_net) 0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(.5, bg.get(0), 1e-6);
+    svector<state<t_net> > &outputs = scaled.get_outputs();
+    for (uint i = 0; i < outputs.size(); ++i)
+      for (intg k = 0; k < bg.dim(0); ++k) {
+        idx<t_net> o = outputs[i].x[0].select(0, k);
+        CPPUNIT_ASSERT_EQUAL(bg.get(k), idx_min(o));
+        CPPUNIT_ASSERT_EQUAL(bg.get(k), idx_max(o));
+      }
+    // without background class, rejected outputs are not extracted,
+    // even with a threshold accepting any window
+    detector<t_net> nobg(*net, sclasses, ans);
+    detection_thread<t_net>::init_detector(nobg, conf, odir, true);
+    nobg.set_bgclass("none");
+    vector<float> any(1, -1e9);
+    nobg.set_raw_thresholds(any);
+    nobg.set_nms(nms_overlap, -1e9, -1e9);
+    nobg.set_cascade_evaluation(3, 1.0);
+    nobg.set_cascade("wstd2", 1e9);
+    CPPUNIT_ASSERT_EQUAL((size_t) 0, nobg.fprop(im).size());
+    delete ans2;
+  }
+  catch(string &err) { cerr << err << endl; }
+}
+
+void detector_test::test_incremental() {
+  try {
+    typedef float t_net;
+    CPPUNIT_ASSERT_MESSAGE(*gl_data_errmsg, gl_data_dir != NULL);
+
+    string confname, imagename, root, ebl;
+    root << *gl_data_dir << "/face/";
+    ebl << *gl_data_dir << "/../../";
+    confname << root << "best.conf";
+    imagename << root << "nens.gif";
+    configuration conf;
+    conf.read(confname.c_str(), false, false, true);
+    conf.set("root2", root.c_str());
+    conf.set("current_dir", root.c_str());
+    conf.set("ebl", ebl.c_str());
+    conf.resolve(true);
+    string odir = "";
+
+    idx<ubyte> classes(1,1);
+    load_matrix<ubyte>(classes, conf.get_cstring("classes"));
+    vector<string> sclasses = ubyteidx_to_stringvector(classes);
+    answer_module<t_net> *ans =
+      create_answer<t_net,t_net,t_net>(conf, classes.dim(0));
+    parameter<t_net> theparam;
+    theparam.set_forward_only();
+    intg thick = -1;
+    module_1_1<t_net> *net =
+      create_network<t_net>(theparam, conf, thick, ans->get_nfeatures());
+    vector<string> w = string_to_stringvector(conf.get_string("weights"));
+    theparam.load_x(w);
+    detector<t_net> ref(*net, sclasses, ans);
+    detection_thread<t_net>::init_detector(ref, conf, odir, true);
+    detector<t_net> incr(*net, sclasses, ans);
+    detection_thread<t_net>::init_detector(incr, conf, odir, true);
+    // the tolerance applies to preprocessed inputs, small shifts caused by
+    // the global normalization of a changed frame are ignored
+    incr.set_incremental(16, .05, 2);
+
+    // a static scene where a corner changes, then nothing changes
+    idx<ubyte> im = load_image<ubyte>(imagename);
+    idx<ubyte> im2 = idx_copy(im);
+    idx<ubyte> corner = im2.narrow(0, 40, 0).narrow(1, 40, 0);
+    idx_fill(corner, (ubyte) 128);
+    idx<ubyte> ims[4] = { im, im2, im2, im2 };
+    for (uint i = 0; i < 4; ++i) {
+      bboxes bb1 = ref.fprop(ims[i]);
+      bboxes bb2 = incr.fprop(ims[i]);
+      // normalizations are not local, only refreshed or unchanged frames
+      // match exactly
+      if (i == 1) continue ;
+      CPPUNIT_ASSERT_EQUAL(bb1.size(), bb2.size());
+      for (uint j = 0; j < bb1.size(); ++j) {
+        CPPUNIT_ASSERT_EQUAL(bb1[j].class_id, bb2[j].class_id);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[j].confidence, bb2[j].confidence,
+                                     1e-5);
+        CPPUNIT_ASSERT_EQUAL(bb1[j].h0, bb2[j].h0);
+        CPPUNIT_ASSERT_EQUAL(bb1[j].w0, bb2[j].w0);
+      }
+    }
+    // frames 0 and 2 are refreshed, 1 is partly computed and 3 not at all
+    double evaluated = incr.get_incremental_evaluated();
+    CPPUNIT_ASSERT(evaluated > .5 && evaluated < .75);
+  }
+  catch(string &err) { cerr << err << endl; }
+}
+
+// returns a horizontally mirrored copy of 'im'.
+static idx<ubyte> mirror(idx<ubyte> &im) {
+  idx<ubyte> m(im.get_idxdim());
+  for (intg j = 0; j < im.dim(1); ++j) {
+    idx<ubyte> src = im.select(1, j), dst = m.select(1, im.dim(1) - 1 - j);
+    idx_copy(src, dst);
+  }
+  return m;
+}
+
+// detects 'frames' with a detection thread configured by 'conf', feeding it
+// like the detect tool does, and returns bboxes and ids in order of arrival.
+static void thread_detect(configuration &conf, vector<idx<ubyte> > &frames,
+                          vector<bboxes> &bbs, vector<uint> &ids) {
+  typedef float t_net;
+  mutex mut;
+  detection_thread<t_net> dt(conf, &mut, "detection thread");
+  idx<ubyte> detframe;
+  uint total_saved = 0, sent = 0, id = 0;
+  string name = "frame", fname;
+  bboxes bb;
+  dt.start();
+  while (bbs.size() < frames.size()) {
+    if (dt.get_data(bb, detframe, total_saved, fname, &id)) {
+      bbs.push_back(bb);
+      ids.push_back(id);
+    }
+    if (sent < frames.size() && dt.available()) {
+      while (!dt.set_data(frames[sent], name, name, sent)) millisleep(5);
+      sent++;
+    }
+    millisleep(5);
+  }
+  dt.stop(true);
+}
+
+void detector_test::test_batch() {
+  try {
+    typedef float t_net;
+    CPPUNIT_ASSERT_MESSAGE(*gl_data_errmsg, gl_data_dir != NULL);
+
+    string confname, imagename, root, ebl;
+    root << *gl_data_dir << "/face/";
+    ebl << *gl_data_dir << "/../../";
+    confname << root << "best.conf";
+    imagename << root << "nens.gif";
+    configuration conf;
+    conf.read(confname.c_str(), false, false, true);
+    conf.set("root2", root.c_str());
+    conf.set("current_dir", root.c_str());
+    conf.set("ebl", ebl.c_str());
+    conf.set("batch_size", "2");
+    conf.set("batch_latency", "100000");
+    conf.resolve(true);
+    string odir = "";
+
+    idx<ubyte> classes(1,1);
+    load_matrix<ubyte>(classes, conf.get_cstring("classes"));
+    vector<string> sclasses = ubyteidx_to_stringvector(classes);
+    answer_module<t_net> *ans =
+      create_answer<t_net,t_net,t_net>(conf, classes.dim(0));
+    parameter<t_net> theparam;
+    theparam.set_forward_only();
+    intg thick = -1;
+    module_1_1<t_net> *net =
+      create_network<t_net>(theparam, conf, thick, ans->get_nfeatures());
+    vector<string> w = string_to_stringvector(conf.get_string("weights"));
+    theparam.load_x(w);
+    detector<t_net> ref(*net, sclasses, ans);
+    detection_thread<t_net>::init_detector(ref, conf, odir, true);
+    detector<t_net> det(*net, sclasses, ans);
+    detection_thread<t_net>::init_detector(det, conf, odir, true);
+    batch_detector<t_net> batch(det, conf);
+
+    // 2 different frames (the second one is mirrored) from 2 sources,
+    // processed once the batch is full
+    idx<ubyte> im = load_image<ubyte>(imagename);
+    idx<ubyte> im2 = mirror(im);
+    vector<bboxes> single(2);
+    single[0] = ref.fprop(im);
+    single[1] = ref.fprop(im2);
+    CPPUNIT_ASSERT(single[0].size() > 0);
+    vector<batch_result> res;
+    batch.push(im, 0, 7);
+    CPPUNIT_ASSERT(!batch.ready());
+    CPPUNIT_ASSERT_EQUAL((uint) 0, batch.process(res));
+    batch.push(im2, 1, 7);
+    CPPUNIT_ASSERT(batch.ready());
+    CPPUNIT_ASSERT_EQUAL((uint) 2, batch.process(res));
+    CPPUNIT_ASSERT_EQUAL((uint) 0, batch.pending());
+    CPPUNIT_ASSERT_EQUAL((size_t) 2, res.size());
+    for (uint i = 0; i < res.size(); ++i) {
+      CPPUNIT_ASSERT_EQUAL(i, res[i].source);
+      CPPUNIT_ASSERT_EQUAL((uint) 7, res[i].frame_id);
+      // normalizations are not local and borders of frames see their
+      // neighbors, results are close but not identical
+      bboxes &bb1 = single[i], &bb2 = res[i].bbs;
+      CPPUNIT_ASSERT_EQUAL(bb1.size(), bb2.size());
+      for (uint j = 0; j < bb1.size(); ++j) {
+        CPPUNIT_ASSERT_EQUAL(bb1[j].class_id, bb2[j].class_id);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[j].confidence, bb2[j].confidence,
+                                     .05);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[j].h0, bb2[j].h0, 2);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[j].w0, bb2[j].w0, 2);
+      }
+    }
+  }
+  catch(string &err) { cerr << err << endl; }
+}
+
+void detector_test::test_batch_thread() {
+  try {
+    CPPUNIT_ASSERT_MESSAGE(*gl_data_errmsg, gl_data_dir != NULL);
+
+    string confname, imagename, root, ebl;
+    root << *gl_data_dir << "/face/";
+    ebl << *gl_data_dir << "/../../";
+    confname << root << "best.conf";
+    imagename << root << "nens.gif";
+    configuration conf;
+    conf.read(confname.c_str(), false, false, true);
+    conf.set("root2", root.c_str());
+    conf.set("current_dir", root.c_str());
+    conf.set("ebl", ebl.c_str());
+    conf.set("silent", "1");
+    conf.set("display_sleep", "0");
+    conf.resolve(true);
+    vector<idx<ubyte> > frames;
+    frames.push_back(load_image<ubyte>(imagename));
+    frames.push_back(mirror(frames[0]));
+
+    // frames one by one, then batched by a single thread
+    vector<bboxes> single, batched;
+    vector<uint> single_ids, batched_ids;
+    thread_detect(conf, frames, single, single_ids);
+    conf.set("batch_size", "2");
+    conf.set("batch_latency", "100000");
+    thread_detect(conf, frames, batched, batched_ids);
+    CPPUNIT_ASSERT_EQUAL((size_t) 2, batched.size());
+    for (uint i = 0; i < batched.size(); ++i) {
+      CPPUNIT_ASSERT_EQUAL(i, single_ids[i]);
+      CPPUNIT_ASSERT_EQUAL(i, batched_ids[i]);
+      bboxes &bb1 = single[i], &bb2 = batched[i];
+      CPPUNIT_ASSERT_EQUAL(bb1.size(), bb2.size());
+      for (uint j = 0; j < bb1.size(); ++j) {
+        CPPUNIT_ASSERT_EQUAL(bb1[j].class_id, bb2[j].class_id);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[j].confidence, bb2[j].confidence,
+                                     .05);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[j].h0, bb2[j].h0, 2);
+        CPPUNIT_ASSERT_DOUBLES_EQUAL(bb1[j].w0, bb2[j].w0, 2);
+      }
+    }
+  }
+  catch(string &err) { cerr << err << endl; }
+}
+
+void detector_test::test_timing_percentiles() {
+  // nearest rank: smallest value with at least p * n values lower or equal
+  vector<double> v;
+  CPPUNIT_ASSERT_EQUAL(0.0, nearest_rank(v, .5));
+  v.push_back(7);
+  CPPUNIT_ASSERT_EQUAL(7.0, nearest_rank(v, .5));
+  CPPUNIT_ASSERT_EQUAL(7.0, nearest_rank(v, .99));
+  v.clear();
+  for (uint i = 1; i <= 20; ++i) v.push_back(i);
+  CPPUNIT_ASSERT_EQUAL(10.0, nearest_rank(v, .50));
+  CPPUNIT_ASSERT_EQUAL(19.0, nearest_rank(v, .95));
+  CPPUNIT_ASSERT_EQUAL(20.0, nearest_rank(v, .99));
+  v.clear();
+  for (uint i = 1; i <= 100; ++i) v.push_back(i);
+  CPPUNIT_ASSERT_EQUAL(50.0, nearest_rank(v, .50));
+  CPPUNIT_ASSERT_EQUAL(95.0, nearest_rank(v, .95));
+  CPPUNIT_ASSERT_EQUAL(99.0, nearest_rank(v, .99));
+  // the report sorts each stage independently of the frames order
+  vector<detector_timing> t(20);
+  for (uint i = 0; i < t.size(); ++i) {
+    t[i].fprop = (20 - i) / 1000.0; // 20ms down to 1ms
+    t[i].total = 1.0;
+  }
+  ostringstream os;
+  print_timing_percentiles(t, 2.0, os);
+  string rep = os.str();
+  CPPUNIT_ASSERT(rep.find("frames=20 seconds=2 fps=10") != string::npos);
+  istringstream is(rep.substr(rep.find("\nfprop") + 1));
+  string name;
+  double p50, p95, p99, mean;
+  is >> name >> p50 >> p95 >> p99 >> mean;
+  CPPUNIT_ASSERT_EQUAL(string("fprop"), name);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(10, p50, 1e-6);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(19, p95, 1e-6);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(20, p99, 1e-6);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(10.5, mean, 1e-6);
+}
+
+//! Return true if 'a' and 'b' have the same dimensions and elements.
+static bool same_frames(idx<ubyte> &a, idx<ubyte> &b) {
+  if (a.get_idxdim() != b.get_idxdim()) return false;
+  { idx_aloop2(ea, a, ubyte, eb, b, ubyte) {
+      if (*ea != *eb) return false;
+    }}
+  return true;
+}
+
+void detector_test::test_camera_synthetic() {
+  ostringstream out, err;
+  // frames only depend on seed and index, cycling through distinct frames
+  camera_synthetic<ubyte> c1(48, 64, 6, 3, "shapes", 3, -1, -1, out, err);
+  camera_synthetic<ubyte> c2(48, 64, 6, 3, "shapes", 3, -1, -1, out, err);
+  camera_synthetic<ubyte> c3(48, 64, 6, 4, "shapes", 3, -1, -1, out, err);
+  CPPUNIT_ASSERT_EQUAL(6, c1.size());
+  vector<idx<ubyte> > f;
+  for (uint i = 0; i < 6; ++i) {
+    CPPUNIT_ASSERT(!c1.empty());
+    // grab() returns the camera's frame buffer, keep copies
+    idx<ubyte> f1 = idx_copy(c1.grab()), f2 = idx_copy(c2.grab());
+    idx<ubyte> f3 = idx_copy(c3.grab());
+    CPPUNIT_ASSERT_EQUAL((intg) 48, f1.dim(0));
+    CPPUNIT_ASSERT_EQUAL((intg) 64, f1.dim(1));
+    CPPUNIT_ASSERT(same_frames(f1, f2)); // same seed
+    CPPUNIT_ASSERT(!same_frames(f1, f3)); // different seed
+    f.push_back(f1);
+  }
+  CPPUNIT_ASSERT(c1.empty());
+  CPPUNIT_ASSERT(!same_frames(f[0], f[1]));
+  CPPUNIT_ASSERT(same_frames(f[0], f[3]));
+  CPPUNIT_ASSERT(same_frames(f[2], f[5]));
+}
+
+void detector_test::test_stage_timing_fallback() {
+  typedef float t_net;
+  vector<string> labels(1, "object");
+  ostringstream out, err;
+  // resizing module nested in a sub-network
+  layers<t_net> inner(true, "inner");
+  inner.add_module(new resizepp_module<t_net>);
+  inner.add_module(new tanh_module<t_net>);
+  layers<t_net> nested(false, "nested");
+  nested.add_module(&inner);
+  // resizing module not followed by any module
+  layers<t_net> last(true, "last");
+  last.add_module(new tanh_module<t_net>);
+  last.add_module(new resizepp_module<t_net>);
+  layers<t_net> *nets[2] = { &nested, &last };
+  for (uint i = 0; i < 2; ++i) {
+    detector<t_net> d(*nets[i], labels, NULL, NULL, NULL, out, err);
+    // warns and times the pyramid in fprop instead of aborting
+    d.set_stage_timing(true);
+  }
+}
+
 // void detector_test::test_norb() {
 //   try {
 //     typedef double t_net;
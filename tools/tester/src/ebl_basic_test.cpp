@@ -1,4 +1,7 @@
 #include "ebl_basic_test.h"
+#ifdef __SPIDX__
+#include "spModules.h"
+#endif
 
 using namespace std;
 using namespace ebl;
@@ -195,6 +198,413 @@ void ebl_basic_test::test_convolution_timing() {
   cout << " big convolution time: " << tim/10 << "ms";
 }
 
+// check that multithreaded bprop/bbprop give the exact serial results
+void ebl_basic_test::test_convolution_bprop_parallel() {
+  typedef double T;
+  idxdim ker(5,5);
+  idxdim stride(1,1);
+  idx<intg> table = full_table(3, 4);
+  ddparameter<T> prm(10000);
+  convolution_module<T> c(&prm, ker, stride, table);
+  dseed(3);
+  idx_random(c.kernel, -1, 1);
+  state<T> in(3, 16, 16), out(4, 12, 12);
+  in.resize_dx(); in.resize_ddx(); out.resize_dx(); out.resize_ddx();
+  idx_random(in, -1, 1);
+  idx_random(out.dx[0], -1, 1);
+  idx_random(out.ddx[0], -1, 1);
+  idx<T> indx[2], inddx[2], kdx[2], kddx[2];
+  thread_pool &pool = thread_pool::global();
+  uint nthreads = pool.get_nthreads();
+  for (uint i = 0; i < 2; ++i) {
+    pool.set_nthreads(i == 0 ? 1 : 4);
+    idx_clear(in.dx[0]); idx_clear(in.ddx[0]);
+    idx_clear(c.kernel.dx[0]); idx_clear(c.kernel.ddx[0]);
+    c.bprop1(in, out);
+    c.bbprop1(in, out);
+    indx[i] = idx_copy(in.dx[0]); inddx[i] = idx_copy(in.ddx[0]);
+    kdx[i] = idx_copy(c.kernel.dx[0]); kddx[i] = idx_copy(c.kernel.ddx[0]);
+  }
+  pool.set_nthreads(nthreads);
+  CPPUNIT_ASSERT(0 == idx_sqrdist(indx[0], indx[1]));
+  CPPUNIT_ASSERT(0 == idx_sqrdist(inddx[0], inddx[1]));
+  CPPUNIT_ASSERT(0 == idx_sqrdist(kdx[0], kdx[1]));
+  CPPUNIT_ASSERT(0 == idx_sqrdist(kddx[0], kddx[1]));
+  CPPUNIT_ASSERT(idx_sqrdist(kdx[0], kddx[0]) > 0);
+}
+
+// check that a convolution reused with different input sizes gives the
+// results of a new module
+void ebl_basic_test::test_convolution_sizes() {
+  typedef double T;
+  idxdim ker(5,5);
+  idxdim stride(1,1);
+  idx<intg> table = full_table(3, 4);
+  ddparameter<T> prm(10000);
+  convolution_module<T> c(&prm, ker, stride, table);
+  dseed(4);
+  idx_random(c.kernel, -1, 1);
+  intg sizes[3] = { 16, 21, 16 };
+  for (uint i = 0; i < 3; ++i) {
+    intg o = sizes[i] - 4;
+    state<T> in(3, sizes[i], sizes[i]), out(4, o, o), out0(4, o, o);
+    in.resize_dx(); out.resize_dx(); out0.resize_dx();
+    idx_random(in, -1, 1);
+    c.fprop1(in, out);
+    convolution_module<T> c0(&prm, ker, stride, table);
+    c0.kernel = c.kernel;
+    c0.fprop1(in, out0);
+    CPPUNIT_ASSERT(0 == idx_sqrdist(out, out0));
+    idx_random(out.dx[0], -1, 1);
+    idx_copy(out.dx[0], out0.dx[0]);
+    idx_clear(in.dx[0]);
+    c.bprop1(in, out);
+    idx<T> indx = idx_copy(in.dx[0]);
+    idx_clear(in.dx[0]);
+    c0.bprop1(in, out0);
+    CPPUNIT_ASSERT(0 == idx_sqrdist(indx, in.dx[0]));
+  }
+}
+
+void ebl_basic_test::test_convolution_fixed_kernels() {
+  typedef double T;
+  dseed(5);
+  for (intg k = 3; k <= 9; ++k) {
+    // a map with non-contiguous rows and a width that is not a multiple of 8
+    idx<T> map(k + 10, k + 23), in = map.narrow(1, k + 20, 1);
+    idx<T> ker(k, k), outd(11, 21);
+    idx_random(map, -1, 1);
+    idx_random(ker, -1, 1);
+    idx_random(outd, -1, 1);
+    idx<T> uin = in.unfold(0, k, 1);
+    uin = uin.unfold(1, k, 1);
+    int transp[4] = { 2, 3, 0, 1 };
+    idx<T> borp = uin.transpose(transp);
+    bool fixed = idx_conv_fixed_size(k);
+    // results match up to rounding: the kernel gradient sums in a different
+    // order, and compilers may contract multiply-adds differently
+    for (int squ = 0; squ < 2; ++squ) {
+      // forward
+      idx<T> out0(outd.get_idxdim()), out1(outd.get_idxdim());
+      idx_fill(out0, (T) 1); idx_fill(out1, (T) 1);
+      CPPUNIT_ASSERT_EQUAL(fixed, idx_conv_fprop_acc(uin, ker, out0));
+      idx_m4dotm2acc(uin, ker, out1);
+      if (fixed) CPPUNIT_ASSERT(idx_sqrdist(out0, out1)
+                                <= 1e-24 * idx_sumsqr(out1));
+      // input gradient
+      idx<T> ind0(in.get_idxdim()), ind1(in.get_idxdim());
+      idx_fill(ind0, (T) 1); idx_fill(ind1, (T) 1);
+      idx<T> uind0 = ind0.unfold(0, k, 1), uind1 = ind1.unfold(0, k, 1);
+      uind0 = uind0.unfold(1, k, 1); uind1 = uind1.unfold(1, k, 1);
+      CPPUNIT_ASSERT_EQUAL(fixed, idx_conv_bprop_acc(outd, ker, uind0,
+                                                     squ == 1));
+      if (squ) idx_m2squextm2acc(outd, ker, uind1);
+      else idx_m2extm2acc(outd, ker, uind1);
+      if (fixed) CPPUNIT_ASSERT(idx_sqrdist(ind0, ind1)
+                                <= 1e-24 * idx_sumsqr(ind1));
+      // kernel gradient
+      idx<T> kd0(k, k), kd1(k, k);
+      idx_fill(kd0, (T) 1); idx_fill(kd1, (T) 1);
+      CPPUNIT_ASSERT_EQUAL(fixed, idx_conv_kgrad_acc(borp, outd, kd0,
+                                                     squ == 1));
+      if (squ) idx_m4squdotm2acc(borp, outd, kd1);
+      else idx_m4dotm2acc(borp, outd, kd1);
+      if (fixed) CPPUNIT_ASSERT(idx_sqrdist(kd0, kd1)
+                                <= 1e-24 * idx_sumsqr(kd1));
+    }
+    // strided unfoldings use the generic operations
+    idx<T> uin2 = in.unfold(0, k, 2);
+    uin2 = uin2.unfold(1, k, 1);
+    idx<T> out2(uin2.dim(0), uin2.dim(1));
+    CPPUNIT_ASSERT(!idx_conv_fprop_acc(uin2, ker, out2));
+  }
+}
+
+void ebl_basic_test::test_ms_module_parallel() {
+  typedef double T;
+  idxdim ker(5,5);
+  idxdim stride(1,1);
+  idx<intg> table = full_table(3, 4);
+  ddparameter<T> prm(10000);
+  std::vector<module_1_1<T>*> pipes;
+  for (uint i = 0; i < 2; ++i) {
+    layers<T> *l = new layers<T>(true);
+    l->add_module(new convolution_module<T>(&prm, ker, stride, table));
+    pipes.push_back(l);
+  }
+  ms_module<T> *ms = new ms_module<T>(pipes);
+  std::vector<std::vector<uint> > states(1);
+  states[0].push_back(0);
+  states[0].push_back(1);
+  merge_module<T> *mm = new merge_module<T>(states, 0);
+  layers<T> net(true);
+  net.add_module(ms);
+  net.add_module(mm);
+  dseed(4);
+  idx_random(prm, -1, 1);
+  state<T> in(3, 16, 16); // replicated to both pipes
+  idx_random(in, -1, 1);
+  in.resize_dx();
+  idx<T> outs[2], kdx[2], indx[2];
+  thread_pool &pool = thread_pool::global();
+  uint nthreads = pool.get_nthreads();
+  pool.set_nthreads(4);
+  for (uint i = 0; i < 2; ++i) {
+    ms->set_parallel(i == 1);
+    ms->set_concat(i == 1);
+    state<T> mout, out;
+    // 2nd call with the same sizes writes pipes outputs into a single buffer
+    for (uint j = 0; j < 2; ++j) {
+      ms->fprop(in, mout);
+      mm->fprop(mout, out);
+    }
+    // merging consecutive slices does not copy them
+    CPPUNIT_ASSERT_EQUAL(i == 1, mout.x[0].getstorage() == out.getstorage());
+    outs[i] = idx_copy(out.x[0]);
+    // backward
+    state<T> nout;
+    net.fprop(in, nout);
+    prm.zero_dx();
+    in.zero_dx();
+    nout.resize_dx();
+    dseed(5);
+    idx_random(nout.dx[0], -1, 1);
+    net.bprop(in, nout);
+    kdx[i] = idx_copy(prm.dx[0]);
+    indx[i] = idx_copy(in.dx[0]);
+  }
+  pool.set_nthreads(nthreads);
+  CPPUNIT_ASSERT(0 == idx_sqrdist(outs[0], outs[1]));
+  // separate weights: pipes are bpropagated concurrently
+  CPPUNIT_ASSERT(0 == idx_sqrdist(kdx[0], kdx[1]));
+  CPPUNIT_ASSERT(idx_max(kdx[0]) > 0);
+  // the replicated input gradient sums both pipes, in a different order
+  CPPUNIT_ASSERT(idx_sqrdist(indx[0], indx[1])
+                 <= 1e-20 * idx_sumsqr(indx[0]));
+  CPPUNIT_ASSERT(idx_max(indx[0]) > 0);
+}
+
+void ebl_basic_test::test_ms_module_shared_weights() {
+  typedef double T;
+  idxdim ker(5,5);
+  idxdim stride(1,1);
+  idx<intg> table = full_table(3, 4);
+  // 2nd pipe is a shared copy of the 1st, like netconf '_shared' modules,
+  // or a sparse version of it accumulating into the same kernel
+  uint ncases = 1;
+#ifdef __SPIDX__
+  ncases = 2;
+#endif
+  for (uint icase = 0; icase < ncases; ++icase) {
+    ddparameter<T> prm(10000);
+    convolution_module<T> *c = new convolution_module<T>(&prm, ker, stride,
+                                                         table);
+    // random weights before pruning, so that no sparse tap is pruned
+    dseed(6);
+    idx_random(prm, -1, 1);
+    std::vector<module_1_1<T>*> pipes;
+    for (uint i = 0; i < 2; ++i) {
+      layers<T> *l = new layers<T>(true);
+      if (i == 0) l->add_module(c);
+#ifdef __SPIDX__
+      else if (icase == 1)
+        l->add_module(new sparse_convolution_module<T>(*c));
+#endif
+      else l->add_module(c->copy());
+      pipes.push_back(l);
+    }
+    ms_module<T> ms(pipes);
+    state<T> in(3, 32, 32); // replicated to both pipes
+    idx_random(in, -1, 1);
+    in.resize_dx();
+    in.resize_ddx();
+    thread_pool &pool = thread_pool::global();
+    uint nthreads = pool.get_nthreads();
+    pool.set_nthreads(4);
+    idx<T> kdx[2], kddx[2];
+    for (uint i = 0; i < 2; ++i) {
+      ms.set_parallel(i == 1);
+      state<T> out;
+      ms.fprop(in, out);
+      out.resize_dx();
+      out.resize_ddx();
+      dseed(7);
+      for (uint k = 0; k < out.x.size(); ++k) {
+        idx_random(out.dx[k], -1, 1);
+        idx_random(out.ddx[k], 0, 1);
+      }
+      // repeat to give concurrent accumulations a chance to collide
+      prm.zero_dx();
+      prm.zero_ddx();
+      for (uint j = 0; j < 20; ++j) {
+        ms.bprop(in, out);
+        ms.bbprop(in, out);
+      }
+      kdx[i] = idx_copy(prm.dx[0]);
+      kddx[i] = idx_copy(prm.ddx[0]);
+    }
+    pool.set_nthreads(nthreads);
+    CPPUNIT_ASSERT(0 == idx_sqrdist(kdx[0], kdx[1]));
+    CPPUNIT_ASSERT(0 == idx_sqrdist(kddx[0], kddx[1]));
+    CPPUNIT_ASSERT(idx_max(kdx[0]) > 0);
+  }
+}
+
+void ebl_basic_test::test_ms_module_dropout_threads() {
+  typedef double T;
+  std::vector<module_1_1<T>*> pipes;
+  for (uint i = 0; i < 2; ++i) {
+    layers<T> *l = new layers<T>(true);
+    l->add_module((module_1_1<T>*) new dropout_module<T>(.5, false));
+    pipes.push_back(l);
+  }
+  ms_module<T> ms(pipes);
+  ms.set_parallel(true);
+  state<T> in(3, 32, 32); // replicated to both pipes
+  dseed(8);
+  idx_random(in, 1, 2);
+  thread_pool &pool = thread_pool::global();
+  uint nthreads = pool.get_nthreads();
+  idx<T> outs[2][2][2]; // threads x fprop x pipe
+  for (uint i = 0; i < 2; ++i) {
+    pool.set_nthreads(i == 0 ? 1 : 4);
+    init_drand(9); // restarts the stream of each dropout module
+    for (uint j = 0; j < 2; ++j) {
+      state<T> out;
+      ms.fprop(in, out);
+      for (uint k = 0; k < 2; ++k) outs[i][j][k] = idx_copy(out.x[k]);
+    }
+  }
+  pool.set_nthreads(nthreads);
+  for (uint j = 0; j < 2; ++j)
+    for (uint k = 0; k < 2; ++k)
+      CPPUNIT_ASSERT(0 == idx_sqrdist(outs[0][j][k], outs[1][j][k]));
+  // each module has its own stream, which moves on at each fprop
+  CPPUNIT_ASSERT(idx_sqrdist(outs[0][0][0], outs[0][0][1]) > 0);
+  CPPUNIT_ASSERT(idx_sqrdist(outs[0][0][0], outs[0][1][0]) > 0);
+}
+
+void ebl_basic_test::test_profiler() {
+  typedef double T;
+  idxdim ker(5,5);
+  idxdim stride(1,1);
+  idx<intg> table = full_table(3, 4);
+  ddparameter<T> prm(10000);
+  std::vector<module_1_1<T>*> pipes;
+  convolution_module<T> *convs[2];
+  for (uint i = 0; i < 2; ++i) {
+    layers<T> *l = new layers<T>(true);
+    convs[i] = new convolution_module<T>(&prm, ker, stride, table);
+    l->add_module(convs[i]);
+    pipes.push_back(l);
+  }
+  ms_module<T> *ms = new ms_module<T>(pipes);
+  std::vector<std::vector<uint> > states(1);
+  states[0].push_back(0);
+  states[0].push_back(1);
+  merge_module<T> *mm = new merge_module<T>(states, 0);
+  layers<T> net(true);
+  net.add_module(ms);
+  net.add_module(mm);
+  dseed(4);
+  idx_random(prm, -1, 1);
+  state<T> in(3, 16, 16), out;
+  idx_random(in, -1, 1);
+  profiler &prof = profiler::global();
+  prof.clear();
+  net.fprop(in, out); // not recorded
+  CPPUNIT_ASSERT_EQUAL((uint) 0, prof.size());
+  prof.enable();
+  net.fprop(in, out);
+  net.fprop(in, out);
+  prm.zero_dx();
+  out.resize_dx();
+  idx_fill(out.dx[0], (T) 1);
+  net.bprop(in, out);
+  prof.enable(false);
+  // ms, merge, 2 pipes and their convolutions
+  CPPUNIT_ASSERT_EQUAL((uint) 6, prof.size());
+  // 4x12x12 outputs, each summing 3 inputs with 5x5 kernels
+  double flops = 4 * 12 * 12 * 2 * 3 * 5 * 5;
+  for (uint i = 0; i < 2; ++i) {
+    profile_counters c = prof.get(convs[i], PROF_FPROP);
+    CPPUNIT_ASSERT_EQUAL((uint64) 2, c.calls);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(2 * flops, c.flops, 1e-6);
+    CPPUNIT_ASSERT_EQUAL((uint64) 1, prof.get(convs[i], PROF_BPROP).calls);
+  }
+  // containers include the costs of the modules they call
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(4 * flops, prof.get(ms, PROF_FPROP).flops,
+                               1e-6);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, prof.get(mm, PROF_FPROP).flops, 1e-6);
+  CPPUNIT_ASSERT_EQUAL((uint64) 2, prof.get(mm, PROF_FPROP).calls);
+  CPPUNIT_ASSERT(prof.get(ms, PROF_FPROP).seconds
+                 >= prof.get(convs[0], PROF_FPROP).seconds);
+  // reports
+  std::ostringstream txt, json;
+  prof.report(txt);
+  prof.report_json(json);
+  CPPUNIT_ASSERT(txt.str().find("convolution") != std::string::npos);
+  CPPUNIT_ASSERT(json.str().find("\"bprop\": { \"calls\": 1")
+                 != std::string::npos);
+  prof.clear();
+}
+
+void ebl_basic_test::test_quantized_layers() {
+  typedef float T;
+  idxdim ker(5,5);
+  idxdim stride(1,1);
+  idx<intg> table = full_table(3, 4);
+  ddparameter<T> prm(10000);
+  layers<T> net(true);
+  convolution_module<T> *c =
+      new convolution_module<T>(&prm, ker, stride, table);
+  linear_module<T> *l = new linear_module<T>(&prm, 4, 2);
+  net.add_module(c);
+  net.add_module(new tanh_module<T>(.1));
+  net.add_module(l);
+  dseed(5);
+  idx_random(c->kernel, -.2, .2);
+  idx_random(l->w, -1, 1);
+  state<T> in(3, 16, 16), fout, qout;
+  quantized_layers<T> qnet(net);
+  CPPUNIT_ASSERT_EQUAL((uint) 2, qnet.nquantized());
+  // calibrate on a few samples
+  qnet.set_calibration(true);
+  for (uint i = 0; i < 4; ++i) {
+    idx_random(in, -1, 1);
+    qnet.fprop(in, qout);
+  }
+  qnet.finalize();
+  // compare quantized and float outputs on the last calibration sample
+  net.fprop(in, fout);
+  qnet.fprop(in, qout);
+  CPPUNIT_ASSERT(fout.same_dim(qout.get_idxdim()));
+  T range = std::max(idx_max(fout), (T) -idx_min(fout));
+  double rms = sqrt(idx_sqrdist(fout, qout) / fout.nelements());
+  CPPUNIT_ASSERT(rms < .02 * range);
+  // a non-contiguous input gives the same output as its contiguous copy
+  quantized_convolution_module<T> qc(*c);
+  idx<T> wide(3, 16, 32), qo1, qo2;
+  idx_random(wide, -1, 1);
+  idx<T> view = wide.narrow(2, 16, 8), copy = idx_copy(view);
+  CPPUNIT_ASSERT(!view.contiguousp());
+  qc.set_calibration(true);
+  qc.fprop1(copy, qo1);
+  qc.finalize();
+  qc.fprop1(view, qo1);
+  qc.fprop1(copy, qo2);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_sqrdist(qo1, qo2), 1e-12);
+  // tanh lookup table against tanh
+  tanh_module<T> th(.1);
+  tanh_lut_module<T> thl(.1);
+  idx<T> x(1000), y1(1000), y2(1000);
+  idx_random(x, -10, 10);
+  th.fprop1(x, y1);
+  thl.fprop1(x, y2);
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0, idx_max(y1) - idx_max(y2), 1e-5);
+  CPPUNIT_ASSERT(idx_sqrdist(y1, y2) / 1000 < 1e-10);
+}
+
 #define FLOAT_THRESHOLD 1e-3
 #define DOUBLE_THRESHOLD 1e-5
 
@@ -393,6 +803,14 @@ void ebl_basic_test::test_l2pooling_module_double() {
   TEST_DERIVATIVES(s, in, out, T, DOUBLE_THRESHOLD)
       }
 
+void ebl_basic_test::test_maxss_module_double() {
+  typedef double T;
+  idxdim kd(3, 3), sd(2, 2);
+  maxss_module<T> s(2, kd, sd);
+  state<T> in(2, 11, 11), out;
+  TEST_DERIVATIVES(s, in, out, T, DOUBLE_THRESHOLD)
+      }
+
 void ebl_basic_test::test_sqrt_power_module_float() {
   typedef float T;
   // test by hand
@@ -471,3 +471,32 @@ void ebl_preprocessing_test::test_preprocessing_modules() {
   for (uint j = 0; j < mods.size(); ++j)
     delete mods[j];
 }
+
+void ebl_preprocessing_test::test_jitter_random() {
+  typedef float T;
+  int trans[] = { -2, 2, -2, 2 };
+  float rotations[] = { -20, 20 }, scalings[] = { .8, 1.2, .8, 1.2 };
+  float shears[] = { -.2, .2, -.2, .2 }, els[] = { 0, 0, 0, 0 };
+  vector<int> tr(trans, trans + 4);
+  vector<float> rot(rotations, rotations + 2), sc(scalings, scalings + 4);
+  vector<float> sh(shears, shears + 4), el(els, els + 4);
+  jitter_module<T> j;
+  j.set_translations(tr);
+  j.set_rotations(rot);
+  j.set_scalings(sc);
+  j.set_shears(sh);
+  j.set_elastics(el);
+  state<T> in(1, 16, 16), out[3];
+  dseed(1);
+  idx_random(in, -1, 1);
+  philox &g = global_philox();
+  g.seed(5);
+  j.fprop(in, out[0]);
+  CPPUNIT_ASSERT_EQUAL((uint64) 0, g.tell()); // draws from its own stream
+  j.fprop(in, out[1]);
+  g.seed(5);
+  drand(); // the legacy generator does not affect deformations
+  j.fprop(in, out[2]);
+  CPPUNIT_ASSERT_EQUAL((T) 0, idx_sqrdist(out[0], out[2]));
+  CPPUNIT_ASSERT(idx_sqrdist(out[0], out[1]) > 0);
+}
@@ -180,3 +180,46 @@ void idxIO_test::test_save_load_matrices() {
     CPPUNIT_ASSERT(false); // err
   }
 }
+
+void idxIO_test::test_load_matrix_concat() {
+  try {
+    // save 4 shards of different sizes along dim 0 (and a ubyte one)
+    std::vector<std::string> files;
+    idx<float> ref;
+    for (uint i = 0; i < 4; ++i) {
+      idx<float> m(i + 1, 3, 5);
+      float v = (float) (i * 100);
+      { idx_aloop1(e, m, float) { *e = v++; } }
+      std::string fname;
+      fname << "./eblearn_tester_shard_" << i << ".mat";
+      if (i == 2) { // type different than loaded type
+	idx<ubyte> mb(m.get_idxdim());
+	idx_copy(m, mb);
+	idx_copy(mb, m);
+	save_matrix(mb, fname);
+      } else
+	save_matrix(m, fname);
+      files.push_back(fname);
+      ref = (i == 0) ? m : idx_concat(ref, m, 0);
+    }
+    // concatenation along dim 0
+    idx<float> w = load_matrix<float>(files, 0);
+    CPPUNIT_ASSERT(w.get_idxdim() == ref.get_idxdim());
+    { idx_aloop2(e, w, float, r, ref, float) { CPPUNIT_ASSERT_EQUAL(*r, *e); } }
+    // concatenation along dim 1 of 2 shards of same size
+    std::vector<std::string> files1;
+    files1.push_back(files[1]);
+    files1.push_back(files[1]);
+    idx<float> s1 = load_matrix<float>(files[1]);
+    idx<float> ref1 = idx_concat(s1, s1, 1);
+    idx<float> w1 = load_matrix<float>(files1, 1);
+    CPPUNIT_ASSERT(w1.get_idxdim() == ref1.get_idxdim());
+    { idx_aloop2(e, w1, float, r, ref1, float) {
+	CPPUNIT_ASSERT_EQUAL(*r, *e); } }
+    for (uint i = 0; i < files.size(); ++i)
+      rm_file(files[i]);
+  } catch(std::string &err) {
+    std::cerr << err << std::endl;
+    CPPUNIT_ASSERT(false); // err
+  }
+}
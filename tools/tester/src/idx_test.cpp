@@ -1,5 +1,6 @@
 #include "idx_test.h"
 #include "idxops.h"
+#include "idx_view.h"
 
 using namespace std;
 using namespace ebl;
@@ -548,3 +549,44 @@ void idx_test::test_view_as_order() {
 		}}}}}}}}}
   CPPUNIT_ASSERT_EQUAL(42, cnt);
 }
+
+void idx_test::test_idx_view() {
+  idx<double> m(4, 5, 6);
+  double v = 0;
+  { idx_aloop1(i, m, double) { *i = v++; } }
+  // element access matches idx, through slices of both
+  idx_view<double,3> vm(m);
+  CPPUNIT_ASSERT(vm.contiguousp());
+  CPPUNIT_ASSERT_EQUAL(m.nelements(), vm.nelements());
+  CPPUNIT_ASSERT_EQUAL(m.get(3, 2, 1), vm(3, 2, 1));
+  idx<double> n = m.narrow(1, 3, 1).transpose(0, 2).select(1, 2);
+  idx_view<double,2> vn = vm.narrow(1, 3, 1).transpose(0, 2).select(1, 2);
+  CPPUNIT_ASSERT(!vn.contiguousp());
+  CPPUNIT_ASSERT_EQUAL(n.dim(0), vn.dim(0));
+  CPPUNIT_ASSERT_EQUAL(n.dim(1), vn.dim(1));
+  for (intg i = 0; i < n.dim(0); ++i)
+    for (intg j = 0; j < n.dim(1); ++j)
+      CPPUNIT_ASSERT_EQUAL(n.get(i, j), vn(i, j));
+  // bloop macros visit the same elements as idx_bloop
+  intg cnt = 0;
+  idx_view<double,3> vt = vm.transpose(0, 1);
+  idx<double> t = m.transpose(0, 1);
+  { idxv_bloop2(a, vt, double, 3, b, vt, double, 3) {
+      idxv_bloop1(aa, a, double, 2) {
+	idxv_bloop1(aaa, aa, double, 1) {
+	  CPPUNIT_ASSERT_EQUAL(t.get(a.index(), aa.index(), aaa.index()),
+			       *aaa);
+	  CPPUNIT_ASSERT_EQUAL(*aaa, b(aa.index(), aaa.index()));
+	  cnt++;
+	}}}}
+  CPPUNIT_ASSERT_EQUAL(m.nelements(), cnt);
+  // lower orders are padded with trailing dimensions of size 1
+  idx<double> r = m.select(0, 1).select(0, 2);
+  idx_view<double,3> vr(r);
+  CPPUNIT_ASSERT_EQUAL((intg) 6, vr.dim(0));
+  CPPUNIT_ASSERT_EQUAL((intg) 1, vr.dim(2));
+  CPPUNIT_ASSERT_EQUAL(r.get(4), vr(4, 0, 0));
+  // views write into the idx
+  vm(0, 0, 0) = -1;
+  CPPUNIT_ASSERT_EQUAL(-1.0, m.get(0, 0, 0));
+}
@@ -1,4 +1,5 @@
 #include "idxops_test.h"
+#include <algorithm>
 
 using namespace ebl;
 
@@ -367,6 +368,236 @@ void idxops_test::test_idx_m2dotm1() {
     CPPUNIT_ASSERT_EQUAL((T)10.0, o.get());
 }
 
+void idxops_test::test_idx_m2dotm2() {
+  // sizes not multiple of the register tiles, and transposed operands
+  idx<T> a(13, 7), x(7, 9), y(13, 9), yref(13, 9);
+  T v = 0;
+  { idx_aloop1(e, a, T) { *e = (v++ / 10) - 3; } }
+  { idx_aloop1(e, x, T) { *e = 2 - (v++ / 20); } }
+  idx_m2dotm2<T>(a, x, yref); // generic version
+  idx_m2dotm2(a, x, y);
+  { idx_aloop2(e, y, T, r, yref, T)
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(*r, *e, 1e-9); }
+  idx<T> at(7, 13), yt(9, 13);
+  at = at.transpose(0, 1);
+  yt = yt.transpose(0, 1);
+  idx_copy(a, at);
+  idx_m2dotm2(at, x, yt);
+  idx_aloop2(e, yt, T, r, yref, T)
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(*r, *e, 1e-9);
+}
+
+void idxops_test::test_idx_m4dotm2acc() {
+  // convolution of a 12x14 input with a 5x5 kernel via an unfolded input
+  idx<T> in(12, 14), ker(5, 5), out(8, 10), outref(8, 10);
+  T v = 0;
+  { idx_aloop1(e, in, T) { *e = (v++ / 7) - 10; } }
+  { idx_aloop1(e, ker, T) { *e = 1 - (v++ / 30); } }
+  idx<T> uin = in.unfold(0, 5, 1);
+  uin = uin.unfold(1, 5, 1);
+  idx_fill(out, (T) 1.0);
+  idx_fill(outref, (T) 1.0);
+  idx_m4dotm2acc<T>(uin, ker, outref); // generic version
+  idx_m4dotm2acc(uin, ker, out);
+  { idx_aloop2(e, out, T, r, outref, T)
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(*r, *e, 1e-9); }
+  // backward convolution into the overlapping unfolded view
+  idx<T> gin(12, 14), ginref(12, 14);
+  idx_clear(gin);
+  idx_clear(ginref);
+  idx<T> ugin = gin.unfold(0, 5, 1);
+  ugin = ugin.unfold(1, 5, 1);
+  idx<T> uginref = ginref.unfold(0, 5, 1);
+  uginref = uginref.unfold(1, 5, 1);
+  idx_m2extm2acc<T>(out, ker, uginref); // generic version
+  idx_m2extm2acc(out, ker, ugin);
+  idx_aloop2(e, gin, T, r, ginref, T)
+    CPPUNIT_ASSERT_DOUBLES_EQUAL(*r, *e, 1e-6);
+}
+
+// counts how many times each slice of dimension 0 is visited
+class count_task : public parallel_range_task {
+public:
+  count_task(idx<int> &c) : counts(c) {}
+  virtual void run_range(intg begin, intg end) {
+    idx<int> s = counts.narrow(0, end - begin, begin);
+    idx_bloop1(ss, s, int) { idx_addc(ss, 1, ss); }
+  }
+  idx<int> &counts;
+};
+
+void idxops_test::test_parallel_for() {
+  typedef double T;
+  thread_pool &pool = thread_pool::global();
+  uint nthreads = pool.get_nthreads();
+  pool.set_nthreads(4);
+  // each slice is visited exactly once, whatever the grain
+  idx<int> counts(1000, 3);
+  for (intg grain = 1; grain < 4000; grain *= 7) {
+    idx_clear(counts);
+    count_task t(counts);
+    parallel_for(t, counts, 0, grain);
+    CPPUNIT_ASSERT_EQUAL((int) counts.nelements(), idx_sum(counts));
+    CPPUNIT_ASSERT_EQUAL(1, idx_max(counts));
+  }
+  // parallel elementwise ops give the serial results
+  idx<T> in(64, 65, 9), out(64, 65, 9), ref(64, 65, 9);
+  dseed(1);
+  idx_random(in, -2, 2);
+  idx<T> nin = in.narrow(2, 5, 2), nout = out.narrow(2, 5, 2);
+  idx_clear(out);
+  idx_tanh(nin, nout);
+  idx_clear(ref);
+  idx<T> nref = ref.narrow(2, 5, 2);
+  idx_aloop2(i, nin, T, r, nref, T) { *r = tanh(*i); }
+  CPPUNIT_ASSERT_EQUAL((T) 0, idx_sqrdist(out, ref));
+  idx_copy(in, out);
+  idx_exp(out);
+  { idx_aloop2(i, in, T, o, out, T)
+      CPPUNIT_ASSERT_EQUAL((T) exp(*i), *o); }
+  // operations with 2 inputs or constants, in place
+  idx_copy(in, out);
+  idx_lincomb(nin, (T) 2, nout, (T) -3, nout);
+  idx_addc(nout, (T) 1);
+  { idx_aloop2(i, nin, T, o, nout, T)
+      CPPUNIT_ASSERT_EQUAL(2 * *i - 3 * *i + 1, *o); }
+  pool.set_nthreads(nthreads);
+}
+
+void idxops_test::test_philox() {
+  typedef float T;
+  // known answers of Philox4x32-10 (Random123)
+  uint32 key[2] = { 0, 0 }, ctr[4] = { 0, 0, 0, 0 }, out[4];
+  philox::block(key, ctr, out);
+  CPPUNIT_ASSERT_EQUAL((uint32) 0x6627e8d5, out[0]);
+  CPPUNIT_ASSERT_EQUAL((uint32) 0xe169c58d, out[1]);
+  CPPUNIT_ASSERT_EQUAL((uint32) 0xbc57ac4c, out[2]);
+  CPPUNIT_ASSERT_EQUAL((uint32) 0x9b00dbd8, out[3]);
+  // sequential draws, seeking and random access agree
+  philox g(42, 3);
+  uint32 seq[11];
+  for (uint i = 0; i < 11; ++i) seq[i] = g.next();
+  CPPUNIT_ASSERT_EQUAL((uint64) 11, g.tell());
+  g.seek(5);
+  CPPUNIT_ASSERT_EQUAL(seq[5], g.next());
+  CPPUNIT_ASSERT_EQUAL(seq[9], g.at(9));
+  CPPUNIT_ASSERT(g.split(4).at(0) != seq[0]);
+  // fills do not depend on the number of threads nor on the memory layout
+  thread_pool &pool = thread_pool::global();
+  uint nthreads = pool.get_nthreads();
+  idx<T> u[2], n[2];
+  for (uint i = 0; i < 2; ++i) {
+    pool.set_nthreads(i == 0 ? 1 : 4);
+    philox r(7);
+    u[i] = idx<T>(300, 41);
+    n[i] = idx<T>(41, 300);
+    idx<T> nt = n[i].transpose(0, 1);
+    idx_fill_uniform(u[i], -1, 1, r);
+    CPPUNIT_ASSERT_EQUAL((uint64) u[i].nelements(), r.tell());
+    idx_fill_normal(nt, 2, 3, r);
+    n[i] = nt;
+  }
+  pool.set_nthreads(nthreads);
+  CPPUNIT_ASSERT_EQUAL((T) 0, idx_sqrdist(u[0], u[1]));
+  CPPUNIT_ASSERT_EQUAL((T) 0, idx_sqrdist(n[0], n[1]));
+  philox r(7);
+  idx<T> uc(300, 41);
+  idx_fill_uniform(uc, -1, 1, r);
+  CPPUNIT_ASSERT_EQUAL((T) 0, idx_sqrdist(uc, u[0]));
+  CPPUNIT_ASSERT_EQUAL(-1 + 2 * (T) philox::to_uniform(r.at(0)),
+		       uc.get(0, 0));
+  idx<T> nc(300, 41);
+  idx_fill_normal(nc, 2, 3, r);
+  CPPUNIT_ASSERT_EQUAL((T) 0, idx_sqrdist(nc, n[0]));
+  // distributions
+  CPPUNIT_ASSERT(idx_min(uc) > -1 && idx_max(uc) < 1);
+  CPPUNIT_ASSERT(fabs(idx_mean(uc)) < .05);
+  T m = idx_mean(nc);
+  CPPUNIT_ASSERT(fabs(m - 2) < .1);
+  idx_addc(nc, -m, nc);
+  CPPUNIT_ASSERT(fabs(sqrt(idx_sumsqr(nc) / nc.nelements()) - 3) < .1);
+}
+
+//! Each piece draws 'n' numbers with drand().
+class drand_task : public parallel_task {
+public:
+  drand_task(intg npieces, intg n_) : draws(npieces), n(n_) {}
+  virtual void run(intg i) {
+    for (intg j = 0; j < n; ++j) draws[i].push_back(drand());
+  }
+  std::vector<std::vector<double> > draws;
+  intg n;
+};
+
+void idxops_test::test_drand_threads() {
+  // concurrent draws interleave in any order, but must be exactly the
+  // numbers of the serial sequence
+  intg npieces = 8, n = 20000;
+  dseed(11);
+  std::vector<double> serial;
+  for (intg i = 0; i < npieces * n; ++i) serial.push_back(drand());
+  thread_pool &pool = thread_pool::global();
+  uint nthreads = pool.get_nthreads();
+  pool.set_nthreads(4);
+  dseed(11);
+  drand_task job(npieces, n);
+  parallel_run(job, npieces);
+  pool.set_nthreads(nthreads);
+  std::vector<double> all;
+  for (intg i = 0; i < npieces; ++i)
+    all.insert(all.end(), job.draws[i].begin(), job.draws[i].end());
+  std::sort(serial.begin(), serial.end());
+  std::sort(all.begin(), all.end());
+  CPPUNIT_ASSERT(serial == all);
+}
+
+// compare pooling kernels with naive loops, for specialized and generic sizes
+void idxops_test::test_idx_m2pooling() {
+  typedef float T;
+  dseed(2);
+  for (intg k = 1; k <= 5; ++k) {
+    for (intg s = 1; s <= k; ++s) {
+      idx<T> big(17, 23);
+      idx_random(big, -1, 1);
+      // average pooling (sums)
+      intg ni = big.dim(0) / k, nj = big.dim(1) / k;
+      idx<T> sm(ni, nj), smt(nj, ni), t = smt.transpose(0, 1);
+      idx_m2subsample(big, k, k, sm);
+      idx<T> bigt(big.dim(1), big.dim(0)), tb = bigt.transpose(0, 1);
+      idx_copy(big, tb);
+      idx_m2subsample(tb, k, k, t); // non-contiguous
+      for (intg i = 0; i < ni; ++i)
+        for (intg j = 0; j < nj; ++j) {
+          T ref = 0;
+          for (intg r = 0; r < k; ++r)
+            for (intg c = 0; c < k; ++c)
+              ref += big.get(i * k + r, j * k + c);
+          CPPUNIT_ASSERT_DOUBLES_EQUAL(ref, sm.get(i, j), 1e-5);
+          CPPUNIT_ASSERT_DOUBLES_EQUAL(ref, t.get(i, j), 1e-5);
+        }
+      // max pooling with a stride, last windows are clipped
+      ni = (big.dim(0) + s - 1) / s; nj = (big.dim(1) + s - 1) / s;
+      idx<T> mx(ni, nj);
+      idx<int> sw(ni, nj, 2);
+      idx_m2maxpool(big, k, k, s, s, mx, sw);
+      for (intg i = 0; i < ni; ++i)
+        for (intg j = 0; j < nj; ++j) {
+          T ref = big.get(i * s, j * s);
+          for (intg r = i * s; r < std::min(i * s + k, big.dim(0)); ++r)
+            for (intg c = j * s; c < std::min(j * s + k, big.dim(1)); ++c)
+              ref = std::max(ref, big.get(r, c));
+          CPPUNIT_ASSERT_EQUAL(ref, mx.get(i, j));
+          CPPUNIT_ASSERT_EQUAL(ref, big.get(sw.get(i, j, 0), sw.get(i, j, 1)));
+        }
+      // unpooling accumulates at the max locations
+      idx<T> back(big.dim(0), big.dim(1));
+      idx_clear(back);
+      idx_m2unpoolacc(mx, sw, back);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL(idx_sum(mx), idx_sum(back), 1e-2);
+    }
+  }
+}
+
 void idxops_test::test_huge_vec() {
 
   // this would not run on many systems
@@ -395,6 +395,98 @@ void image_test::test_deformations() {
 	}
 }
 
+// returns the maximum absolute difference between a and b
+static float max_absdiff(idx<float> &a, idx<float> &b) {
+	idx<float> d(a.get_idxdim());
+	idx_sub(a, b, d);
+	idx_abs(d, d);
+	return idx_max(d);
+}
+
+void image_test::test_deformation_affine() {
+	dseed(1);
+	idx<float> im(23, 31, 3), ref(im.get_idxdim()), out(im.get_idxdim());
+	idx_random(im, 0, 1);
+	float th = 3, tw = -2, sh = .8, sw = 1.2, deg = 20, shh = .1, shw = -.1;
+	// affine warp matches the warp of the dense flow
+	idx<float> flow = image_deformation_flow(im, th, tw, sh, sw, deg, shh, shw,
+																					 0, 0);
+	image_warp_flow(im, ref, flow);
+	image_deformation(im, out, th, tw, sh, sw, deg, shh, shw, 0, 0);
+	CPPUNIT_ASSERT(max_absdiff(ref, out) < 1e-4);
+	// serial and parallel planar warps are identical
+	float m[6];
+	deformation_affine(im.dim(0), im.dim(1), th, tw, sh, sw, deg, shh, shw, m);
+	idx<float> pin = im.shift_dim(2, 0), p1(pin.get_idxdim()), p2(pin.get_idxdim());
+	image_warp_affine(pin, p1, m, (idx<float>*) NULL, (float) 0, false);
+	image_warp_affine(pin, p2, m, (idx<float>*) NULL, (float) 0, true);
+	CPPUNIT_ASSERT_EQUAL((float) 0, max_absdiff(p1, p2));
+	// separable elastic smoothing matches the 2D gaussian convolution
+	uint sz = 7;
+	float coeff = 5;
+	idx<float> e1(2, 23, 31), e2(2, 23, 31), noise(2, 23 + sz - 1, 31 + sz - 1);
+	idx_clear(e1);
+	dseed(2);
+	elastic_flow(e1, sz, coeff);
+	dseed(2);
+	idx_random(noise, -.5, .5);
+	idx<float> g = create_gaussian_kernel<float>(sz);
+	idx_3dconvol(noise, g, e2);
+	idx_dotc(e2, coeff, e2);
+	CPPUNIT_ASSERT(max_absdiff(e1, e2) < 1e-4);
+}
+
+void image_test::test_colorspace_kernels() {
+	dseed(3);
+	idx<ubyte> im(17, 29, 3);
+	{ idx_aloop1(i, im, ubyte) { *i = (ubyte) drand(0, 255); }}
+	idx<float> fim(im.get_idxdim()), ref(im.get_idxdim());
+	idx_copy(im, fim);
+	// reference: per-pixel conversion
+	{ idx_bloop2(r, fim, float, y, ref, float) {
+			idx_bloop2(rr, r, float, yy, y, float) {
+				rgb_to_yuv_1D(rr, yy); }}}
+	// interleaved float into interleaved and planar outputs
+	idx<float> out(im.get_idxdim());
+	rgb_to_yuv(fim, out);
+	CPPUNIT_ASSERT(max_absdiff(ref, out) < 1e-3);
+	idx<float> planar(3, im.dim(0), im.dim(1));
+	idx<float> pview = planar.shift_dim(0, 2);
+	rgb_to_yuv(fim, pview);
+	CPPUNIT_ASSERT(max_absdiff(ref, pview) < 1e-3);
+	// planar to planar
+	idx<float> pin(3, im.dim(0), im.dim(1)), pout(3, im.dim(0), im.dim(1));
+	idx<float> pinv = pin.shift_dim(0, 2), poutv = pout.shift_dim(0, 2);
+	idx_copy(fim, pinv);
+	rgb_to_yuv(pinv, poutv);
+	CPPUNIT_ASSERT(max_absdiff(ref, poutv) < 1e-3);
+	// fixed-point ubyte input straight into planar float
+	idx_clear(planar);
+	rgb_to_yuv(im, pview);
+	CPPUNIT_ASSERT(max_absdiff(ref, pview) < .01);
+	// y and bgr y
+	idx<float> y(im.dim(0), im.dim(1), 1), yref(im.dim(0), im.dim(1), 1);
+	idx<float> bgr(im.get_idxdim());
+	{ idx_bloop3(r, fim, float, yr, yref, float, b, bgr, float) {
+			idx_bloop3(rr, r, float, yy, yr, float, bb, b, float) {
+				rgb_to_y_1D(rr, yy);
+				bb.set(rr.get(2), 0); bb.set(rr.get(1), 1); bb.set(rr.get(0), 2);
+			}}}
+	rgb_to_y(im, y);
+	CPPUNIT_ASSERT(max_absdiff(yref, y) < .01);
+	idx_clear(y);
+	bgr_to_y(bgr, y);
+	CPPUNIT_ASSERT(max_absdiff(yref, y) < 1e-3);
+	// hsv with a non-contiguous input
+	idx<float> hin = fim.narrow(1, 20, 5), href(hin.get_idxdim()),
+		hout(hin.get_idxdim());
+	{ idx_bloop2(r, hin, float, h, href, float) {
+			idx_bloop2(rr, r, float, hh, h, float) {
+				rgb_to_hsv_1D(rr, hh); }}}
+	rgb_to_hsv(hin, hout);
+	CPPUNIT_ASSERT(max_absdiff(href, hout) < 1e-3);
+}
+
 void image_test::test_colorspaces() {
 	try {
 		CPPUNIT_ASSERT_MESSAGE(*gl_data_errmsg, gl_data_dir != NULL);
@@ -55,6 +55,8 @@
 #include "ebl_basic_test.h"
 #include "ebl_preprocessing_test.h"
 #include "datasource_test.h"
+#include "metaparser_test.h"
+#include "pascal_xml_test.h"
 #include "idxiter_test.h"
 #include "detector_test.h"
 #include "ClusterTest.h"
@@ -276,6 +278,8 @@ MAIN_QTHREAD(int, argc, char**, argv) {
 #endif
     runner.addTest(ClusterTest::suite());
     runner.addTest(datasource_test::suite());
+    runner.addTest(metaparser_test::suite());
+    runner.addTest(pascal_xml_test::suite());
     runner.addTest(ebl_basic_test::suite());
     runner.addTest(ebl_preprocessing_test::suite());
     runner.addTest(image_test::suite());
@@ -0,0 +1,136 @@
+#include "metaparser_test.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdlib.h>
+
+#include "utils.h"
+#include "job.h"
+
+using namespace std;
+using namespace ebl;
+
+void metaparser_test::setUp() {
+  char tmpl[] = "/tmp/metaparser_testXXXXXX";
+  CPPUNIT_ASSERT(mkdtemp(tmpl) != NULL);
+  dir = tmpl;
+  // 2 jobs, job a reaching iteration 3 and job b iteration 2
+  ofstream a((dir + "/a.log").c_str()), b((dir + "/b.log").c_str());
+  for (int i = 0; i <= 3; ++i)
+    a << "job=a i=" << i << " test_errors=0." << 9 - i << endl;
+  for (int i = 0; i <= 2; ++i)
+    b << "job=b i=" << i << " test_errors=0." << 8 - i << endl;
+}
+
+void metaparser_test::tearDown() {
+  rm_file(dir + "/a.log");
+  rm_file(dir + "/b.log");
+  rmdir(dir.c_str());
+}
+
+// the hierarchy keys "job" and "i" must be parsed whether or not
+// the watched variables are restricted by 'meta_watch_vars'.
+void metaparser_test::test_max_common_iter() {
+  configuration conf;
+  metaparser p;
+  CPPUNIT_ASSERT_EQUAL(2, p.get_max_common_iter(conf, dir));
+  double v = 0;
+  CPPUNIT_ASSERT(p.get_value("a", 3, "test_errors", v));
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.6, v, 1e-9);
+  // restricting watched variables keeps hierarchy keys
+  conf.set("meta_watch_vars", "test_errors");
+  metaparser p2;
+  CPPUNIT_ASSERT_EQUAL(2, p2.get_max_common_iter(conf, dir));
+  CPPUNIT_ASSERT(p2.get_value("b", 2, "test_errors", v));
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.6, v, 1e-9);
+}
+
+// exposes the successive halving state of a job_manager with a single rung,
+// pausing jobs so that no job objects are needed.
+class promotion_manager : public job_manager {
+public:
+  promotion_manager(uint eta) {
+    sched_eta = eta;
+    sched_pause = true;
+    rungs.push_back(1);
+    rung_results.resize(1);
+    promoted_at.resize(1);
+  }
+  // records result 'v' of job 'j' at the rung and updates promotions.
+  void add(uint j, double v) {
+    rung_results[0][j] = v;
+    promote(0);
+  }
+  bool promoted(uint j) { return promoted_at[0].count(j) > 0; }
+  size_t npromoted() { return promoted_at[0].size(); }
+};
+
+void metaparser_test::test_promotion() {
+  promotion_manager m(3);
+  // all jobs are promoted until there are eta results to compare
+  m.add(0, .5);
+  m.add(1, .9);
+  CPPUNIT_ASSERT(m.promoted(0) && m.promoted(1));
+  // a better job waits: 2 promotions already exceed 1/3 of 3 results,
+  // and the worse promoted jobs are not demoted
+  m.add(2, .1);
+  CPPUNIT_ASSERT(!m.promoted(2));
+  CPPUNIT_ASSERT(m.promoted(0) && m.promoted(1));
+  // 7 results allow 3 promotions: the best waiting job is promoted
+  m.add(3, .8);
+  m.add(4, .7);
+  m.add(5, .95);
+  CPPUNIT_ASSERT_EQUAL((size_t) 2, m.npromoted());
+  m.add(6, .2);
+  CPPUNIT_ASSERT_EQUAL((size_t) 3, m.npromoted());
+  CPPUNIT_ASSERT(m.promoted(2));
+  CPPUNIT_ASSERT(!m.promoted(6));
+  // 10 results allow 4 promotions, going to the best of the waiting jobs
+  m.add(7, .05);
+  m.add(8, .3);
+  CPPUNIT_ASSERT_EQUAL((size_t) 3, m.npromoted());
+  m.add(9, .99);
+  CPPUNIT_ASSERT_EQUAL((size_t) 4, m.npromoted());
+  CPPUNIT_ASSERT(m.promoted(7));
+  CPPUNIT_ASSERT(m.promoted(0) && m.promoted(1) && m.promoted(2));
+}
+
+void metaparser_test::test_rewritten_log() {
+  string a = dir + "/a.log";
+  metaparser p;
+  double v = 0;
+  p.parse_logs(dir);
+  CPPUNIT_ASSERT(p.get_value("a", 3, "test_errors", v));
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.6, v, 1e-9);
+  // a log rewritten with the same size is parsed again
+  {
+    ofstream f(a.c_str());
+    for (int i = 0; i <= 3; ++i)
+      f << "job=a i=" << i << " test_errors=0." << 5 - i << endl;
+  }
+  p.parse_logs(dir);
+  CPPUNIT_ASSERT(p.get_value("a", 3, "test_errors", v));
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.2, v, 1e-9);
+  // a log rewritten with a larger size and the same first lines is parsed
+  // again rather than from the previous offset
+  {
+    ofstream f(a.c_str());
+    for (int i = 0; i <= 4; ++i)
+      f << "job=a i=" << i << " test_errors=0." << (i < 3 ? 5 - i : 7) << endl;
+  }
+  p.parse_logs(dir);
+  CPPUNIT_ASSERT(p.get_value("a", 3, "test_errors", v));
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.7, v, 1e-9);
+  CPPUNIT_ASSERT(p.get_value("a", 4, "test_errors", v));
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.7, v, 1e-9);
+  // lines appended to the log are still parsed incrementally
+  {
+    ofstream f(a.c_str(), ios::app);
+    f << "job=a i=5 test_errors=0.1" << endl;
+  }
+  p.parse_logs(dir);
+  CPPUNIT_ASSERT(p.get_value("a", 5, "test_errors", v));
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.1, v, 1e-9);
+  CPPUNIT_ASSERT(p.get_value("a", 2, "test_errors", v));
+  CPPUNIT_ASSERT_DOUBLES_EQUAL(0.3, v, 1e-9);
+}
@@ -0,0 +1,218 @@
+#include "pascal_xml_test.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#include "utils.h"
+
+using namespace std;
+using namespace ebl;
+
+// an annotation of a single car, in pascal voc format
+static const char *voc_xml =
+  "<annotation><folder>cars</folder><filename>%s.jpg</filename>"
+  "<size><width>64</width><height>48</height><depth>3</depth></size>"
+  "<object><name>car</name><pose>Left</pose><truncated>0</truncated>"
+  "<difficult>1</difficult><bndbox><xmin>1</xmin><ymin>2</ymin>"
+  "<xmax>30</xmax><ymax>40</ymax></bndbox></object></annotation>\n";
+
+// writes the annotation of image 'name' into 'fname'.
+static void write_xml(const string &fname, const char *name) {
+  FILE *fp = fopen(fname.c_str(), "w");
+  CPPUNIT_ASSERT(fp != NULL);
+  fprintf(fp, voc_xml, name);
+  fclose(fp);
+}
+
+// sets the modification time of 'fname' to 'sec' seconds and 'usec'
+// microseconds.
+static void set_modified(const string &fname, long sec, long usec) {
+  struct timeval t[2];
+  t[0].tv_sec = t[1].tv_sec = sec;
+  t[0].tv_usec = t[1].tv_usec = usec;
+  CPPUNIT_ASSERT(utimes(fname.c_str(), t) == 0);
+}
+
+// a pascal_index which does not need libxml: the image name is the xml
+// content, and annotations have fixed objects with all optional fields.
+class fake_index : public pascal_index {
+public:
+  // returns a new parse of 'xmlfile', to be deleted by the caller.
+  pascal_annotation *reparse(const string &xmlfile) { return parse(xmlfile); }
+protected:
+  virtual bool read_xml(pascal_annotation &a) const {
+    ifstream f(a.xmlfile.c_str());
+    getline(f, a.image_filename);
+    a.folder = "cars";
+    a.height = 48;
+    a.width = 64;
+    a.depth = 3;
+    a.cropr = new rect<int>(0, 1, 40, 60);
+    object *o = new object(0);
+    o->set_rect(1, 2, 30, 40);
+    o->set_visible(2, 3, 20, 30);
+    o->set_centroid(10, 12);
+    o->name = "car";
+    o->pose = "Left";
+    o->difficult = true;
+    object *p = new object(1);
+    p->set_rect(3, 4, 9, 10);
+    p->name = "wheel";
+    o->parts.push_back(p);
+    a.objs.push_back(o);
+    return true;
+  }
+};
+
+// returns true if rects 'a' and 'b' are identical.
+static bool same_rect(const rect<int> &a, const rect<int> &b) {
+  return a.h0 == b.h0 && a.w0 == b.w0 && a.height == b.height
+    && a.width == b.width;
+}
+
+// returns true if objects 'a' and 'b' and their parts are identical.
+static bool same_object(const object &a, const object &b) {
+  if (!same_rect(a, b) || a.id != b.id
+      || a.name != b.name || a.pose != b.pose || a.difficult != b.difficult
+      || a.truncated != b.truncated || a.occluded != b.occluded
+      || !a.visible != !b.visible || !a.centroid != !b.centroid
+      || a.parts.size() != b.parts.size())
+    return false;
+  if (a.visible && !same_rect(*a.visible, *b.visible)) return false;
+  if (a.centroid && *a.centroid != *b.centroid) return false;
+  for (uint i = 0; i < a.parts.size(); ++i)
+    if (!same_object(*a.parts[i], *b.parts[i])) return false;
+  return true;
+}
+
+// returns true if annotations 'a' and 'b' are identical.
+static bool same_annotation(const pascal_annotation &a,
+                            const pascal_annotation &b) {
+  if (a.xmlfile != b.xmlfile || a.modified != b.modified || a.size != b.size
+      || a.valid != b.valid || a.image_filename != b.image_filename
+      || a.folder != b.folder || a.height != b.height || a.width != b.width
+      || a.depth != b.depth || !a.cropr != !b.cropr
+      || a.objs.size() != b.objs.size())
+    return false;
+  if (a.cropr && !same_rect(*a.cropr, *b.cropr)) return false;
+  for (uint i = 0; i < a.objs.size(); ++i)
+    if (!same_object(*a.objs[i], *b.objs[i])) return false;
+  return true;
+}
+
+void pascal_xml_test::setUp() {
+  char tmpl[] = "/tmp/pascal_xml_testXXXXXX";
+  CPPUNIT_ASSERT(mkdtemp(tmpl) != NULL);
+  dir = tmpl;
+  cache = dir + "/index.bin";
+  // xml files are found recursively
+  CPPUNIT_ASSERT(mkdir((dir + "/sub").c_str(), 0755) == 0);
+  write_xml(dir + "/a.xml", "a");
+  write_xml(dir + "/sub/b.xml", "b");
+}
+
+void pascal_xml_test::tearDown() {
+  rm_file(dir + "/a.xml");
+  rm_file(dir + "/sub/b.xml");
+  rm_file(cache);
+  rmdir((dir + "/sub").c_str());
+  rmdir(dir.c_str());
+}
+
+void pascal_xml_test::test_cache_roundtrip() {
+  fake_index i1, i2;
+  CPPUNIT_ASSERT_EQUAL((uint) 2, i1.load(dir, cache));
+  CPPUNIT_ASSERT_EQUAL((uint) 2, i1.parsed());
+  CPPUNIT_ASSERT(file_exists(cache));
+  // everything is read back from the cache, identical to a new parse
+  CPPUNIT_ASSERT_EQUAL((uint) 2, i2.load(dir, cache));
+  CPPUNIT_ASSERT_EQUAL((uint) 0, i2.parsed());
+  for (uint i = 0; i < i2.size(); ++i) {
+    const pascal_annotation &a = i2.get(i);
+    pascal_annotation *p = i2.reparse(a.xmlfile);
+    CPPUNIT_ASSERT(same_annotation(i1.get(i), a));
+    CPPUNIT_ASSERT(same_annotation(*p, a));
+    delete p;
+  }
+#ifdef __XML__
+  // with the xml parser, cached properties match the xml files
+  pascal_index x1, x2;
+  rm_file(cache);
+  x1.load(dir, cache);
+  x2.load(dir, cache);
+  CPPUNIT_ASSERT_EQUAL((uint) 0, x2.parsed());
+  for (uint i = 0; i < x2.size(); ++i) {
+    string xmlfile = x2.get(i).xmlfile;
+    string fname1, fname2, full1, full2, folder1, folder2;
+    int h1 = -1, w1 = -1, d1 = -1, h2 = -1, w2 = -1, d2 = -1;
+    vector<object*> o1, o2;
+    rect<int> *c1 = NULL, *c2 = NULL;
+    CPPUNIT_ASSERT(pascal_xml::get_properties(dir, xmlfile, fname1, full1,
+                                              folder1, h1, w1, d1, o1, &c1));
+    CPPUNIT_ASSERT(x2.get_properties(dir, xmlfile, fname2, full2, folder2,
+                                     h2, w2, d2, o2, &c2));
+    CPPUNIT_ASSERT(fname1 == fname2 && full1 == full2 && folder1 == folder2);
+    CPPUNIT_ASSERT(h1 == h2 && w1 == w2 && d1 == d2);
+    CPPUNIT_ASSERT(!c1 && !c2);
+    CPPUNIT_ASSERT_EQUAL(o1.size(), o2.size());
+    for (uint j = 0; j < o1.size(); ++j) {
+      CPPUNIT_ASSERT(same_object(*o1[j], *o2[j]));
+      delete o1[j];
+      delete o2[j];
+    }
+  }
+#endif
+}
+
+void pascal_xml_test::test_cache_invalidation() {
+  string a = dir + "/a.xml";
+  fake_index i0;
+  i0.load(dir, cache);
+  CPPUNIT_ASSERT_EQUAL((uint) 2, i0.parsed());
+  // a file changing size is parsed again
+  write_xml(a, "aa");
+  fake_index i1;
+  i1.load(dir, cache);
+  CPPUNIT_ASSERT_EQUAL((uint) 1, i1.parsed());
+  CPPUNIT_ASSERT(i1.find(a)->image_filename.find("aa.jpg") != string::npos);
+  // a file with the same size but modified later is parsed again,
+  // even within the same second
+  write_xml(a, "ab");
+  set_modified(a, 1000000000, 100000);
+  fake_index i2;
+  i2.load(dir, cache);
+  CPPUNIT_ASSERT_EQUAL((uint) 1, i2.parsed());
+  set_modified(a, 1000000000, 600000);
+  fake_index i3;
+  i3.load(dir, cache);
+  CPPUNIT_ASSERT_EQUAL((uint) 1, i3.parsed());
+  fake_index i4;
+  i4.load(dir, cache);
+  CPPUNIT_ASSERT_EQUAL((uint) 0, i4.parsed());
+  // a cache with a wrong magic number is rebuilt
+  FILE *fp = fopen(cache.c_str(), "r+b");
+  CPPUNIT_ASSERT(fp != NULL);
+  fputc('X', fp);
+  fclose(fp);
+  fake_index i5;
+  i5.load(dir, cache);
+  CPPUNIT_ASSERT_EQUAL((uint) 2, i5.parsed());
+  // a cache with another version is rebuilt (the version follows the
+  // magic string "EBLPASCALIDX" and its terminating 0)
+  fp = fopen(cache.c_str(), "r+b");
+  CPPUNIT_ASSERT(fp != NULL);
+  int version = 999;
+  fseek(fp, 13, SEEK_SET);
+  fwrite(&version, sizeof (int), 1, fp);
+  fclose(fp);
+  fake_index i6;
+  i6.load(dir, cache);
+  CPPUNIT_ASSERT_EQUAL((uint) 2, i6.parsed());
+  fake_index i7;
+  i7.load(dir, cache);
+  CPPUNIT_ASSERT_EQUAL((uint) 0, i7.parsed());
+}
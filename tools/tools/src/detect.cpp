@@ -68,8 +68,16 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
 #ifdef __LINUX__
       feenableexcept(FE_DIVBYZERO | FE_INVALID); // enable float exceptions
 #endif
-      // load configuration
-      configuration	conf(argv[1], true, true, false);
+      // load configuration, directly from a precompiled bundle if given one,
+      // which is opened only once and shared by all threads
+      configuration	conf;
+      netbundle<t_net> *bundle = NULL;
+      if (is_netbundle(argv[1])) {
+	bundle = new netbundle<t_net>(argv[1]);
+	conf = bundle->get_configuration();
+	conf.set("netbundle", argv[1]);
+      } else if (!conf.read(argv[1], false, true, true))
+	eblerror("failed to open configuration file");
       if (conf.exists_true("fixed_randomization"))
 	cout << "Using fixed seed: " << fixed_init_drand() << endl;
       else
@@ -105,7 +113,10 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
       idx<ubyte> classes(1,1);
       vector<string> sclasses;
       try { // try loading classes names but do not stop upon failure
-	load_matrix<ubyte>(classes, conf.get_cstring("classes"));
+	if (bundle)
+	  classes = bundle->get_classes();
+	else
+	  load_matrix<ubyte>(classes, conf.get_cstring("classes"));
       } catch(string &err) { merr << "warning: " << err << endl; }
       sclasses = ubyteidx_to_stringvector(classes);
       t_bbox_saving bbsaving = bbox_none;
@@ -116,6 +127,10 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
       uint              ipp_cores     = 1;
       if (conf.exists("ipp_cores")) ipp_cores = conf.get_uint("ipp_cores");
       ipp_init(ipp_cores); // limit IPP (if available) to 1 core
+      // library-wide thread pool (all cores if pool_cores <= 0)
+      pool_init(conf.try_get_int("pool_cores", 1),
+                conf.try_get_intg("pool_grain", 0));
+      profile_init(conf); // per-module profiling if 'profile' is true
       bool		save_video    = conf.exists_true("save_video");
       bool              save_detections = conf.exists_true("save_detections");
       int		height        = -1;
@@ -167,6 +182,7 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
       for (uint i = 0; i < nthreads; ++i) {
 	detection_thread<t_net> *dt =
 	  new detection_thread<t_net>(conf, &out_mutex, NULL, NULL, sync);
+	if (bundle) dt->set_netbundle(bundle);
 	threads.push_back(dt);
 	dt->start();
       }
@@ -229,6 +245,14 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
 	else eblerror("expected 2nd argument");
       } else if (!strcmp(cam_type.c_str(), "datasource")) {
         cam = new camera_datasource<ubyte,int>(conf);
+      } else if (!strcmp(cam_type.c_str(), "synthetic")) {
+	cam = new camera_synthetic<ubyte>
+	  (conf.try_get_uint("synthetic_height", 480),
+	   conf.try_get_uint("synthetic_width", 640),
+	   conf.try_get_uint("synthetic_frames", 100),
+	   conf.try_get_uint("synthetic_seed", 0),
+	   conf.try_get_string("synthetic_content", "shapes").c_str(),
+	   conf.try_get_uint("synthetic_distinct", 8), height, width);
       } else eblerror("unknown camera type, set \"camera\" in your .conf");
       // a camera directory may be used first, then switching to regular cam
       if (conf.exists_true("precamera"))
@@ -276,6 +300,11 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
       timer tpass, toverall, tstop;
       uint cnt = 0;
       bool stop = false, finished = false;
+      // benchmark: time from first frame sent to last result received
+      bool benchmark = conf.exists_true("benchmark");
+      timer tbench;
+      bool bench_started = false;
+      double bench_seconds = 0;
 
       // loop
       toverall.start();
@@ -298,6 +327,8 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
 	  if (skipped) cnt++; // a new skipped frame was received
 	  // save bounding boxes
 	  if (updated) {
+	    if (bench_started)
+	      bench_seconds = tbench.elapsed_microseconds() / 1e6;
 	    idxdim d(detframe);
 	    if (boot.activated()) bb.clear();
 	    if (bbsaving != bbox_none) {
@@ -455,6 +486,10 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
 		}
 		// we just sent a new frame
 		tpass.restart();
+		if (!bench_started) {
+		  tbench.start();
+		  bench_started = true;
+		}
 	      }
 	    }
 	  }
@@ -486,13 +521,32 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
       // saving bootstrapping
       if (conf.exists_true("bootstrapping_save") && boot.activated())
 	boot.save_dataset(all_samples, all_bbsamples, outdir, classes);
+      profile_report(conf); // print per-module profile if profiling
+      if (benchmark) { // per-stage latencies of all threads and throughput
+	vector<detector_timing> timings, t;
+	for (ithreads = threads.begin(); ithreads != threads.end(); ++ithreads) {
+	  (*ithreads)->get_timings(t);
+	  timings.insert(timings.end(), t.begin(), t.end());
+	}
+	mout << "Detection benchmark with " << nthreads << " threads:" << endl;
+	print_timing_percentiles(timings, bench_seconds, mout);
+      }
       // free variables
       if (cam) delete cam;
-      for (ithreads = threads.begin(); ithreads != threads.end(); ++ithreads) {
+      for (ithreads = threads.begin(); ithreads != threads.end(); ++ithreads)
 	if (!(*ithreads)->finished())
 	  (*ithreads)->stop(); // stop thread without waiting
+      // wait until threads exited, they may still read the mapped weights
+      bool all_joined = true;
+      for (ithreads = threads.begin(); ithreads != threads.end(); ++ithreads) {
+	if (!(*ithreads)->join()) all_joined = false;
 	delete *ithreads;
       }
+      if (bundle) {
+	if (all_joined) delete bundle;
+	else merr << "Warning: not unmapping network bundle " << argv[1]
+		  << ", some detection threads may still be running." << endl;
+      }
 #ifdef __GUI__
       if (!conf.exists_true("no_gui_quit") && !conf.exists("next_on_key")) {
 	mout << "Closing windows..." << endl;
@@ -143,6 +143,8 @@ string          label            = "";
 idxdim          gridsz;
 string          annotations;
 string		ignore_path;
+string		annotations_cache;
+bool		annotations_cache_set = false;
 uint            tjitter_step = 0; // translation step in pixels
 uint            tjitter_hmin = 0; // translation min height in pixels
 uint            tjitter_hmax = 0; // translation max height in pixels
@@ -226,6 +228,11 @@ bool parse_args(int argc, char **argv) {
       } else if (strcmp(argv[i], "-ignore_path") == 0) {
 	++i; if (i >= argc) throw 0;
 	ignore_path = argv[i];
+      } else if (strcmp(argv[i], "-annotations_cache") == 0) {
+	++i; if (i >= argc) throw 0;
+	annotations_cache = argv[i];
+	if (!strcmp(argv[i], "none")) annotations_cache = "";
+	annotations_cache_set = true;
       } else if (strcmp(argv[i], "-disp") == 0) {
 	display = true;
       } else if (strcmp(argv[i], "-nopp") == 0) {
@@ -519,6 +526,10 @@ void print_usage() {
   cout << "  -annotations <directory>" << endl;
   cout << "  -ignore_path <directory>" << endl
        << "     Path of ignored annotations files." << endl;
+  cout << "  -annotations_cache <file|none>" << endl
+       << "     Binary cache of parsed annotations, reused as long as"
+       << " xml files" << endl
+       << "     are unchanged (default: <annotations>/.pascal_index)." << endl;
   cout << "  -image_pattern <pattern>" << endl;
   cout << "     default: " << IMAGE_PATTERN_MAT << endl;
   cout << "  -channels <channel>" << endl;
@@ -680,6 +691,8 @@ void compile() {
     if (max_aspect_ratio_set) d->set_max_aspect_ratio(max_aspect_ratio);
     if (minborders_set) d->set_minborders(minborders);
     if (max_jitt_match > 0.0) d->set_max_jitter_match(max_jitt_match);
+    if (annotations_cache_set)
+      d->set_annotation_cache(annotations_cache.c_str());
   } else if (!strcmp(stype.c_str(), "pascalbg")) {
     ds = new pascalbg_dataset<Tdata>
         (dataset_name.c_str(), images_root.c_str(), outdir.c_str(), maxperclass,
@@ -215,6 +215,10 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
       uint              ipp_cores     = 1;
       if (conf.exists("ipp_cores")) ipp_cores = conf.get_uint("ipp_cores");
       ipp_init(ipp_cores); // limit IPP (if available) to 1 core
+      // library-wide thread pool (all cores if pool_cores <= 0)
+      pool_init(conf.try_get_int("pool_cores", 1),
+                conf.try_get_intg("pool_grain", 0));
+      profile_init(conf); // per-module profiling if 'profile' is true
 
       //! load datasets
       uint noutputs = 0;
@@ -275,6 +279,7 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
       if (!dump && train_ds)
         fprop_and_save(conf, *net, *train_ds, outdir, traindata, arch_name,
                        counter, total_size);
+      profile_report(conf); // print per-module profile if profiling
 
       //free variables
       if (net) delete net;
@@ -0,0 +1,539 @@
+/***************************************************************************
+ *   Copyright (C) 2012 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+// Micro-benchmarks of the libidx and libeblearn kernels that dominate training
+// and detection time. Each kernel runs on synthetic data at realistic sizes,
+// results are printed (and optionally saved) as a whitespace-separated table
+// or as json, and can be compared against a previously saved table.
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include "libidx.h"
+#include "libeblearn.h"
+#include "nms.h"
+
+using namespace std;
+using namespace ebl;
+
+string filter = ""; // only run benchmarks whose name contains this
+double min_time = 0.2; // minimum seconds spent per benchmark
+uint nsamples = 7; // number of timing samples per benchmark
+string save_file = ""; // where to save the result table
+string json_file = ""; // where to save the json results
+string baseline_file = ""; // table to compare results against
+double tolerance = 0.10; // relative slowdown considered a regression
+string tmp_file = "eblbench_tmp.mat"; // scratch file for load_matrix
+int nthreads = -1; // number of threads of the global pool (-1: default)
+bool list_only = false;
+
+////////////////////////////////////////////////////////////////////////////////
+// benchmarks
+
+//! A benchmark allocates its synthetic data in its constructor and times
+//! run() only.
+class benchmark {
+public:
+  benchmark(const char *name_) : name(name_) {}
+  virtual ~benchmark() {}
+  //! Runs the kernel once.
+  virtual void run() = 0;
+public:
+  string name;
+};
+
+//! Timing results of one benchmark, in microseconds per run.
+struct bench_result {
+  bench_result() : median(0), min(0), runs(0) {}
+  string name;
+  double median;
+  double min;
+  intg runs;
+};
+
+// idx_m2dotm1: 1024x1024 matrix times vector (linear layer, batch of 1).
+class bench_m2dotm1 : public benchmark {
+public:
+  bench_m2dotm1() : benchmark("idx_m2dotm1_1024"), a(1024, 1024), x(1024),
+                    y(1024) {
+    idx_random(a, -1, 1); idx_random(x, -1, 1);
+  }
+  virtual void run() { idx_m2dotm1(a, x, y); }
+  idx<float> a, x, y;
+};
+
+// idx_m4dotm2acc: 64x64 output with 9x9 kernels (unfolded 2D convolution).
+class bench_m4dotm2acc : public benchmark {
+public:
+  bench_m4dotm2acc() : benchmark("idx_m4dotm2acc_64x64x9x9"),
+                       in(64, 64, 9, 9), ker(9, 9), out(64, 64) {
+    idx_random(in, -1, 1); idx_random(ker, -1, 1); idx_clear(out);
+  }
+  virtual void run() { idx_m4dotm2acc(in, ker, out); }
+  idx<float> in, ker, out;
+};
+
+// idx_tanh family: 1M elements, out of place.
+class bench_tanh : public benchmark {
+public:
+  bench_tanh() : benchmark("idx_tanh_1M"), in(1024, 1024), out(1024, 1024) {
+    idx_random(in, -3, 3);
+  }
+  virtual void run() { idx_tanh(in, out); }
+  idx<float> in, out;
+};
+
+class bench_dtanh : public bench_tanh {
+public:
+  bench_dtanh() { name = "idx_dtanh_1M"; }
+  virtual void run() { idx_dtanh(in, out); }
+};
+
+class bench_stdsigmoid : public bench_tanh {
+public:
+  bench_stdsigmoid() { name = "idx_stdsigmoid_1M"; }
+  virtual void run() { idx_stdsigmoid(in, out); }
+};
+
+// idx_exp is in place: the input is restored with a same-type copy before
+// each run, which is timed separately by idx_copy_f32_f32_1M.
+class bench_exp : public bench_tanh {
+public:
+  bench_exp() { name = "idx_exp_1M"; }
+  virtual void run() { idx_copy(in, out); idx_exp(out); }
+};
+
+// idx_copy: same-type copy and the casts used when loading images and
+// datasets.
+template <typename T1, typename T2> class bench_copy : public benchmark {
+public:
+  bench_copy(const char *name) : benchmark(name), in(1024, 1024),
+                                 out(1024, 1024) {
+    idx_random(in, 0, 255);
+  }
+  virtual void run() { idx_copy(in, out); }
+  idx<T1> in;
+  idx<T2> out;
+};
+
+// 2D convolution of a 480x640 plane with a 7x7 kernel.
+class bench_2dconvol : public benchmark {
+public:
+  bench_2dconvol() : benchmark("idx_2dconvol_480x640_7x7"), in(486, 646),
+                     ker(7, 7), out(480, 640) {
+    idx_random(in, -1, 1); idx_random(ker, -1, 1);
+  }
+  virtual void run() { idx_2dconvol(in, ker, out); }
+  idx<float> in, ker, out;
+};
+
+#ifdef __TH__
+class bench_th_convolution : public bench_2dconvol {
+public:
+  bench_th_convolution() { name = "th_convolution_480x640_7x7"; }
+  virtual void run() { th_convolution(in, ker, out); }
+};
+#endif
+
+// Modules: fprop and bprop of a first-stage feature extractor on a 64x64
+// window, 8 input planes, 16 output planes.
+template <typename T> class bench_module : public benchmark {
+public:
+  //! Takes ownership of 'm'. If bprop is true, run() times bprop only.
+  bench_module(const char *name, module_1_1<T> *m, idxdim &indims,
+               bool bprop_)
+    : benchmark(name), mod(m), in(indims), bprop(bprop_) {
+    idx_random(in, -1, 1);
+    mod->fprop(in, out);
+    in.resize_dx(); out.resize_dx();
+    idx_random(out.dx[0], -1, 1);
+  }
+  virtual ~bench_module() { delete mod; }
+  virtual void run() {
+    if (bprop) {
+      in.zero_dx(); mod->bprop(in, out);
+    } else mod->fprop(in, out);
+  }
+  module_1_1<T> *mod;
+  state<T> in, out;
+  bool bprop;
+};
+
+// image_resize: bilinear downsampling of a 480x640 rgb image by 2.
+class bench_resize : public benchmark {
+public:
+  bench_resize() : benchmark("image_resize_480x640x3_half"), in(480, 640, 3) {
+    idx_random(in, 0, 255);
+  }
+  virtual void run() { idx<float> out = image_resize(in, 240, 320, 1); }
+  idx<float> in;
+};
+
+// Color conversion of a 480x640 rgb image.
+class bench_rgb_to_yuv : public benchmark {
+public:
+  bench_rgb_to_yuv() : benchmark("rgb_to_yuv_480x640"), in(480, 640, 3),
+                       out(480, 640, 3) {
+    idx_random(in, 0, 255);
+  }
+  virtual void run() { rgb_to_yuv(in, out); }
+  idx<float> in, out;
+};
+
+// Traditional nms over 2000 random detections in a 480x640 image.
+class bench_nms : public benchmark {
+public:
+  bench_nms() : benchmark("nms_2000"),
+                pnms(.3, .2, .3, .3, 1, 1, 1, 1, 1) {
+    for (uint i = 0; i < 2000; ++i) {
+      float h = (float) drand(20, 200);
+      bbox *b = new bbox((float) drand(0, 480 - h), (float) drand(0, 640 - h),
+                         h, h);
+      b->confidence = (float) drand(0, 1);
+      b->class_id = 0;
+      boxes.push_back(b);
+    }
+  }
+  virtual void run() { bboxes out; pnms.fprop(boxes, out); }
+  nms pnms;
+  bboxes boxes;
+};
+
+// load_matrix of a 16x128x128 float matrix (1MB) from disk.
+class bench_load_matrix : public benchmark {
+public:
+  bench_load_matrix() : benchmark("load_matrix_16x128x128") {
+    idx<float> m(16, 128, 128);
+    idx_random(m, -1, 1);
+    if (!save_matrix(m, tmp_file))
+      eblerror("failed to write benchmark matrix to " << tmp_file);
+  }
+  virtual ~bench_load_matrix() { remove(tmp_file.c_str()); }
+  virtual void run() { idx<float> m = load_matrix<float>(tmp_file); }
+};
+
+//! Allocates all benchmarks whose name contains 'filter' into 'all'.
+//! Module weights and their gradients are allocated in 'p'.
+void make_benchmarks(vector<benchmark*> &all, parameter<float> &p) {
+  idxdim ker(5, 5), stride(1, 1), pool(2, 2), norm(7, 7);
+  idxdim conv_in(8, 64, 64), feat_in(16, 60, 60);
+  idx<intg> table = full_table(8, 16);
+  all.push_back(new bench_m2dotm1);
+  all.push_back(new bench_m4dotm2acc);
+  all.push_back(new bench_tanh);
+  all.push_back(new bench_dtanh);
+  all.push_back(new bench_stdsigmoid);
+  all.push_back(new bench_exp);
+  all.push_back(new bench_copy<float,float>("idx_copy_f32_f32_1M"));
+  all.push_back(new bench_copy<ubyte,float>("idx_copy_u8_f32_1M"));
+  all.push_back(new bench_copy<float,double>("idx_copy_f32_f64_1M"));
+  all.push_back(new bench_copy<float,ubyte>("idx_copy_f32_u8_1M"));
+  all.push_back(new bench_2dconvol);
+#ifdef __TH__
+  all.push_back(new bench_th_convolution);
+#endif
+  all.push_back(new bench_module<float>
+                ("convolution_fprop_8x64x64_5x5_16",
+                 new convolution_module<float>(&p, ker, stride, table),
+                 conv_in, false));
+  all.push_back(new bench_module<float>
+                ("convolution_bprop_8x64x64_5x5_16",
+                 new convolution_module<float>(&p, ker, stride, table),
+                 conv_in, true));
+  all.push_back(new bench_module<float>
+                ("subsampling_fprop_16x60x60_2x2",
+                 new subsampling_module<float>(&p, 16, pool, pool),
+                 feat_in, false));
+  all.push_back(new bench_module<float>
+                ("subsampling_bprop_16x60x60_2x2",
+                 new subsampling_module<float>(&p, 16, pool, pool),
+                 feat_in, true));
+  all.push_back(new bench_module<float>
+                ("contrast_norm_fprop_16x60x60_7x7",
+                 new contrast_norm_module<float>(norm, 16, true),
+                 feat_in, false));
+  all.push_back(new bench_module<float>
+                ("contrast_norm_bprop_16x60x60_7x7",
+                 new contrast_norm_module<float>(norm, 16, true),
+                 feat_in, true));
+  all.push_back(new bench_resize);
+  all.push_back(new bench_rgb_to_yuv);
+  all.push_back(new bench_nms);
+  all.push_back(new bench_load_matrix);
+  // filter by name
+  if (!filter.empty()) {
+    vector<benchmark*> kept;
+    for (uint i = 0; i < all.size(); ++i)
+      if (all[i]->name.find(filter) != string::npos) kept.push_back(all[i]);
+      else delete all[i];
+    all = kept;
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// timing
+
+//! Times 'b': after one warm-up run, the number of runs per sample is doubled
+//! until a sample lasts min_time / nsamples, then nsamples samples are taken.
+bench_result time_benchmark(benchmark &b) {
+  bench_result r;
+  r.name = b.name;
+  timer t;
+  b.run(); // warm-up (first-touch allocations, caches)
+  double sample_us = min_time * 1e6 / std::max((uint) 1, nsamples);
+  intg n = 1;
+  while (true) {
+    t.start();
+    for (intg i = 0; i < n; ++i) b.run();
+    long us = t.elapsed_microseconds();
+    if (us >= sample_us || n >= (1 << 24)) break;
+    n *= 2;
+  }
+  vector<double> samples;
+  for (uint s = 0; s < nsamples; ++s) {
+    t.start();
+    for (intg i = 0; i < n; ++i) b.run();
+    samples.push_back(t.elapsed_microseconds() / (double) n);
+  }
+  sort(samples.begin(), samples.end());
+  r.median = samples[samples.size() / 2];
+  r.min = samples[0];
+  r.runs = n * nsamples;
+  return r;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// results i/o
+
+//! Saves results as a table: one benchmark per line, '#' starts a comment.
+bool save_table(vector<bench_result> &res, const string &fname) {
+  ofstream f(fname.c_str());
+  if (!f) {
+    cerr << "failed to open " << fname << " for writing" << endl;
+    return false;
+  }
+  f << "# name median_us min_us runs" << endl;
+  for (uint i = 0; i < res.size(); ++i)
+    f << res[i].name << " " << res[i].median << " " << res[i].min << " "
+      << res[i].runs << endl;
+  return true;
+}
+
+//! Loads a table written by save_table() into 'base', indexed by name.
+bool load_table(const string &fname, map<string,bench_result> &base) {
+  ifstream f(fname.c_str());
+  if (!f) {
+    cerr << "failed to open baseline " << fname << endl;
+    return false;
+  }
+  string line;
+  while (getline(f, line)) {
+    if (line.empty() || line[0] == '#') continue;
+    istringstream s(line);
+    bench_result r;
+    if (s >> r.name >> r.median >> r.min >> r.runs) base[r.name] = r;
+  }
+  return true;
+}
+
+bool save_json(vector<bench_result> &res, const string &fname) {
+  ofstream f(fname.c_str());
+  if (!f) {
+    cerr << "failed to open " << fname << " for writing" << endl;
+    return false;
+  }
+  f << "{\"unit\": \"us\", \"benchmarks\": [" << endl;
+  for (uint i = 0; i < res.size(); ++i)
+    f << "  {\"name\": \"" << res[i].name << "\", \"median\": "
+      << res[i].median << ", \"min\": " << res[i].min << ", \"runs\": "
+      << res[i].runs << "}" << (i + 1 < res.size() ? "," : "") << endl;
+  f << "]}" << endl;
+  return true;
+}
+
+//! Prints each result next to its baseline and returns the number of
+//! benchmarks slower than baseline by more than 'tolerance'. Medians are
+//! compared since they are the least sensitive to scheduling noise.
+uint compare(vector<bench_result> &res, map<string,bench_result> &base) {
+  uint nregressions = 0;
+  cout << endl << "Comparison with baseline " << baseline_file
+       << " (tolerance " << tolerance * 100 << "%):" << endl;
+  for (uint i = 0; i < res.size(); ++i) {
+    map<string,bench_result>::iterator b = base.find(res[i].name);
+    cout << "  " << left << setw(40) << res[i].name << right;
+    if (b == base.end() || b->second.median <= 0) {
+      cout << " (no baseline)" << endl;
+      continue;
+    }
+    double ratio = res[i].median / b->second.median;
+    cout << setw(12) << b->second.median << " -> " << setw(12)
+         << res[i].median << " us  x" << setprecision(3) << ratio
+         << setprecision(6);
+    if (ratio > 1 + tolerance) {
+      cout << "  REGRESSION";
+      nregressions++;
+    } else if (ratio < 1 - tolerance) cout << "  improved";
+    cout << endl;
+  }
+  return nregressions;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// main
+
+// parse command line input
+bool parse_args(int argc, char **argv) {
+  for (int i = 1; i < argc; ++i) {
+    try {
+      if (strcmp(argv[i], "-filter") == 0) {
+	++i; if (i >= argc) throw 0;
+	filter = argv[i];
+      } else if (strcmp(argv[i], "-min_time") == 0) {
+	++i; if (i >= argc) throw 1;
+	min_time = atof(argv[i]);
+      } else if (strcmp(argv[i], "-samples") == 0) {
+	++i; if (i >= argc) throw 1;
+	nsamples = (uint) std::max(1, atoi(argv[i]));
+      } else if (strcmp(argv[i], "-save") == 0) {
+	++i; if (i >= argc) throw 0;
+	save_file = argv[i];
+      } else if (strcmp(argv[i], "-json") == 0) {
+	++i; if (i >= argc) throw 0;
+	json_file = argv[i];
+      } else if (strcmp(argv[i], "-baseline") == 0) {
+	++i; if (i >= argc) throw 0;
+	baseline_file = argv[i];
+      } else if (strcmp(argv[i], "-tolerance") == 0) {
+	++i; if (i >= argc) throw 1;
+	tolerance = atof(argv[i]);
+      } else if (strcmp(argv[i], "-tmp") == 0) {
+	++i; if (i >= argc) throw 0;
+	tmp_file = argv[i];
+      } else if (strcmp(argv[i], "-nthreads") == 0) {
+	++i; if (i >= argc) throw 1;
+	nthreads = atoi(argv[i]);
+      } else if (strcmp(argv[i], "-list") == 0) {
+	list_only = true;
+      } else if ((strcmp(argv[i], "-help") == 0) ||
+		 (strcmp(argv[i], "-h") == 0)) {
+	return false;
+      } else throw 2;
+    } catch (int err) {
+      cerr << "input error: ";
+      switch (err) {
+      case 0: cerr << "expecting string after " << argv[i-1]; break;
+      case 1: cerr << "expecting number after " << argv[i-1]; break;
+      case 2: cerr << "unknown parameter " << argv[i]; break;
+      default: cerr << "undefined error";
+      }
+      cerr << endl << endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// print command line usage
+void print_usage() {
+  cout << "Usage: ./eblbench [OPTIONS]" << endl << "Options are:" << endl;
+  cout << "  -filter <string>" << endl
+       << "   Only run benchmarks whose name contains this string." << endl;
+  cout << "  -list" << endl
+       << "   List benchmark names and exit." << endl;
+  cout << "  -min_time <seconds> (default " << min_time << ")" << endl
+       << "   Minimum time spent timing each benchmark." << endl;
+  cout << "  -samples <n> (default " << nsamples << ")" << endl
+       << "   Number of timing samples, the median and min are reported."
+       << endl;
+  cout << "  -save <file>" << endl
+       << "   Save results as a table usable with -baseline." << endl;
+  cout << "  -json <file>" << endl
+       << "   Save results in json format." << endl;
+  cout << "  -baseline <file>" << endl
+       << "   Compare results with a table saved with -save and return 1 if"
+       << endl << "   any benchmark regressed." << endl;
+  cout << "  -tolerance <ratio> (default " << tolerance << ")" << endl
+       << "   Relative slowdown of the median considered a regression."
+       << endl;
+  cout << "  -nthreads <n>" << endl
+       << "   Number of threads of the global thread pool." << endl;
+  cout << "  -tmp <file> (default " << tmp_file << ")" << endl
+       << "   Scratch file used by the load_matrix benchmark." << endl;
+}
+
+int main(int argc, char **argv) {
+  if (!parse_args(argc, argv)) {
+    print_usage();
+    return -1;
+  }
+  init_drand(12345); // fixed seed: same synthetic data on every run
+  if (nthreads > 0) thread_pool::global().set_nthreads((uint) nthreads);
+  dparameter<float> p(1);
+  vector<benchmark*> all;
+  make_benchmarks(all, p);
+  if (list_only) {
+    for (uint i = 0; i < all.size(); ++i) {
+      cout << all[i]->name << endl;
+      delete all[i];
+    }
+    return 0;
+  }
+  // run benchmarks
+  vector<bench_result> res;
+  cout << "# name median_us min_us runs" << endl;
+  for (uint i = 0; i < all.size(); ++i) {
+    res.push_back(time_benchmark(*all[i]));
+    bench_result &r = res.back();
+    cout << r.name << " " << r.median << " " << r.min << " " << r.runs
+         << endl;
+    delete all[i];
+  }
+  // save and compare
+  int ret = 0;
+  if (!save_file.empty() && !save_table(res, save_file)) ret = -1;
+  if (!json_file.empty() && !save_json(res, json_file)) ret = -1;
+  if (!baseline_file.empty()) {
+    map<string,bench_result> base;
+    if (!load_table(baseline_file, base)) return -1;
+    uint n = compare(res, base);
+    if (n > 0) {
+      cout << n << " benchmark(s) regressed." << endl;
+      if (ret == 0) ret = 1;
+    }
+  }
+  return ret;
+}
@@ -0,0 +1,36 @@
+#!/bin/sh
+# A fake training program to try metarun's scheduling policies without
+# training anything (see meta_asha_example.conf and meta_warm_example.conf).
+# It reads 'quality', 'late' and 'iterations' from the configuration file given
+# as argument and prints a decreasing test error at each iteration, the lower
+# 'quality' and 'late' the better the job. Like the real training programs,
+# it touches a <job_name>_netXXXXX.mat file at each iteration and resumes from
+# 'retrain_iteration' when retraining.
+
+conf=$1
+get() { sed -n "s/^ *$1 *= *\([0-9.]*\).*/\1/p" $conf | tail -n 1; }
+gets() { sed -n "s/^ *$1 *= *\([^ #]*\).*/\1/p" $conf | tail -n 1; }
+job_name=`gets job_name`
+quality=`get quality`
+late=`get late`
+save_ds_state=`get save_ds_state`
+iterations=`get iterations`
+delay=`get fake_delay`
+i=`get retrain_iteration`
+if [ -z "$i" ]; then i=0; else i=`expr $i - 1`; fi
+[ -z "$delay" ] && delay=1
+[ -z "$late" ] && late=0
+[ "`get retrain`" = "1" ] && echo "retrain_weights=`gets retrain_weights`"
+
+while [ $i -lt $iterations ]; do
+    i=`expr $i + 1`
+    err=`echo "$quality $i $late" | \
+	awk '{ printf "%.3f", $1 * 10 + 50 / $2 + $3 * $2 }'`
+    echo "i=$i test_errors=$err"
+    w=`printf "%s_net%05d" $job_name $i`
+    touch $w.mat
+    [ "$save_ds_state" = "1" ] && touch ${w}_ds.mat
+    printf "i = %d\ntotal = %d\nretrain_iteration = %d\nretrain_weights = %s\n" \
+	`expr $i + 1` $iterations `expr $i + 1` $w.mat > progress
+    sleep $delay
+done
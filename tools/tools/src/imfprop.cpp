@@ -90,6 +90,9 @@ int main(int argc, char **argv) { // regular main without gui
     ostream &merr = sync ? muterr : cerr;
     uint ipp_cores = conf.try_get_uint("ipp_cores", 1);
     ipp_init(ipp_cores); // limit IPP (if available) to 1 core
+    // library-wide thread pool (all cores if pool_cores <= 0)
+    pool_init(conf.try_get_int("pool_cores", 1),
+              conf.try_get_intg("pool_grain", 0));
     uint skip_frames = conf.try_get_uint("skip_frames", 0);
 
     // camera //////////////////////////////////////////////////////////////////
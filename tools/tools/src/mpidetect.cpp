@@ -408,6 +408,9 @@ public:
 		uint        ipp_cores				= 1;
 		if (conf.exists("ipp_cores")) ipp_cores = conf.get_uint("ipp_cores");
 		ipp_init(ipp_cores);	// limit IPP (if available) to 1 core
+		// library-wide thread pool (all cores if pool_cores <= 0)
+		pool_init(conf.try_get_int("pool_cores", 1),
+		          conf.try_get_intg("pool_grain", 0));
 		bool	save_video				= conf.exists_true("save_video");
 		string	cam_type				= conf.get_string("camera");
 		int		height					= conf.get_int("input_height");
@@ -729,6 +732,9 @@ MAIN_QTHREAD(int, argc, char **, argv) { // macro to enable multithreaded gui
 			uint              ipp_cores     = 1;
 			if (conf.exists("ipp_cores")) ipp_cores = conf.get_uint("ipp_cores");
 			ipp_init(ipp_cores); // limit IPP (if available) to 1 core
+			// library-wide thread pool (all cores if pool_cores <= 0)
+			pool_init(conf.try_get_int("pool_cores", 1),
+			          conf.try_get_intg("pool_grain", 0));
 			// output synchronization
 			bool sync = conf.exists_true("sync_outputs");
 			mutex out_mutex;
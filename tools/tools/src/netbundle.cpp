@@ -0,0 +1,108 @@
+/***************************************************************************
+ *   Copyright (C) 2013 by Pierre Sermanet *
+ *   pierre.sermanet@gmail.com *
+ *   All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Redistribution under a license not approved by the Open Source
+ *       Initiative (http://www.opensource.org) must display the
+ *       following acknowledgement in all advertising material:
+ *        This product includes software developed at the Courant
+ *        Institute of Mathematical Sciences (http://cims.nyu.edu).
+ *     * The names of the authors may not be used to endorse or promote products
+ *       derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED ``AS IS'' AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL ThE AUTHORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ ***************************************************************************/
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "libeblearn.h"
+#include "libeblearntools.h"
+
+typedef float t_net; // network precision, must match detect's
+
+using namespace std;
+using namespace ebl;
+
+//! Compile configuration, classes, weights and the scales geometry of a set
+//! of input sizes into a single network bundle that 'detect' loads directly.
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    cerr << "usage: netbundle <config file> <output bundle> "
+         << "[<height>x<width>[x<channels>] ...]" << endl;
+    return -1;
+  }
+  try {
+    // load and resolve configuration like detect does
+    configuration conf(argv[1], true, true, false);
+    if (!conf.exists("root2") || !conf.exists("current_dir")) {
+      string dir;
+      dir << dirname(argv[1]) << "/";
+      conf.set("root2", dir.c_str());
+      conf.set("current_dir", dir.c_str());
+    }
+    conf.set("run_type", "detect");
+    conf.resolve();
+    // input sizes for which to precompute scales, in image layout
+    vector<idxdim> indims;
+    for (int i = 3; i < argc; ++i) indims.push_back(string_to_idxdim(argv[i]));
+    if (indims.empty() && conf.exists("input_height")
+        && conf.exists("input_width"))
+      indims.push_back(idxdim(conf.get_int("input_height"),
+                              conf.get_int("input_width"), 3));
+    for (uint i = 0; i < indims.size(); ++i) { // move channels to 1st dim
+      if (indims[i].order() == 2) indims[i].insert_dim(0, 1);
+      else if (indims[i].order() == 3) indims[i].shift_dim(2, 0);
+      else eblerror("expected HxW or HxWxC input size but got " << indims[i]);
+    }
+    // classes, network and weights
+    idx<ubyte> classes(1,1);
+    load_matrix<ubyte>(classes, conf.get_cstring("classes"));
+    vector<string> sclasses = ubyteidx_to_stringvector(classes);
+    answer_module<t_net> *ans =
+        create_answer<t_net,t_net,t_net>(conf, classes.dim(0));
+    parameter<t_net> theparam;
+    theparam.set_forward_only();
+    intg thick = -1;
+    module_1_1<t_net> *net = create_network<t_net>(theparam, conf, thick,
+                                                   ans->get_nfeatures());
+    if (!conf.exists("weights"))
+      eblerror("a network bundle requires trained \"weights\"");
+    vector<string> w = string_to_stringvector(conf.get_string("weights"));
+    theparam.load_x(w);
+    if (conf.exists("weights_permutation")) {
+      vector<intg> blocks =
+          string_to_intgvector(conf.get_cstring("weights_blocks"));
+      vector<uint> permut =
+          string_to_uintvector(conf.get_cstring("weights_permutation"));
+      theparam.permute_x(blocks, permut);
+    }
+    // detector geometry
+    string outdir = "";
+    detector<t_net> detect(*net, sclasses, ans);
+    detection_thread<t_net>::init_detector(detect, conf, outdir, true);
+    netbundle<t_net>::save(argv[2], conf, classes, theparam, detect, indims);
+    cout << "Wrote network bundle with " << theparam.dim(0) << " weights and "
+         << indims.size() << " precomputed input sizes to " << argv[2] << endl;
+    delete net;
+    delete ans;
+  } eblcatcherror();
+  return 0;
+}
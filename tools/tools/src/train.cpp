@@ -70,6 +70,10 @@ int train(configuration &conf, string &conffname) {
     uint              ipp_cores     = 1;
     if (conf.exists("ipp_cores")) ipp_cores = conf.get_uint("ipp_cores");
     ipp_init(ipp_cores); // limit IPP (if available) to 1 core
+    // library-wide thread pool (all cores if pool_cores <= 0)
+    pool_init(conf.try_get_int("pool_cores", 1),
+              conf.try_get_intg("pool_grain", 0));
+    profile_init(conf); // per-module profiling if 'profile' is true
     intg nhessian = conf.exists("ndiaghessian") ?
       conf.get_int("ndiaghessian") : 100;
     intg hessian_period = conf.exists("hessian_period") ?
@@ -97,6 +101,10 @@ int train(configuration &conf, string &conffname) {
                                                  &net, iter);
     thetrainer->set_test_display_modulo
         (conf.try_get_intg("test_display_modulo", 0));
+    // resume training sample order of a warm-started job
+    if (train_ds && conf.exists_true("retrain")
+	&& conf.exists("retrain_ds_state"))
+      train_ds->read_state(conf.get_string("retrain_ds_state"));
     // a classifier-meter measures classification errors
     classifier_meter trainmeter, testmeter;
     trainmeter.init(noutputs);
@@ -151,6 +159,11 @@ int train(configuration &conf, string &conffname) {
       cout << "saving confusion to " << fname << endl;
       save_matrix(testmeter.get_confusion(), fname.c_str());
     }
+    // compare with an 8-bit quantized version of the network
+    if (conf.exists_true("quantize_test"))
+      quantized_test(conf, *net, noutputs, train_ds ? *train_ds : *test_ds,
+                     *test_ds, infp, testmeter.get_normalized_error());
+    profile_report(conf); // print per-module profile if profiling
     // free variables
     if (net) delete net;
     if (thetrainer) delete thetrainer;